@@ -1769,6 +1769,73 @@ int libvlc_video_take_snapshot( libvlc_media_player_t *p_mi, unsigned num,
                                 const char *psz_filepath, unsigned int i_width,
                                 unsigned int i_height );
 
+/**
+ * What happened to a picture handed to a video output
+ */
+typedef enum libvlc_video_frame_status_t {
+    libvlc_video_frame_displayed = 0,
+    libvlc_video_frame_dropped_late,    /**< too late to be rendered */
+    libvlc_video_frame_dropped_filter,  /**< video filters returned nothing */
+    libvlc_video_frame_dropped_convert, /**< display conversion failed */
+} libvlc_video_frame_status_t;
+
+/**
+ * Timings of a picture handed to a video output
+ *
+ * All values are in microseconds. Dates are comparable with libvlc_clock().
+ * Durations are 0 if not relevant, e.g. for dropped pictures.
+ */
+typedef struct libvlc_video_frame_timing_t
+{
+    int64_t i_pts;      /**< picture timestamp */
+    int64_t i_date;     /**< date of the display or of the drop */
+    int64_t i_latency;  /**< from the decoder output to i_date, or -1 */
+    int64_t i_render;   /**< filtering, blending and conversion time */
+    int64_t i_prepare;  /**< time spent preparing the display */
+    int64_t i_slip;     /**< display date minus the expected one */
+    libvlc_video_frame_status_t i_status;
+    bool b_forced;      /**< displayed regardless of its date (refresh,
+                             frame stepping...), i_slip is then 0 */
+} libvlc_video_frame_timing_t;
+
+/**
+ * Get the timings of the last pictures displayed or dropped by a video
+ * output, oldest first.
+ *
+ * At most the last 256 pictures are remembered. This can be polled to
+ * diagnose judder or dropped frames.
+ *
+ * \version LibVLC 4.0.0 or later
+ *
+ * \param p_mi media player instance
+ * \param num number of video output (typically 0 for the first/only one)
+ * \param p_timings array to fill [OUT]
+ * \param i_count size of the array
+ * \return the number of timings written, or -1 if the video was not found
+ */
+LIBVLC_API
+int libvlc_video_get_frame_timings( libvlc_media_player_t *p_mi, unsigned num,
+                                    libvlc_video_frame_timing_t *p_timings,
+                                    unsigned i_count );
+
+/**
+ * Write the timings of the last pictures displayed or dropped by a video
+ * output to a CSV file.
+ *
+ * The file has a header line, then one line per picture, with the fields of
+ * libvlc_video_frame_timing_t in order. The file is overwritten.
+ *
+ * \version LibVLC 4.0.0 or later
+ *
+ * \param p_mi media player instance
+ * \param num number of video output (typically 0 for the first/only one)
+ * \param psz_filepath the path of the file to write
+ * \return 0 on success, -1 if the video was not found or on write error
+ */
+LIBVLC_API
+int libvlc_video_dump_frame_timings( libvlc_media_player_t *p_mi, unsigned num,
+                                     const char *psz_filepath );
+
 /**
  * Enable or disable deinterlace filter
  *
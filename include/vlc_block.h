@@ -202,6 +202,27 @@ VLC_API block_t *block_Realloc(block_t *, ssize_t pre, size_t body) VLC_USED;
  */
 VLC_API void block_Release(block_t *block);
 
+/**
+ * Block allocator cache statistics.
+ *
+ * Small blocks from block_Alloc() are recycled through per-thread caches.
+ * Counters are updated periodically by each thread, so they lag behind a
+ * little.
+ */
+struct vlc_block_cache_stats
+{
+    uint64_t hits; /**< allocations served from a cache */
+    uint64_t misses; /**< allocations served from the heap */
+    size_t cached; /**< bytes held by caches */
+};
+
+/**
+ * Gets block allocator cache statistics.
+ *
+ * @param stats storage for the statistics [OUT]
+ */
+VLC_API void block_cache_Stats(struct vlc_block_cache_stats *stats);
+
 static inline void block_CopyProperties( block_t *dst, const block_t *src )
 {
     dst->i_flags   = src->i_flags;
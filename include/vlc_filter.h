@@ -40,10 +40,23 @@ typedef struct vlc_video_context  vlc_video_context;
  * Filter modules interface
  */
 
+/**
+ * Slice callback of a video filter
+ *
+ * \param opaque data passed to filter_ExecuteSlices()
+ * \param slice index of the slice to process, from 0 to slices - 1
+ * \param slices number of slices of the picture
+ */
+typedef void (*filter_slice_cb)(filter_t *, void *opaque,
+                                unsigned slice, unsigned slices);
+
 struct filter_video_callbacks
 {
     picture_t *(*buffer_new)(filter_t *);
     vlc_decoder_device * (*hold_device)(vlc_object_t *, void *sys);
+    /** Runs slices on worker threads, can be NULL */
+    void (*execute)(filter_t *, filter_slice_cb, void *opaque,
+                    unsigned slices);
 };
 
 struct filter_subpicture_callbacks
@@ -51,12 +64,20 @@ struct filter_subpicture_callbacks
     subpicture_t *(*buffer_new)(filter_t *);
 };
 
+struct filter_audio_callbacks
+{
+    /** Returns the software gain to apply to the current block, can be NULL.
+     * A filter calling it takes over the software volume of its owner. */
+    float (*get_gain)(filter_t *);
+};
+
 typedef struct filter_owner_t
 {
     union
     {
         const struct filter_video_callbacks *video;
         const struct filter_subpicture_callbacks *sub;
+        const struct filter_audio_callbacks *audio;
     };
     void *sys;
 } filter_owner_t;
@@ -118,6 +139,14 @@ struct filter_t
         /* TODO: video filter drain */
         /** Drain (audio filter) */
         block_t *(*pf_audio_drain) ( filter_t * );
+
+        /** Live settings key (text render)
+         *
+         * Returns a value that changes with the settings read by pf_render
+         * each time it renders, so that the owner can reuse an earlier
+         * rendering of the same region while it is unchanged. If NULL,
+         * renderings are not reused. */
+        uint64_t (*pf_render_settings)( filter_t * );
     };
 
     /** Flush
@@ -198,6 +227,34 @@ static inline void filter_ChangeViewpoint( filter_t *p_filter,
         p_filter->pf_change_viewpoint( p_filter, vp );
 }
 
+/**
+ * This function processes a picture in slices, concurrently if the filter
+ * owner provides worker threads. It returns once all slices are done.
+ *
+ * The callback can be invoked from several threads at the same time, so the
+ * slices must neither overlap in the output nor share any scratch state.
+ *
+ * \param cb slice callback
+ * \param opaque data passed to the callback
+ * \param slices number of slices, or 0 to let the owner pick a number of
+ *               horizontal bands suitable for its worker threads
+ */
+static inline void filter_ExecuteSlices( filter_t *p_filter,
+                                         filter_slice_cb cb, void *opaque,
+                                         unsigned slices )
+{
+    if( p_filter->owner.video != NULL && p_filter->owner.video->execute != NULL )
+    {
+        p_filter->owner.video->execute( p_filter, cb, opaque, slices );
+        return;
+    }
+
+    if( slices == 0 )
+        slices = 1;
+    for( unsigned i = 0; i < slices; i++ )
+        cb( p_filter, opaque, i, slices );
+}
+
 static inline vlc_decoder_device * filter_HoldDecoderDevice( filter_t *p_filter )
 {
     if ( !p_filter->owner.video || !p_filter->owner.video->hold_device )
@@ -234,6 +291,17 @@ static inline block_t *filter_DrainAudio( filter_t *p_filter )
         return NULL;
 }
 
+/**
+ * Returns the software gain that an audio filter applies to its output, if
+ * its owner provides one, and 1 otherwise.
+ */
+static inline float filter_GetGain( filter_t *p_filter )
+{
+    if( p_filter->owner.audio != NULL && p_filter->owner.audio->get_gain != NULL )
+        return p_filter->owner.audio->get_gain( p_filter );
+    return 1.f;
+}
+
 /**
  * This function will return a new subpicture usable by p_filter as an output
  * buffer. You have to release it using subpicture_Delete or by returning it to
@@ -93,6 +93,39 @@ enum vlc_vout_order
     VLC_VOUT_ORDER_SECONDARY,
 };
 
+/**
+ * What happened to a picture handled by the video output
+ */
+enum vout_frame_status
+{
+    VOUT_FRAME_DISPLAYED, /**< The picture was displayed */
+    VOUT_FRAME_DROPPED_LATE, /**< Dropped before rendering, as too late */
+    VOUT_FRAME_DROPPED_FILTER, /**< The interactive filters returned nothing */
+    VOUT_FRAME_DROPPED_CONVERT, /**< The display conversion failed */
+};
+
+/**
+ * Timings of a picture handled by the video output
+ *
+ * Durations are 0 if not relevant, e.g. for dropped pictures.
+ */
+typedef struct vout_frame_timing_t
+{
+    vlc_tick_t pts; /**< Picture timestamp */
+    vlc_tick_t date; /**< System date of the display or of the drop */
+    /** Time from vout_PutPicture() to date, VLC_TICK_INVALID if unknown */
+    vlc_tick_t latency;
+    vlc_tick_t render; /**< Filtering, blending and conversion time */
+    vlc_tick_t prepare; /**< Time spent in vout_display_t::prepare */
+    /** Display date minus the expected one, positive if late. For a late
+     * drop, by how much the picture missed its date. */
+    vlc_tick_t slip;
+    enum vout_frame_status status;
+    /** The picture was displayed as soon as possible, regardless of its
+     * date: first picture, refresh, frame stepping, ... */
+    bool forced;
+} vout_frame_timing_t;
+
 /*****************************************************************************
  * Prototypes
  *****************************************************************************/
@@ -126,6 +159,19 @@ VLC_API int vout_GetSnapshot( vout_thread_t *p_vout,
                               video_format_t *p_fmt,
                               const char *psz_format, vlc_tick_t i_timeout );
 
+/**
+ * Gets the timings of the last pictures displayed or dropped.
+ *
+ * The timings are copied oldest first. At most the last 256 pictures are
+ * remembered.
+ *
+ * \param frames array to fill
+ * \param max size of the array
+ * \return the number of timings copied
+ */
+VLC_API size_t vout_GetFrameTimings( vout_thread_t *p_vout,
+                                     vout_frame_timing_t *frames, size_t max );
+
 /* */
 VLC_API picture_t * vout_GetPicture( vout_thread_t * );
 VLC_API void vout_PutPicture( vout_thread_t *, picture_t * );
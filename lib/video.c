@@ -38,11 +38,13 @@
 #include <vlc_modules.h>
 #include <vlc_vout.h>
 #include <vlc_url.h>
+#include <vlc_fs.h>
 
 #include "libvlc_internal.h"
 #include "media_player_internal.h"
 #include <math.h>
 #include <assert.h>
+#include <errno.h>
 
 /*
  * Remember to release the returned vout_thread_t.
@@ -155,6 +157,94 @@ libvlc_video_take_snapshot( libvlc_media_player_t *p_mi, unsigned num,
     return 0;
 }
 
+static int GetFrameTimings( libvlc_media_player_t *p_mi, unsigned num,
+                            vout_frame_timing_t *frames, size_t max )
+{
+    vout_thread_t *p_vout = GetVout (p_mi, num);
+    if (p_vout == NULL)
+        return -1;
+
+    size_t count = vout_GetFrameTimings(p_vout, frames, max);
+    vout_Release(p_vout);
+    return count;
+}
+
+int libvlc_video_get_frame_timings( libvlc_media_player_t *p_mi, unsigned num,
+                                    libvlc_video_frame_timing_t *p_timings,
+                                    unsigned i_count )
+{
+    static_assert(libvlc_video_frame_dropped_late
+                  == (int)VOUT_FRAME_DROPPED_LATE
+               && libvlc_video_frame_dropped_filter
+                  == (int)VOUT_FRAME_DROPPED_FILTER
+               && libvlc_video_frame_dropped_convert
+                  == (int)VOUT_FRAME_DROPPED_CONVERT,
+                  "Mismatched frame status");
+
+    vout_frame_timing_t *frames = vlc_alloc(i_count, sizeof (*frames));
+    if (frames == NULL && i_count > 0)
+        return -1;
+
+    int count = GetFrameTimings(p_mi, num, frames, i_count);
+    for (int i = 0; i < count; i++)
+    {
+        const vout_frame_timing_t *f = &frames[i];
+        libvlc_video_frame_timing_t *t = &p_timings[i];
+
+        t->i_pts = US_FROM_VLC_TICK(f->pts);
+        t->i_date = US_FROM_VLC_TICK(f->date);
+        t->i_latency = f->latency != VLC_TICK_INVALID ?
+                       US_FROM_VLC_TICK(f->latency) : -1;
+        t->i_render = US_FROM_VLC_TICK(f->render);
+        t->i_prepare = US_FROM_VLC_TICK(f->prepare);
+        t->i_slip = US_FROM_VLC_TICK(f->slip);
+        t->i_status = (libvlc_video_frame_status_t)f->status;
+        t->b_forced = f->forced;
+    }
+    free(frames);
+    return count;
+}
+
+int libvlc_video_dump_frame_timings( libvlc_media_player_t *p_mi, unsigned num,
+                                     const char *psz_filepath )
+{
+    static const char *const status[] = {
+        "displayed", "late", "filter", "convert",
+    };
+    libvlc_video_frame_timing_t timings[256];
+
+    assert( psz_filepath );
+
+    int count = libvlc_video_get_frame_timings(p_mi, num, timings,
+                                               ARRAY_SIZE(timings));
+    if (count < 0)
+        return -1;
+
+    FILE *stream = vlc_fopen(psz_filepath, "w");
+    if (stream == NULL)
+    {
+        libvlc_printerr("Cannot open %s: %s", psz_filepath,
+                        vlc_strerror_c(errno));
+        return -1;
+    }
+
+    fputs("pts,date,latency,render,prepare,slip,status,forced\n", stream);
+    for (int i = 0; i < count; i++)
+    {
+        const libvlc_video_frame_timing_t *t = &timings[i];
+
+        fprintf(stream, "%"PRId64",%"PRId64",%"PRId64",%"PRId64",%"PRId64
+                ",%"PRId64",%s,%d\n", t->i_pts, t->i_date, t->i_latency,
+                t->i_render, t->i_prepare, t->i_slip, status[t->i_status],
+                t->b_forced);
+    }
+
+    int ret = ferror(stream) ? -1 : 0;
+    if (fclose(stream))
+        ret = -1;
+    return ret;
+}
+
 int libvlc_video_get_size( libvlc_media_player_t *p_mi, unsigned num,
                            unsigned *restrict px, unsigned *restrict py )
 {
@@ -61,10 +61,16 @@
 #include <vlc_fs.h>
 #include <vlc_url.h>
 #include <vlc_interrupt.h>
+#ifdef HAVE_LINUX_IO_URING_H
+# include "uring.h"
+#endif
 
 typedef struct
 {
     int fd;
+#ifdef HAVE_LINUX_IO_URING_H
+    file_uring_t *uring;
+#endif
 
     bool b_pace_control;
 } access_sys_t;
@@ -127,6 +133,10 @@ static bool IsRemote (const char *path)
 
 static ssize_t Read (stream_t *, void *, size_t);
 static int FileSeek (stream_t *, uint64_t);
+#ifdef HAVE_LINUX_IO_URING_H
+static ssize_t UringRead (stream_t *, void *, size_t);
+static int UringSeek (stream_t *, uint64_t);
+#endif
 static int FileControl (stream_t *, int, va_list);
 
 /*****************************************************************************
@@ -210,6 +220,9 @@ int FileOpen( vlc_object_t *p_this )
     p_access->pf_control = FileControl;
     p_access->p_sys = p_sys;
     p_sys->fd = fd;
+#ifdef HAVE_LINUX_IO_URING_H
+    p_sys->uring = NULL;
+#endif
 
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
@@ -228,6 +241,17 @@ int FileOpen( vlc_object_t *p_this )
             fcntl (fd, F_RDAHEAD, 0);
         else
             fcntl (fd, F_RDAHEAD, 1);
+#endif
+#ifdef HAVE_LINUX_IO_URING_H
+        /* Keep reads in flight while the previous data is demuxed */
+        if (S_ISREG (st.st_mode) && var_InheritBool (p_access, "file-uring")
+         && !IsRemote (fd, p_access->psz_filepath))
+            p_sys->uring = file_uring_New (p_this, fd, 0);
+        if (p_sys->uring != NULL)
+        {
+            p_access->pf_read = UringRead;
+            p_access->pf_seek = UringSeek;
+        }
 #endif
     }
     else
@@ -258,6 +282,10 @@ void FileClose (vlc_object_t * p_this)
 
     access_sys_t *p_sys = p_access->p_sys;
 
+#ifdef HAVE_LINUX_IO_URING_H
+    if (p_sys->uring != NULL)
+        file_uring_Delete (p_sys->uring);
+#endif
     vlc_close (p_sys->fd);
 }
 
@@ -284,6 +312,50 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
     return val;
 }
 
+#ifdef HAVE_LINUX_IO_URING_H
+static ssize_t UringRead (stream_t *p_access, void *p_buffer, size_t i_len)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    ssize_t val = file_uring_Read (p_sys->uring, p_buffer, i_len);
+    if (val < 0)
+    {
+        switch (errno)
+        {
+            case EINTR:
+            case EAGAIN:
+                return -1;
+            case ENOTSUP:
+            {   /* older kernel: carry on with plain reads */
+                uint64_t pos = file_uring_Tell (p_sys->uring);
+
+                msg_Dbg (p_access, "io_uring reads not supported");
+                file_uring_Delete (p_sys->uring);
+                p_sys->uring = NULL;
+                p_access->pf_read = Read;
+                p_access->pf_seek = FileSeek;
+                if (FileSeek (p_access, pos))
+                    return 0;
+                return Read (p_access, p_buffer, i_len);
+            }
+        }
+
+        msg_Err (p_access, "read error: %s", vlc_strerror_c(errno));
+        val = 0;
+    }
+
+    return val;
+}
+
+static int UringSeek (stream_t *p_access, uint64_t i_pos)
+{
+    access_sys_t *sys = p_access->p_sys;
+
+    file_uring_Seek (sys->uring, i_pos);
+    return VLC_SUCCESS;
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
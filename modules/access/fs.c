@@ -39,6 +39,11 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+#ifdef HAVE_LINUX_IO_URING_H
+    add_bool("file-uring", false, N_("Asynchronous file reads"),
+             N_("Keep several reads of local files in flight with io_uring"),
+             true)
+#endif
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
@@ -0,0 +1,280 @@
+/*****************************************************************************
+ * mmap.c: memory-mapped file input
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_access.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+
+#define FILE_MMAP_TEXT N_("Use file memory mapping")
+#define FILE_MMAP_LONGTEXT N_( \
+    "Read local files through memory mappings, without copying the data " \
+    "to intermediate buffers.")
+
+static int  Open (vlc_object_t *);
+static void Close (vlc_object_t *);
+
+vlc_module_begin ()
+    set_shortname (N_("MMap"))
+    set_description (N_("Memory-mapped file input"))
+    set_category (CAT_INPUT)
+    set_subcategory (SUBCAT_INPUT_ACCESS)
+    set_capability ("access", 52)
+    add_shortcut ("file")
+    set_callbacks (Open, Close)
+
+    add_bool ("file-mmap", false, FILE_MMAP_TEXT, FILE_MMAP_LONGTEXT, true)
+vlc_module_end ()
+
+/* Size of the windows handed out as blocks (a multiple of the page size) */
+#define MMAP_SIZE (4 << 20)
+/* Size of the blocks read once the file was truncated */
+#define READ_SIZE (64 << 10)
+
+typedef struct
+{
+    int      fd;
+    uint64_t offset;
+    uint64_t size;
+    size_t   page_size;
+    bool     truncated; /**< Whether the file shrank, so is not mapped */
+} access_sys_t;
+
+#ifndef HAVE_POSIX_FADVISE
+# define posix_fadvise(fd, off, len, adv)
+#endif
+#ifndef HAVE_POSIX_MADVISE
+# define posix_madvise(addr, len, adv)
+#endif
+
+static block_t *Block (stream_t *, bool *);
+static int Seek (stream_t *, uint64_t);
+static int Control (stream_t *, int, va_list);
+
+static int Open (vlc_object_t *p_this)
+{
+    stream_t *p_access = (stream_t *)p_this;
+    const char *path = p_access->psz_filepath;
+
+    if (!var_InheritBool (p_this, "file-mmap") || path == NULL)
+        return VLC_EGENERIC;
+
+    int fd = vlc_open (path, O_RDONLY | O_NOCTTY);
+    if (fd == -1)
+    {
+        msg_Warn (p_access, "cannot open file %s (%s)", path,
+                  vlc_strerror_c(errno));
+        return VLC_EGENERIC;
+    }
+
+    /* Only regular files have a meaningful size to map, leave the rest to
+     * the file input */
+    struct stat st;
+    if (fstat (fd, &st) || !S_ISREG (st.st_mode) || st.st_size == 0)
+        goto error;
+
+    /* Some file systems do not implement mmap() */
+    void *addr = mmap (NULL, 1, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        msg_Dbg (p_access, "cannot map file %s (%s)", path,
+                 vlc_strerror_c(errno));
+        goto error;
+    }
+    munmap (addr, 1);
+
+    access_sys_t *p_sys = vlc_obj_malloc (p_this, sizeof (*p_sys));
+    if (unlikely(p_sys == NULL))
+        goto error;
+
+    p_sys->fd = fd;
+    p_sys->offset = 0;
+    p_sys->size = st.st_size;
+    p_sys->page_size = sysconf (_SC_PAGE_SIZE);
+    p_sys->truncated = false;
+
+    /* Files are mostly read once, from start to end */
+    posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise (fd, 0, MMAP_SIZE, POSIX_FADV_WILLNEED);
+
+    p_access->pf_read = NULL;
+    p_access->pf_block = Block;
+    p_access->pf_seek = Seek;
+    p_access->pf_control = Control;
+    p_access->p_sys = p_sys;
+    return VLC_SUCCESS;
+
+error:
+    vlc_close (fd);
+    return VLC_EGENERIC;
+}
+
+static void Close (vlc_object_t *p_this)
+{
+    stream_t *p_access = (stream_t *)p_this;
+    access_sys_t *p_sys = p_access->p_sys;
+
+    /* Blocks still in use keep their own mapping */
+    vlc_close (p_sys->fd);
+}
+
+/* Reads the file once mapping it is no longer safe */
+static block_t *ReadBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    const size_t length = __MIN(p_sys->size - p_sys->offset, READ_SIZE);
+
+    block_t *block = block_Alloc (length);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    ssize_t val = pread (p_sys->fd, block->p_buffer, length, p_sys->offset);
+    if (val <= 0)
+    {
+        block_Release (block);
+        if (val < 0 && errno == EINTR)
+            return NULL;
+        if (val < 0)
+            msg_Err (p_access, "read error: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    block->i_buffer = val;
+    p_sys->offset += val;
+    return block;
+}
+
+static block_t *Block (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    /* Touching mapped pages past the end of the file raises SIGBUS. Check
+     * the current size before each mapping, and stop mapping altogether if
+     * the file shrank, as it may do so again while the blocks are in use.
+     * The file might also still be growing. */
+    struct stat st;
+
+    if (fstat (p_sys->fd, &st) == 0)
+    {
+        if ((uint64_t)st.st_size < p_sys->size && !p_sys->truncated)
+        {
+            msg_Warn (p_access, "file truncated, reading it instead");
+            p_sys->truncated = true;
+        }
+        p_sys->size = st.st_size;
+    }
+
+    if (p_sys->offset >= p_sys->size)
+    {
+        *eof = true;
+        return NULL;
+    }
+
+    if (p_sys->truncated)
+        return ReadBlock (p_access, eof);
+
+    /* Mappings start on a page boundary */
+    const size_t inner = p_sys->offset % p_sys->page_size;
+    const uint64_t outer = p_sys->offset - inner;
+    const size_t length = __MIN(p_sys->size - outer, MMAP_SIZE);
+
+    void *addr = mmap (NULL, length, PROT_READ, MAP_SHARED, p_sys->fd, outer);
+    if (addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "memory mapping failed (%s)",
+                 vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    posix_madvise (addr, length, POSIX_MADV_SEQUENTIAL);
+    /* Have the next window read while this one is consumed */
+    posix_fadvise (p_sys->fd, outer + length, MMAP_SIZE, POSIX_FADV_WILLNEED);
+
+    block_t *block = block_mmap_Alloc (addr, length);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    block->p_buffer += inner;
+    block->i_buffer -= inner;
+    p_sys->offset = outer + length;
+    return block;
+}
+
+static int Seek (stream_t *p_access, uint64_t i_pos)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    p_sys->offset = i_pos;
+    posix_fadvise (p_sys->fd, i_pos - (i_pos % p_sys->page_size), MMAP_SIZE,
+                   POSIX_FADV_WILLNEED);
+    return VLC_SUCCESS;
+}
+
+static int Control (stream_t *p_access, int query, va_list args)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_FASTSEEK:
+        case STREAM_CAN_PAUSE:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg (args, bool *) = true;
+            break;
+
+        case STREAM_GET_SIZE:
+        {
+            struct stat st;
+
+            if (fstat (p_sys->fd, &st))
+                return VLC_EGENERIC;
+            *va_arg (args, uint64_t *) = st.st_size;
+            break;
+        }
+
+        case STREAM_GET_PTS_DELAY:
+            *va_arg (args, vlc_tick_t *) =
+                VLC_TICK_FROM_MS(var_InheritInteger (p_access, "file-caching"));
+            break;
+
+        case STREAM_SET_PAUSE_STATE:
+            /* Nothing to do */
+            break;
+
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
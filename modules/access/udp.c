@@ -47,15 +47,57 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_RECVMMSG
+# include <sys/socket.h>
+#endif
 
 /* Buffer can be max theoretical datagram content minus anticipated MTU.
  * IPv6 headers are larger than IPv4, ignore IPv6 jumbograms.
  */
 #define MRU 65507u
 
+/* Upper bound of datagrams received at once. Each of them may spill up to
+ * MRU - SLOT_SIZE bytes, so this bounds the overflow buffers to about 4 MiB. */
+#define BATCH_MAX 64
+
+#ifdef HAVE_RECVMMSG
+/* Pooled blocks fit common MTUs (7 TS packets, RTP, Ethernet). Larger
+ * datagrams spill into a per-slot overflow buffer and are copied back. */
+# define SLOT_SIZE 2048u
+# define STATS_INTERVAL VLC_TICK_FROM_SEC(10)
+
+typedef struct {
+    unsigned count; /* slots */
+    unsigned next; /* next received datagram to return */
+    unsigned avail; /* received datagrams */
+
+    block_t **blocks;
+    struct mmsghdr *msgs;
+    struct iovec *iovs;
+    char *overflow;
+# ifdef SO_RXQ_OVFL
+    char *cmsgs;
+# endif
+
+    /* Statistics */
+    uint64_t calls;
+    uint64_t datagrams;
+    uint64_t truncated;
+    uint32_t drops; /* socket receive queue overflows */
+    vlc_tick_t last_report;
+} udp_batch_t;
+
+# ifdef SO_RXQ_OVFL
+#  define CMSG_SIZE CMSG_SPACE(sizeof (uint32_t))
+# endif
+#endif
+
 typedef struct {
     int fd;
     int timeout;
+#ifdef HAVE_RECVMMSG
+    udp_batch_t *batch;
+#endif
 
     size_t length;
     char *offset;
@@ -132,6 +174,185 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
     return val;
 }
 
+#ifdef HAVE_RECVMMSG
+static void BatchReport(stream_t *access, udp_batch_t *batch)
+{
+    if (batch->calls == 0)
+        return;
+
+    msg_Dbg(access, "received %"PRIu64" datagrams in %"PRIu64" calls "
+            "(%.1f per call, batch of %u), %"PRIu32" dropped, "
+            "%"PRIu64" truncated", batch->datagrams, batch->calls,
+            (double)batch->datagrams / batch->calls, batch->count,
+            batch->drops, batch->truncated);
+}
+
+static void BatchDelete(udp_batch_t *batch)
+{
+    for (unsigned i = 0; i < batch->count; i++)
+        if (batch->blocks[i] != NULL)
+            block_Release(batch->blocks[i]);
+    free(batch->blocks);
+    free(batch->msgs);
+    free(batch->iovs);
+    free(batch->overflow);
+# ifdef SO_RXQ_OVFL
+    free(batch->cmsgs);
+# endif
+    free(batch);
+}
+
+static udp_batch_t *BatchNew(unsigned count)
+{
+    udp_batch_t *batch = calloc(1, sizeof (*batch));
+    if (unlikely(batch == NULL))
+        return NULL;
+
+    batch->count = count;
+    batch->blocks = calloc(count, sizeof (*batch->blocks));
+    batch->msgs = calloc(count, sizeof (*batch->msgs));
+    batch->iovs = calloc(count * 2, sizeof (*batch->iovs));
+    batch->overflow = malloc(count * (MRU - SLOT_SIZE));
+# ifdef SO_RXQ_OVFL
+    batch->cmsgs = malloc(count * CMSG_SIZE);
+    if (unlikely(batch->cmsgs == NULL))
+    {
+        BatchDelete(batch);
+        return NULL;
+    }
+# endif
+    if (unlikely(batch->blocks == NULL || batch->msgs == NULL
+              || batch->iovs == NULL || batch->overflow == NULL))
+    {
+        BatchDelete(batch);
+        return NULL;
+    }
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        struct iovec *iov = &batch->iovs[2 * i];
+
+        iov[1].iov_base = batch->overflow + i * (MRU - SLOT_SIZE);
+        iov[1].iov_len = MRU - SLOT_SIZE;
+        batch->msgs[i].msg_hdr.msg_iov = iov;
+        batch->msgs[i].msg_hdr.msg_iovlen = 2;
+    }
+    batch->last_report = vlc_tick_now();
+    return batch;
+}
+
+static block_t *BatchPop(udp_batch_t *batch)
+{
+    while (batch->next < batch->avail)
+    {
+        block_t *block = batch->blocks[batch->next];
+
+        batch->blocks[batch->next++] = NULL;
+        if (block == NULL)
+            continue;
+        /* empty (0 bytes) payload does *not* mean EOF here */
+        if (block->i_buffer > 0)
+            return block;
+        block_Release(block);
+    }
+    return NULL;
+}
+
+static block_t *BlockBatch(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+    udp_batch_t *batch = sys->batch;
+
+    /* Return datagrams from the last batch first */
+    if (batch->next < batch->avail)
+        return BatchPop(batch);
+
+    struct pollfd ufd[1];
+
+    ufd[0].fd = sys->fd;
+    ufd[0].events = POLLIN;
+
+    switch (vlc_poll_i11e(ufd, 1, sys->timeout)) {
+        case 0:
+            msg_Err(access, "receive time-out");
+            *eof = true;
+            /* fall through */
+        case -1:
+            return NULL;
+    }
+
+    /* Replace the blocks handed out since the previous call */
+    unsigned count;
+    for (count = 0; count < batch->count; count++)
+    {
+        struct msghdr *hdr = &batch->msgs[count].msg_hdr;
+
+        if (batch->blocks[count] == NULL)
+        {
+            batch->blocks[count] = block_Alloc(SLOT_SIZE);
+            if (unlikely(batch->blocks[count] == NULL))
+                break;
+        }
+        hdr->msg_iov[0].iov_base = batch->blocks[count]->p_buffer;
+        hdr->msg_iov[0].iov_len = SLOT_SIZE;
+# ifdef SO_RXQ_OVFL
+        hdr->msg_control = batch->cmsgs + count * CMSG_SIZE;
+        hdr->msg_controllen = CMSG_SIZE;
+# endif
+    }
+    if (unlikely(count == 0))
+        return NULL;
+
+    int val = recvmmsg(sys->fd, batch->msgs, count, MSG_DONTWAIT, NULL);
+    if (val <= 0)
+        return NULL;
+
+    batch->calls++;
+    batch->datagrams += val;
+
+    for (int i = 0; i < val; i++)
+    {
+        struct msghdr *hdr = &batch->msgs[i].msg_hdr;
+        block_t *block = batch->blocks[i];
+        size_t len = batch->msgs[i].msg_len;
+
+        if (hdr->msg_flags & MSG_TRUNC)
+            batch->truncated++;
+
+        if (len > SLOT_SIZE)
+        {   /* Rare oversized datagram: move the tail into the block */
+            block = block_Realloc(block, 0, len);
+            if (likely(block != NULL))
+                memcpy(block->p_buffer + SLOT_SIZE, hdr->msg_iov[1].iov_base,
+                       len - SLOT_SIZE);
+            batch->blocks[i] = block;
+        }
+        else
+            block->i_buffer = len;
+
+# ifdef SO_RXQ_OVFL
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr); cmsg != NULL;
+             cmsg = CMSG_NXTHDR(hdr, cmsg))
+            if (cmsg->cmsg_level == SOL_SOCKET
+             && cmsg->cmsg_type == SO_RXQ_OVFL)
+                memcpy(&batch->drops, CMSG_DATA(cmsg), sizeof (batch->drops));
+# endif
+    }
+
+    batch->next = 0;
+    batch->avail = val;
+
+    vlc_tick_t now = vlc_tick_now();
+    if (now - batch->last_report >= STATS_INTERVAL)
+    {
+        BatchReport(access, batch);
+        batch->last_report = now;
+    }
+
+    return BatchPop(batch);
+}
+#endif
+
 /*****************************************************************************
  * Open: open the socket
  *****************************************************************************/
@@ -217,6 +438,27 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+#ifdef HAVE_RECVMMSG
+    sys->batch = NULL;
+
+    int64_t i_batch = var_InheritInteger( p_access, "udp-batch" );
+    if( i_batch > 1 )
+    {
+        sys->batch = BatchNew( __MIN( i_batch, BATCH_MAX ) );
+        if( unlikely(sys->batch == NULL) )
+        {
+            net_Close( sys->fd );
+            return VLC_ENOMEM;
+        }
+# ifdef SO_RXQ_OVFL
+        setsockopt( sys->fd, SOL_SOCKET, SO_RXQ_OVFL, &(int){ 1 },
+                    sizeof (int) );
+# endif
+        p_access->pf_read = NULL;
+        p_access->pf_block = BlockBatch;
+    }
+#endif
+
     return VLC_SUCCESS;
 }
 
@@ -228,10 +470,21 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_RECVMMSG
+    if( sys->batch != NULL )
+    {
+        BatchReport( p_access, sys->batch );
+        BatchDelete( sys->batch );
+    }
+#endif
     net_Close( sys->fd );
 }
 
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
+#define BATCH_TEXT N_("Datagrams received per system call")
+#define BATCH_LONGTEXT N_("Receive up to this number of datagrams at once, " \
+    "each directly into its own block. Receive statistics are logged " \
+    "periodically. 1 disables batching.")
 
 vlc_module_begin()
     set_shortname(N_("UDP"))
@@ -242,6 +495,8 @@ vlc_module_begin()
     add_obsolete_integer("server-port") /* since 2.0.0 */
     add_obsolete_integer("udp-buffer") /* since 3.0.0 */
     add_integer("udp-timeout", -1, TIMEOUT_TEXT, NULL, true)
+    add_integer_with_range("udp-batch", 1, 1, BATCH_MAX, BATCH_TEXT,
+                           BATCH_LONGTEXT, true)
 
     set_capability("access", 0)
     add_shortcut("udp", "udpstream", "udp4", "udp6")
@@ -0,0 +1,394 @@
+/*****************************************************************************
+ * uring.c: io_uring file reader
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+#include "uring.h"
+
+#define URING_DEPTH    8
+#define URING_BUF_SIZE (512 * 1024)
+
+struct uring_slot
+{
+    uint64_t offset;
+    size_t   consumed;
+    int      res; /* bytes read, or minus the error number */
+    bool     pending;
+    struct iovec iov;
+};
+
+struct file_uring
+{
+    vlc_object_t *obj;
+    int fd;
+    int ring_fd;
+    bool fixed; /* registered buffers */
+    bool started; /* a read succeeded */
+    bool failed; /* the ring is unusable, reads may still be in flight */
+
+    /* submission queue */
+    void *sq_ring;
+    size_t sq_ring_size;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    /* completion queue */
+    void *cq_ring;
+    size_t cq_ring_size;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    /* read slots, used as a FIFO from head */
+    uint8_t *buffers;
+    struct uring_slot slots[URING_DEPTH];
+    unsigned head;
+    unsigned count;
+    unsigned inflight;
+    unsigned unsubmitted;
+    uint64_t next; /* file offset of the next submitted read */
+};
+
+static int uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(int fd, unsigned submit, unsigned complete,
+                       unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, fd, submit, complete, flags,
+                   NULL, 0);
+}
+
+static int uring_register(int fd, unsigned opcode, const void *arg,
+                          unsigned count)
+{
+    return syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+static uint8_t *SlotBuffer(file_uring_t *u, unsigned i)
+{
+    return u->buffers + (size_t)i * URING_BUF_SIZE;
+}
+
+static void Queue(file_uring_t *u, unsigned i)
+{
+    struct uring_slot *slot = &u->slots[i];
+    unsigned tail = *u->sq_tail;
+    unsigned index = tail & *u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[index];
+    uint8_t *buf = SlotBuffer(u, i);
+
+    memset(sqe, 0, sizeof (*sqe));
+    sqe->fd = u->fd;
+    sqe->off = slot->offset;
+    sqe->user_data = i;
+    if (u->fixed)
+    {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = (uintptr_t)buf;
+        sqe->len = URING_BUF_SIZE;
+        sqe->buf_index = i;
+    }
+    else
+    {   /* IORING_OP_READ needs Linux 5.6, READV is there since 5.1 */
+        slot->iov.iov_base = buf;
+        slot->iov.iov_len = URING_BUF_SIZE;
+        sqe->opcode = IORING_OP_READV;
+        sqe->addr = (uintptr_t)&slot->iov;
+        sqe->len = 1;
+    }
+    u->sq_array[index] = index;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    slot->consumed = 0;
+    slot->pending = true;
+    u->inflight++;
+    u->unsubmitted++;
+}
+
+/* Hands the queued reads to the kernel, and optionally waits for one */
+static int Enter(file_uring_t *u, bool wait)
+{
+    int val = uring_enter(u->ring_fd, u->unsubmitted, wait,
+                          wait ? IORING_ENTER_GETEVENTS : 0);
+    if (val < 0)
+        return (errno == EINTR || errno == EAGAIN) ? 0 : -1;
+    u->unsubmitted -= val;
+    return 0;
+}
+
+/* Keeps all the free slots busy reading ahead. Failed submissions are
+ * retried when waiting. */
+static void Refill(file_uring_t *u)
+{
+    while (u->count < URING_DEPTH)
+    {
+        unsigned i = (u->head + u->count) % URING_DEPTH;
+
+        u->slots[i].offset = u->next;
+        Queue(u, i);
+        u->next += URING_BUF_SIZE;
+        u->count++;
+    }
+    Enter(u, false);
+}
+
+static void Reap(file_uring_t *u)
+{
+    unsigned head = *u->cq_head;
+
+    while (head != __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE))
+    {
+        const struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+        struct uring_slot *slot = &u->slots[cqe->user_data];
+
+        slot->res = cqe->res;
+        slot->pending = false;
+        u->inflight--;
+        head++;
+    }
+    __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static int Wait(file_uring_t *u)
+{
+    if (u->failed)
+        return -1;
+
+    Reap(u);
+    while (u->slots[u->head].pending || (u->count == 0 && u->inflight > 0))
+    {
+        if (Enter(u, true))
+        {   /* the kernel may still own the buffers: keep them until the
+             * ring is deleted, and leak them if reads are in flight */
+            msg_Err(u->obj, "io_uring wait error: %s", vlc_strerror_c(errno));
+            u->failed = true;
+            return -1;
+        }
+        Reap(u);
+    }
+    return 0;
+}
+
+/* Forgets the read ahead data, once the kernel is done with the buffers */
+static void Drain(file_uring_t *u)
+{
+    u->count = 0;
+    Wait(u);
+    u->head = 0;
+}
+
+ssize_t file_uring_Read(file_uring_t *u, void *buf, size_t len)
+{
+    if (u->failed)
+    {
+        errno = EIO;
+        return -1;
+    }
+
+    if (u->count == 0)
+        Refill(u);
+
+    struct uring_slot *slot = &u->slots[u->head];
+    if (Wait(u))
+    {
+        errno = EIO;
+        return -1;
+    }
+
+    if (slot->res < 0)
+    {   /* the next read will try again from there */
+        int err = -slot->res;
+
+        u->next = slot->offset;
+        Drain(u);
+        /* the kernel does not support the read operation on this file */
+        if (err == EINVAL && !u->started)
+            err = ENOTSUP;
+        errno = err;
+        return -1;
+    }
+    u->started = true;
+
+    size_t avail = slot->res - slot->consumed;
+    if (len > avail)
+        len = avail;
+    memcpy(buf, SlotBuffer(u, u->head) + slot->consumed, len);
+    slot->consumed += len;
+
+    if (slot->consumed == (size_t)slot->res)
+    {
+        if (slot->res < URING_BUF_SIZE)
+        {   /* end of file (for now): the next reads are useless */
+            u->next = slot->offset + slot->res;
+            Drain(u);
+        }
+        else
+        {
+            u->head = (u->head + 1) % URING_DEPTH;
+            u->count--;
+            Refill(u);
+        }
+    }
+    return len;
+}
+
+uint64_t file_uring_Tell(const file_uring_t *u)
+{
+    if (u->count > 0)
+    {
+        const struct uring_slot *slot = &u->slots[u->head];
+        return slot->offset + slot->consumed;
+    }
+    return u->next;
+}
+
+void file_uring_Seek(file_uring_t *u, uint64_t offset)
+{
+    if (u->count > 0)
+    {
+        struct uring_slot *slot = &u->slots[u->head];
+
+        /* small forward skip within the current buffer */
+        if (!slot->pending && slot->res > 0
+         && offset >= slot->offset + slot->consumed
+         && offset < slot->offset + slot->res)
+        {
+            slot->consumed = offset - slot->offset;
+            return;
+        }
+        Drain(u);
+    }
+    u->next = offset;
+}
+
+file_uring_t *file_uring_New(vlc_object_t *obj, int fd, uint64_t offset)
+{
+    file_uring_t *u = calloc(1, sizeof (*u));
+    if (unlikely(u == NULL))
+        return NULL;
+
+    u->obj = obj;
+    u->fd = fd;
+    u->next = offset;
+    u->sq_ring = u->cq_ring = u->sqes = MAP_FAILED;
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof (p));
+    u->ring_fd = uring_setup(URING_DEPTH, &p);
+    if (u->ring_fd == -1)
+    {
+        msg_Dbg(obj, "io_uring not available: %s", vlc_strerror_c(errno));
+        free(u);
+        return NULL;
+    }
+
+    u->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+    u->cq_ring_size = p.cq_off.cqes
+                    + p.cq_entries * sizeof (struct io_uring_cqe);
+    u->sqes_size = p.sq_entries * sizeof (struct io_uring_sqe);
+
+    u->sq_ring = mmap(NULL, u->sq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, u->ring_fd,
+                      IORING_OFF_SQ_RING);
+    u->cq_ring = mmap(NULL, u->cq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, u->ring_fd,
+                      IORING_OFF_CQ_RING);
+    u->sqes = mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, u->ring_fd, IORING_OFF_SQES);
+    if (u->sq_ring == MAP_FAILED || u->cq_ring == MAP_FAILED
+     || u->sqes == MAP_FAILED)
+        goto error;
+
+    uint8_t *sq = u->sq_ring, *cq = u->cq_ring;
+    u->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    u->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)(sq + p.sq_off.array);
+    u->cq_head = (unsigned *)(cq + p.cq_off.head);
+    u->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    u->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    u->buffers = aligned_alloc(4096, URING_DEPTH * URING_BUF_SIZE);
+    if (unlikely(u->buffers == NULL))
+        goto error;
+
+    /* Registered buffers spare the kernel a page walk per read, but are
+     * subject to the locked memory limit */
+    struct iovec iov[URING_DEPTH];
+    for (unsigned i = 0; i < URING_DEPTH; i++)
+    {
+        iov[i].iov_base = SlotBuffer(u, i);
+        iov[i].iov_len = URING_BUF_SIZE;
+    }
+    u->fixed = uring_register(u->ring_fd, IORING_REGISTER_BUFFERS,
+                              iov, URING_DEPTH) == 0;
+
+    msg_Dbg(obj, "using io_uring, %u reads of %u KiB in flight%s",
+            URING_DEPTH, URING_BUF_SIZE / 1024,
+            u->fixed ? ", registered buffers" : "");
+    return u;
+
+error:
+    file_uring_Delete(u);
+    return NULL;
+}
+
+void file_uring_Delete(file_uring_t *u)
+{
+    if (u->buffers != NULL)
+        Drain(u);
+    if (u->inflight > 0)
+    {   /* the kernel may still write into the buffers */
+        msg_Warn(u->obj, "leaking io_uring buffers");
+        u->buffers = NULL;
+    }
+
+    if (u->sqes != MAP_FAILED)
+        munmap(u->sqes, u->sqes_size);
+    if (u->cq_ring != MAP_FAILED)
+        munmap(u->cq_ring, u->cq_ring_size);
+    if (u->sq_ring != MAP_FAILED)
+        munmap(u->sq_ring, u->sq_ring_size);
+    close(u->ring_fd);
+    free(u->buffers);
+    free(u);
+}
+#endif
@@ -0,0 +1,43 @@
+/*****************************************************************************
+ * uring.h: io_uring file reader
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_ACCESS_URING_H
+#define VLC_ACCESS_URING_H
+
+/* Sequential reader keeping several reads of a regular file in flight, into
+ * buffers registered with the kernel. Reads are completed by the calling
+ * thread, no helper thread is involved. */
+
+typedef struct file_uring file_uring_t;
+
+/* Returns NULL if io_uring is not available, in which case the caller
+ * should fall back to read() */
+file_uring_t *file_uring_New(vlc_object_t *, int fd, uint64_t offset);
+void file_uring_Delete(file_uring_t *);
+
+/* Same semantics as read(): returns 0 at end of file, or -1 and sets errno
+ * on error. ENOTSUP means that the kernel cannot read the file this way,
+ * in which case the caller should fall back to read() from
+ * file_uring_Tell(). */
+ssize_t file_uring_Read(file_uring_t *, void *, size_t);
+uint64_t file_uring_Tell(const file_uring_t *);
+void file_uring_Seek(file_uring_t *, uint64_t);
+
+#endif
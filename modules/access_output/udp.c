@@ -45,11 +45,19 @@
 #elif defined (HAVE_SYS_SOCKET_H)
 #   include <sys/socket.h>
 #endif
+#ifdef HAVE_SENDMMSG
+#   include <sys/uio.h>
+#   include <time.h>
+#   include <linux/net_tstamp.h>
+#endif
 
 #include <vlc_network.h>
 
 #define MAX_EMPTY_BLOCKS 200
 
+/* Upper bound of datagrams sent at once */
+#define BATCH_MAX 1024
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -70,6 +78,21 @@ static void Close( vlc_object_t * );
                           "helps reducing the scheduling load on " \
                           "heavily-loaded systems." )
 
+#define BATCH_TEXT N_("Packets sent per system call")
+#define BATCH_LONGTEXT N_("Hand up to this number of packets to the kernel " \
+                          "at once. Transmission statistics, including " \
+                          "timing jitter and late packets, are logged " \
+                          "periodically. This replaces grouping. " \
+                          "1 disables batching." )
+
+#define TXTIME_TEXT N_("Kernel pacing")
+#define TXTIME_LONGTEXT N_("Give each packet its transmission time " \
+                           "(SO_TXTIME), and hand it to the kernel ahead " \
+                           "of time, so that the kernel paces packets " \
+                           "rather than the sending thread. This requires " \
+                           "the fq queuing discipline on the outgoing " \
+                           "interface." )
+
 vlc_module_begin ()
     set_description( N_("UDP stream output") )
     set_shortname( "UDP" )
@@ -78,6 +101,10 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000, CACHING_TEXT, CACHING_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "group", 1, GROUP_TEXT, GROUP_LONGTEXT,
                                  true )
+    add_integer_with_range( SOUT_CFG_PREFIX "batch", 1, 1, BATCH_MAX,
+                            BATCH_TEXT, BATCH_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "txtime", false, TXTIME_TEXT, TXTIME_LONGTEXT,
+              true )
 
     set_capability( "sout access", 0 )
     add_shortcut( "udp" )
@@ -91,6 +118,8 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "caching",
     "group",
+    "batch",
+    "txtime",
     NULL
 };
 
@@ -107,6 +136,44 @@ static int Control( sout_access_out_t *, int, va_list );
 
 static void* ThreadWrite( void * );
 
+#ifdef HAVE_SENDMMSG
+/* How long ahead packets are handed to the kernel with their transmission
+ * time, and without, how early they may be sent to fill a batch */
+# define TXTIME_HORIZON VLC_TICK_FROM_MS(10)
+# define BATCH_SLACK    VLC_TICK_FROM_MS(1)
+/* Packets leaving later than this after their date are counted as late */
+# define LATE_MARGIN    VLC_TICK_FROM_MS(1)
+# define STATS_INTERVAL VLC_TICK_FROM_SEC(10)
+# define TXTIME_CMSG_SIZE CMSG_SPACE(sizeof (uint64_t))
+
+typedef struct
+{
+    unsigned max; /* slots */
+    unsigned count; /* packets in the current batch */
+    bool txtime;
+
+    block_t **blocks;
+    vlc_tick_t *dates;
+    struct mmsghdr *msgs;
+    struct iovec *iovs;
+    char *cmsgs;
+    block_t *pending; /* first packet of the next batch */
+    vlc_tick_t date_last; /* date of the last packet taken */
+    unsigned dropped; /* packets dropped after a hole */
+
+    /* Statistics */
+    uint64_t calls;
+    uint64_t datagrams;
+    uint64_t late;
+    uint64_t errors;
+    vlc_tick_t deviation; /* sum of the absolute timing deviations */
+    vlc_tick_t deviation_max;
+    vlc_tick_t last_report;
+} udp_batch_t;
+
+static void* ThreadBatch( void * );
+#endif
+
 typedef struct
 {
     vlc_tick_t    i_caching;
@@ -116,12 +183,105 @@ typedef struct
 
     block_fifo_t *p_fifo;
     block_t      *p_buffer;
+#ifdef HAVE_SENDMMSG
+    udp_batch_t  *p_batch;
+#endif
 
     vlc_thread_t  thread;
 } sout_access_out_sys_t;
 
 #define DEFAULT_PORT 1234
 
+#ifdef HAVE_SENDMMSG
+static void BatchReport( sout_access_out_t *p_access, udp_batch_t *p_batch )
+{
+    if( p_batch->datagrams == 0 )
+        return;
+
+    msg_Dbg( p_access, "sent %"PRIu64" datagrams in %"PRIu64" calls "
+             "(%.1f per call, batch of %u%s), jitter %"PRId64" us mean, "
+             "%"PRId64" us max, %"PRIu64" late, %"PRIu64" errors",
+             p_batch->datagrams, p_batch->calls,
+             p_batch->calls ? (double)p_batch->datagrams / p_batch->calls : 0.,
+             p_batch->max,
+             p_batch->txtime ? ", kernel paced" : "",
+             US_FROM_VLC_TICK( p_batch->deviation / p_batch->datagrams ),
+             US_FROM_VLC_TICK( p_batch->deviation_max ),
+             p_batch->late, p_batch->errors );
+}
+
+static void BatchClear( void *data )
+{
+    udp_batch_t *p_batch = data;
+
+    for( unsigned i = 0; i < p_batch->count; i++ )
+        block_Release( p_batch->blocks[i] );
+    p_batch->count = 0;
+    if( p_batch->pending != NULL )
+    {
+        block_Release( p_batch->pending );
+        p_batch->pending = NULL;
+    }
+}
+
+static void BatchDelete( udp_batch_t *p_batch )
+{
+    BatchClear( p_batch );
+    free( p_batch->blocks );
+    free( p_batch->dates );
+    free( p_batch->msgs );
+    free( p_batch->iovs );
+    free( p_batch->cmsgs );
+    free( p_batch );
+}
+
+static udp_batch_t *BatchNew( unsigned max, bool txtime )
+{
+    udp_batch_t *p_batch = calloc( 1, sizeof (*p_batch) );
+    if( unlikely(p_batch == NULL) )
+        return NULL;
+
+    p_batch->max = max;
+    p_batch->txtime = txtime;
+    p_batch->blocks = calloc( max, sizeof (*p_batch->blocks) );
+    p_batch->dates = calloc( max, sizeof (*p_batch->dates) );
+    p_batch->msgs = calloc( max, sizeof (*p_batch->msgs) );
+    p_batch->iovs = calloc( max, sizeof (*p_batch->iovs) );
+    p_batch->cmsgs = calloc( max, TXTIME_CMSG_SIZE );
+    if( unlikely(p_batch->blocks == NULL || p_batch->dates == NULL
+              || p_batch->msgs == NULL || p_batch->iovs == NULL
+              || p_batch->cmsgs == NULL) )
+    {
+        BatchDelete( p_batch );
+        return NULL;
+    }
+
+    for( unsigned i = 0; i < max; i++ )
+    {
+        struct msghdr *hdr = &p_batch->msgs[i].msg_hdr;
+
+        hdr->msg_iov = &p_batch->iovs[i];
+        hdr->msg_iovlen = 1;
+# ifdef SO_TXTIME
+        if( txtime )
+        {
+            struct cmsghdr *cmsg =
+                (struct cmsghdr *)(p_batch->cmsgs + i * TXTIME_CMSG_SIZE);
+
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_TXTIME;
+            cmsg->cmsg_len = CMSG_LEN(sizeof (uint64_t));
+            hdr->msg_control = cmsg;
+            hdr->msg_controllen = TXTIME_CMSG_SIZE;
+        }
+# endif
+    }
+    p_batch->date_last = -1;
+    p_batch->last_report = vlc_tick_now();
+    return p_batch;
+}
+#endif
+
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -209,10 +369,52 @@ static int Open( vlc_object_t *p_this )
     p_sys->p_fifo = block_FifoNew();
     p_sys->p_buffer = NULL;
 
-    if( vlc_clone( &p_sys->thread, ThreadWrite, p_access,
+    void *(*thread)( void * ) = ThreadWrite;
+#ifdef HAVE_SENDMMSG
+    p_sys->p_batch = NULL;
+
+    int64_t i_batch = var_GetInteger( p_access, SOUT_CFG_PREFIX "batch" );
+    bool b_txtime = var_GetBool( p_access, SOUT_CFG_PREFIX "txtime" );
+    if( b_txtime )
+    {
+# ifdef SO_TXTIME
+        /* vlc_tick_now() runs on the monotonic clock */
+        const struct sock_txtime txtime = { .clockid = CLOCK_MONOTONIC };
+
+        if( setsockopt( i_handle, SOL_SOCKET, SO_TXTIME, &txtime,
+                        sizeof (txtime) ) )
+        {
+            msg_Warn( p_access, "kernel pacing not available: %s",
+                      vlc_strerror_c(errno) );
+            b_txtime = false;
+        }
+# else
+        msg_Warn( p_access, "kernel pacing not supported" );
+        b_txtime = false;
+# endif
+    }
+    if( i_batch > 1 || b_txtime )
+    {
+        p_sys->p_batch = BatchNew( __MIN( i_batch, BATCH_MAX ), b_txtime );
+        if( unlikely(p_sys->p_batch == NULL) )
+        {
+            block_FifoRelease( p_sys->p_fifo );
+            net_Close (i_handle);
+            free (p_sys);
+            return VLC_ENOMEM;
+        }
+        thread = ThreadBatch;
+    }
+#endif
+
+    if( vlc_clone( &p_sys->thread, thread, p_access,
                            VLC_THREAD_PRIORITY_HIGHEST ) )
     {
         msg_Err( p_access, "cannot spawn sout access thread" );
+#ifdef HAVE_SENDMMSG
+        if( p_sys->p_batch != NULL )
+            BatchDelete( p_sys->p_batch );
+#endif
         block_FifoRelease( p_sys->p_fifo );
         net_Close (i_handle);
         free (p_sys);
@@ -235,6 +437,13 @@ static void Close( vlc_object_t * p_this )
 
     vlc_cancel( p_sys->thread );
     vlc_join( p_sys->thread, NULL );
+#ifdef HAVE_SENDMMSG
+    if( p_sys->p_batch != NULL )
+    {
+        BatchReport( p_access, p_sys->p_batch );
+        BatchDelete( p_sys->p_batch );
+    }
+#endif
     block_FifoRelease( p_sys->p_fifo );
 
     if( p_sys->p_buffer ) block_Release( p_sys->p_buffer );
@@ -419,3 +628,149 @@ static void* ThreadWrite( void *data )
     }
     return NULL;
 }
+
+#ifdef HAVE_SENDMMSG
+/* Adds a packet to the batch, unless it is due later than the given date */
+static bool BatchAdd( udp_batch_t *p_batch, block_t *p_pk, vlc_tick_t i_date,
+                      vlc_tick_t i_limit )
+{
+    if( i_date > i_limit )
+    {
+        p_batch->pending = p_pk;
+        return false;
+    }
+
+    const unsigned i = p_batch->count++;
+
+    p_batch->blocks[i] = p_pk;
+    p_batch->dates[i] = i_date;
+    p_batch->iovs[i].iov_base = p_pk->p_buffer;
+    p_batch->iovs[i].iov_len = p_pk->i_buffer;
+    if( p_batch->txtime )
+    {
+        uint64_t ns = NS_FROM_VLC_TICK( i_date );
+        memcpy( CMSG_DATA(CMSG_FIRSTHDR(&p_batch->msgs[i].msg_hdr)), &ns,
+                sizeof (ns) );
+    }
+    return true;
+}
+
+static void BatchSend( sout_access_out_t *p_access, udp_batch_t *p_batch )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    const vlc_tick_t now = vlc_tick_now();
+
+    for( unsigned i = 0; i < p_batch->count; i++ )
+    {
+        /* Kernel paced packets handed over early leave on time */
+        vlc_tick_t i_deviation = now - p_batch->dates[i];
+        if( i_deviation < 0 )
+            i_deviation = p_batch->txtime ? 0 : -i_deviation;
+        else if( i_deviation > LATE_MARGIN )
+            p_batch->late++;
+
+        p_batch->deviation += i_deviation;
+        if( i_deviation > p_batch->deviation_max )
+            p_batch->deviation_max = i_deviation;
+    }
+
+    for( unsigned i = 0; i < p_batch->count; )
+    {
+        int val = sendmmsg( p_sys->i_handle, &p_batch->msgs[i],
+                            p_batch->count - i, 0 );
+        if( val <= 0 )
+        {
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+            p_batch->errors += p_batch->count - i;
+            break;
+        }
+        p_batch->calls++;
+        i += val;
+    }
+    p_batch->datagrams += p_batch->count;
+
+    for( unsigned i = 0; i < p_batch->count; i++ )
+        block_Release( p_batch->blocks[i] );
+    p_batch->count = 0;
+
+    if( now - p_batch->last_report >= STATS_INTERVAL )
+    {
+        BatchReport( p_access, p_batch );
+        p_batch->last_report = now;
+    }
+}
+
+/*****************************************************************************
+ * ThreadBatch: hand packets to the kernel in batches, with their date when
+ * the kernel paces them.
+ *****************************************************************************/
+static void* ThreadBatch( void *data )
+{
+    sout_access_out_t *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    udp_batch_t *p_batch = p_sys->p_batch;
+    const vlc_tick_t i_horizon = p_batch->txtime ? TXTIME_HORIZON
+                                                 : BATCH_SLACK;
+
+    vlc_cleanup_push( BatchClear, p_batch );
+    for (;;)
+    {
+        block_t *p_pk = p_batch->pending;
+
+        p_batch->pending = NULL;
+        if( p_pk == NULL )
+            p_pk = block_FifoGet( p_sys->p_fifo );
+
+        vlc_tick_t i_date = p_sys->i_caching + p_pk->i_dts;
+        if( p_batch->date_last > 0
+         && i_date - p_batch->date_last > VLC_TICK_FROM_SEC(2) )
+        {
+            if( !p_batch->dropped )
+                msg_Dbg( p_access, "mmh, hole (%"PRId64" > 2s) -> drop",
+                         i_date - p_batch->date_last );
+            block_Release( p_pk );
+            p_batch->date_last = i_date;
+            p_batch->dropped++;
+            continue;
+        }
+        if( p_batch->dropped )
+        {
+            msg_Dbg( p_access, "dropped %u packets", p_batch->dropped );
+            p_batch->dropped = 0;
+        }
+        p_batch->date_last = i_date;
+
+        /* Wake up once per batch, when the first packet is due (less the
+         * horizon), then take every packet due within the horizon */
+        p_batch->pending = p_pk;
+        vlc_tick_wait( i_date - i_horizon );
+        p_batch->pending = NULL;
+
+        const vlc_tick_t i_limit = vlc_tick_now() + i_horizon;
+        BatchAdd( p_batch, p_pk, i_date, INT64_MAX );
+
+        while( p_batch->count < p_batch->max )
+        {
+            vlc_fifo_Lock( p_sys->p_fifo );
+            p_pk = vlc_fifo_DequeueUnlocked( p_sys->p_fifo );
+            vlc_fifo_Unlock( p_sys->p_fifo );
+            if( p_pk == NULL )
+                break;
+
+            i_date = p_sys->i_caching + p_pk->i_dts;
+            if( i_date - p_batch->date_last > VLC_TICK_FROM_SEC(2) )
+            {   /* left for the next round to drop */
+                p_batch->pending = p_pk;
+                break;
+            }
+            if( !BatchAdd( p_batch, p_pk, i_date, i_limit ) )
+                break;
+            p_batch->date_last = i_date;
+        }
+
+        BatchSend( p_access, p_batch );
+    }
+    vlc_cleanup_pop();
+    return NULL;
+}
+#endif
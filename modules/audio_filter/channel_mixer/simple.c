@@ -51,11 +51,12 @@ static block_t *Filter( filter_t *, block_t * );
 static void DoWork_7_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
         float ctr = p_src[6] * 0.7071f;
-        *p_dest++ = ctr + p_src[0] + p_src[2] / 4 + p_src[4] / 4;
-        *p_dest++ = ctr + p_src[1] + p_src[3] / 4 + p_src[5] / 4;
+        *p_dest++ = gain * (ctr + p_src[0] + p_src[2] / 4 + p_src[4] / 4);
+        *p_dest++ = gain * (ctr + p_src[1] + p_src[3] / 4 + p_src[5] / 4);
 
         p_src += 7;
 
@@ -66,14 +67,14 @@ static void DoWork_7_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t
 static void DoWork_6_1_to_2_0( filter_t *p_filter, block_t *p_in_buf,
                                block_t *p_out_buf )
 {
-    VLC_UNUSED(p_filter);
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
         float ctr = (p_src[2] + p_src[5]) * 0.7071f;
-        *p_dest++ = p_src[0] + p_src[3] + ctr;
-        *p_dest++ = p_src[1] + p_src[4] + ctr;
+        *p_dest++ = gain * (p_src[0] + p_src[3] + ctr);
+        *p_dest++ = gain * (p_src[1] + p_src[4] + ctr);
 
         p_src += 6;
 
@@ -85,10 +86,11 @@ static void DoWork_6_1_to_2_0( filter_t *p_filter, block_t *p_in_buf,
 static void DoWork_5_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
-        *p_dest++ = p_src[0] + 0.7071f * (p_src[4] + p_src[2]);
-        *p_dest++ = p_src[1] + 0.7071f * (p_src[4] + p_src[3]);
+        *p_dest++ = gain * (p_src[0] + 0.7071f * (p_src[4] + p_src[2]));
+        *p_dest++ = gain * (p_src[1] + 0.7071f * (p_src[4] + p_src[3]));
 
         p_src += 5;
 
@@ -97,13 +99,13 @@ static void DoWork_5_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t
 }
 
 static void DoWork_4_0_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
-        *p_dest++ = p_src[2] + p_src[3] + 0.5f * p_src[0];
-        *p_dest++ = p_src[2] + p_src[3] + 0.5f * p_src[1];
+        *p_dest++ = gain * (p_src[2] + p_src[3] + 0.5f * p_src[0]);
+        *p_dest++ = gain * (p_src[2] + p_src[3] + 0.5f * p_src[1]);
         p_src += 4;
     }
 }
@@ -111,10 +113,11 @@ static void DoWork_4_0_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t
 static void DoWork_3_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
-        *p_dest++ = p_src[2] + 0.5f * p_src[0];
-        *p_dest++ = p_src[2] + 0.5f * p_src[1];
+        *p_dest++ = gain * (p_src[2] + 0.5f * p_src[0]);
+        *p_dest++ = gain * (p_src[2] + 0.5f * p_src[1]);
 
         p_src += 3;
 
@@ -125,9 +128,10 @@ static void DoWork_3_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t
 static void DoWork_7_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
-        *p_dest++ = p_src[6] + p_src[0] / 4 + p_src[1] / 4 + p_src[2] / 8 + p_src[3] / 8 + p_src[4] / 8 + p_src[5] / 8;
+        *p_dest++ = gain * (p_src[6] + p_src[0] / 4 + p_src[1] / 4 + p_src[2] / 8 + p_src[3] / 8 + p_src[4] / 8 + p_src[5] / 8);
 
         p_src += 7;
 
@@ -138,10 +142,11 @@ static void DoWork_7_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t
 static void DoWork_5_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
-        *p_dest++ = 0.7071f * (p_src[0] + p_src[1]) + p_src[4]
-                     + 0.5f * (p_src[2] + p_src[3]);
+        *p_dest++ = gain * (0.7071f * (p_src[0] + p_src[1]) + p_src[4]
+                            + 0.5f * (p_src[2] + p_src[3]));
 
         p_src += 5;
 
@@ -150,12 +155,12 @@ static void DoWork_5_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t
 }
 
 static void DoWork_4_0_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
-        *p_dest++ = p_src[2] + p_src[3] + p_src[0] / 4 + p_src[1] / 4;
+        *p_dest++ = gain * (p_src[2] + p_src[3] + p_src[0] / 4 + p_src[1] / 4);
         p_src += 4;
     }
 }
@@ -163,9 +168,10 @@ static void DoWork_4_0_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t
 static void DoWork_3_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
-        *p_dest++ = p_src[2] + p_src[0] / 4 + p_src[1] / 4;
+        *p_dest++ = gain * (p_src[2] + p_src[0] / 4 + p_src[1] / 4);
 
         p_src += 3;
 
@@ -174,12 +180,12 @@ static void DoWork_3_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t
 }
 
 static void DoWork_2_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
-        *p_dest++ = p_src[0] / 2 + p_src[1] / 2;
+        *p_dest++ = gain * (p_src[0] / 2 + p_src[1] / 2);
 
         p_src += 2;
     }
@@ -188,12 +194,13 @@ static void DoWork_2_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t
 static void DoWork_7_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
-        *p_dest++ = p_src[6] + 0.5f * p_src[0] + p_src[2] / 6;
-        *p_dest++ = p_src[6] + 0.5f * p_src[1] + p_src[3] / 6;
-        *p_dest++ = p_src[2] / 6 +  p_src[4];
-        *p_dest++ = p_src[3] / 6 +  p_src[5];
+        *p_dest++ = gain * (p_src[6] + 0.5f * p_src[0] + p_src[2] / 6);
+        *p_dest++ = gain * (p_src[6] + 0.5f * p_src[1] + p_src[3] / 6);
+        *p_dest++ = gain * (p_src[2] / 6 +  p_src[4]);
+        *p_dest++ = gain * (p_src[3] / 6 +  p_src[5]);
 
         p_src += 7;
 
@@ -204,13 +211,14 @@ static void DoWork_7_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t
 static void DoWork_5_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
         float ctr = p_src[4] * 0.7071f;
-        *p_dest++ = p_src[0] + ctr;
-        *p_dest++ = p_src[1] + ctr;
-        *p_dest++ = p_src[2];
-        *p_dest++ = p_src[3];
+        *p_dest++ = gain * (p_src[0] + ctr);
+        *p_dest++ = gain * (p_src[1] + ctr);
+        *p_dest++ = gain * p_src[2];
+        *p_dest++ = gain * p_src[3];
 
         p_src += 5;
 
@@ -221,39 +229,40 @@ static void DoWork_5_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t
 static void DoWork_7_x_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
-        *p_dest++ = p_src[0];
-        *p_dest++ = p_src[1];
-        *p_dest++ = (p_src[2] + p_src[4]) * 0.5f;
-        *p_dest++ = (p_src[3] + p_src[5]) * 0.5f;
-        *p_dest++ = p_src[6];
+        *p_dest++ = gain * p_src[0];
+        *p_dest++ = gain * p_src[1];
+        *p_dest++ = gain * ((p_src[2] + p_src[4]) * 0.5f);
+        *p_dest++ = gain * ((p_src[3] + p_src[5]) * 0.5f);
+        *p_dest++ = gain * p_src[6];
 
         p_src += 7;
 
         if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE &&
             p_filter->fmt_out.audio.i_physical_channels & AOUT_CHAN_LFE )
-            *p_dest++ = *p_src++;
+            *p_dest++ = gain * *p_src++;
         else if( p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE ) p_src++;
     }
 }
 
 static void DoWork_6_1_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    VLC_UNUSED(p_filter);
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
+    const float gain = filter_GetGain( p_filter );
     for( int i = p_in_buf->i_nb_samples; i--; )
     {
-        *p_dest++ = p_src[0];
-        *p_dest++ = p_src[1];
-        *p_dest++ = (p_src[2] + p_src[4]) * 0.5f;
-        *p_dest++ = (p_src[3] + p_src[4]) * 0.5f;
-        *p_dest++ = p_src[5];
+        *p_dest++ = gain * p_src[0];
+        *p_dest++ = gain * p_src[1];
+        *p_dest++ = gain * ((p_src[2] + p_src[4]) * 0.5f);
+        *p_dest++ = gain * ((p_src[3] + p_src[4]) * 0.5f);
+        *p_dest++ = gain * p_src[5];
 
         p_src += 6;
 
         /* We always have LFE here */
-        *p_dest++ = *p_src++;
+        *p_dest++ = gain * *p_src++;
     }
 }
 
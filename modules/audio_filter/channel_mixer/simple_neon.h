@@ -40,6 +40,10 @@
         float *p_dest = (float *)p_out_buf->p_buffer;                            \
         convert_##in##_to_##out##_neon_asm( p_dest, p_src, p_in_buf->i_nb_samples, \
                   p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE );  \
+        const float gain = filter_GetGain( p_filter );                           \
+        if( gain != 1.f )                                                        \
+            for( size_t i = 0; i < p_out_buf->i_buffer / sizeof (float); i++ )  \
+                p_dest[i] *= gain;                                               \
     } \
     static inline void (*GET_WORK_##in##_to_##out##_neon())(filter_t*, block_t*, block_t*) \
     { \
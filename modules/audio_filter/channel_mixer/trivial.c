@@ -79,11 +79,13 @@ static block_t *Upmix( filter_t *p_filter, block_t *p_in_buf )
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (float *)p_in_buf->p_buffer;
     const int *channel_map = p_sys->channel_map;
+    const float gain = filter_GetGain( p_filter );
 
     for( size_t i = 0; i < p_in_buf->i_nb_samples; i++ )
     {
         for( unsigned j = 0; j < i_output_nb; j++ )
-            p_dest[j] = channel_map[j] == -1 ? 0.f : p_src[channel_map[j]];
+            p_dest[j] = channel_map[j] == -1 ? 0.f
+                                             : p_src[channel_map[j]] * gain;
 
         p_src += i_input_nb;
         p_dest += i_output_nb;
@@ -108,13 +110,15 @@ static block_t *Downmix( filter_t *p_filter, block_t *p_buf )
     float *p_dest = (float *)p_buf->p_buffer;
     const float *p_src = p_dest;
     const int *channel_map = p_sys->channel_map;
+    const float gain = filter_GetGain( p_filter );
     /* Use an extra buffer to avoid overlapping */
     float buffer[i_output_nb];
 
     for( size_t i = 0; i < p_buf->i_nb_samples; i++ )
     {
         for( unsigned j = 0; j < i_output_nb; j++ )
-            buffer[j] = channel_map[j] == -1 ? 0.f : p_src[channel_map[j]];
+            buffer[j] = channel_map[j] == -1 ? 0.f
+                                             : p_src[channel_map[j]] * gain;
         memcpy( p_dest, buffer, i_output_nb * sizeof(float) );
 
         p_src += i_input_nb;
@@ -127,7 +131,15 @@ static block_t *Downmix( filter_t *p_filter, block_t *p_buf )
 
 static block_t *Equals( filter_t *p_filter, block_t *p_buf )
 {
-    (void) p_filter;
+    const float gain = filter_GetGain( p_filter );
+
+    if( gain != 1.f )
+    {
+        float *p_samples = (float *)p_buf->p_buffer;
+
+        for( size_t i = 0; i < p_buf->i_nb_samples; i++ )
+            p_samples[i] *= gain;
+    }
     return p_buf;
 }
 
@@ -0,0 +1,1865 @@
+/*****************************************************************************
+ * format_kernels.c : PCM format conversion kernels
+ *****************************************************************************
+ * Copyright (C) 2002-2005 VLC authors and VideoLAN
+ * Copyright (C) 2010 Laurent Aimar
+ *
+ * Authors: Christophe Massiot <massiot@via.ecp.fr>
+ *          Gildas Bazin <gbazin@videolan.org>
+ *          Laurent Aimar <fenrir _AT_ videolan _DOT_ org>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_fourcc.h>
+
+#include "format_kernels.h"
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+# define FORMAT_SSE2 __attribute__ ((__target__ ("sse2")))
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+# define FORMAT_AVX2 __attribute__ ((__target__ ("avx2")))
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+# include <arm_neon.h>
+# define FORMAT_NEON
+#endif
+
+/*****************************************************************************
+ * C, the reference
+ *****************************************************************************/
+
+/*** from U8 ***/
+static void U8toS16_c(void *restrict dst_, const void *restrict src_,
+                      size_t n)
+{
+    const uint8_t *src = src_;
+    int16_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((*src++) << 8) - 0x8000;
+}
+
+static void U8toFl32_c(void *restrict dst_, const void *restrict src_,
+                       size_t n)
+{
+    const uint8_t *src = src_;
+    float *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((float)((*src++) - 128)) / 128.f;
+}
+
+static void U8toS32_c(void *restrict dst_, const void *restrict src_,
+                      size_t n)
+{
+    const uint8_t *src = src_;
+    int32_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((*src++) << 24) - 0x80000000;
+}
+
+static void U8toFl64_c(void *restrict dst_, const void *restrict src_,
+                       size_t n)
+{
+    const uint8_t *src = src_;
+    double *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((double)((*src++) - 128)) / 128.;
+}
+
+/*** from S16N ***/
+static void S16toU8_c(void *dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    uint8_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((*src++) + 32768) >> 8;
+}
+
+static void S16toFl32_c(void *restrict dst_, const void *restrict src_,
+                        size_t n)
+{
+    const int16_t *src = src_;
+    float *dst = dst_;
+    for (size_t i = n; i--;)
+    {   /* This is Walken's trick based on IEEE float format. On my PIII
+         * this takes 16 seconds to perform one billion conversions, instead
+         * of 19 seconds for a division by 32768. */
+        union { float f; int32_t i; } u;
+        u.i = *src++ + 0x43c00000;
+        *dst++ = u.f - 384.f;
+    }
+}
+
+static void S16toS32_c(void *restrict dst_, const void *restrict src_,
+                       size_t n)
+{
+    const int16_t *src = src_;
+    int32_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = *src++ << 16;
+}
+
+static void S16toFl64_c(void *restrict dst_, const void *restrict src_,
+                        size_t n)
+{
+    const int16_t *src = src_;
+    double *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = (double)*src++ / 32768.;
+}
+
+/*** from FL32 ***/
+static void Fl32toU8_c(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    uint8_t *dst = dst_;
+    for (size_t i = n; i--;)
+    {
+        float s = *(src++) * 128.f;
+        if (s >= 127.f)
+            *(dst++) = 255;
+        else
+        if (s <= -128.f)
+            *(dst++) = 0;
+        else
+            *(dst++) = lroundf(s) + 128;
+    }
+}
+
+static void Fl32toS16_c(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int16_t *dst = dst_;
+    for (size_t i = n; i--;)
+    {   /* This is Walken's trick based on IEEE float format. */
+        union { float f; int32_t i; } u;
+        u.f = *src++ + 384.f;
+        if (u.i > 0x43c07fff)
+            *dst++ = 32767;
+        else if (u.i < 0x43bf8000)
+            *dst++ = -32768;
+        else
+            *dst++ = u.i - 0x43c00000;
+    }
+}
+
+static void Fl32toS32_c(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int32_t *dst = dst_;
+    for (size_t i = n; i--;)
+    {
+        float s = *(src++) * 2147483648.f;
+        if (s >= 2147483647.f)
+            *(dst++) = 2147483647;
+        else
+        if (s <= -2147483648.f)
+            *(dst++) = -2147483648;
+        else
+            *(dst++) = lroundf(s);
+    }
+}
+
+static void Fl32toFl64_c(void *restrict dst_, const void *restrict src_,
+                         size_t n)
+{
+    const float *src = src_;
+    double *dst = dst_;
+    for (size_t i = n; i--;)
+        *(dst++) = *(src++);
+}
+
+/*** from S32N ***/
+static void S32toU8_c(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    uint8_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = ((*src++) >> 24) + 128;
+}
+
+static void S32toS16_c(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    int16_t *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = (*src++) >> 16;
+}
+
+static void S32toFl32_c(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    float *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = (float)(*src++) / 2147483648.f;
+}
+
+static void S32toFl64_c(void *restrict dst_, const void *restrict src_,
+                        size_t n)
+{
+    const int32_t *src = src_;
+    double *dst = dst_;
+    for (size_t i = n; i--;)
+        *dst++ = (double)(*src++) / 2147483648.;
+}
+
+/*** from FL64 ***/
+static void Fl64toU8_c(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    uint8_t *dst = dst_;
+    for (size_t i = n; i--;)
+    {
+        float s = *(src++) * 128.;
+        if (s >= 127.f)
+            *(dst++) = 255;
+        else
+        if (s <= -128.f)
+            *(dst++) = 0;
+        else
+            *(dst++) = lround(s) + 128;
+    }
+}
+
+static void Fl64toS16_c(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    int16_t *dst = dst_;
+    for (size_t i = n; i--;) {
+        const double v = *src++ * 32768.;
+        /* Slow version. */
+        if (v >= 32767.)
+            *dst++ = 32767;
+        else if (v < -32768.)
+            *dst++ = -32768;
+        else
+            *dst++ = lround(v);
+    }
+}
+
+static void Fl64toFl32_c(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    float *dst = dst_;
+    for (size_t i = n; i--;)
+        *(dst++) = *(src++);
+}
+
+static void Fl64toS32_c(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    int32_t *dst = dst_;
+    for (size_t i = n; i--;)
+    {
+        float s = *(src++) * 2147483648.;
+        if (s >= 2147483647.f)
+            *(dst++) = 2147483647;
+        else
+        if (s <= -2147483648.f)
+            *(dst++) = -2147483648;
+        else
+            *(dst++) = lround(s);
+    }
+}
+
+/*** to FL32, with a gain ***/
+/* The conversions to FL32 scale by a power of two, into which the gain can
+ * be folded exactly while the product remains a normal float. Otherwise,
+ * the samples are converted first, then amplified. */
+static bool FoldGain(float scale, float gain, float *k)
+{
+    *k = scale * gain;
+    /* k is not tested against zero, as it might have been flushed */
+    return gain == 0.f || isnormal(*k);
+}
+
+static void AmplifyFl32(float *p, size_t n, float gain)
+{
+    for (size_t i = n; i--;)
+        *(p++) *= gain;
+}
+
+static void U8toFl32g_c(void *restrict dst_, const void *restrict src_,
+                        size_t n, float gain)
+{
+    const uint8_t *src = src_;
+    float *dst = dst_;
+    float k;
+
+    if (!FoldGain(1.f / 128.f, gain, &k))
+    {
+        U8toFl32_c(dst, src, n);
+        AmplifyFl32(dst, n, gain);
+        return;
+    }
+    for (size_t i = n; i--;)
+        *dst++ = (float)((*src++) - 128) * k;
+}
+
+static void S16toFl32g_c(void *restrict dst_, const void *restrict src_,
+                         size_t n, float gain)
+{
+    const int16_t *src = src_;
+    float *dst = dst_;
+    float k;
+
+    if (!FoldGain(1.f / 32768.f, gain, &k))
+    {
+        S16toFl32_c(dst, src, n);
+        AmplifyFl32(dst, n, gain);
+        return;
+    }
+    for (size_t i = n; i--;)
+        *dst++ = (float)(*src++) * k;
+}
+
+static void S32toFl32g_c(void *dst_, const void *src_, size_t n, float gain)
+{
+    const int32_t *src = src_;
+    float *dst = dst_;
+    float k;
+
+    if (!FoldGain(1.f / 2147483648.f, gain, &k))
+    {
+        S32toFl32_c(dst, src, n);
+        AmplifyFl32(dst, n, gain);
+        return;
+    }
+    for (size_t i = n; i--;)
+        *dst++ = (float)(*src++) * k;
+}
+
+static void Fl64toFl32g_c(void *dst_, const void *src_, size_t n, float gain)
+{
+    const double *src = src_;
+    float *dst = dst_;
+    float k;
+
+    if (!FoldGain(1.f, gain, &k))
+    {
+        Fl64toFl32_c(dst, src, n);
+        AmplifyFl32(dst, n, gain);
+        return;
+    }
+    for (size_t i = n; i--;)
+        *(dst++) = (float)*(src++) * k;
+}
+
+/* The vector kernels convert whole vectors, then leave the remaining
+ * samples to the C ones. In place, all the input vectors of an iteration are
+ * loaded before anything is stored. */
+#define TAIL(name, i, n) name##_c(&dst[i], &src[i], (n) - (i))
+
+/* lroundf() and lround() round halfway cases away from zero. Adding the
+ * float (resp. double) just below 0.5, with the sign of the value, and
+ * truncating gives the same results. */
+#define HALF_DOWN_F 0x1.fffffep-2f
+#define HALF_DOWN_D 0x1.fffffffffffffp-2
+
+/* The vector conversions to FL32 end with the scaling multiplication, which
+ * applies the gain as well when it can be folded in. The scaled loops return
+ * how many samples they converted. */
+#define TO_FL32(name, type, scale, isa, attr) \
+attr \
+static void name##_##isa(void *dst_, const void *src_, size_t n) \
+{ \
+    float *dst = dst_; \
+    const type *src = src_; \
+    size_t i = name##k_##isa(dst, src, n, scale); \
+    TAIL(name, i, n); \
+} \
+\
+attr \
+static void name##g_##isa(void *dst_, const void *src_, size_t n, \
+                          float gain) \
+{ \
+    float *dst = dst_; \
+    const type *src = src_; \
+    float k; \
+    size_t i = 0; \
+    if (FoldGain(scale, gain, &k)) \
+        i = name##k_##isa(dst, src, n, k); \
+    name##g_c(&dst[i], &src[i], n - i, gain); \
+}
+
+#define TO_FL32_ALL(isa, attr) \
+    TO_FL32(U8toFl32,   uint8_t, 1.f / 128.f,        isa, attr) \
+    TO_FL32(S16toFl32,  int16_t, 1.f / 32768.f,      isa, attr) \
+    TO_FL32(S32toFl32,  int32_t, 1.f / 2147483648.f, isa, attr) \
+    TO_FL32(Fl64toFl32, double,  1.f,                isa, attr)
+
+/*****************************************************************************
+ * SSE2
+ *****************************************************************************/
+#ifdef FORMAT_SSE2
+FORMAT_SSE2
+static inline __m128i Select_sse2(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+FORMAT_SSE2
+static inline __m128i RoundF_sse2(__m128 s)
+{
+    const __m128 sign = _mm_and_ps(s, _mm_set1_ps(-0.f));
+    s = _mm_add_ps(s, _mm_or_ps(sign, _mm_set1_ps(HALF_DOWN_F)));
+    return _mm_cvttps_epi32(s);
+}
+
+FORMAT_SSE2
+static inline __m128i RoundD_sse2(__m128d v)
+{
+    const __m128d sign = _mm_and_pd(v, _mm_set1_pd(-0.));
+    v = _mm_add_pd(v, _mm_or_pd(sign, _mm_set1_pd(HALF_DOWN_D)));
+    return _mm_cvttpd_epi32(v);
+}
+
+/* s already scaled by 128, to 32-bit lanes of 0 to 255 */
+FORMAT_SSE2
+static inline __m128i ToU8_sse2(__m128 s)
+{
+    const __m128i hi = _mm_castps_si128(_mm_cmpge_ps(s, _mm_set1_ps(127.f)));
+    const __m128i lo = _mm_castps_si128(_mm_cmple_ps(s, _mm_set1_ps(-128.f)));
+
+    /* lroundf(NAN) + 128 gives 128 */
+    s = _mm_and_ps(s, _mm_cmpord_ps(s, s));
+
+    __m128i r = _mm_add_epi32(RoundF_sse2(s), _mm_set1_epi32(128));
+    r = Select_sse2(hi, _mm_set1_epi32(255), r);
+    return _mm_andnot_si128(lo, r);
+}
+
+/* s already scaled by 2^31 */
+FORMAT_SSE2
+static inline __m128i ToS32_sse2(__m128 s)
+{
+    const __m128i hi =
+        _mm_castps_si128(_mm_cmpge_ps(s, _mm_set1_ps(2147483648.f)));
+
+    /* (int32_t)lroundf(NAN) gives 0 */
+    s = _mm_and_ps(s, _mm_cmpord_ps(s, s));
+
+    /* Out of range values convert to INT32_MIN: flip the positive ones */
+    return _mm_xor_si128(RoundF_sse2(s), hi);
+}
+
+/* 4 doubles scaled, to floats */
+FORMAT_SSE2
+static inline __m128 LoadD_sse2(const double *src, double scale)
+{
+    const __m128d k = _mm_set1_pd(scale);
+    const __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(src), k));
+    const __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(src + 2), k));
+    return _mm_movelh_ps(lo, hi);
+}
+
+/* 4 integers, scaled, to doubles */
+FORMAT_SSE2
+static inline void StoreD_sse2(double *dst, __m128i v, double scale)
+{
+    const __m128d k = _mm_set1_pd(scale);
+    _mm_storeu_pd(dst, _mm_mul_pd(_mm_cvtepi32_pd(v), k));
+    _mm_storeu_pd(dst + 2, _mm_mul_pd(_mm_cvtepi32_pd(
+                      _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2))), k));
+}
+
+/*** from U8 ***/
+FORMAT_SSE2
+static void U8toS16_sse2(void *restrict dst_, const void *restrict src_,
+                         size_t n)
+{
+    const uint8_t *src = src_;
+    int16_t *dst = dst_;
+    const __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi16(-0x8000);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i *)&src[i]);
+        _mm_storeu_si128((__m128i *)&dst[i],
+                         _mm_xor_si128(_mm_unpacklo_epi8(zero, x), bias));
+        _mm_storeu_si128((__m128i *)&dst[i + 8],
+                         _mm_xor_si128(_mm_unpackhi_epi8(zero, x), bias));
+    }
+    TAIL(U8toS16, i, n);
+}
+
+FORMAT_SSE2
+static size_t U8toFl32k_sse2(float *restrict dst, const uint8_t *restrict src,
+                             size_t n, float scale)
+{
+    const __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi32(128);
+    const __m128 k = _mm_set1_ps(scale);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i *)&src[i]);
+        const __m128i w[2] = {
+            _mm_unpacklo_epi8(x, zero), _mm_unpackhi_epi8(x, zero),
+        };
+
+        for (unsigned j = 0; j < 4; j++)
+        {
+            __m128i d = (j & 1) ? _mm_unpackhi_epi16(w[j / 2], zero)
+                                : _mm_unpacklo_epi16(w[j / 2], zero);
+            d = _mm_sub_epi32(d, bias);
+            _mm_storeu_ps(&dst[i + 4 * j], _mm_mul_ps(_mm_cvtepi32_ps(d), k));
+        }
+    }
+    return i;
+}
+
+FORMAT_SSE2
+static void U8toS32_sse2(void *restrict dst_, const void *restrict src_,
+                         size_t n)
+{
+    const uint8_t *src = src_;
+    int32_t *dst = dst_;
+    const __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi32(INT32_MIN);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i *)&src[i]);
+        const __m128i w[2] = {
+            _mm_unpacklo_epi8(zero, x), _mm_unpackhi_epi8(zero, x),
+        };
+
+        for (unsigned j = 0; j < 4; j++)
+        {
+            __m128i d = (j & 1) ? _mm_unpackhi_epi16(zero, w[j / 2])
+                                : _mm_unpacklo_epi16(zero, w[j / 2]);
+            _mm_storeu_si128((__m128i *)&dst[i + 4 * j],
+                             _mm_xor_si128(d, bias));
+        }
+    }
+    TAIL(U8toS32, i, n);
+}
+
+FORMAT_SSE2
+static void U8toFl64_sse2(void *restrict dst_, const void *restrict src_,
+                          size_t n)
+{
+    const uint8_t *src = src_;
+    double *dst = dst_;
+    const __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi32(128);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i *)&src[i]);
+        const __m128i w[2] = {
+            _mm_unpacklo_epi8(x, zero), _mm_unpackhi_epi8(x, zero),
+        };
+
+        for (unsigned j = 0; j < 4; j++)
+        {
+            __m128i d = (j & 1) ? _mm_unpackhi_epi16(w[j / 2], zero)
+                                : _mm_unpacklo_epi16(w[j / 2], zero);
+            StoreD_sse2(&dst[i + 4 * j], _mm_sub_epi32(d, bias), 1. / 128.);
+        }
+    }
+    TAIL(U8toFl64, i, n);
+}
+
+/*** from S16N ***/
+FORMAT_SSE2
+static void S16toU8_sse2(void *dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    uint8_t *dst = dst_;
+    const __m128i bias = _mm_set1_epi16(-0x8000);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)&src[i]);
+        __m128i b = _mm_loadu_si128((const __m128i *)&src[i + 8]);
+
+        a = _mm_srli_epi16(_mm_xor_si128(a, bias), 8);
+        b = _mm_srli_epi16(_mm_xor_si128(b, bias), 8);
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(a, b));
+    }
+    TAIL(S16toU8, i, n);
+}
+
+FORMAT_SSE2
+static size_t S16toFl32k_sse2(float *restrict dst, const int16_t *restrict src,
+                              size_t n, float scale)
+{
+    const __m128 k = _mm_set1_ps(scale);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i *)&src[i]);
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_cvtepi32_ps(lo), k));
+        _mm_storeu_ps(&dst[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(hi), k));
+    }
+    return i;
+}
+
+FORMAT_SSE2
+static void S16toS32_sse2(void *restrict dst_, const void *restrict src_,
+                          size_t n)
+{
+    const int16_t *src = src_;
+    int32_t *dst = dst_;
+    const __m128i zero = _mm_setzero_si128();
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i *)&src[i]);
+
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_unpacklo_epi16(zero, x));
+        _mm_storeu_si128((__m128i *)&dst[i + 4], _mm_unpackhi_epi16(zero, x));
+    }
+    TAIL(S16toS32, i, n);
+}
+
+FORMAT_SSE2
+static void S16toFl64_sse2(void *restrict dst_, const void *restrict src_,
+                           size_t n)
+{
+    const int16_t *src = src_;
+    double *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i *)&src[i]);
+
+        StoreD_sse2(&dst[i], _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16),
+                    1. / 32768.);
+        StoreD_sse2(&dst[i + 4], _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16),
+                    1. / 32768.);
+    }
+    TAIL(S16toFl64, i, n);
+}
+
+/*** from FL32 ***/
+FORMAT_SSE2
+static void Fl32toU8_sse2(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    uint8_t *dst = dst_;
+    const __m128 k = _mm_set1_ps(128.f);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        __m128i r[4];
+
+        for (unsigned j = 0; j < 4; j++)
+            r[j] = ToU8_sse2(_mm_mul_ps(_mm_loadu_ps(&src[i + 4 * j]), k));
+        _mm_storeu_si128((__m128i *)&dst[i],
+                         _mm_packus_epi16(_mm_packs_epi32(r[0], r[1]),
+                                          _mm_packs_epi32(r[2], r[3])));
+    }
+    TAIL(Fl32toU8, i, n);
+}
+
+FORMAT_SSE2
+static void Fl32toS16_sse2(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int16_t *dst = dst_;
+    const __m128 magic = _mm_set1_ps(384.f);
+    const __m128i max = _mm_set1_epi32(0x43c07fff);
+    const __m128i min = _mm_set1_epi32(0x43bf8000);
+    const __m128i offset = _mm_set1_epi32(0x43c00000);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m128i r[2];
+
+        for (unsigned j = 0; j < 2; j++)
+        {
+            __m128i u = _mm_castps_si128(
+                _mm_add_ps(_mm_loadu_ps(&src[i + 4 * j]), magic));
+
+            u = Select_sse2(_mm_cmpgt_epi32(u, max), max, u);
+            u = Select_sse2(_mm_cmplt_epi32(u, min), min, u);
+            r[j] = _mm_sub_epi32(u, offset);
+        }
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packs_epi32(r[0], r[1]));
+    }
+    TAIL(Fl32toS16, i, n);
+}
+
+FORMAT_SSE2
+static void Fl32toS32_sse2(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int32_t *dst = dst_;
+    const __m128 k = _mm_set1_ps(2147483648.f);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        _mm_storeu_si128((__m128i *)&dst[i],
+                         ToS32_sse2(_mm_mul_ps(_mm_loadu_ps(&src[i]), k)));
+    TAIL(Fl32toS32, i, n);
+}
+
+FORMAT_SSE2
+static void Fl32toFl64_sse2(void *restrict dst_, const void *restrict src_,
+                            size_t n)
+{
+    const float *src = src_;
+    double *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        const __m128 x = _mm_loadu_ps(&src[i]);
+
+        _mm_storeu_pd(&dst[i], _mm_cvtps_pd(x));
+        _mm_storeu_pd(&dst[i + 2], _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+    }
+    TAIL(Fl32toFl64, i, n);
+}
+
+/*** from S32N ***/
+FORMAT_SSE2
+static void S32toU8_sse2(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    uint8_t *dst = dst_;
+    const __m128i bias = _mm_set1_epi32(0x80);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        __m128i r[4];
+
+        for (unsigned j = 0; j < 4; j++)
+        {
+            r[j] = _mm_loadu_si128((const __m128i *)&src[i + 4 * j]);
+            r[j] = _mm_xor_si128(_mm_srli_epi32(r[j], 24), bias);
+        }
+        _mm_storeu_si128((__m128i *)&dst[i],
+                         _mm_packus_epi16(_mm_packs_epi32(r[0], r[1]),
+                                          _mm_packs_epi32(r[2], r[3])));
+    }
+    TAIL(S32toU8, i, n);
+}
+
+FORMAT_SSE2
+static void S32toS16_sse2(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    int16_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)&src[i]);
+        __m128i b = _mm_loadu_si128((const __m128i *)&src[i + 4]);
+
+        _mm_storeu_si128((__m128i *)&dst[i],
+                         _mm_packs_epi32(_mm_srai_epi32(a, 16),
+                                         _mm_srai_epi32(b, 16)));
+    }
+    TAIL(S32toS16, i, n);
+}
+
+FORMAT_SSE2
+static size_t S32toFl32k_sse2(float *dst, const int32_t *src,
+                              size_t n, float scale)
+{
+    const __m128 k = _mm_set1_ps(scale);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i *)&src[i]);
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_cvtepi32_ps(x), k));
+    }
+    return i;
+}
+
+FORMAT_SSE2
+static void S32toFl64_sse2(void *restrict dst_, const void *restrict src_,
+                           size_t n)
+{
+    const int32_t *src = src_;
+    double *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        StoreD_sse2(&dst[i], _mm_loadu_si128((const __m128i *)&src[i]),
+                    1. / 2147483648.);
+    TAIL(S32toFl64, i, n);
+}
+
+/*** from FL64 ***/
+FORMAT_SSE2
+static void Fl64toU8_sse2(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    uint8_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        __m128i r[4];
+
+        for (unsigned j = 0; j < 4; j++)
+            r[j] = ToU8_sse2(LoadD_sse2(&src[i + 4 * j], 128.));
+        _mm_storeu_si128((__m128i *)&dst[i],
+                         _mm_packus_epi16(_mm_packs_epi32(r[0], r[1]),
+                                          _mm_packs_epi32(r[2], r[3])));
+    }
+    TAIL(Fl64toU8, i, n);
+}
+
+FORMAT_SSE2
+static void Fl64toS16_sse2(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    int16_t *dst = dst_;
+    const __m128d k = _mm_set1_pd(32768.);
+    const __m128d max = _mm_set1_pd(32767.), min = _mm_set1_pd(-32768.);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m128i r[4];
+
+        for (unsigned j = 0; j < 4; j++)
+        {
+            __m128d v = _mm_mul_pd(_mm_loadu_pd(&src[i + 2 * j]), k);
+
+            /* (int16_t)lround(NAN) gives 0 */
+            v = _mm_and_pd(v, _mm_cmpord_pd(v, v));
+            v = _mm_min_pd(_mm_max_pd(v, min), max);
+            r[j] = RoundD_sse2(v);
+        }
+        _mm_storeu_si128((__m128i *)&dst[i],
+                         _mm_packs_epi32(_mm_unpacklo_epi64(r[0], r[1]),
+                                         _mm_unpacklo_epi64(r[2], r[3])));
+    }
+    TAIL(Fl64toS16, i, n);
+}
+
+FORMAT_SSE2
+static size_t Fl64toFl32k_sse2(float *dst, const double *src,
+                               size_t n, float scale)
+{
+    const __m128 k = _mm_set1_ps(scale);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(LoadD_sse2(&src[i], 1.), k));
+    return i;
+}
+
+FORMAT_SSE2
+static void Fl64toS32_sse2(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    int32_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        _mm_storeu_si128((__m128i *)&dst[i],
+                         ToS32_sse2(LoadD_sse2(&src[i], 2147483648.)));
+    TAIL(Fl64toS32, i, n);
+}
+
+TO_FL32_ALL(sse2, FORMAT_SSE2)
+#endif
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#ifdef FORMAT_AVX2
+FORMAT_AVX2
+static inline __m256i RoundF_avx2(__m256 s)
+{
+    const __m256 sign = _mm256_and_ps(s, _mm256_set1_ps(-0.f));
+    s = _mm256_add_ps(s, _mm256_or_ps(sign, _mm256_set1_ps(HALF_DOWN_F)));
+    return _mm256_cvttps_epi32(s);
+}
+
+FORMAT_AVX2
+static inline __m128i RoundD_avx2(__m256d v)
+{
+    const __m256d sign = _mm256_and_pd(v, _mm256_set1_pd(-0.));
+    v = _mm256_add_pd(v, _mm256_or_pd(sign, _mm256_set1_pd(HALF_DOWN_D)));
+    return _mm256_cvttpd_epi32(v);
+}
+
+FORMAT_AVX2
+static inline __m256i ToU8_avx2(__m256 s)
+{
+    const __m256i hi = _mm256_castps_si256(
+        _mm256_cmp_ps(s, _mm256_set1_ps(127.f), _CMP_GE_OQ));
+    const __m256i lo = _mm256_castps_si256(
+        _mm256_cmp_ps(s, _mm256_set1_ps(-128.f), _CMP_LE_OQ));
+
+    s = _mm256_and_ps(s, _mm256_cmp_ps(s, s, _CMP_ORD_Q));
+
+    __m256i r = _mm256_add_epi32(RoundF_avx2(s), _mm256_set1_epi32(128));
+    r = _mm256_blendv_epi8(r, _mm256_set1_epi32(255), hi);
+    return _mm256_andnot_si256(lo, r);
+}
+
+FORMAT_AVX2
+static inline __m256i ToS32_avx2(__m256 s)
+{
+    const __m256i hi = _mm256_castps_si256(
+        _mm256_cmp_ps(s, _mm256_set1_ps(2147483648.f), _CMP_GE_OQ));
+
+    s = _mm256_and_ps(s, _mm256_cmp_ps(s, s, _CMP_ORD_Q));
+    return _mm256_xor_si256(RoundF_avx2(s), hi);
+}
+
+FORMAT_AVX2
+static inline __m256 LoadD_avx2(const double *src, double scale)
+{
+    const __m256d k = _mm256_set1_pd(scale);
+    const __m128 lo = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_loadu_pd(src), k));
+    const __m128 hi = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_loadu_pd(src + 4),
+                                                    k));
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+/* 4 x 8 lanes of 0 to 255, to 32 bytes */
+FORMAT_AVX2
+static inline __m256i PackU8_avx2(const __m256i r[4])
+{
+    const __m256i x = _mm256_packus_epi16(_mm256_packs_epi32(r[0], r[1]),
+                                          _mm256_packs_epi32(r[2], r[3]));
+    /* the packs work within 128-bit lanes */
+    return _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 4, 1, 5,
+                                                            2, 6, 3, 7));
+}
+
+/* 2 x 8 lanes, to 16 saturated 16-bit samples */
+FORMAT_AVX2
+static inline __m256i PackS16_avx2(__m256i a, __m256i b)
+{
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b),
+                                    _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+/*** from U8 ***/
+FORMAT_AVX2
+static void U8toS16_avx2(void *restrict dst_, const void *restrict src_,
+                         size_t n)
+{
+    const uint8_t *src = src_;
+    int16_t *dst = dst_;
+    const __m256i bias = _mm256_set1_epi16(-0x8000);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        __m256i x = _mm256_cvtepu8_epi16(
+            _mm_loadu_si128((const __m128i *)&src[i]));
+        x = _mm256_xor_si256(_mm256_slli_epi16(x, 8), bias);
+        _mm256_storeu_si256((__m256i *)&dst[i], x);
+    }
+    TAIL(U8toS16, i, n);
+}
+
+FORMAT_AVX2
+static size_t U8toFl32k_avx2(float *restrict dst, const uint8_t *restrict src,
+                             size_t n, float scale)
+{
+    const __m256i bias = _mm256_set1_epi32(128);
+    const __m256 k = _mm256_set1_ps(scale);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((const __m128i *)&src[i]));
+        x = _mm256_sub_epi32(x, bias);
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(_mm256_cvtepi32_ps(x), k));
+    }
+    return i;
+}
+
+FORMAT_AVX2
+static void U8toS32_avx2(void *restrict dst_, const void *restrict src_,
+                         size_t n)
+{
+    const uint8_t *src = src_;
+    int32_t *dst = dst_;
+    const __m256i bias = _mm256_set1_epi32(INT32_MIN);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m256i x = _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64((const __m128i *)&src[i]));
+        x = _mm256_xor_si256(_mm256_slli_epi32(x, 24), bias);
+        _mm256_storeu_si256((__m256i *)&dst[i], x);
+    }
+    TAIL(U8toS32, i, n);
+}
+
+FORMAT_AVX2
+static void U8toFl64_avx2(void *restrict dst_, const void *restrict src_,
+                          size_t n)
+{
+    const uint8_t *src = src_;
+    double *dst = dst_;
+    const __m128i bias = _mm_set1_epi32(128);
+    const __m256d k = _mm256_set1_pd(1. / 128.);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        int32_t word;
+        memcpy(&word, &src[i], sizeof (word));
+
+        __m128i x = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(word));
+        x = _mm_sub_epi32(x, bias);
+        _mm256_storeu_pd(&dst[i], _mm256_mul_pd(_mm256_cvtepi32_pd(x), k));
+    }
+    TAIL(U8toFl64, i, n);
+}
+
+/*** from S16N ***/
+FORMAT_AVX2
+static void S16toU8_avx2(void *dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    uint8_t *dst = dst_;
+    const __m256i bias = _mm256_set1_epi16(-0x8000);
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)&src[i]);
+        __m256i b = _mm256_loadu_si256((const __m256i *)&src[i + 16]);
+
+        a = _mm256_srli_epi16(_mm256_xor_si256(a, bias), 8);
+        b = _mm256_srli_epi16(_mm256_xor_si256(b, bias), 8);
+        _mm256_storeu_si256((__m256i *)&dst[i],
+                            _mm256_permute4x64_epi64(
+                                _mm256_packus_epi16(a, b),
+                                _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    TAIL(S16toU8, i, n);
+}
+
+FORMAT_AVX2
+static size_t S16toFl32k_avx2(float *restrict dst, const int16_t *restrict src,
+                              size_t n, float scale)
+{
+    const __m256 k = _mm256_set1_ps(scale);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const __m256i x = _mm256_cvtepi16_epi32(
+            _mm_loadu_si128((const __m128i *)&src[i]));
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(_mm256_cvtepi32_ps(x), k));
+    }
+    return i;
+}
+
+FORMAT_AVX2
+static void S16toS32_avx2(void *restrict dst_, const void *restrict src_,
+                          size_t n)
+{
+    const int16_t *src = src_;
+    int32_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const __m256i x = _mm256_cvtepi16_epi32(
+            _mm_loadu_si128((const __m128i *)&src[i]));
+        _mm256_storeu_si256((__m256i *)&dst[i], _mm256_slli_epi32(x, 16));
+    }
+    TAIL(S16toS32, i, n);
+}
+
+FORMAT_AVX2
+static void S16toFl64_avx2(void *restrict dst_, const void *restrict src_,
+                           size_t n)
+{
+    const int16_t *src = src_;
+    double *dst = dst_;
+    const __m256d k = _mm256_set1_pd(1. / 32768.);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        const __m128i x = _mm_cvtepi16_epi32(
+            _mm_loadl_epi64((const __m128i *)&src[i]));
+        _mm256_storeu_pd(&dst[i], _mm256_mul_pd(_mm256_cvtepi32_pd(x), k));
+    }
+    TAIL(S16toFl64, i, n);
+}
+
+/*** from FL32 ***/
+FORMAT_AVX2
+static void Fl32toU8_avx2(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    uint8_t *dst = dst_;
+    const __m256 k = _mm256_set1_ps(128.f);
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32)
+    {
+        __m256i r[4];
+
+        for (unsigned j = 0; j < 4; j++)
+            r[j] = ToU8_avx2(_mm256_mul_ps(_mm256_loadu_ps(&src[i + 8 * j]),
+                                           k));
+        _mm256_storeu_si256((__m256i *)&dst[i], PackU8_avx2(r));
+    }
+    TAIL(Fl32toU8, i, n);
+}
+
+FORMAT_AVX2
+static void Fl32toS16_avx2(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int16_t *dst = dst_;
+    const __m256 magic = _mm256_set1_ps(384.f);
+    const __m256i max = _mm256_set1_epi32(0x43c07fff);
+    const __m256i min = _mm256_set1_epi32(0x43bf8000);
+    const __m256i offset = _mm256_set1_epi32(0x43c00000);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        __m256i r[2];
+
+        for (unsigned j = 0; j < 2; j++)
+        {
+            __m256i u = _mm256_castps_si256(
+                _mm256_add_ps(_mm256_loadu_ps(&src[i + 8 * j]), magic));
+
+            u = _mm256_max_epi32(_mm256_min_epi32(u, max), min);
+            r[j] = _mm256_sub_epi32(u, offset);
+        }
+        _mm256_storeu_si256((__m256i *)&dst[i], PackS16_avx2(r[0], r[1]));
+    }
+    TAIL(Fl32toS16, i, n);
+}
+
+FORMAT_AVX2
+static void Fl32toS32_avx2(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int32_t *dst = dst_;
+    const __m256 k = _mm256_set1_ps(2147483648.f);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+        _mm256_storeu_si256((__m256i *)&dst[i],
+                            ToS32_avx2(_mm256_mul_ps(_mm256_loadu_ps(&src[i]),
+                                                     k)));
+    TAIL(Fl32toS32, i, n);
+}
+
+FORMAT_AVX2
+static void Fl32toFl64_avx2(void *restrict dst_, const void *restrict src_,
+                            size_t n)
+{
+    const float *src = src_;
+    double *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(&dst[i], _mm256_cvtps_pd(_mm_loadu_ps(&src[i])));
+    TAIL(Fl32toFl64, i, n);
+}
+
+/*** from S32N ***/
+FORMAT_AVX2
+static void S32toU8_avx2(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    uint8_t *dst = dst_;
+    const __m256i bias = _mm256_set1_epi32(0x80);
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32)
+    {
+        __m256i r[4];
+
+        for (unsigned j = 0; j < 4; j++)
+        {
+            r[j] = _mm256_loadu_si256((const __m256i *)&src[i + 8 * j]);
+            r[j] = _mm256_xor_si256(_mm256_srli_epi32(r[j], 24), bias);
+        }
+        _mm256_storeu_si256((__m256i *)&dst[i], PackU8_avx2(r));
+    }
+    TAIL(S32toU8, i, n);
+}
+
+FORMAT_AVX2
+static void S32toS16_avx2(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    int16_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)&src[i]);
+        __m256i b = _mm256_loadu_si256((const __m256i *)&src[i + 8]);
+
+        _mm256_storeu_si256((__m256i *)&dst[i],
+                            PackS16_avx2(_mm256_srai_epi32(a, 16),
+                                         _mm256_srai_epi32(b, 16)));
+    }
+    TAIL(S32toS16, i, n);
+}
+
+FORMAT_AVX2
+static size_t S32toFl32k_avx2(float *dst, const int32_t *src,
+                              size_t n, float scale)
+{
+    const __m256 k = _mm256_set1_ps(scale);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const __m256i x = _mm256_loadu_si256((const __m256i *)&src[i]);
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(_mm256_cvtepi32_ps(x), k));
+    }
+    return i;
+}
+
+FORMAT_AVX2
+static void S32toFl64_avx2(void *restrict dst_, const void *restrict src_,
+                           size_t n)
+{
+    const int32_t *src = src_;
+    double *dst = dst_;
+    const __m256d k = _mm256_set1_pd(1. / 2147483648.);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        const __m128i x = _mm_loadu_si128((const __m128i *)&src[i]);
+        _mm256_storeu_pd(&dst[i], _mm256_mul_pd(_mm256_cvtepi32_pd(x), k));
+    }
+    TAIL(S32toFl64, i, n);
+}
+
+/*** from FL64 ***/
+FORMAT_AVX2
+static void Fl64toU8_avx2(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    uint8_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 32 <= n; i += 32)
+    {
+        __m256i r[4];
+
+        for (unsigned j = 0; j < 4; j++)
+            r[j] = ToU8_avx2(LoadD_avx2(&src[i + 8 * j], 128.));
+        _mm256_storeu_si256((__m256i *)&dst[i], PackU8_avx2(r));
+    }
+    TAIL(Fl64toU8, i, n);
+}
+
+FORMAT_AVX2
+static void Fl64toS16_avx2(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    int16_t *dst = dst_;
+    const __m256d k = _mm256_set1_pd(32768.);
+    const __m256d max = _mm256_set1_pd(32767.), min = _mm256_set1_pd(-32768.);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        __m128i r[2];
+
+        for (unsigned j = 0; j < 2; j++)
+        {
+            __m256d v = _mm256_mul_pd(_mm256_loadu_pd(&src[i + 4 * j]), k);
+
+            v = _mm256_and_pd(v, _mm256_cmp_pd(v, v, _CMP_ORD_Q));
+            v = _mm256_min_pd(_mm256_max_pd(v, min), max);
+            r[j] = RoundD_avx2(v);
+        }
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packs_epi32(r[0], r[1]));
+    }
+    TAIL(Fl64toS16, i, n);
+}
+
+FORMAT_AVX2
+static size_t Fl64toFl32k_avx2(float *dst, const double *src,
+                               size_t n, float scale)
+{
+    const __m256 k = _mm256_set1_ps(scale);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(&dst[i], _mm256_mul_ps(LoadD_avx2(&src[i], 1.), k));
+    return i;
+}
+
+FORMAT_AVX2
+static void Fl64toS32_avx2(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    int32_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+        _mm256_storeu_si256((__m256i *)&dst[i],
+                            ToS32_avx2(LoadD_avx2(&src[i], 2147483648.)));
+    TAIL(Fl64toS32, i, n);
+}
+
+TO_FL32_ALL(avx2, FORMAT_AVX2)
+#endif
+
+/*****************************************************************************
+ * NEON (AArch64 only, for the double vectors and rounding conversions)
+ *****************************************************************************/
+#ifdef FORMAT_NEON
+/* vcvtaq rounds halfway cases away from zero like lroundf(), and converts
+ * NaN to 0 */
+static inline int32x4_t ToU8_neon(float32x4_t s)
+{
+    const uint32x4_t hi = vcgeq_f32(s, vdupq_n_f32(127.f));
+    const uint32x4_t lo = vcleq_f32(s, vdupq_n_f32(-128.f));
+    int32x4_t r = vaddq_s32(vcvtaq_s32_f32(s), vdupq_n_s32(128));
+
+    r = vbslq_s32(hi, vdupq_n_s32(255), r);
+    return vbslq_s32(lo, vdupq_n_s32(0), r);
+}
+
+static inline uint8x8_t PackU8_neon(int32x4_t a, int32x4_t b)
+{
+    return vqmovn_u16(vcombine_u16(vqmovun_s32(a), vqmovun_s32(b)));
+}
+
+static inline float32x4_t LoadD_neon(const double *src, double scale)
+{
+    const float64x2_t k = vdupq_n_f64(scale);
+    const float32x2_t lo = vcvt_f32_f64(vmulq_f64(vld1q_f64(src), k));
+    return vcvt_high_f32_f64(lo, vmulq_f64(vld1q_f64(src + 2), k));
+}
+
+/*** from U8 ***/
+static void U8toS16_neon(void *restrict dst_, const void *restrict src_,
+                         size_t n)
+{
+    const uint8_t *src = src_;
+    int16_t *dst = dst_;
+    const uint16x8_t bias = vdupq_n_u16(0x8000);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const uint16x8_t x = vshll_n_u8(vld1_u8(&src[i]), 8);
+        vst1q_s16(&dst[i], vreinterpretq_s16_u16(veorq_u16(x, bias)));
+    }
+    TAIL(U8toS16, i, n);
+}
+
+static size_t U8toFl32k_neon(float *restrict dst, const uint8_t *restrict src,
+                             size_t n, float scale)
+{
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const int16x8_t x = vsubq_s16(
+            vreinterpretq_s16_u16(vmovl_u8(vld1_u8(&src[i]))),
+            vdupq_n_s16(128));
+
+        vst1q_f32(&dst[i], vmulq_n_f32(vcvtq_f32_s32(
+                               vmovl_s16(vget_low_s16(x))), scale));
+        vst1q_f32(&dst[i + 4], vmulq_n_f32(vcvtq_f32_s32(
+                                   vmovl_high_s16(x)), scale));
+    }
+    return i;
+}
+
+static void U8toS32_neon(void *restrict dst_, const void *restrict src_,
+                         size_t n)
+{
+    const uint8_t *src = src_;
+    int32_t *dst = dst_;
+    const uint32x4_t bias = vdupq_n_u32(0x80000000);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const uint16x8_t x = vmovl_u8(vld1_u8(&src[i]));
+        const uint32x4_t lo = vshll_n_u16(vget_low_u16(x), 16);
+        const uint32x4_t hi = vshll_high_n_u16(x, 16);
+
+        vst1q_s32(&dst[i], vreinterpretq_s32_u32(
+                               veorq_u32(vshlq_n_u32(lo, 8), bias)));
+        vst1q_s32(&dst[i + 4], vreinterpretq_s32_u32(
+                                   veorq_u32(vshlq_n_u32(hi, 8), bias)));
+    }
+    TAIL(U8toS32, i, n);
+}
+
+static void U8toFl64_neon(void *restrict dst_, const void *restrict src_,
+                          size_t n)
+{
+    const uint8_t *src = src_;
+    double *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const int16x8_t x = vsubq_s16(
+            vreinterpretq_s16_u16(vmovl_u8(vld1_u8(&src[i]))),
+            vdupq_n_s16(128));
+        const int32x4_t w[2] = {
+            vmovl_s16(vget_low_s16(x)), vmovl_high_s16(x),
+        };
+
+        for (unsigned j = 0; j < 2; j++)
+        {
+            vst1q_f64(&dst[i + 4 * j], vmulq_n_f64(vcvtq_f64_s64(
+                          vmovl_s32(vget_low_s32(w[j]))), 1. / 128.));
+            vst1q_f64(&dst[i + 4 * j + 2], vmulq_n_f64(vcvtq_f64_s64(
+                          vmovl_high_s32(w[j])), 1. / 128.));
+        }
+    }
+    TAIL(U8toFl64, i, n);
+}
+
+/*** from S16N ***/
+static void S16toU8_neon(void *dst_, const void *src_, size_t n)
+{
+    const int16_t *src = src_;
+    uint8_t *dst = dst_;
+    const uint16x8_t bias = vdupq_n_u16(0x8000);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const uint16x8_t x = vreinterpretq_u16_s16(vld1q_s16(&src[i]));
+        vst1_u8(&dst[i], vshrn_n_u16(veorq_u16(x, bias), 8));
+    }
+    TAIL(S16toU8, i, n);
+}
+
+static size_t S16toFl32k_neon(float *restrict dst, const int16_t *restrict src,
+                              size_t n, float scale)
+{
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const int16x8_t x = vld1q_s16(&src[i]);
+
+        vst1q_f32(&dst[i], vmulq_n_f32(vcvtq_f32_s32(
+                               vmovl_s16(vget_low_s16(x))), scale));
+        vst1q_f32(&dst[i + 4], vmulq_n_f32(vcvtq_f32_s32(
+                                   vmovl_high_s16(x)), scale));
+    }
+    return i;
+}
+
+static void S16toS32_neon(void *restrict dst_, const void *restrict src_,
+                          size_t n)
+{
+    const int16_t *src = src_;
+    int32_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const int16x8_t x = vld1q_s16(&src[i]);
+
+        vst1q_s32(&dst[i], vshll_n_s16(vget_low_s16(x), 16));
+        vst1q_s32(&dst[i + 4], vshll_high_n_s16(x, 16));
+    }
+    TAIL(S16toS32, i, n);
+}
+
+static void S16toFl64_neon(void *restrict dst_, const void *restrict src_,
+                           size_t n)
+{
+    const int16_t *src = src_;
+    double *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        const int32x4_t x = vmovl_s16(vld1_s16(&src[i]));
+
+        vst1q_f64(&dst[i], vmulq_n_f64(vcvtq_f64_s64(
+                               vmovl_s32(vget_low_s32(x))), 1. / 32768.));
+        vst1q_f64(&dst[i + 2], vmulq_n_f64(vcvtq_f64_s64(
+                                   vmovl_high_s32(x)), 1. / 32768.));
+    }
+    TAIL(S16toFl64, i, n);
+}
+
+/*** from FL32 ***/
+static void Fl32toU8_neon(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    uint8_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const int32x4_t a = ToU8_neon(vmulq_n_f32(vld1q_f32(&src[i]), 128.f));
+        const int32x4_t b = ToU8_neon(vmulq_n_f32(vld1q_f32(&src[i + 4]),
+                                                  128.f));
+        vst1_u8(&dst[i], PackU8_neon(a, b));
+    }
+    TAIL(Fl32toU8, i, n);
+}
+
+static void Fl32toS16_neon(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int16_t *dst = dst_;
+    const int32x4_t max = vdupq_n_s32(0x43c07fff);
+    const int32x4_t min = vdupq_n_s32(0x43bf8000);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        int32x4_t r[2];
+
+        for (unsigned j = 0; j < 2; j++)
+        {
+            int32x4_t u = vreinterpretq_s32_f32(
+                vaddq_f32(vld1q_f32(&src[i + 4 * j]), vdupq_n_f32(384.f)));
+
+            u = vmaxq_s32(vminq_s32(u, max), min);
+            r[j] = vsubq_s32(u, vdupq_n_s32(0x43c00000));
+        }
+        vst1q_s16(&dst[i], vcombine_s16(vmovn_s32(r[0]), vmovn_s32(r[1])));
+    }
+    TAIL(Fl32toS16, i, n);
+}
+
+static void Fl32toS32_neon(void *dst_, const void *src_, size_t n)
+{
+    const float *src = src_;
+    int32_t *dst = dst_;
+    size_t i;
+
+    /* vcvtaq saturates like the C code */
+    for (i = 0; i + 4 <= n; i += 4)
+        vst1q_s32(&dst[i], vcvtaq_s32_f32(vmulq_n_f32(vld1q_f32(&src[i]),
+                                                      2147483648.f)));
+    TAIL(Fl32toS32, i, n);
+}
+
+static void Fl32toFl64_neon(void *restrict dst_, const void *restrict src_,
+                            size_t n)
+{
+    const float *src = src_;
+    double *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        const float32x4_t x = vld1q_f32(&src[i]);
+
+        vst1q_f64(&dst[i], vcvt_f64_f32(vget_low_f32(x)));
+        vst1q_f64(&dst[i + 2], vcvt_high_f64_f32(x));
+    }
+    TAIL(Fl32toFl64, i, n);
+}
+
+/*** from S32N ***/
+static void S32toU8_neon(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    uint8_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const uint16x4_t a = vshrn_n_u32(
+            vreinterpretq_u32_s32(vld1q_s32(&src[i])), 16);
+        const uint16x4_t b = vshrn_n_u32(
+            vreinterpretq_u32_s32(vld1q_s32(&src[i + 4])), 16);
+        const uint8x8_t x = vshrn_n_u16(vcombine_u16(a, b), 8);
+
+        vst1_u8(&dst[i], veor_u8(x, vdup_n_u8(0x80)));
+    }
+    TAIL(S32toU8, i, n);
+}
+
+static void S32toS16_neon(void *dst_, const void *src_, size_t n)
+{
+    const int32_t *src = src_;
+    int16_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const int16x4_t a = vshrn_n_s32(vld1q_s32(&src[i]), 16);
+        const int16x4_t b = vshrn_n_s32(vld1q_s32(&src[i + 4]), 16);
+
+        vst1q_s16(&dst[i], vcombine_s16(a, b));
+    }
+    TAIL(S32toS16, i, n);
+}
+
+static size_t S32toFl32k_neon(float *dst, const int32_t *src,
+                              size_t n, float scale)
+{
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        vst1q_f32(&dst[i], vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(&src[i])),
+                                       scale));
+    return i;
+}
+
+static void S32toFl64_neon(void *restrict dst_, const void *restrict src_,
+                           size_t n)
+{
+    const int32_t *src = src_;
+    double *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        const int32x4_t x = vld1q_s32(&src[i]);
+
+        vst1q_f64(&dst[i], vmulq_n_f64(vcvtq_f64_s64(
+                               vmovl_s32(vget_low_s32(x))), 1. / 2147483648.));
+        vst1q_f64(&dst[i + 2], vmulq_n_f64(vcvtq_f64_s64(
+                                   vmovl_high_s32(x)), 1. / 2147483648.));
+    }
+    TAIL(S32toFl64, i, n);
+}
+
+/*** from FL64 ***/
+static void Fl64toU8_neon(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    uint8_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        const int32x4_t a = ToU8_neon(LoadD_neon(&src[i], 128.));
+        const int32x4_t b = ToU8_neon(LoadD_neon(&src[i + 4], 128.));
+
+        vst1_u8(&dst[i], PackU8_neon(a, b));
+    }
+    TAIL(Fl64toU8, i, n);
+}
+
+static void Fl64toS16_neon(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    int16_t *dst = dst_;
+    const float64x2_t max = vdupq_n_f64(32767.), min = vdupq_n_f64(-32768.);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        int32x2_t r[2];
+
+        for (unsigned j = 0; j < 2; j++)
+        {
+            float64x2_t v = vmulq_n_f64(vld1q_f64(&src[i + 2 * j]), 32768.);
+
+            /* NaN goes through, and converts to 0 */
+            v = vminq_f64(vmaxq_f64(v, min), max);
+            r[j] = vmovn_s64(vcvtaq_s64_f64(v));
+        }
+        vst1_s16(&dst[i], vmovn_s32(vcombine_s32(r[0], r[1])));
+    }
+    TAIL(Fl64toS16, i, n);
+}
+
+static size_t Fl64toFl32k_neon(float *dst, const double *src,
+                               size_t n, float scale)
+{
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        vst1q_f32(&dst[i], vmulq_n_f32(LoadD_neon(&src[i], 1.), scale));
+    return i;
+}
+
+static void Fl64toS32_neon(void *dst_, const void *src_, size_t n)
+{
+    const double *src = src_;
+    int32_t *dst = dst_;
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+        vst1q_s32(&dst[i], vcvtaq_s32_f32(LoadD_neon(&src[i], 2147483648.)));
+    TAIL(Fl64toS32, i, n);
+}
+
+TO_FL32_ALL(neon, )
+#endif
+
+/*****************************************************************************
+ * Selection
+ *****************************************************************************/
+#ifdef FORMAT_SSE2
+# define SSE2(name) name##_sse2
+#else
+# define SSE2(name) NULL
+#endif
+#ifdef FORMAT_AVX2
+# define AVX2(name) name##_avx2
+#else
+# define AVX2(name) NULL
+#endif
+#ifdef FORMAT_NEON
+# define NEON(name) name##_neon
+#else
+# define NEON(name) NULL
+#endif
+
+#define KERNELS(src, dst, name) \
+    { VLC_CODEC_##src, VLC_CODEC_##dst, name##_c, \
+      SSE2(name), AVX2(name), NEON(name) }
+
+const format_kernels_t format_kernels[] = {
+    KERNELS(U8,   S16N, U8toS16),
+    KERNELS(U8,   FL32, U8toFl32),
+    KERNELS(U8,   S32N, U8toS32),
+    KERNELS(U8,   FL64, U8toFl64),
+
+    KERNELS(S16N, U8,   S16toU8),
+    KERNELS(S16N, FL32, S16toFl32),
+    KERNELS(S16N, S32N, S16toS32),
+    KERNELS(S16N, FL64, S16toFl64),
+
+    KERNELS(FL32, U8,   Fl32toU8),
+    KERNELS(FL32, S16N, Fl32toS16),
+    KERNELS(FL32, S32N, Fl32toS32),
+    KERNELS(FL32, FL64, Fl32toFl64),
+
+    KERNELS(S32N, U8,   S32toU8),
+    KERNELS(S32N, S16N, S32toS16),
+    KERNELS(S32N, FL32, S32toFl32),
+    KERNELS(S32N, FL64, S32toFl64),
+
+    KERNELS(FL64, U8,   Fl64toU8),
+    KERNELS(FL64, S16N, Fl64toS16),
+    KERNELS(FL64, FL32, Fl64toFl32),
+    KERNELS(FL64, S32N, Fl64toS32),
+};
+
+const size_t format_kernels_count = ARRAY_SIZE(format_kernels);
+
+#define GAIN_KERNELS(src, name) \
+    { VLC_CODEC_##src, name##g_c, \
+      SSE2(name##g), AVX2(name##g), NEON(name##g) }
+
+const format_gain_kernels_t format_gain_kernels[] = {
+    GAIN_KERNELS(U8,   U8toFl32),
+    GAIN_KERNELS(S16N, S16toFl32),
+    GAIN_KERNELS(S32N, S32toFl32),
+    GAIN_KERNELS(FL64, Fl64toFl32),
+};
+
+const size_t format_gain_kernels_count = ARRAY_SIZE(format_gain_kernels);
+
+const format_kernels_t *format_FindKernels(vlc_fourcc_t src, vlc_fourcc_t dst)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(format_kernels); i++)
+        if (format_kernels[i].src == src && format_kernels[i].dst == dst)
+            return &format_kernels[i];
+    return NULL;
+}
+
+#if defined(FORMAT_AVX2)
+# define SELECT_AVX2(k, name) \
+    if ((k)->avx2 != NULL && vlc_CPU_AVX2()) \
+    { \
+        *(name) = "AVX2"; \
+        return (k)->avx2; \
+    }
+#else
+# define SELECT_AVX2(k, name)
+#endif
+#if defined(FORMAT_SSE2)
+# define SELECT_SSE2(k, name) \
+    if ((k)->sse2 != NULL && vlc_CPU_SSE2()) \
+    { \
+        *(name) = "SSE2"; \
+        return (k)->sse2; \
+    }
+#else
+# define SELECT_SSE2(k, name)
+#endif
+#if defined(FORMAT_NEON)
+# define SELECT_NEON(k, name) \
+    if ((k)->neon != NULL && vlc_CPU_ARM_NEON()) \
+    { \
+        *(name) = "NEON"; \
+        return (k)->neon; \
+    }
+#else
+# define SELECT_NEON(k, name)
+#endif
+#define SELECT(k, name) \
+    SELECT_AVX2(k, name) \
+    SELECT_SSE2(k, name) \
+    SELECT_NEON(k, name) \
+    *(name) = "C"; \
+    return (k)->c
+
+format_kernel_t format_GetKernel(const format_kernels_t *k, const char **name)
+{
+    SELECT(k, name);
+}
+
+const format_gain_kernels_t *format_FindGainKernels(vlc_fourcc_t src)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(format_gain_kernels); i++)
+        if (format_gain_kernels[i].src == src)
+            return &format_gain_kernels[i];
+    return NULL;
+}
+
+format_gain_kernel_t format_GetGainKernel(const format_gain_kernels_t *k,
+                                          const char **name)
+{
+    SELECT(k, name);
+}
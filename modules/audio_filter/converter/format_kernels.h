@@ -0,0 +1,72 @@
+/*****************************************************************************
+ * format_kernels.h : PCM format conversion kernels
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FORMAT_KERNELS_H
+#define VLC_FORMAT_KERNELS_H
+
+/* Converts samples from src to dst. When the output samples are not larger
+ * than the input ones, dst may be src: the conversion is then in place. */
+typedef void (*format_kernel_t)(void *dst, const void *src, size_t samples);
+
+/* Implementations of one conversion. The vector ones give the same results
+ * as the C one, bit for bit, and are NULL where missing. */
+typedef struct
+{
+    vlc_fourcc_t src;
+    vlc_fourcc_t dst;
+    format_kernel_t c;
+    format_kernel_t sse2;
+    format_kernel_t avx2;
+    format_kernel_t neon;
+} format_kernels_t;
+
+extern const format_kernels_t format_kernels[];
+extern const size_t format_kernels_count;
+
+/* Returns the implementations of a conversion, or NULL if not supported */
+const format_kernels_t *format_FindKernels(vlc_fourcc_t src, vlc_fourcc_t dst);
+
+/* Returns the fastest implementation for the CPU, and names it */
+format_kernel_t format_GetKernel(const format_kernels_t *, const char **name);
+
+/* Converts samples from src to FL32 and multiplies them by gain, in a single
+ * pass. dst may be src as for format_kernel_t. */
+typedef void (*format_gain_kernel_t)(void *dst, const void *src,
+                                     size_t samples, float gain);
+
+typedef struct
+{
+    vlc_fourcc_t src;
+    format_gain_kernel_t c;
+    format_gain_kernel_t sse2;
+    format_gain_kernel_t avx2;
+    format_gain_kernel_t neon;
+} format_gain_kernels_t;
+
+extern const format_gain_kernels_t format_gain_kernels[];
+extern const size_t format_gain_kernels_count;
+
+/* Returns the implementations of a conversion to FL32 with a gain, or NULL */
+const format_gain_kernels_t *format_FindGainKernels(vlc_fourcc_t src);
+
+format_gain_kernel_t format_GetGainKernel(const format_gain_kernels_t *,
+                                          const char **name);
+
+#endif
@@ -34,6 +34,8 @@
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
 
+#include "volume_kernels.h"
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -50,36 +52,6 @@ vlc_module_begin ()
     set_callback( Create )
 vlc_module_end ()
 
-/**
- * Mixes a new output buffer
- */
-static void FilterFL32( audio_volume_t *p_volume, block_t *p_buffer,
-                        float f_multiplier )
-{
-    if( f_multiplier == 1.f )
-        return; /* nothing to do */
-
-    float *p = (float *)p_buffer->p_buffer;
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
-        *(p++) *= f_multiplier;
-
-    (void) p_volume;
-}
-
-static void FilterFL64( audio_volume_t *p_volume, block_t *p_buffer,
-                        float f_multiplier )
-{
-    double *p = (double *)p_buffer->p_buffer;
-    double mult = f_multiplier;
-    if( mult == 1. )
-        return; /* nothing to do */
-
-    for( size_t i = p_buffer->i_buffer / sizeof(*p); i > 0; i-- )
-        *(p++) *= mult;
-
-    (void) p_volume;
-}
-
 /**
  * Initializes the mixer
  */
@@ -87,16 +59,13 @@ static int Create( vlc_object_t *p_this )
 {
     audio_volume_t *p_volume = (audio_volume_t *)p_this;
 
-    switch (p_volume->format)
-    {
-        case VLC_CODEC_FL32:
-            p_volume->amplify = FilterFL32;
-            break;
-        case VLC_CODEC_FL64:
-            p_volume->amplify = FilterFL64;
-            break;
-        default:
-            return -1;
-    }
+    if( p_volume->format != VLC_CODEC_FL32
+     && p_volume->format != VLC_CODEC_FL64 )
+        return -1;
+
+    const volume_kernels_t *p_kernels = volume_FindKernels( p_volume->format );
+    const char *psz_name;
+    p_volume->amplify = volume_GetKernel( p_kernels, &psz_name );
+    msg_Dbg( p_volume, "using %s amplifier", psz_name );
     return 0;
 }
@@ -0,0 +1,528 @@
+/*****************************************************************************
+ * volume_kernels.c : software volume kernels
+ *****************************************************************************
+ * Copyright (C) 2002 VLC authors and VideoLAN
+ * Copyright (C) 2011 Rémi Denis-Courmont
+ *
+ * Authors: Christophe Massiot <massiot@via.ecp.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+#include <limits.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+
+#include "volume_kernels.h"
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+# define VOLUME_SSE2 __attribute__ ((__target__ ("sse2")))
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+# define VOLUME_AVX2 __attribute__ ((__target__ ("avx2")))
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+# include <arm_neon.h>
+# define VOLUME_NEON
+#endif
+
+/*****************************************************************************
+ * C, the reference
+ *****************************************************************************/
+
+static void AmplifyFL32(float *p, size_t n, float mult)
+{
+    for (size_t i = n; i > 0; i--)
+        *(p++) *= mult;
+}
+
+static void AmplifyFL64(double *p, size_t n, double mult)
+{
+    for (size_t i = n; i > 0; i--)
+        *(p++) *= mult;
+}
+
+static void AmplifyS32N(int32_t *p, size_t n, int_fast32_t mult)
+{
+    for (; n > 0; n--)
+    {
+        int_fast64_t s = (*p * (int_fast64_t)mult) >> INT64_C(24);
+        if (s > INT32_MAX)
+            s = INT32_MAX;
+        else
+        if (s < INT32_MIN)
+            s = INT32_MIN;
+        *(p++) = s;
+    }
+}
+
+static void AmplifyS16N(int16_t *p, size_t n, int_fast16_t mult)
+{
+    for (; n > 0; n--)
+    {
+        int_fast32_t s = (*p * (int_fast32_t)mult) >> 8;
+        if (s > INT16_MAX)
+            s = INT16_MAX;
+        else
+        if (s < INT16_MIN)
+            s = INT16_MIN;
+        *(p++) = s;
+    }
+}
+
+static void AmplifyU8(uint8_t *p, size_t n, int_fast16_t mult)
+{
+    for (; n > 0; n--)
+    {
+        int_fast32_t s = (((int_fast8_t)(*p - 128)) * (int_fast32_t)mult) >> 8;
+        if (s > INT8_MAX)
+            s = INT8_MAX;
+        else
+        if (s < INT8_MIN)
+            s = INT8_MIN;
+        *(p++) = s + 128;
+    }
+}
+
+static void FilterFL32_c(audio_volume_t *vol, block_t *block, float volume)
+{
+    if (volume == 1.f)
+        return; /* nothing to do */
+
+    AmplifyFL32((float *)block->p_buffer, block->i_buffer / sizeof (float),
+                volume);
+    (void) vol;
+}
+
+static void FilterFL64_c(audio_volume_t *vol, block_t *block, float volume)
+{
+    double mult = volume;
+    if (mult == 1.)
+        return; /* nothing to do */
+
+    AmplifyFL64((double *)block->p_buffer, block->i_buffer / sizeof (double),
+                mult);
+    (void) vol;
+}
+
+static void FilterS32N_c(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast32_t mult = lroundf(volume * 0x1.p24f);
+    if (mult == (1 << 24))
+        return;
+
+    AmplifyS32N((int32_t *)block->p_buffer,
+                block->i_buffer / sizeof (int32_t), mult);
+    (void) vol;
+}
+
+static void FilterS16N_c(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast16_t mult = lroundf(volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+
+    AmplifyS16N((int16_t *)block->p_buffer,
+                block->i_buffer / sizeof (int16_t), mult);
+    (void) vol;
+}
+
+static void FilterU8_c(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast16_t mult = lroundf(volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+
+    AmplifyU8(block->p_buffer, block->i_buffer, mult);
+    (void) vol;
+}
+
+/*****************************************************************************
+ * SSE2
+ *****************************************************************************/
+#ifdef VOLUME_SSE2
+VOLUME_SSE2
+static void FilterFL32_sse2(audio_volume_t *vol, block_t *block, float volume)
+{
+    if (volume == 1.f)
+        return;
+
+    float *p = (float *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    const __m128 k = _mm_set1_ps(volume);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        _mm_storeu_ps(&p[i], _mm_mul_ps(_mm_loadu_ps(&p[i]), k));
+        _mm_storeu_ps(&p[i + 4], _mm_mul_ps(_mm_loadu_ps(&p[i + 4]), k));
+    }
+    AmplifyFL32(&p[i], n - i, volume);
+    (void) vol;
+}
+
+VOLUME_SSE2
+static void FilterFL64_sse2(audio_volume_t *vol, block_t *block, float volume)
+{
+    double mult = volume;
+    if (mult == 1.)
+        return;
+
+    double *p = (double *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    const __m128d k = _mm_set1_pd(mult);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_pd(&p[i], _mm_mul_pd(_mm_loadu_pd(&p[i]), k));
+        _mm_storeu_pd(&p[i + 2], _mm_mul_pd(_mm_loadu_pd(&p[i + 2]), k));
+    }
+    AmplifyFL64(&p[i], n - i, mult);
+    (void) vol;
+}
+
+VOLUME_SSE2
+static void FilterS16N_sse2(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast16_t mult = lroundf(volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+
+    int16_t *p = (int16_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i = 0;
+
+    /* 16x16-bit products, saturated back to 16 bits by the pack */
+    if (mult >= INT16_MIN && mult <= INT16_MAX)
+    {
+        const __m128i k = _mm_set1_epi16(mult);
+
+        for (; i + 8 <= n; i += 8)
+        {
+            const __m128i x = _mm_loadu_si128((const __m128i *)&p[i]);
+            const __m128i lo = _mm_mullo_epi16(x, k);
+            const __m128i hi = _mm_mulhi_epi16(x, k);
+            const __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 8);
+            const __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 8);
+
+            _mm_storeu_si128((__m128i *)&p[i], _mm_packs_epi32(a, b));
+        }
+    }
+    AmplifyS16N(&p[i], n - i, mult);
+    (void) vol;
+}
+#endif
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#ifdef VOLUME_AVX2
+VOLUME_AVX2
+static void FilterFL32_avx2(audio_volume_t *vol, block_t *block, float volume)
+{
+    if (volume == 1.f)
+        return;
+
+    float *p = (float *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    const __m256 k = _mm256_set1_ps(volume);
+    size_t i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        _mm256_storeu_ps(&p[i], _mm256_mul_ps(_mm256_loadu_ps(&p[i]), k));
+        _mm256_storeu_ps(&p[i + 8],
+                         _mm256_mul_ps(_mm256_loadu_ps(&p[i + 8]), k));
+    }
+    AmplifyFL32(&p[i], n - i, volume);
+    (void) vol;
+}
+
+VOLUME_AVX2
+static void FilterFL64_avx2(audio_volume_t *vol, block_t *block, float volume)
+{
+    double mult = volume;
+    if (mult == 1.)
+        return;
+
+    double *p = (double *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    const __m256d k = _mm256_set1_pd(mult);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_pd(&p[i], _mm256_mul_pd(_mm256_loadu_pd(&p[i]), k));
+        _mm256_storeu_pd(&p[i + 4],
+                         _mm256_mul_pd(_mm256_loadu_pd(&p[i + 4]), k));
+    }
+    AmplifyFL64(&p[i], n - i, mult);
+    (void) vol;
+}
+
+VOLUME_AVX2
+static void FilterS32N_avx2(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast32_t mult = lroundf(volume * 0x1.p24f);
+    if (mult == (1 << 24))
+        return;
+
+    int32_t *p = (int32_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i = 0;
+
+    if (mult >= INT32_MIN && mult <= INT32_MAX)
+    {
+        const __m256i k = _mm256_set1_epi32(mult);
+        const __m256i max = _mm256_set1_epi32(INT32_MAX);
+        const __m256i min = _mm256_set1_epi32(INT32_MIN);
+
+        for (; i + 8 <= n; i += 8)
+        {
+            const __m256i x = _mm256_loadu_si256((const __m256i *)&p[i]);
+            /* 64-bit products of the even and the odd samples */
+            const __m256i even = _mm256_mul_epi32(x, k);
+            const __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(x, 32), k);
+
+            /* bits 24 to 55 of the products */
+            __m256i r = _mm256_blend_epi32(_mm256_srli_epi64(even, 24),
+                                           _mm256_slli_epi64(odd, 8), 0xAA);
+            /* bits 32 to 63, which tell whether the result is in range */
+            const __m256i h = _mm256_blend_epi32(
+                _mm256_shuffle_epi32(even, _MM_SHUFFLE(3, 3, 1, 1)), odd, 0xAA);
+
+            r = _mm256_blendv_epi8(r, max,
+                    _mm256_cmpgt_epi32(h, _mm256_set1_epi32((1 << 23) - 1)));
+            r = _mm256_blendv_epi8(r, min,
+                    _mm256_cmpgt_epi32(_mm256_set1_epi32(-(1 << 23)), h));
+            _mm256_storeu_si256((__m256i *)&p[i], r);
+        }
+    }
+    AmplifyS32N(&p[i], n - i, mult);
+    (void) vol;
+}
+
+VOLUME_AVX2
+static void FilterS16N_avx2(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast16_t mult = lroundf(volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+
+    int16_t *p = (int16_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i = 0;
+
+    if (mult >= INT16_MIN && mult <= INT16_MAX)
+    {
+        const __m256i k = _mm256_set1_epi16(mult);
+
+        for (; i + 16 <= n; i += 16)
+        {
+            const __m256i x = _mm256_loadu_si256((const __m256i *)&p[i]);
+            const __m256i lo = _mm256_mullo_epi16(x, k);
+            const __m256i hi = _mm256_mulhi_epi16(x, k);
+            /* unpack and pack both work within 128-bit lanes */
+            const __m256i a = _mm256_srai_epi32(_mm256_unpacklo_epi16(lo, hi),
+                                                8);
+            const __m256i b = _mm256_srai_epi32(_mm256_unpackhi_epi16(lo, hi),
+                                                8);
+
+            _mm256_storeu_si256((__m256i *)&p[i], _mm256_packs_epi32(a, b));
+        }
+    }
+    AmplifyS16N(&p[i], n - i, mult);
+    (void) vol;
+}
+#endif
+
+/*****************************************************************************
+ * NEON (AArch64 only)
+ *****************************************************************************/
+#ifdef VOLUME_NEON
+static void FilterFL32_neon(audio_volume_t *vol, block_t *block, float volume)
+{
+    if (volume == 1.f)
+        return;
+
+    float *p = (float *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        vst1q_f32(&p[i], vmulq_n_f32(vld1q_f32(&p[i]), volume));
+        vst1q_f32(&p[i + 4], vmulq_n_f32(vld1q_f32(&p[i + 4]), volume));
+    }
+    AmplifyFL32(&p[i], n - i, volume);
+    (void) vol;
+}
+
+static void FilterFL64_neon(audio_volume_t *vol, block_t *block, float volume)
+{
+    double mult = volume;
+    if (mult == 1.)
+        return;
+
+    double *p = (double *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i;
+
+    for (i = 0; i + 4 <= n; i += 4)
+    {
+        vst1q_f64(&p[i], vmulq_n_f64(vld1q_f64(&p[i]), mult));
+        vst1q_f64(&p[i + 2], vmulq_n_f64(vld1q_f64(&p[i + 2]), mult));
+    }
+    AmplifyFL64(&p[i], n - i, mult);
+    (void) vol;
+}
+
+static void FilterS32N_neon(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast32_t mult = lroundf(volume * 0x1.p24f);
+    if (mult == (1 << 24))
+        return;
+
+    int32_t *p = (int32_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i = 0;
+
+    /* the saturating narrowing shift does the clipping */
+    if (mult >= INT32_MIN && mult <= INT32_MAX)
+    {
+        const int32x4_t k = vdupq_n_s32(mult);
+
+        for (; i + 4 <= n; i += 4)
+        {
+            const int32x4_t x = vld1q_s32(&p[i]);
+            const int64x2_t lo = vmull_s32(vget_low_s32(x), vget_low_s32(k));
+            const int64x2_t hi = vmull_high_s32(x, k);
+
+            vst1q_s32(&p[i], vcombine_s32(vqshrn_n_s64(lo, 24),
+                                          vqshrn_n_s64(hi, 24)));
+        }
+    }
+    AmplifyS32N(&p[i], n - i, mult);
+    (void) vol;
+}
+
+static void FilterS16N_neon(audio_volume_t *vol, block_t *block, float volume)
+{
+    int_fast16_t mult = lroundf(volume * 0x1.p8f);
+    if (mult == (1 << 8))
+        return;
+
+    int16_t *p = (int16_t *)block->p_buffer;
+    const size_t n = block->i_buffer / sizeof (*p);
+    size_t i = 0;
+
+    if (mult >= INT16_MIN && mult <= INT16_MAX)
+    {
+        const int16x8_t k = vdupq_n_s16(mult);
+
+        for (; i + 8 <= n; i += 8)
+        {
+            const int16x8_t x = vld1q_s16(&p[i]);
+            const int32x4_t lo = vmull_s16(vget_low_s16(x), vget_low_s16(k));
+            const int32x4_t hi = vmull_high_s16(x, k);
+
+            vst1q_s16(&p[i], vcombine_s16(vqshrn_n_s32(lo, 8),
+                                          vqshrn_n_s32(hi, 8)));
+        }
+    }
+    AmplifyS16N(&p[i], n - i, mult);
+    (void) vol;
+}
+#endif
+
+/*****************************************************************************
+ * Selection
+ *****************************************************************************/
+#ifdef VOLUME_SSE2
+# define SSE2(name) name##_sse2
+#else
+# define SSE2(name) NULL
+#endif
+#ifdef VOLUME_AVX2
+# define AVX2(name) name##_avx2
+#else
+# define AVX2(name) NULL
+#endif
+#ifdef VOLUME_NEON
+# define NEON(name) name##_neon
+#else
+# define NEON(name) NULL
+#endif
+
+const volume_kernels_t volume_kernels[] = {
+    { VLC_CODEC_FL32, FilterFL32_c,
+      SSE2(FilterFL32), AVX2(FilterFL32), NEON(FilterFL32) },
+    { VLC_CODEC_FL64, FilterFL64_c,
+      SSE2(FilterFL64), AVX2(FilterFL64), NEON(FilterFL64) },
+    /* SSE2 has no signed 32x32-bit multiplication */
+    { VLC_CODEC_S32N, FilterS32N_c,
+      NULL, AVX2(FilterS32N), NEON(FilterS32N) },
+    { VLC_CODEC_S16N, FilterS16N_c,
+      SSE2(FilterS16N), AVX2(FilterS16N), NEON(FilterS16N) },
+    { VLC_CODEC_U8, FilterU8_c, NULL, NULL, NULL },
+};
+
+const size_t volume_kernels_count = ARRAY_SIZE(volume_kernels);
+
+const volume_kernels_t *volume_FindKernels(vlc_fourcc_t format)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(volume_kernels); i++)
+        if (volume_kernels[i].format == format)
+            return &volume_kernels[i];
+    return NULL;
+}
+
+volume_kernel_t volume_GetKernel(const volume_kernels_t *k, const char **name)
+{
+#ifdef VOLUME_AVX2
+    if (k->avx2 != NULL && vlc_CPU_AVX2())
+    {
+        *name = "AVX2";
+        return k->avx2;
+    }
+#endif
+#ifdef VOLUME_SSE2
+    if (k->sse2 != NULL && vlc_CPU_SSE2())
+    {
+        *name = "SSE2";
+        return k->sse2;
+    }
+#endif
+#ifdef VOLUME_NEON
+    if (k->neon != NULL && vlc_CPU_ARM_NEON())
+    {
+        *name = "NEON";
+        return k->neon;
+    }
+#endif
+    *name = "C";
+    return k->c;
+}
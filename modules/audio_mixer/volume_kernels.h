@@ -0,0 +1,49 @@
+/*****************************************************************************
+ * volume_kernels.h : software volume kernels
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_VOLUME_KERNELS_H
+#define VLC_VOLUME_KERNELS_H
+
+#include <vlc_aout_volume.h>
+
+/* Amplifies a block in place; this is the audio_volume_t amplify callback */
+typedef void (*volume_kernel_t)(audio_volume_t *, block_t *, float);
+
+/* Implementations for one sample format. The vector ones give the same
+ * results as the C one, bit for bit, and are NULL where missing. */
+typedef struct
+{
+    vlc_fourcc_t format;
+    volume_kernel_t c;
+    volume_kernel_t sse2;
+    volume_kernel_t avx2;
+    volume_kernel_t neon;
+} volume_kernels_t;
+
+extern const volume_kernels_t volume_kernels[];
+extern const size_t volume_kernels_count;
+
+/* Returns the implementations for a format, or NULL if not supported */
+const volume_kernels_t *volume_FindKernels(vlc_fourcc_t format);
+
+/* Returns the fastest implementation for the CPU, and names it */
+volume_kernel_t volume_GetKernel(const volume_kernels_t *, const char **name);
+
+#endif
@@ -94,6 +94,10 @@ typedef struct
     bool        b_direct_rendering;
     atomic_bool b_dr_failure;
 
+    /* pictures output, and how many of them had to be copied */
+    unsigned    i_pictures;
+    unsigned    i_copies;
+
     /* Hack to force display of still pictures */
     bool b_first_frame;
 
@@ -1278,6 +1282,7 @@ static int DecodeBlock( decoder_t *p_dec, block_t **pp_block )
                 picture_Release( p_pic );
                 break;
             }
+            p_sys->i_copies++;
         }
         else
         {
@@ -1328,6 +1333,7 @@ static int DecodeBlock( decoder_t *p_dec, block_t **pp_block )
             if(p_frame_info->b_eos)
                 p_pic->b_still = true;
             p_sys->b_first_frame = false;
+            p_sys->i_pictures++;
             vlc_mutex_unlock(&p_sys->lock);
             decoder_QueueVideo( p_dec, p_pic );
         }
@@ -1397,6 +1403,11 @@ void EndVideoDec( vlc_object_t *obj )
 
     cc_Flush( &p_sys->cc );
 
+    if( p_sys->i_pictures > 0 )
+        msg_Dbg( p_dec, "%u pictures output, %.2f copies per picture",
+                 p_sys->i_pictures,
+                 (double)p_sys->i_copies / p_sys->i_pictures );
+
     avcodec_free_context( &ctx );
 
     if( p_sys->p_va )
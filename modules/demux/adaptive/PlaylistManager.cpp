@@ -107,6 +107,8 @@ bool PlaylistManager::setupPeriod()
     if(!logic && !(logic = createLogic(logicType, resources->getConnManager())))
         return false;
 
+    const int64_t prefetch = var_InheritInteger(p_demux, "adaptive-prefetch");
+
     std::vector<BaseAdaptationSet*> sets = currentPeriod->getAdaptationSets();
     std::vector<BaseAdaptationSet*>::iterator it;
     for(it=sets.begin();it!=sets.end();++it)
@@ -117,6 +119,8 @@ bool PlaylistManager::setupPeriod()
             SegmentTracker *tracker = new SegmentTracker(resources, logic, set);
             if(!tracker)
                 continue;
+            if(prefetch > 0)
+                tracker->setPrefetchDepth(prefetch);
 
             AbstractStream *st = streamFactory->create(p_demux, set->getStreamFormat(),
                                                        tracker, resources->getConnManager());
@@ -86,6 +86,7 @@ SegmentTracker::SegmentTracker(SharedResources *res,
     index_sent = false;
     init_sent = false;
     curRepresentation = NULL;
+    prefetchDepth = 0;
     setAdaptationLogic(logic_);
     adaptationSet = adaptSet;
     format = StreamFormat::UNKNOWN;
@@ -152,8 +153,70 @@ bool SegmentTracker::segmentsListReady() const
     return true;
 }
 
+void SegmentTracker::setPrefetchDepth(unsigned depth)
+{
+    prefetchDepth = depth;
+}
+
+SegmentChunk * SegmentTracker::getPrefetchedChunk(BaseRepresentation *rep, uint64_t number)
+{
+    /* drop the ones we can no longer use (switched or skipped) */
+    while(!prefetched.empty() &&
+          (prefetched.front().rep != rep || prefetched.front().number < number))
+    {
+        delete prefetched.front().chunk;
+        prefetched.pop_front();
+    }
+
+    if(prefetched.empty() || prefetched.front().number != number)
+        return NULL;
+
+    SegmentChunk *chunk = prefetched.front().chunk;
+    prefetched.pop_front();
+    return chunk;
+}
+
+void SegmentTracker::prefetchChunks(AbstractConnectionManager *connManager)
+{
+    BaseRepresentation *rep = curRepresentation;
+    if(!rep)
+        return;
+
+    for(uint64_t number = next; number < next + prefetchDepth; number++)
+    {
+        if(!prefetched.empty() && prefetched.back().number >= number)
+            continue;
+
+        /* only contiguous and already listed segments */
+        uint64_t found;
+        bool b_gap;
+        ISegment *segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA,
+                                                number, &found, &b_gap);
+        if(!segment || found != number)
+            break;
+
+        PrefetchedChunk entry;
+        entry.rep = rep;
+        entry.number = number;
+        entry.chunk = segment->toChunk(resources, connManager, number, rep);
+        if(!entry.chunk)
+            break;
+        prefetched.push_back(entry);
+    }
+}
+
+void SegmentTracker::clearPrefetchedChunks()
+{
+    while(!prefetched.empty())
+    {
+        delete prefetched.front().chunk;
+        prefetched.pop_front();
+    }
+}
+
 void SegmentTracker::reset()
 {
+    clearPrefetchedChunks();
     notify(SegmentTrackerEvent(curRepresentation, NULL));
     curRepresentation = NULL;
     init_sent = false;
@@ -276,7 +339,9 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
         initializing = false;
     }
 
-    SegmentChunk *chunk = segment->toChunk(resources, connManager, next, rep);
+    SegmentChunk *chunk = getPrefetchedChunk(rep, next);
+    if(!chunk)
+        chunk = segment->toChunk(resources, connManager, next, rep);
 
     /* Notify new segment length for stats / logic */
     if(chunk)
@@ -303,6 +368,7 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     {
         curNumber = next;
         next++;
+        prefetchChunks(connManager);
     }
 
     return chunk;
@@ -341,6 +407,7 @@ void SegmentTracker::setPositionByNumber(uint64_t segnumber, bool restarted)
         index_sent = false;
         init_sent = false;
     }
+    clearPrefetchedChunks();
     curNumber = next = segnumber;
 }
 
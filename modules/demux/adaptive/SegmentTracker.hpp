@@ -136,10 +136,14 @@ namespace adaptive
             void notifyBufferingLevel(vlc_tick_t, vlc_tick_t, vlc_tick_t) const;
             void registerListener(SegmentTrackerListenerInterface *);
             void updateSelected();
+            void setPrefetchDepth(unsigned);
 
         private:
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const SegmentTrackerEvent &) const;
+            SegmentChunk * getPrefetchedChunk(BaseRepresentation *, uint64_t);
+            void prefetchChunks(AbstractConnectionManager *);
+            void clearPrefetchedChunks();
             bool first;
             bool initializing;
             bool index_sent;
@@ -152,6 +156,17 @@ namespace adaptive
             BaseAdaptationSet *adaptationSet;
             BaseRepresentation *curRepresentation;
             std::list<SegmentTrackerListenerInterface *> listeners;
+
+            /* media chunks already downloading, ahead of the current one */
+            class PrefetchedChunk
+            {
+                public:
+                    BaseRepresentation *rep;
+                    uint64_t number;
+                    SegmentChunk *chunk;
+            };
+            std::list<PrefetchedChunk> prefetched;
+            unsigned prefetchDepth;
     };
 }
 
@@ -225,7 +225,7 @@ block_t * HTTPChunkSource::read(size_t readsize)
         if((size_t)ret < readsize)
             eof = true;
         if(ret && time)
-            connManager->updateDownloadRate(sourceid, p_block->i_buffer, time);
+            connManager->updateDownloadRate(sourceid, p_block->i_buffer, time, 0);
     }
 
     return p_block;
@@ -303,6 +303,7 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     eof = false;
     held = false;
     downloadstart = 0;
+    firstbytetime = 0;
 }
 
 HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
@@ -375,7 +376,8 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     {
         size_t size;
         vlc_tick_t time;
-    } rate = {0,0};
+        vlc_tick_t latency;
+    } rate = {0,0,0};
 
     ssize_t ret = connection->read(p_block->p_buffer, readsize);
     if(ret <= 0)
@@ -386,6 +388,7 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         done = true;
         rate.size = buffered + consumed;
         rate.time = vlc_tick_now() - downloadstart;
+        rate.latency = firstbytetime;
         downloadstart = 0;
     }
     else
@@ -399,13 +402,14 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
             done = true;
             rate.size = buffered + consumed;
             rate.time = vlc_tick_now() - downloadstart;
+            rate.latency = firstbytetime;
             downloadstart = 0;
         }
     }
 
     if(rate.size && rate.time)
     {
-        connManager->updateDownloadRate(sourceid, rate.size, rate.time);
+        connManager->updateDownloadRate(sourceid, rate.size, rate.time, rate.latency);
     }
 
     vlc_cond_signal(&avail);
@@ -416,7 +420,10 @@ bool HTTPChunkBufferedSource::prepare()
     if(!prepared)
     {
         downloadstart = vlc_tick_now();
-        return HTTPChunkSource::prepare();
+        if(!HTTPChunkSource::prepare())
+            return false;
+        /* request sent and reply headers received */
+        firstbytetime = vlc_tick_now() - downloadstart;
     }
     return true;
 }
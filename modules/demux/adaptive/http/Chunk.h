@@ -141,6 +141,7 @@ namespace adaptive
                 bool                done;
                 bool                eof;
                 vlc_tick_t          downloadstart;
+                vlc_tick_t          firstbytetime; /* TTFB */
                 vlc_cond_t          avail;
                 bool                held;
         };
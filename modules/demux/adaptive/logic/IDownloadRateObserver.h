@@ -34,7 +34,8 @@ namespace adaptive
     class IDownloadRateObserver
     {
         public:
-            virtual void updateDownloadRate(const ID &, size_t, vlc_tick_t) = 0;
+            /* size, transfer time, and time to first byte of a download */
+            virtual void updateDownloadRate(const ID &, size_t, vlc_tick_t, vlc_tick_t) = 0;
             virtual ~IDownloadRateObserver(){}
     };
 }
@@ -47,6 +47,7 @@ PredictiveStats::PredictiveStats()
     buffering_target = 1;
     last_download_rate = 0;
     last_duration = 1;
+    last_latency = 0;
 }
 
 bool PredictiveStats::starting() const
@@ -105,7 +106,11 @@ BaseRepresentation *PredictiveAdaptationLogic::getNextRepresentation(BaseAdaptat
         }
         else
         {
-            const unsigned i_available_bw = getAvailableBw(i_max_bitrate, prevRep);
+            unsigned i_available_bw = getAvailableBw(i_max_bitrate, prevRep);
+            /* Each segment first waits for the server reply */
+            if(stats.last_latency > 0 && stats.last_latency < stats.last_duration)
+                i_available_bw = i_available_bw *
+                        (double)(stats.last_duration - stats.last_latency) / stats.last_duration;
             if(!prevRep)
             {
                 rep = selector.select(adaptSet, i_available_bw);
@@ -151,14 +156,19 @@ BaseRepresentation *PredictiveAdaptationLogic::getNextRepresentation(BaseAdaptat
     return rep;
 }
 
-void PredictiveAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize, vlc_tick_t time)
+void PredictiveAdaptationLogic::updateDownloadRate(const ID &id, size_t dlsize,
+                                                   vlc_tick_t time, vlc_tick_t latency)
 {
     vlc_mutex_lock(&lock);
     std::map<ID, PredictiveStats>::iterator it = streams.find(id);
     if(it != streams.end())
     {
         PredictiveStats &stats = (*it).second;
+        /* Separate the request round trip from the link throughput */
+        if(latency > 0 && latency < time)
+            time -= latency;
         stats.last_download_rate = stats.average.push(CLOCK_FREQ * dlsize * 8 / time);
+        stats.last_latency = latency;
     }
     vlc_mutex_unlock(&lock);
 }
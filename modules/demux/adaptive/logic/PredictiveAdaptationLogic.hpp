@@ -42,6 +42,7 @@ namespace adaptive
                 vlc_tick_t buffering_target;
                 unsigned last_download_rate;
                 vlc_tick_t last_duration;
+                vlc_tick_t last_latency;
                 MovingAverage<unsigned> average;
         };
 
@@ -52,7 +53,7 @@ namespace adaptive
                 virtual ~PredictiveAdaptationLogic();
 
                 virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *);
-                virtual void                updateDownloadRate     (const ID &, size_t, vlc_tick_t); /* reimpl */
+                virtual void                updateDownloadRate     (const ID &, size_t, vlc_tick_t, vlc_tick_t); /* reimpl */
                 virtual void                trackerEvent           (const SegmentTrackerEvent &); /* reimpl */
 
             private:
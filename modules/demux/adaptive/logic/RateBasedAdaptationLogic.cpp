@@ -44,6 +44,7 @@ RateBasedAdaptationLogic::RateBasedAdaptationLogic  (vlc_object_t *obj) :
     usedBps = 0;
     dllength = 0;
     dlsize = 0;
+    dlend = VLC_TICK_INVALID;
     vlc_mutex_init(&lock);
 }
 
@@ -76,20 +77,36 @@ BaseRepresentation *RateBasedAdaptationLogic::getNextRepresentation(BaseAdaptati
     return rep;
 }
 
-void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size, vlc_tick_t time)
+void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size, vlc_tick_t time, vlc_tick_t)
 {
     if(unlikely(time == 0))
         return;
-    /* Accumulate up to observation window */
-    dllength += time;
+
+    /* Parallel downloads share the link: measure the amount of data over
+     * the time any download was running, not over the sum of their
+     * durations. Reports end now, so the union of the download intervals
+     * only grows by the part after the previous end. */
+    const vlc_tick_t end = vlc_tick_now();
+    const vlc_tick_t start = end - time;
+
+    vlc_mutex_lock(&lock);
+    if(start >= dlend)
+        dllength += time;
+    else if(end > dlend)
+        dllength += end - dlend;
+    if(end > dlend)
+        dlend = end;
     dlsize += size;
 
+    /* Accumulate up to observation window */
     if(dllength < VLC_TICK_FROM_MS(250))
+    {
+        vlc_mutex_unlock(&lock);
         return;
+    }
 
     const size_t bps = CLOCK_FREQ * dlsize * 8 / dllength;
 
-    vlc_mutex_lock(&lock);
     bpsAvg = average.push(bps);
 
 //    BwDebug(msg_Dbg(p_obj, "alpha1 %lf alpha0 %lf dmax %ld ds %ld", alpha,
@@ -0,0 +1,223 @@
+/*****************************************************************************
+ * index_cache.c: demuxers persistent seek index cache
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_configuration.h>
+
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "index_cache.h"
+
+/* magic, version, file size, file mtime, path length */
+#define INDEX_CACHE_MAGIC       "VLCI"
+#define INDEX_CACHE_HEADER_SIZE (4 + 4 + 8 + 8 + 4)
+
+static bool IndexCacheGetKey( demux_t *p_demux, struct stat *p_st )
+{
+    if( p_demux->psz_filepath == NULL ||
+        !var_InheritBool( p_demux, "demux-index-cache" ) )
+        return false;
+
+    return vlc_stat( p_demux->psz_filepath, p_st ) == 0 &&
+           S_ISREG( p_st->st_mode );
+}
+
+static char * IndexCacheGetPath( const char *psz_file, const char *psz_tag,
+                                 bool b_create )
+{
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_cachedir == NULL )
+        return NULL;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, psz_file, strlen( psz_file ) );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    char *psz_path = NULL;
+    if( psz_hash )
+    {
+        if( asprintf( &psz_path, "%s" DIR_SEP "index" DIR_SEP "%s.%s",
+                      psz_cachedir, psz_hash, psz_tag ) == -1 )
+            psz_path = NULL;
+        else if( b_create )
+        {
+            /* create all the parent directories */
+            for( char *psz = strchr( psz_path + 1, DIR_SEP_CHAR ); psz;
+                 psz = strchr( psz + 1, DIR_SEP_CHAR ) )
+            {
+                *psz = '\0';
+                vlc_mkdir( psz_path, 0700 );
+                *psz = DIR_SEP_CHAR;
+            }
+        }
+        free( psz_hash );
+    }
+    free( psz_cachedir );
+    return psz_path;
+}
+
+uint64_t * demux_IndexCacheLoad( demux_t *p_demux, const char *psz_tag,
+                                 uint32_t i_version, size_t *pi_count )
+{
+    struct stat st;
+    if( !IndexCacheGetKey( p_demux, &st ) )
+        return NULL;
+
+    char *psz_path = IndexCacheGetPath( p_demux->psz_filepath, psz_tag, false );
+    if( psz_path == NULL )
+        return NULL;
+
+    FILE *f = vlc_fopen( psz_path, "rb" );
+    free( psz_path );
+    if( f == NULL )
+        return NULL;
+
+    const size_t i_file = strlen( p_demux->psz_filepath );
+    uint64_t *p_values = NULL;
+    uint8_t header[INDEX_CACHE_HEADER_SIZE];
+    uint8_t count[8];
+    char *psz_file = NULL;
+
+    if( fread( header, 1, sizeof(header), f ) != sizeof(header) ||
+        memcmp( header, INDEX_CACHE_MAGIC, 4 ) ||
+        GetDWBE( &header[4] ) != i_version ||
+        GetQWBE( &header[8] ) != (uint64_t) st.st_size ||
+        GetQWBE( &header[16] ) != (uint64_t) st.st_mtime ||
+        GetDWBE( &header[24] ) != i_file )
+        goto end;
+
+    /* different paths can have the same hash */
+    psz_file = malloc( i_file );
+    if( psz_file == NULL ||
+        fread( psz_file, 1, i_file, f ) != i_file ||
+        memcmp( psz_file, p_demux->psz_filepath, i_file ) )
+        goto end;
+
+    /* an index is never larger than the file it describes */
+    if( fread( count, 1, 8, f ) != 8 ||
+        GetQWBE( count ) == 0 || GetQWBE( count ) > (uint64_t) st.st_size )
+        goto end;
+
+    const size_t i_count = GetQWBE( count );
+    p_values = vlc_alloc( i_count, sizeof(*p_values) );
+    if( p_values == NULL )
+        goto end;
+
+    if( fread( p_values, sizeof(*p_values), i_count, f ) != i_count )
+    {
+        free( p_values );
+        p_values = NULL;
+        goto end;
+    }
+
+    for( size_t i = 0; i < i_count; i++ )
+        p_values[i] = GetQWBE( &p_values[i] );
+    *pi_count = i_count;
+
+    msg_Dbg( p_demux, "loaded %s index cache (%zu values)", psz_tag, i_count );
+
+end:
+    free( psz_file );
+    fclose( f );
+    return p_values;
+}
+
+int demux_IndexCacheStore( demux_t *p_demux, const char *psz_tag,
+                           uint32_t i_version, const uint64_t *p_values,
+                           size_t i_count )
+{
+    struct stat st;
+    if( i_count == 0 || !IndexCacheGetKey( p_demux, &st ) )
+        return VLC_EGENERIC;
+
+    char *psz_path = IndexCacheGetPath( p_demux->psz_filepath, psz_tag, true );
+    if( psz_path == NULL )
+        return VLC_ENOMEM;
+
+    char *psz_tmp;
+    if( asprintf( &psz_tmp, "%s.XXXXXX", psz_path ) == -1 )
+    {
+        free( psz_path );
+        return VLC_ENOMEM;
+    }
+
+    /* write to a temporary file of its own first, so that concurrent
+     * instances never read a partial index, nor write to the same file */
+    int i_ret = VLC_EGENERIC;
+    int fd = vlc_mkstemp( psz_tmp );
+    if( fd == -1 )
+    {
+        msg_Warn( p_demux, "cannot create index cache %s: %s", psz_tmp,
+                  vlc_strerror_c( errno ) );
+        goto end;
+    }
+
+    FILE *f = fdopen( fd, "wb" );
+    if( f == NULL )
+    {
+        vlc_close( fd );
+        vlc_unlink( psz_tmp );
+        goto end;
+    }
+
+    const size_t i_file = strlen( p_demux->psz_filepath );
+    uint8_t buf[INDEX_CACHE_HEADER_SIZE];
+    memcpy( buf, INDEX_CACHE_MAGIC, 4 );
+    SetDWBE( &buf[4], i_version );
+    SetQWBE( &buf[8], st.st_size );
+    SetQWBE( &buf[16], st.st_mtime );
+    SetDWBE( &buf[24], i_file );
+
+    bool b_error = fwrite( buf, 1, sizeof(buf), f ) != sizeof(buf) ||
+                   fwrite( p_demux->psz_filepath, 1, i_file, f ) != i_file;
+
+    SetQWBE( buf, i_count );
+    b_error = b_error || fwrite( buf, 1, 8, f ) != 8;
+
+    for( size_t i = 0; i < i_count && !b_error; i++ )
+    {
+        SetQWBE( buf, p_values[i] );
+        b_error = fwrite( buf, 1, 8, f ) != 8;
+    }
+
+    if( fclose( f ) || b_error || vlc_rename( psz_tmp, psz_path ) )
+    {
+        msg_Warn( p_demux, "cannot write index cache %s", psz_path );
+        vlc_unlink( psz_tmp );
+        goto end;
+    }
+
+    msg_Dbg( p_demux, "stored %s index cache (%zu values)", psz_tag, i_count );
+    i_ret = VLC_SUCCESS;
+
+end:
+    free( psz_tmp );
+    free( psz_path );
+    return i_ret;
+}
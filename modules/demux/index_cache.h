@@ -0,0 +1,48 @@
+/*****************************************************************************
+ * index_cache.h: demuxers persistent seek index cache
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_DEMUX_INDEX_CACHE_H
+#define VLC_DEMUX_INDEX_CACHE_H
+
+/* Seek indexes a demuxer had to build by scanning a local file are stored
+ * in the user cache directory, as arrays of 64 bits values, keyed by the
+ * file path, size and modification time. They are only used when the
+ * demux-index-cache option is set.
+ *
+ * psz_tag identifies the index kind within the file, and i_version its
+ * layout, so that data from another layout is never returned. */
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/* Returns the i_count values of the cached index, or NULL if there is no
+ * valid index for the current file. Must be freed by the caller. */
+uint64_t * demux_IndexCacheLoad( demux_t *, const char *psz_tag,
+                                 uint32_t i_version, size_t *pi_count );
+
+/* Replaces the cached index of the current file */
+int demux_IndexCacheStore( demux_t *, const char *psz_tag, uint32_t i_version,
+                           const uint64_t *p_values, size_t i_count );
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif
@@ -27,6 +27,7 @@
 #include "util.hpp"
 #include "Ebml_parser.hpp"
 #include "Ebml_dispatcher.hpp"
+#include "../index_cache.h"
 
 #include <new>
 #include <iterator>
@@ -62,11 +63,15 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,ep( EbmlParser(&estream, p_seg, &demuxer.demuxer ))
     ,b_preloaded(false)
     ,b_ref_external_segments(false)
+    ,b_index_cache(false)
+    ,i_index_cache_values(0)
 {
 }
 
 matroska_segment_c::~matroska_segment_c()
 {
+    StoreIndexCache();
+
     free( psz_writing_application );
     free( psz_muxing_application );
     free( psz_segment_filename );
@@ -681,6 +686,7 @@ bool matroska_segment_c::Preload( )
     }
 
     ComputeTrackPriority();
+    LoadIndexCache();
 
     b_preloaded = true;
 
@@ -690,6 +696,53 @@ bool matroska_segment_c::Preload( )
     return true;
 }
 
+/* Seek index cache, keyed by the segment position in the opened file */
+#define MKV_INDEX_CACHE_VERSION 1
+
+void matroska_segment_c::LoadIndexCache()
+{
+    /* segments linked from other files are not cached */
+    if( sys.streams.empty() || &sys.streams.front()->estream != &es ||
+        !var_InheritBool( &sys.demuxer, "demux-index-cache" ) )
+        return;
+
+    char psz_tag[32];
+    snprintf( psz_tag, sizeof(psz_tag), "mkv.%" PRIu64, segment->GetElementPosition() );
+
+    size_t i_count;
+    uint64_t *p_values = demux_IndexCacheLoad( &sys.demuxer, psz_tag,
+                                               MKV_INDEX_CACHE_VERSION, &i_count );
+    if( p_values )
+    {
+        if( !_seeker.load_index( p_values, i_count ) )
+            msg_Warn( &sys.demuxer, "discarding invalid seek index cache" );
+        free( p_values );
+    }
+
+    std::vector<uint64_t> values;
+    _seeker.save_index( values );
+    i_index_cache_values = values.size();
+    b_index_cache = true;
+}
+
+void matroska_segment_c::StoreIndexCache()
+{
+    if( !b_index_cache )
+        return;
+
+    std::vector<uint64_t> values;
+    _seeker.save_index( values );
+
+    /* only if more of the file got indexed since it was loaded */
+    if( values.size() > i_index_cache_values )
+    {
+        char psz_tag[32];
+        snprintf( psz_tag, sizeof(psz_tag), "mkv.%" PRIu64, segment->GetElementPosition() );
+        demux_IndexCacheStore( &sys.demuxer, psz_tag, MKV_INDEX_CACHE_VERSION,
+                               values.data(), values.size() );
+    }
+}
+
 /* Here we try to load elements that were found in Seek Heads, but not yet parsed */
 bool matroska_segment_c::LoadSeekHeadItem( const EbmlCallbacks & ClassInfos, int64_t i_element_position )
 {
@@ -137,6 +137,8 @@ public:
     EbmlParser                     ep;
     bool                           b_preloaded;
     bool                           b_ref_external_segments;
+    bool                           b_index_cache;
+    size_t                         i_index_cache_values;
 
     bool Preload();
     bool PreloadFamily( const matroska_segment_c & segment );
@@ -172,6 +174,8 @@ private:
     bool TrackInit( mkv_track_t * p_tk );
     void ComputeTrackPriority();
     void EnsureDuration();
+    void LoadIndexCache();
+    void StoreIndexCache();
 
     SegmentSeeker _seeker;
 
@@ -519,4 +519,133 @@ SegmentSeeker::mkv_jump_to( matroska_segment_c& ms, fptr_t fpos )
         ms.es.I_O().setFilePointer( fpos );
 }
 
+void
+SegmentSeeker::save_index( std::vector<uint64_t>& out ) const
+{
+    out.push_back( _ranges_searched.size() );
+    out.push_back( _cluster_positions.size() );
+    out.push_back( _clusters.size() );
+    out.push_back( _tracks_seekpoints.size() );
+
+    for( ranges_t::const_iterator it = _ranges_searched.begin(); it != _ranges_searched.end(); ++it )
+    {
+        out.push_back( it->start );
+        out.push_back( it->end );
+    }
+
+    out.insert( out.end(), _cluster_positions.begin(), _cluster_positions.end() );
+
+    for( cluster_map_t::const_iterator it = _clusters.begin(); it != _clusters.end(); ++it )
+    {
+        out.push_back( it->second.fpos );
+        out.push_back( it->second.pts );
+        out.push_back( it->second.duration );
+        out.push_back( it->second.size );
+    }
+
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin(); it != _tracks_seekpoints.end(); ++it )
+    {
+        out.push_back( it->first );
+        out.push_back( it->second.size() );
+
+        for( seekpoints_t::const_iterator sp = it->second.begin(); sp != it->second.end(); ++sp )
+        {
+            out.push_back( sp->fpos );
+            out.push_back( sp->pts );
+            out.push_back( static_cast<int64_t>( sp->trust_level ) );
+        }
+    }
+}
+
+bool
+SegmentSeeker::load_index( uint64_t const* p, size_t count )
+{
+    uint64_t const* const end = p + count;
+
+    struct Layout {
+        static bool fits( uint64_t const* p, uint64_t const* end, uint64_t n, size_t width )
+        {
+            return n <= static_cast<size_t>( end - p ) / width;
+        }
+    };
+
+    if( !Layout::fits( p, end, 4, 1 ) )
+        return false;
+
+    uint64_t const ranges = p[0], positions = p[1], clusters = p[2], tracks = p[3];
+
+    // validate the whole layout before merging anything
+
+    uint64_t const* it = p + 4;
+
+    if( !Layout::fits( it, end, ranges, 2 ) )
+        return false;
+    it += 2 * ranges;
+
+    if( !Layout::fits( it, end, positions, 1 ) )
+        return false;
+    it += positions;
+
+    if( !Layout::fits( it, end, clusters, 4 ) )
+        return false;
+    it += 4 * clusters;
+
+    for( uint64_t i = 0; i < tracks; ++i )
+    {
+        if( !Layout::fits( it, end, 2, 1 ) || !Layout::fits( it + 2, end, it[1], 3 ) )
+            return false;
+
+        for( uint64_t j = 0; j < it[1]; ++j )
+        {
+            int64_t trust_level = static_cast<int64_t>( it[2 + 3 * j + 2] );
+            if( trust_level != Seekpoint::TRUSTED && trust_level != Seekpoint::QUESTIONABLE &&
+                trust_level != Seekpoint::DISABLED )
+                return false;
+        }
+        it += 2 + 3 * it[1];
+    }
+
+    if( it != end )
+        return false;
+
+    // merge with what was already found while opening
+
+    it = p + 4;
+
+    for( uint64_t i = 0; i < ranges; ++i, it += 2 )
+        mark_range_as_searched( Range( it[0], it[1] ) );
+
+    for( uint64_t i = 0; i < positions; ++i, ++it )
+    {
+        if( !std::binary_search( _cluster_positions.begin(), _cluster_positions.end(), *it ) )
+            add_cluster_position( *it );
+    }
+
+    for( uint64_t i = 0; i < clusters; ++i, it += 4 )
+    {
+        Cluster cinfo = {
+            /* fpos     */ it[0],
+            /* pts      */ static_cast<vlc_tick_t>( it[1] ),
+            /* duration */ static_cast<vlc_tick_t>( it[2] ),
+            /* size     */ it[3]
+        };
+
+        _clusters.insert( cluster_map_t::value_type( cinfo.pts, cinfo ) );
+    }
+
+    for( uint64_t i = 0; i < tracks; ++i )
+    {
+        track_id_t track_id = it[0];
+        uint64_t   points   = it[1];
+
+        for( it += 2; points--; it += 3 )
+        {
+            add_seekpoint( track_id, Seekpoint( it[0], static_cast<vlc_tick_t>( it[1] ),
+                Seekpoint::TrustLevel( static_cast<int64_t>( it[2] ) ) ) );
+        }
+    }
+
+    return true;
+}
+
 } // namespace
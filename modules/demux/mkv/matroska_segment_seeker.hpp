@@ -119,6 +119,10 @@ class SegmentSeeker
         void mark_range_as_searched( Range );
         ranges_t get_search_areas( fptr_t start, fptr_t end ) const;
 
+        /* flat representation of what was learned, for the index cache */
+        void save_index( std::vector<uint64_t>& ) const;
+        bool load_index( uint64_t const*, size_t );
+
     public:
         ranges_t            _ranges_searched;
         tracks_seekpoints_t _tracks_seekpoints;
@@ -41,6 +41,7 @@
 #include "heif.h"
 #include "../../codec/cc.h"
 #include "../av1_unpack.h"
+#include "../index_cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -4135,6 +4136,88 @@ static bool GetMoofTrackDuration( MP4_Box_t *p_moov, MP4_Box_t *p_moof,
     return true;
 }
 
+/* Fragments index cache layout: movie timescale, tracks count, entries
+ * count, last time, then tracks IDs, moof positions and per track times */
+#define FRAG_INDEX_CACHE_TAG     "mp4frag"
+#define FRAG_INDEX_CACHE_VERSION 1
+#define FRAG_INDEX_CACHE_HEADER  4
+
+static void FragStoreIndexCache( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const mp4_fragments_index_t *p_index = p_sys->p_fragsindex;
+    const size_t i_count = FRAG_INDEX_CACHE_HEADER + p_index->i_tracks +
+                           (size_t) p_index->i_entries * (1 + p_index->i_tracks);
+
+    uint64_t *p_values = vlc_alloc( i_count, sizeof(*p_values) );
+    if( !p_values )
+        return;
+
+    uint64_t *p = p_values;
+    *p++ = p_sys->i_timescale;
+    *p++ = p_index->i_tracks;
+    *p++ = p_index->i_entries;
+    *p++ = p_index->i_last_time;
+    for( unsigned i=0; i<p_index->i_tracks; i++ )
+        *p++ = p_sys->track[i].i_track_ID;
+    for( unsigned i=0; i<p_index->i_entries; i++ )
+        *p++ = p_index->pi_pos[i];
+    for( size_t i=0; i<(size_t) p_index->i_entries * p_index->i_tracks; i++ )
+        *p++ = p_index->p_times[i];
+
+    demux_IndexCacheStore( p_demux, FRAG_INDEX_CACHE_TAG,
+                           FRAG_INDEX_CACHE_VERSION, p_values, i_count );
+    free( p_values );
+}
+
+static bool FragLoadIndexCache( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    size_t i_count;
+
+    uint64_t *p_values = demux_IndexCacheLoad( p_demux, FRAG_INDEX_CACHE_TAG,
+                                               FRAG_INDEX_CACHE_VERSION, &i_count );
+    if( !p_values )
+        return false;
+
+    const unsigned i_tracks = p_sys->i_tracks;
+    const uint64_t *p = p_values;
+    bool b_valid = i_count > FRAG_INDEX_CACHE_HEADER + i_tracks &&
+                   p[0] == p_sys->i_timescale && p[1] == i_tracks &&
+                   p[2] > 0 && p[2] <= UINT_MAX &&
+                   (i_count - FRAG_INDEX_CACHE_HEADER - i_tracks) / (1 + i_tracks) == p[2] &&
+                   (i_count - FRAG_INDEX_CACHE_HEADER - i_tracks) % (1 + i_tracks) == 0;
+
+    for( unsigned i=0; b_valid && i<i_tracks; i++ )
+        b_valid = p[FRAG_INDEX_CACHE_HEADER + i] == p_sys->track[i].i_track_ID;
+
+    mp4_fragments_index_t *p_index = NULL;
+    if( b_valid )
+        p_index = MP4_Fragments_Index_New( i_tracks, p[2] );
+
+    if( p_index )
+    {
+        p_index->i_last_time = p[3];
+        p += FRAG_INDEX_CACHE_HEADER + i_tracks;
+        for( unsigned i=0; i<p_index->i_entries; i++ )
+            p_index->pi_pos[i] = *p++;
+        for( size_t i=0; i<(size_t) p_index->i_entries * i_tracks; i++ )
+            p_index->p_times[i] = *p++;
+
+        MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
+        p_sys->p_fragsindex = p_index;
+        p_sys->b_fragments_probed = true;
+
+        if ( !MP4_BoxGet( p_sys->p_moov, "mvex/mehd" ) )
+            p_sys->i_cumulated_duration = GetCumulatedDuration( p_demux );
+    }
+    else
+        msg_Warn( p_demux, "discarding mismatching fragments index cache" );
+
+    free( p_values );
+    return p_index != NULL;
+}
+
 static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -4143,6 +4226,14 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
 
     assert( p_sys->p_root );
 
+    /* Full index from a previous scan of that same file */
+    if( p_sys->b_seekable && (p_sys->b_fastseekable || b_force) &&
+        FragLoadIndexCache( p_demux ) )
+    {
+        *pb_fragmented = true;
+        return VLC_SUCCESS;
+    }
+
     MP4_Box_t *p_vroot = MP4_BoxNew(ATOM_root);
     if( !p_vroot )
         return VLC_EGENERIC;
@@ -4218,6 +4309,7 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
 #ifdef MP4_VERBOSE
             MP4_Fragments_Index_Dump( VLC_OBJECT(p_demux), p_sys->p_fragsindex, p_sys->i_timescale );
 #endif
+            FragStoreIndexCache( p_demux );
         }
     }
     else
@@ -4250,6 +4342,10 @@ static int ProbeFragmentsChecked( demux_t *p_demux )
     if( p_sys->b_fragments_probed )
         return VLC_SUCCESS;
 
+    /* No need to ask, nor to read the whole file again */
+    if( FragLoadIndexCache( p_demux ) )
+        return VLC_SUCCESS;
+
     if( !p_sys->b_fastseekable )
     {
         const char *psz_msg = _(
@@ -24,6 +24,7 @@
     typedef struct arib_instance_t arib_instance_t;
 #endif
 typedef struct csa_t csa_t;
+typedef struct ts_chunk_reader_t ts_chunk_reader_t;
 
 #define TS_USER_PMT_NUMBER (0)
 
@@ -71,6 +72,9 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* Batched packets reads from the stream */
+    ts_chunk_reader_t *p_reader;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
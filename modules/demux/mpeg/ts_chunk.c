@@ -0,0 +1,288 @@
+/*****************************************************************************
+ * ts_chunk.c: Transport Stream batched packets reader
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_stream.h>
+
+#include "ts_chunk.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+
+typedef struct ts_chunk_t ts_chunk_t;
+
+struct ts_chunk_reader_t
+{
+    ts_chunk_t *p_chunk;
+    unsigned    i_packet_size;
+    unsigned    i_header_size;
+    unsigned    i_packets;
+    bool        b_lost_sync;
+    bool        b_aligned;
+};
+
+typedef struct
+{
+    block_t     self;
+    ts_chunk_t *p_chunk;
+} ts_chunk_view_t;
+
+struct ts_chunk_t
+{
+    atomic_uint     refs;
+    size_t          i_size;     /* valid bytes in p_data */
+    size_t          i_offset;   /* read cursor in p_data */
+    unsigned        i_synced;   /* packets at cursor with checked sync byte */
+    unsigned        i_views;    /* used views since last refill */
+    uint8_t        *p_data;
+    ts_chunk_view_t views[];
+};
+
+static ts_chunk_t * ts_chunk_New( const ts_chunk_reader_t *r )
+{
+    const size_t i_views = sizeof(ts_chunk_view_t) * r->i_packets;
+    ts_chunk_t *c = malloc( sizeof(*c) + i_views +
+                            (size_t) r->i_packets * r->i_packet_size );
+    if( !c )
+        return NULL;
+    atomic_init( &c->refs, 1 );
+    c->i_size = 0;
+    c->i_offset = 0;
+    c->i_synced = 0;
+    c->i_views = 0;
+    c->p_data = (uint8_t *) &c->views[r->i_packets];
+    return c;
+}
+
+static void ts_chunk_Release( ts_chunk_t *c )
+{
+    if( atomic_fetch_sub_explicit( &c->refs, 1, memory_order_acq_rel ) == 1 )
+        free( c );
+}
+
+static void ts_chunk_view_Release( block_t *p_block )
+{
+    ts_chunk_view_t *p_view = container_of( p_block, ts_chunk_view_t, self );
+    ts_chunk_Release( p_view->p_chunk );
+}
+
+static const struct vlc_block_callbacks ts_chunk_view_cbs =
+{
+    ts_chunk_view_Release,
+};
+
+ts_chunk_reader_t * ts_chunk_reader_New( unsigned i_packet_size,
+                                         unsigned i_header_size,
+                                         unsigned i_packets )
+{
+    assert( i_packets > 1 && i_packet_size > i_header_size );
+    ts_chunk_reader_t *r = malloc( sizeof(*r) );
+    if( !r )
+        return NULL;
+    r->p_chunk = NULL;
+    r->i_packet_size = i_packet_size;
+    r->i_header_size = i_header_size;
+    r->i_packets = i_packets;
+    r->b_lost_sync = false;
+    r->b_aligned = false;
+    return r;
+}
+
+void ts_chunk_reader_Delete( ts_chunk_reader_t *r )
+{
+    /* Chunk is freed once its last packet is released */
+    if( r->p_chunk )
+        ts_chunk_Release( r->p_chunk );
+    free( r );
+}
+
+size_t ts_chunk_reader_Pending( const ts_chunk_reader_t *r )
+{
+    const ts_chunk_t *c = r->p_chunk;
+    return c ? c->i_size - c->i_offset : 0;
+}
+
+void ts_chunk_reader_SetAligned( ts_chunk_reader_t *r, bool b_aligned )
+{
+    r->b_aligned = b_aligned;
+}
+
+void ts_chunk_reader_Flush( ts_chunk_reader_t *r )
+{
+    ts_chunk_t *c = r->p_chunk;
+    if( c )
+    {
+        c->i_offset = c->i_size;
+        c->i_synced = 0;
+    }
+    r->b_lost_sync = false;
+}
+
+/* Checks sync bytes of all complete packets at cursor in one pass */
+static unsigned CountSynced( const ts_chunk_reader_t *r, const ts_chunk_t *c )
+{
+    const uint8_t *p = &c->p_data[c->i_offset + r->i_header_size];
+    size_t i_avail = c->i_size - c->i_offset;
+    unsigned i_count = 0;
+
+    while( i_avail >= r->i_packet_size && *p == 0x47 )
+    {
+        p += r->i_packet_size;
+        i_avail -= r->i_packet_size;
+        i_count++;
+    }
+    return i_count;
+}
+
+/* Moves the cursor to the next pair of sync bytes one packet apart.
+ * Returns false if more data is needed to find it */
+static bool Resync( ts_chunk_reader_t *r, vlc_object_t *p_obj, ts_chunk_t *c )
+{
+    const uint8_t *p = &c->p_data[c->i_offset];
+    const size_t i_avail = c->i_size - c->i_offset;
+    const size_t i_next = r->i_header_size + r->i_packet_size;
+    size_t i_skip = 0;
+    bool b_found = false;
+
+    if( !r->b_lost_sync )
+    {
+        msg_Warn( p_obj, "lost synchro" );
+        r->b_lost_sync = true;
+    }
+
+    for( ; i_skip + i_next < i_avail; i_skip++ )
+    {
+        if( p[i_skip + r->i_header_size] == 0x47 && p[i_skip + i_next] == 0x47 )
+        {
+            b_found = true;
+            break;
+        }
+    }
+
+    if( i_skip > 0 )
+        msg_Dbg( p_obj, "skipping %zu bytes of garbage", i_skip );
+    c->i_offset += i_skip;
+    if( b_found )
+        r->b_lost_sync = false;
+    return b_found;
+}
+
+static int Refill( ts_chunk_reader_t *r, stream_t *s )
+{
+    ts_chunk_t *c = r->p_chunk;
+    size_t i_carry = 0;
+
+    if( c == NULL ||
+        atomic_load_explicit( &c->refs, memory_order_acquire ) != 1 )
+    {
+        /* Packets of the current chunk are still in use downstream */
+        ts_chunk_t *p_new = ts_chunk_New( r );
+        if( !p_new )
+            return VLC_ENOMEM;
+        if( c )
+        {
+            i_carry = c->i_size - c->i_offset;
+            memcpy( p_new->p_data, &c->p_data[c->i_offset], i_carry );
+            ts_chunk_Release( c );
+        }
+        r->p_chunk = c = p_new;
+    }
+    else
+    {
+        i_carry = c->i_size - c->i_offset;
+        memmove( c->p_data, &c->p_data[c->i_offset], i_carry );
+    }
+
+    c->i_size = i_carry;
+    c->i_offset = 0;
+    c->i_views = 0;
+
+    /* Don't wait for a full chunk, live sources would add latency */
+    const size_t i_max = (size_t) r->i_packets * r->i_packet_size;
+    const size_t i_min = __MAX( r->i_packet_size, i_carry + 1 );
+    assert( i_min <= i_max );
+    /* The carried bytes start a packet, unless garbage follows */
+    while( c->i_size < i_min ||
+           ( r->b_aligned && c->i_size % r->i_packet_size ) )
+    {
+        ssize_t i_read = vlc_stream_ReadPartial( s, &c->p_data[c->i_size],
+                                                 i_max - c->i_size );
+        if( i_read < 0 )
+            continue;
+        if( i_read == 0 )
+        {
+            if( c->i_size < i_min )
+                return VLC_EGENERIC;
+            break;
+        }
+        c->i_size += i_read;
+    }
+
+    c->i_synced = CountSynced( r, c );
+    return VLC_SUCCESS;
+}
+
+block_t * ts_chunk_reader_Read( ts_chunk_reader_t *r, vlc_object_t *p_obj,
+                                stream_t *s )
+{
+    ts_chunk_t *c = r->p_chunk;
+
+    while( c == NULL || c->i_synced == 0 )
+    {
+        if( c && c->i_size - c->i_offset >= r->i_packet_size &&
+            Resync( r, p_obj, c ) )
+        {
+            c->i_synced = CountSynced( r, c );
+            continue;
+        }
+
+        if( Refill( r, s ) != VLC_SUCCESS )
+            return NULL;
+        c = r->p_chunk;
+    }
+
+    assert( c->i_views < r->i_packets );
+    ts_chunk_view_t *p_view = &c->views[c->i_views++];
+    block_t *p_pkt = block_Init( &p_view->self, &ts_chunk_view_cbs,
+                                 &c->p_data[c->i_offset], r->i_packet_size );
+    p_pkt->p_buffer += r->i_header_size;
+    p_pkt->i_buffer -= r->i_header_size;
+    p_view->p_chunk = c;
+    atomic_fetch_add_explicit( &c->refs, 1, memory_order_relaxed );
+
+    c->i_offset += r->i_packet_size;
+    c->i_synced--;
+
+    return p_pkt;
+}
+
+block_t * ts_chunk_Detach( block_t *p_pkt )
+{
+    if( p_pkt->cbs != &ts_chunk_view_cbs )
+        return p_pkt;
+
+    block_t *p_dup = block_Duplicate( p_pkt );
+    block_Release( p_pkt );
+    return p_dup;
+}
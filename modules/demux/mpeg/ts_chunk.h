@@ -0,0 +1,57 @@
+/*****************************************************************************
+ * ts_chunk.h: Transport Stream batched packets reader
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_CHUNK_H
+#define VLC_TS_CHUNK_H
+
+/* Number of TS packets read from the stream at once */
+#define TS_CHUNK_PACKETS 256
+
+/* Packets are read from the stream by runs of up to i_packets, and are
+ * handed out as blocks pointing into the shared chunk buffer. The chunk
+ * stays alive as long as one of its packets is not released, so only
+ * packets retained by a consumer need a copy (see ts_chunk_Detach). */
+typedef struct ts_chunk_reader_t ts_chunk_reader_t;
+
+/* i_header_size is the extra header before sync byte (BluRay) */
+ts_chunk_reader_t * ts_chunk_reader_New( unsigned i_packet_size,
+                                         unsigned i_header_size,
+                                         unsigned i_packets );
+void ts_chunk_reader_Delete( ts_chunk_reader_t * );
+
+/* Returns next synchronized packet, with extra header skipped,
+ * or NULL on end of stream */
+block_t * ts_chunk_reader_Read( ts_chunk_reader_t *, vlc_object_t *, stream_t * );
+
+/* Bytes already read from the stream but not yet returned */
+size_t ts_chunk_reader_Pending( const ts_chunk_reader_t * );
+
+/* Only reads whole packets from the stream, so that no bytes are pending
+ * once the packets read are returned. Used to hand over the stream between
+ * two packets, to start recording for instance */
+void ts_chunk_reader_SetAligned( ts_chunk_reader_t *, bool );
+
+/* Drops pending bytes. Must be called when the stream position changes */
+void ts_chunk_reader_Flush( ts_chunk_reader_t * );
+
+/* Returns a standalone copy of a packet still pointing into its chunk,
+ * releasing the original, for consumers keeping packets around */
+block_t * ts_chunk_Detach( block_t * );
+
+#endif
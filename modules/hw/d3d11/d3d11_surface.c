@@ -489,7 +489,7 @@ static filter_t *CreateCPUtoGPUFilter( filter_t *p_this, const es_format_t *p_fm
     if (unlikely(p_filter == NULL))
         return NULL;
 
-    static const struct filter_video_callbacks cbs = { NewBuffer, HoldD3D11DecoderDevice };
+    static const struct filter_video_callbacks cbs = { NewBuffer, HoldD3D11DecoderDevice, NULL };
     p_filter->b_allow_fmt_out_change = false;
     p_filter->owner.video = &cbs;
     p_filter->owner.sys = p_this;
@@ -26,10 +26,20 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
+
 #include <vlc_common.h>
+#include <vlc_cpu.h>
 
 #include "csa.h"
 
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+
 struct csa_t
 {
     /* odd and even keys */
@@ -128,7 +138,9 @@ int csa_UseKey( vlc_object_t *p_caller, csa_t *c, bool use_odd )
 {
     if ( !c ) return VLC_ENOOBJ;
     c->use_odd = use_odd;
-#ifndef TS_NO_CSA_CK_MSG
+#ifdef TS_NO_CSA_CK_MSG
+    VLC_UNUSED(p_caller);
+#else
         msg_Dbg( p_caller, "using the %s key for scrambling",
                  use_odd ? "odd" : "even" );
 #endif
@@ -227,15 +239,19 @@ void csa_Decrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
 /*****************************************************************************
  * csa_Encrypt:
  *****************************************************************************/
-void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
+typedef struct
 {
-    uint8_t *ck;
-    uint8_t *kk;
-
-    int i, j;
-    int i_hdr = 4; /* hdr len */
-    uint8_t  ib[184/8+2][8], stream[8], block[8];
-    int n, i_residue;
+    uint8_t  *p;        /* payload */
+    unsigned n;         /* 8 bytes blocks */
+    unsigned residue;   /* bytes after the last block */
+} csa_lane_t;
+
+/* Sets the transport scrambling control, and locates the payload. Returns
+ * false when it is too short to be scrambled. */
+static bool csa_EncryptHeader( csa_t *c, uint8_t *pkt, int i_pkt_size,
+                               csa_lane_t *lane )
+{
+    int i_hdr, n;
 
     /* set transport scrambling control */
     pkt[3] |= 0x80;
@@ -243,13 +259,6 @@ void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
     if( c->use_odd )
     {
         pkt[3] |= 0x40;
-        ck = c->o_ck;
-        kk = c->o_kk;
-    }
-    else
-    {
-        ck = c->e_ck;
-        kk = c->e_kk;
     }
 
     /* hdr len */
@@ -260,14 +269,29 @@ void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
         i_hdr += pkt[4] + 1;
     }
     n = (i_pkt_size - i_hdr) / 8;
-    i_residue = (i_pkt_size - i_hdr) % 8;
 
     if( n <= 0 )
     {
         pkt[3] &= 0x3f;
-        return;
+        return false;
     }
 
+    lane->p = &pkt[i_hdr];
+    lane->n = n;
+    lane->residue = (i_pkt_size - i_hdr) % 8;
+    return true;
+}
+
+static void csa_EncryptLane( csa_t *c, uint8_t *ck, uint8_t *kk,
+                             const csa_lane_t *lane )
+{
+    uint8_t *p = lane->p;
+    const int n = lane->n;
+    const int i_residue = lane->residue;
+
+    int i, j;
+    uint8_t  ib[184/8+2][8], stream[8], block[8];
+
     /* */
     for( i = 0; i < 8; i++ )
     {
@@ -277,7 +301,7 @@ void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
     {
         for( j = 0; j < 8; j++ )
         {
-            block[j] = pkt[i_hdr+8*(i-1)+j] ^ib[i+1][j];
+            block[j] = p[8*(i-1)+j] ^ib[i+1][j];
         }
         csa_BlockCypher( kk, block, ib[i] );
     }
@@ -287,14 +311,14 @@ void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
 
     for( i = 0; i < 8; i++ )
     {
-        pkt[i_hdr+i] = ib[1][i];
+        p[i] = ib[1][i];
     }
     for( i = 2; i < n+1; i++ )
     {
         csa_StreamCypher( c, 0, ck, NULL, stream );
         for( j = 0; j < 8; j++ )
         {
-            pkt[i_hdr+8*(i-1)+j] = ib[i][j] ^ stream[j];
+            p[8*(i-1)+j] = ib[i][j] ^ stream[j];
         }
     }
     if( i_residue > 0 )
@@ -302,11 +326,24 @@ void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
         csa_StreamCypher( c, 0, ck, NULL, stream );
         for( j = 0; j < i_residue; j++ )
         {
-            pkt[i_pkt_size - i_residue + j] ^= stream[j];
+            p[8*n + j] ^= stream[j];
         }
     }
 }
 
+void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
+{
+    csa_lane_t lane;
+
+    if( csa_EncryptHeader( c, pkt, i_pkt_size, &lane ) )
+    {
+        if( c->use_odd )
+            csa_EncryptLane( c, c->o_ck, c->o_kk, &lane );
+        else
+            csa_EncryptLane( c, c->e_ck, c->e_kk, &lane );
+    }
+}
+
 /*****************************************************************************
  * Divers
  *****************************************************************************/
@@ -610,3 +647,196 @@ static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] )
     }
 }
 
+
+/*****************************************************************************
+ * Bitsliced scrambling
+ *****************************************************************************/
+
+/* Transposes the 8x8 bit matrix of the bytes of x: the bit b of the byte i
+ * becomes the bit i of the byte b. */
+static inline uint64_t csa_Transpose8( uint64_t x )
+{
+    uint64_t t;
+
+    t = (x ^ (x >>  7)) & UINT64_C(0x00AA00AA00AA00AA);
+    x ^= t ^ (t <<  7);
+    t = (x ^ (x >> 14)) & UINT64_C(0x0000CCCC0000CCCC);
+    x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & UINT64_C(0x00000000F0F0F0F0);
+    x ^= t ^ (t << 28);
+    return x;
+}
+
+/* Loads the first payload block of the lanes into 64 words of i_word bytes,
+ * the bit b of the byte i going to the word 8 * i + b. The lane k has the
+ * bit k % 8 of the byte k / 8 of each word. */
+static void csa_LanesToPlanes( uint8_t *planes, size_t i_word,
+                               const csa_lane_t *lanes, unsigned count )
+{
+    memset( planes, 0, 64 * i_word );
+    for( unsigned g = 0; g < (count + 7) / 8; g++ )
+        for( int i = 0; i < 8; i++ )
+        {
+            uint64_t x = 0;
+
+            for( unsigned l = 0; l < 8 && 8 * g + l < count; l++ )
+                x |= (uint64_t)lanes[8 * g + l].p[i] << (8 * l);
+            x = csa_Transpose8( x );
+            for( int b = 0; b < 8; b++ )
+                planes[(8 * i + b) * i_word + g] = x >> (8 * b);
+        }
+}
+
+/* XORs the 8 stream bytes of csa_LanesToPlanes() layout into the block
+ * i_block of the lanes, or into their residue after their last block. */
+static void csa_XorPlanes( const uint8_t *planes, size_t i_word,
+                           const csa_lane_t *lanes, unsigned count,
+                           unsigned i_block )
+{
+    for( unsigned g = 0; g < (count + 7) / 8; g++ )
+    {
+        uint64_t x[8];
+
+        for( int i = 0; i < 8; i++ )
+        {
+            x[i] = 0;
+            for( int b = 0; b < 8; b++ )
+                x[i] |= (uint64_t)planes[(8 * i + b) * i_word + g] << (8 * b);
+            x[i] = csa_Transpose8( x[i] );
+        }
+
+        for( unsigned l = 0; l < 8 && 8 * g + l < count; l++ )
+        {
+            const csa_lane_t *lane = &lanes[8 * g + l];
+            unsigned i_size;
+
+            if( i_block < lane->n )
+                i_size = 8;
+            else if( i_block == lane->n )
+                i_size = lane->residue;
+            else
+                continue;
+
+            for( unsigned i = 0; i < i_size; i++ )
+                lane->p[8 * i_block + i] ^= x[i] >> (8 * l);
+        }
+    }
+}
+
+/* 64 packets at once, in C */
+#define BS_WORD         uint64_t
+#define BS_FUNC(f)      f##_c
+#define BS_TARGET
+#define BS_ZERO         UINT64_C(0)
+#define BS_ONES         (~UINT64_C(0))
+#define BS_BYTES(c)     (UINT64_C(0x0101010101010101) * (c))
+#define BS_AND(a, b)    ((a) & (b))
+#define BS_OR(a, b)     ((a) | (b))
+#define BS_XOR(a, b)    ((a) ^ (b))
+#define BS_SHL(a, n)    ((a) << (n))
+#define BS_SHR(a, n)    ((a) >> (n))
+#include "csa_bitslice.h"
+
+#ifdef HAVE_SSE2_INTRINSICS
+/* 128 packets at once */
+# define BS_WORD        __m128i
+# define BS_FUNC(f)     f##_sse2
+# define BS_TARGET      __attribute__ ((__target__ ("sse2")))
+# define BS_ZERO        _mm_setzero_si128()
+# define BS_ONES        _mm_set1_epi32(-1)
+# define BS_BYTES(c)    _mm_set1_epi8(c)
+# define BS_AND         _mm_and_si128
+# define BS_OR          _mm_or_si128
+# define BS_XOR         _mm_xor_si128
+# define BS_SHL         _mm_slli_epi64
+# define BS_SHR         _mm_srli_epi64
+# include "csa_bitslice.h"
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+/* 256 packets at once */
+# define BS_WORD        __m256i
+# define BS_FUNC(f)     f##_avx2
+# define BS_TARGET      __attribute__ ((__target__ ("avx2")))
+# define BS_ZERO        _mm256_setzero_si256()
+# define BS_ONES        _mm256_set1_epi32(-1)
+# define BS_BYTES(c)    _mm256_set1_epi8(c)
+# define BS_AND         _mm256_and_si256
+# define BS_OR          _mm256_or_si256
+# define BS_XOR         _mm256_xor_si256
+# define BS_SHL         _mm256_slli_epi64
+# define BS_SHR         _mm256_srli_epi64
+# include "csa_bitslice.h"
+#endif
+
+#define CSA_LANES_MAX 256
+/* below that many packets, the scalar code is faster */
+#define CSA_LANES_MIN 4
+
+typedef void (*csa_lanes_t)( const uint8_t ck[8], const uint8_t kk[57],
+                             const csa_lane_t *, unsigned );
+
+/* Returns the kernel for count packets, and how many it takes. The AVX2 one
+ * only pays off for more packets than the SSE2 one takes, while the SSE2 one
+ * is as fast as C even for few packets. */
+static unsigned csa_GetLanes( unsigned count, csa_lanes_t *pf )
+{
+#ifdef HAVE_AVX2_INTRINSICS
+    if( count > 128 && vlc_CPU_AVX2() )
+    {
+        *pf = csa_EncryptLanes_avx2;
+        return 256;
+    }
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+    {
+        *pf = csa_EncryptLanes_sse2;
+        return 128;
+    }
+#endif
+    *pf = csa_EncryptLanes_c;
+    return 64;
+}
+
+static void csa_EncryptLanes( csa_t *c, uint8_t *ck, uint8_t *kk,
+                              const csa_lane_t *lanes, unsigned count )
+{
+    while( count >= CSA_LANES_MIN )
+    {
+        csa_lanes_t pf;
+        const unsigned i_lanes = __MIN( count, csa_GetLanes( count, &pf ) );
+
+        pf( ck, kk, lanes, i_lanes );
+        lanes += i_lanes;
+        count -= i_lanes;
+    }
+
+    for( unsigned k = 0; k < count; k++ )
+        csa_EncryptLane( c, ck, kk, &lanes[k] );
+}
+
+/*****************************************************************************
+ * csa_EncryptBatch:
+ *****************************************************************************/
+void csa_EncryptBatch( csa_t *c, uint8_t **pp_pkt, size_t i_count,
+                       int i_pkt_size )
+{
+    uint8_t *ck = c->use_odd ? c->o_ck : c->e_ck;
+    uint8_t *kk = c->use_odd ? c->o_kk : c->e_kk;
+    csa_lane_t lanes[CSA_LANES_MAX];
+    unsigned i_lanes = 0;
+
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        if( !csa_EncryptHeader( c, pp_pkt[i], i_pkt_size, &lanes[i_lanes] ) )
+            continue;
+
+        if( ++i_lanes == CSA_LANES_MAX )
+        {
+            csa_EncryptLanes( c, ck, kk, lanes, i_lanes );
+            i_lanes = 0;
+        }
+    }
+    csa_EncryptLanes( c, ck, kk, lanes, i_lanes );
+}
@@ -0,0 +1,550 @@
+/*****************************************************************************
+ * csa_bitslice.h: bitsliced CSA scrambler
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file has no include guard: csa.c includes it once per word type,
+ * after defining:
+ *  - BS_WORD, the word type, and BS_FUNC(name), the names for this type,
+ *  - BS_TARGET, the attributes of the functions using the type,
+ *  - BS_ZERO, BS_ONES, and BS_BYTES(c) with c in every byte,
+ *  - BS_AND, BS_OR, BS_XOR, and BS_SHL, BS_SHR shifting 64-bit lanes.
+ *
+ * Each packet is given one bit of every word, so a word scrambles as many
+ * packets at once as it has bits. The stream cypher is bitsliced: each bit
+ * of its state is one word. The block cypher is byte-sliced instead: each
+ * register is a row of bytes, one per packet, as its 8-bit s-box is cheaper
+ * to look up than to compute. */
+
+#define BS_LANES    (8 * sizeof (BS_WORD))
+#define BS_INLINE   inline BS_TARGET
+
+#define BS_NOT(a)               BS_XOR( a, BS_ONES )
+#define BS_XOR3(a,b,c)          BS_XOR( BS_XOR( a, b ), c )
+#define BS_XOR4(a,b,c,d)        BS_XOR( BS_XOR( a, b ), BS_XOR( c, d ) )
+#define BS_XOR5(a,b,c,d,e)      BS_XOR( BS_XOR4( a, b, c, d ), e )
+#define BS_XOR6(a,b,c,d,e,f)    BS_XOR( BS_XOR4( a, b, c, d ), BS_XOR( e, f ) )
+/* s ? a : b */
+#define BS_MUX(s,a,b)           BS_XOR( b, BS_AND( s, BS_XOR( a, b ) ) )
+
+/*****************************************************************************
+ * Stream cypher
+ *****************************************************************************/
+
+/* The s-boxes of csa_StreamCypher(), in algebraic normal form: each output
+ * bit is the XOR of AND terms of the 5 input bits, x4 being the high bit of
+ * the table index. s[1] is the high output bit and s[0] the low one. */
+static BS_INLINE void BS_FUNC(csa_Sbox1)( BS_WORD s[2],
+        BS_WORD x4, BS_WORD x3, BS_WORD x2, BS_WORD x1, BS_WORD x0 )
+{
+    const BS_WORD x01 = BS_AND( x1, x0 );
+    const BS_WORD x02 = BS_AND( x2, x0 );
+    const BS_WORD x12 = BS_AND( x2, x1 );
+    const BS_WORD x03 = BS_AND( x3, x0 );
+    const BS_WORD x13 = BS_AND( x3, x1 );
+    const BS_WORD x23 = BS_AND( x3, x2 );
+    const BS_WORD x04 = BS_AND( x4, x0 );
+    const BS_WORD x14 = BS_AND( x4, x1 );
+    const BS_WORD x24 = BS_AND( x4, x2 );
+    const BS_WORD x34 = BS_AND( x4, x3 );
+    const BS_WORD x013 = BS_AND( x13, x0 );
+    const BS_WORD x023 = BS_AND( x23, x0 );
+    const BS_WORD x123 = BS_AND( x23, x1 );
+    const BS_WORD x014 = BS_AND( x14, x0 );
+    const BS_WORD x124 = BS_AND( x24, x1 );
+    const BS_WORD x134 = BS_AND( x34, x1 );
+    const BS_WORD x234 = BS_AND( x34, x2 );
+    const BS_WORD x0134 = BS_AND( x134, x0 );
+    const BS_WORD x0234 = BS_AND( x234, x0 );
+    const BS_WORD x1234 = BS_AND( x234, x1 );
+
+    s[1] = BS_NOT( BS_XOR5( BS_XOR4( x0, x1, x01, x02 ),
+                            BS_XOR4( x12, x03, x13, x23 ),
+                            BS_XOR4( x023, x123, x4, x014 ),
+                            BS_XOR4( x24, x124, x34, x134 ),
+                            BS_XOR3( x0134, x234, x1234 ) ) );
+    s[0] = BS_XOR3( BS_XOR4( x1, x02, x3, x03 ),
+                    BS_XOR4( x013, x04, x34, x134 ),
+                    BS_XOR( x234, x0234 ) );
+}
+
+static BS_INLINE void BS_FUNC(csa_Sbox2)( BS_WORD s[2],
+        BS_WORD x4, BS_WORD x3, BS_WORD x2, BS_WORD x1, BS_WORD x0 )
+{
+    const BS_WORD x02 = BS_AND( x2, x0 );
+    const BS_WORD x12 = BS_AND( x2, x1 );
+    const BS_WORD x13 = BS_AND( x3, x1 );
+    const BS_WORD x23 = BS_AND( x3, x2 );
+    const BS_WORD x14 = BS_AND( x4, x1 );
+    const BS_WORD x24 = BS_AND( x4, x2 );
+    const BS_WORD x34 = BS_AND( x4, x3 );
+    const BS_WORD x012 = BS_AND( x12, x0 );
+    const BS_WORD x013 = BS_AND( x13, x0 );
+    const BS_WORD x023 = BS_AND( x23, x0 );
+    const BS_WORD x014 = BS_AND( x14, x0 );
+    const BS_WORD x124 = BS_AND( x24, x1 );
+    const BS_WORD x034 = BS_AND( x34, x0 );
+    const BS_WORD x134 = BS_AND( x34, x1 );
+    const BS_WORD x234 = BS_AND( x34, x2 );
+    const BS_WORD x0134 = BS_AND( x134, x0 );
+    const BS_WORD x0234 = BS_AND( x234, x0 );
+
+    s[1] = BS_NOT( BS_XOR3( BS_XOR4( x0, x1, x02, x12 ),
+                            BS_XOR4( x012, x3, x124, x034 ),
+                            BS_XOR3( x134, x0134, x234 ) ) );
+    s[0] = BS_NOT( BS_XOR3( BS_XOR4( x1, x2, x02, x013 ),
+                            BS_XOR4( x023, x014, x24, x34 ),
+                            BS_XOR( x0134, x0234 ) ) );
+}
+
+static BS_INLINE void BS_FUNC(csa_Sbox3)( BS_WORD s[2],
+        BS_WORD x4, BS_WORD x3, BS_WORD x2, BS_WORD x1, BS_WORD x0 )
+{
+    const BS_WORD x01 = BS_AND( x1, x0 );
+    const BS_WORD x02 = BS_AND( x2, x0 );
+    const BS_WORD x12 = BS_AND( x2, x1 );
+    const BS_WORD x03 = BS_AND( x3, x0 );
+    const BS_WORD x13 = BS_AND( x3, x1 );
+    const BS_WORD x23 = BS_AND( x3, x2 );
+    const BS_WORD x14 = BS_AND( x4, x1 );
+    const BS_WORD x24 = BS_AND( x4, x2 );
+    const BS_WORD x34 = BS_AND( x4, x3 );
+    const BS_WORD x012 = BS_AND( x12, x0 );
+    const BS_WORD x013 = BS_AND( x13, x0 );
+    const BS_WORD x123 = BS_AND( x23, x1 );
+    const BS_WORD x014 = BS_AND( x14, x0 );
+    const BS_WORD x024 = BS_AND( x24, x0 );
+    const BS_WORD x124 = BS_AND( x24, x1 );
+    const BS_WORD x034 = BS_AND( x34, x0 );
+    const BS_WORD x234 = BS_AND( x34, x2 );
+    const BS_WORD x0124 = BS_AND( x124, x0 );
+    const BS_WORD x1234 = BS_AND( x234, x1 );
+
+    s[1] = BS_NOT( BS_XOR6( BS_XOR4( x0, x1, x02, x12 ),
+                            BS_XOR4( x012, x3, x03, x13 ),
+                            BS_XOR4( x013, x23, x123, x4 ),
+                            BS_XOR4( x14, x014, x24, x024 ),
+                            BS_XOR4( x124, x0124, x034, x234 ),
+                            x1234 ) );
+    s[0] = BS_XOR( BS_XOR4( x1, x01, x02, x3 ),
+                   x4 );
+}
+
+static BS_INLINE void BS_FUNC(csa_Sbox4)( BS_WORD s[2],
+        BS_WORD x4, BS_WORD x3, BS_WORD x2, BS_WORD x1, BS_WORD x0 )
+{
+    const BS_WORD x01 = BS_AND( x1, x0 );
+    const BS_WORD x12 = BS_AND( x2, x1 );
+    const BS_WORD x03 = BS_AND( x3, x0 );
+    const BS_WORD x13 = BS_AND( x3, x1 );
+    const BS_WORD x23 = BS_AND( x3, x2 );
+    const BS_WORD x04 = BS_AND( x4, x0 );
+    const BS_WORD x14 = BS_AND( x4, x1 );
+    const BS_WORD x24 = BS_AND( x4, x2 );
+    const BS_WORD x34 = BS_AND( x4, x3 );
+    const BS_WORD x012 = BS_AND( x12, x0 );
+    const BS_WORD x013 = BS_AND( x13, x0 );
+    const BS_WORD x123 = BS_AND( x23, x1 );
+    const BS_WORD x124 = BS_AND( x24, x1 );
+    const BS_WORD x034 = BS_AND( x34, x0 );
+    const BS_WORD x134 = BS_AND( x34, x1 );
+    const BS_WORD x234 = BS_AND( x34, x2 );
+    const BS_WORD x0124 = BS_AND( x124, x0 );
+    const BS_WORD x0134 = BS_AND( x134, x0 );
+    const BS_WORD x1234 = BS_AND( x234, x1 );
+
+    s[1] = BS_NOT( BS_XOR4( BS_XOR4( x0, x01, x2, x012 ),
+                            BS_XOR4( x3, x123, x4, x04 ),
+                            BS_XOR4( x14, x0124, x34, x034 ),
+                            BS_XOR3( x0134, x234, x1234 ) ) );
+    s[0] = BS_NOT( BS_XOR4( BS_XOR4( x1, x01, x2, x03 ),
+                            BS_XOR4( x013, x23, x04, x14 ),
+                            BS_XOR4( x0124, x34, x034, x0134 ),
+                            BS_XOR( x234, x1234 ) ) );
+}
+
+static BS_INLINE void BS_FUNC(csa_Sbox5)( BS_WORD s[2],
+        BS_WORD x4, BS_WORD x3, BS_WORD x2, BS_WORD x1, BS_WORD x0 )
+{
+    const BS_WORD x01 = BS_AND( x1, x0 );
+    const BS_WORD x02 = BS_AND( x2, x0 );
+    const BS_WORD x12 = BS_AND( x2, x1 );
+    const BS_WORD x03 = BS_AND( x3, x0 );
+    const BS_WORD x13 = BS_AND( x3, x1 );
+    const BS_WORD x23 = BS_AND( x3, x2 );
+    const BS_WORD x04 = BS_AND( x4, x0 );
+    const BS_WORD x14 = BS_AND( x4, x1 );
+    const BS_WORD x24 = BS_AND( x4, x2 );
+    const BS_WORD x34 = BS_AND( x4, x3 );
+    const BS_WORD x012 = BS_AND( x12, x0 );
+    const BS_WORD x013 = BS_AND( x13, x0 );
+    const BS_WORD x023 = BS_AND( x23, x0 );
+    const BS_WORD x123 = BS_AND( x23, x1 );
+    const BS_WORD x024 = BS_AND( x24, x0 );
+    const BS_WORD x124 = BS_AND( x24, x1 );
+    const BS_WORD x034 = BS_AND( x34, x0 );
+    const BS_WORD x134 = BS_AND( x34, x1 );
+    const BS_WORD x234 = BS_AND( x34, x2 );
+    const BS_WORD x0124 = BS_AND( x124, x0 );
+    const BS_WORD x0134 = BS_AND( x134, x0 );
+    const BS_WORD x0234 = BS_AND( x234, x0 );
+    const BS_WORD x1234 = BS_AND( x234, x1 );
+
+    s[1] = BS_NOT( BS_XOR5( BS_XOR4( x0, x1, x01, x02 ),
+                            BS_XOR4( x12, x012, x3, x03 ),
+                            BS_XOR4( x013, x023, x123, x04 ),
+                            BS_XOR4( x14, x24, x124, x0124 ),
+                            BS_XOR4( x034, x134, x0234, x1234 ) ) );
+    s[0] = BS_XOR4( BS_XOR4( x01, x2, x02, x012 ),
+                    BS_XOR4( x03, x13, x023, x04 ),
+                    BS_XOR4( x24, x024, x124, x0124 ),
+                    BS_XOR4( x34, x034, x134, x0134 ) );
+}
+
+static BS_INLINE void BS_FUNC(csa_Sbox6)( BS_WORD s[2],
+        BS_WORD x4, BS_WORD x3, BS_WORD x2, BS_WORD x1, BS_WORD x0 )
+{
+    const BS_WORD x02 = BS_AND( x2, x0 );
+    const BS_WORD x12 = BS_AND( x2, x1 );
+    const BS_WORD x13 = BS_AND( x3, x1 );
+    const BS_WORD x23 = BS_AND( x3, x2 );
+    const BS_WORD x14 = BS_AND( x4, x1 );
+    const BS_WORD x24 = BS_AND( x4, x2 );
+    const BS_WORD x34 = BS_AND( x4, x3 );
+    const BS_WORD x012 = BS_AND( x12, x0 );
+    const BS_WORD x013 = BS_AND( x13, x0 );
+    const BS_WORD x023 = BS_AND( x23, x0 );
+    const BS_WORD x123 = BS_AND( x23, x1 );
+    const BS_WORD x014 = BS_AND( x14, x0 );
+    const BS_WORD x124 = BS_AND( x24, x1 );
+    const BS_WORD x034 = BS_AND( x34, x0 );
+    const BS_WORD x134 = BS_AND( x34, x1 );
+    const BS_WORD x234 = BS_AND( x34, x2 );
+    const BS_WORD x0124 = BS_AND( x124, x0 );
+    const BS_WORD x0134 = BS_AND( x134, x0 );
+    const BS_WORD x1234 = BS_AND( x234, x1 );
+
+    s[1] = BS_XOR( BS_XOR4( x1, x02, x013, x23 ),
+                   BS_XOR4( x023, x4, x014, x034 ) );
+    s[0] = BS_XOR3( BS_XOR4( x0, x2, x12, x012 ),
+                    BS_XOR4( x13, x23, x123, x014 ),
+                    BS_XOR4( x124, x0124, x0134, x1234 ) );
+}
+
+static BS_INLINE void BS_FUNC(csa_Sbox7)( BS_WORD s[2],
+        BS_WORD x4, BS_WORD x3, BS_WORD x2, BS_WORD x1, BS_WORD x0 )
+{
+    const BS_WORD x01 = BS_AND( x1, x0 );
+    const BS_WORD x12 = BS_AND( x2, x1 );
+    const BS_WORD x13 = BS_AND( x3, x1 );
+    const BS_WORD x23 = BS_AND( x3, x2 );
+    const BS_WORD x04 = BS_AND( x4, x0 );
+    const BS_WORD x14 = BS_AND( x4, x1 );
+    const BS_WORD x24 = BS_AND( x4, x2 );
+    const BS_WORD x34 = BS_AND( x4, x3 );
+    const BS_WORD x012 = BS_AND( x12, x0 );
+    const BS_WORD x013 = BS_AND( x13, x0 );
+    const BS_WORD x014 = BS_AND( x14, x0 );
+    const BS_WORD x124 = BS_AND( x24, x1 );
+    const BS_WORD x134 = BS_AND( x34, x1 );
+    const BS_WORD x234 = BS_AND( x34, x2 );
+    const BS_WORD x0124 = BS_AND( x124, x0 );
+    const BS_WORD x0134 = BS_AND( x134, x0 );
+    const BS_WORD x1234 = BS_AND( x234, x1 );
+
+    s[1] = BS_XOR4( BS_XOR4( x0, x1, x01, x2 ),
+                    BS_XOR4( x3, x013, x04, x014 ),
+                    BS_XOR4( x24, x124, x0124, x0134 ),
+                    x1234 );
+    s[0] = BS_XOR3( BS_XOR4( x0, x01, x2, x12 ),
+                    BS_XOR4( x012, x3, x23, x4 ),
+                    BS_XOR( x134, x0134 ) );
+}
+
+typedef struct
+{
+    BS_WORD A[11][4]; /* A[1] to A[10], bit by bit */
+    BS_WORD B[11][4];
+    BS_WORD X[4], Y[4], Z[4];
+    BS_WORD D[4], E[4], F[4];
+    BS_WORD p, q, r;
+} BS_FUNC(csa_stream_t);
+
+/* One iteration of csa_StreamCypher(), giving 2 output bits. in_a and in_b
+ * are the input nibbles during initialisation, NULL afterwards. */
+static BS_INLINE void BS_FUNC(csa_StreamClock)( BS_FUNC(csa_stream_t) *c,
+                                               const BS_WORD *in_a,
+                                               const BS_WORD *in_b,
+                                               BS_WORD op[2] )
+{
+    BS_WORD (*A)[4] = c->A;
+    BS_WORD (*B)[4] = c->B;
+    BS_WORD s1[2], s2[2], s3[2], s4[2], s5[2], s6[2], s7[2];
+    BS_WORD extra_B[4], next_A1[4], next_B1[4], next_F[4];
+
+    BS_FUNC(csa_Sbox1)( s1, A[4][0], A[1][2], A[6][1], A[7][3], A[9][0] );
+    BS_FUNC(csa_Sbox2)( s2, A[2][1], A[3][2], A[6][3], A[7][0], A[9][1] );
+    BS_FUNC(csa_Sbox3)( s3, A[1][3], A[2][0], A[5][1], A[5][3], A[6][2] );
+    BS_FUNC(csa_Sbox4)( s4, A[3][3], A[1][1], A[2][3], A[4][2], A[8][0] );
+    BS_FUNC(csa_Sbox5)( s5, A[5][2], A[4][3], A[6][0], A[8][1], A[9][2] );
+    BS_FUNC(csa_Sbox6)( s6, A[3][1], A[4][1], A[5][0], A[7][2], A[9][3] );
+    BS_FUNC(csa_Sbox7)( s7, A[2][2], A[3][0], A[7][1], A[8][2], A[8][3] );
+
+    /* 4x4 xor for T3 */
+    extra_B[3] = BS_XOR4( B[3][0], B[6][1], B[7][2], B[9][3] );
+    extra_B[2] = BS_XOR4( B[6][0], B[8][1], B[3][3], B[4][2] );
+    extra_B[1] = BS_XOR4( B[5][3], B[8][2], B[4][0], B[5][1] );
+    extra_B[0] = BS_XOR4( B[9][2], B[6][3], B[3][1], B[8][0] );
+
+    /* T1 and T2 */
+    for( int b = 0; b < 4; b++ )
+    {
+        next_A1[b] = BS_XOR( A[10][b], c->X[b] );
+        next_B1[b] = BS_XOR3( B[7][b], B[10][b], c->Y[b] );
+        if( in_a != NULL )
+        {
+            next_A1[b] = BS_XOR3( next_A1[b], c->D[b], in_a[b] );
+            next_B1[b] = BS_XOR( next_B1[b], in_b[b] );
+        }
+    }
+    /* if p=1, rotate left */
+    const BS_WORD b3 = next_B1[3];
+    for( int b = 3; b > 0; b-- )
+        next_B1[b] = BS_MUX( c->p, next_B1[b - 1], next_B1[b] );
+    next_B1[0] = BS_MUX( c->p, b3, next_B1[0] );
+
+    /* T3, and T4 the sum, carry of Z + E + r if q=1 */
+    BS_WORD carry = c->r;
+    for( int b = 0; b < 4; b++ )
+    {
+        const BS_WORD ze = BS_XOR( c->Z[b], c->E[b] );
+
+        c->D[b] = BS_XOR( ze, extra_B[b] );
+        next_F[b] = BS_MUX( c->q, BS_XOR( ze, carry ), c->E[b] );
+        carry = BS_OR( BS_AND( c->Z[b], c->E[b] ), BS_AND( ze, carry ) );
+        c->E[b] = c->F[b];
+        c->F[b] = next_F[b];
+    }
+    c->r = BS_MUX( c->q, carry, c->r );
+
+    memmove( &A[2], &A[1], 9 * sizeof (A[1]) );
+    memmove( &B[2], &B[1], 9 * sizeof (B[1]) );
+    memcpy( A[1], next_A1, sizeof (A[1]) );
+    memcpy( B[1], next_B1, sizeof (B[1]) );
+
+    c->X[3] = s4[0]; c->X[2] = s3[0]; c->X[1] = s2[1]; c->X[0] = s1[1];
+    c->Y[3] = s6[0]; c->Y[2] = s5[0]; c->Y[1] = s4[1]; c->Y[0] = s3[1];
+    c->Z[3] = s2[0]; c->Z[2] = s1[0]; c->Z[1] = s6[1]; c->Z[0] = s5[1];
+    c->p = s7[1];
+    c->q = s7[0];
+
+    /* 2 output bits are a function of the 4 bits of D */
+    op[1] = BS_XOR( c->D[2], c->D[3] );
+    op[0] = BS_XOR( c->D[0], c->D[1] );
+}
+
+/* Loads the key, and initialises with the 8 bytes of sb, given bit by bit:
+ * sb[8 * i + b] is the bit b of byte i. */
+static BS_TARGET void BS_FUNC(csa_StreamInit)( BS_FUNC(csa_stream_t) *c,
+                                              const uint8_t ck[8],
+                                              const BS_WORD sb[64] )
+{
+    BS_WORD op[2];
+
+    memset( c, 0, sizeof (*c) );
+    /* A[1] to A[8] are the nibbles of the first 32 bits of ck, high nibble
+     * first, and B[1] to B[8] those of the last 32 bits */
+    for( int i = 0; i < 8; i++ )
+        for( int b = 0; b < 4; b++ )
+        {
+            const int shift = ((i & 1) ? 0 : 4) + b;
+
+            c->A[1 + i][b] = ((ck[i / 2] >> shift) & 1) ? BS_ONES : BS_ZERO;
+            c->B[1 + i][b] = ((ck[4 + i / 2] >> shift) & 1) ? BS_ONES : BS_ZERO;
+        }
+
+    for( int i = 0; i < 8; i++ )
+    {
+        const BS_WORD *in1 = &sb[8 * i + 4];
+        const BS_WORD *in2 = &sb[8 * i];
+
+        for( int j = 0; j < 4; j += 2 )
+        {
+            BS_FUNC(csa_StreamClock)( c, in1, in2, op );
+            BS_FUNC(csa_StreamClock)( c, in2, in1, op );
+        }
+    }
+}
+
+/* Outputs the next 8 bytes, bit by bit as the input of csa_StreamInit() */
+static BS_TARGET void BS_FUNC(csa_StreamBytes)( BS_FUNC(csa_stream_t) *c,
+                                               BS_WORD cb[64] )
+{
+    for( int i = 0; i < 8; i++ )
+        for( int j = 0; j < 4; j++ )
+        {
+            BS_WORD op[2];
+
+            BS_FUNC(csa_StreamClock)( c, NULL, NULL, op );
+            cb[8 * i + 7 - 2 * j] = op[1];
+            cb[8 * i + 6 - 2 * j] = op[0];
+        }
+}
+
+/*****************************************************************************
+ * Block cypher
+ *****************************************************************************/
+
+/* block_perm[] moves each bit within the byte */
+static BS_INLINE BS_WORD BS_FUNC(csa_BlockPerm)( BS_WORD x )
+{
+    return BS_OR( BS_OR( BS_OR( BS_SHL( BS_AND( x, BS_BYTES(0x29) ), 1 ),
+                                BS_SHL( BS_AND( x, BS_BYTES(0x02) ), 6 ) ),
+                         BS_OR( BS_SHL( BS_AND( x, BS_BYTES(0x04) ), 3 ),
+                                BS_SHR( BS_AND( x, BS_BYTES(0x10) ), 2 ) ) ),
+                  BS_OR( BS_SHR( BS_AND( x, BS_BYTES(0x40) ), 6 ),
+                         BS_SHR( BS_AND( x, BS_BYTES(0x80) ), 4 ) ) );
+}
+
+/* csa_BlockCypher() of the first count packets: the byte k of the row R[j]
+ * is the register j+1 of the packet k. */
+static BS_TARGET void BS_FUNC(csa_BlockCypher)( const uint8_t kk[57],
+                                               BS_WORD R[8][8],
+                                               unsigned count )
+{
+    BS_WORD sbox_out[8];
+    uint8_t *s = (uint8_t *)sbox_out;
+
+    memset( sbox_out, 0, sizeof (sbox_out) );
+    for( int i = 1; i <= 56; i++ )
+    {
+        /* rather than shifting the registers, each round renames them:
+         * R1 is the row (i - 1) % 8, and becomes R8 */
+        BS_WORD *R1 = R[(i - 1) & 7];
+        BS_WORD *R3 = R[(i + 1) & 7];
+        BS_WORD *R4 = R[(i + 2) & 7];
+        BS_WORD *R5 = R[(i + 3) & 7];
+        BS_WORD *R7 = R[(i + 5) & 7];
+        const uint8_t *R8 = (const uint8_t *)R[(i + 6) & 7];
+
+        /* 8 packets at a time, to load and store fewer bytes */
+        const uint64_t key = UINT64_C(0x0101010101010101) * kk[i];
+        for( unsigned k = 0; k < count; k += 8 )
+        {
+            uint64_t in, out = 0;
+
+            memcpy( &in, &R8[k], 8 );
+            in ^= key;
+            for( int b = 0; b < 64; b += 8 )
+                out |= (uint64_t)block_sbox[(in >> b) & 0xff] << b;
+            memcpy( &s[k], &out, 8 );
+        }
+
+        for( int w = 0; w < 8; w++ )
+        {
+            R3[w] = BS_XOR( R3[w], R1[w] );
+            R4[w] = BS_XOR( R4[w], R1[w] );
+            R5[w] = BS_XOR( R5[w], R1[w] );
+            R7[w] = BS_XOR( R7[w], BS_FUNC(csa_BlockPerm)( sbox_out[w] ) );
+            R1[w] = BS_XOR( R1[w], sbox_out[w] );
+        }
+    }
+}
+
+/*****************************************************************************
+ * csa_EncryptLanes: scrambles count packets, at most BS_LANES
+ *****************************************************************************/
+static BS_TARGET void BS_FUNC(csa_EncryptLanes)( const uint8_t ck[8],
+                                                const uint8_t kk[57],
+                                                const csa_lane_t *lanes,
+                                                unsigned count )
+{
+    BS_WORD R[8][8];
+    BS_WORD planes[64];
+    BS_FUNC(csa_stream_t) c;
+    unsigned n_max = 0, steps = 0;
+
+    assert( count <= BS_LANES );
+    for( unsigned k = 0; k < count; k++ )
+    {
+        const unsigned n = lanes[k].n + (lanes[k].residue > 0);
+
+        if( lanes[k].n > n_max )
+            n_max = lanes[k].n;
+        if( n > steps )
+            steps = n;
+    }
+
+    /* block cypher, chained from the last block to the first */
+    memset( R, 0, sizeof (R) );
+    for( unsigned m = 0; m < n_max; m++ )
+    {
+        for( unsigned k = 0; k < count; k++ )
+        {
+            if( m >= lanes[k].n )
+                continue;
+
+            const uint8_t *in = &lanes[k].p[8 * (lanes[k].n - 1 - m)];
+            for( int j = 0; j < 8; j++ )
+                ((uint8_t *)R[j])[k] ^= in[j];
+        }
+
+        BS_FUNC(csa_BlockCypher)( kk, R, count );
+
+        for( unsigned k = 0; k < count; k++ )
+        {
+            if( m >= lanes[k].n )
+                continue;
+
+            uint8_t *out = &lanes[k].p[8 * (lanes[k].n - 1 - m)];
+            for( int j = 0; j < 8; j++ )
+                out[j] = ((const uint8_t *)R[j])[k];
+        }
+    }
+
+    /* stream cypher, initialised with the first block */
+    csa_LanesToPlanes( (uint8_t *)planes, sizeof (BS_WORD), lanes, count );
+    BS_FUNC(csa_StreamInit)( &c, ck, planes );
+    for( unsigned i = 1; i < steps; i++ )
+    {
+        BS_FUNC(csa_StreamBytes)( &c, planes );
+        csa_XorPlanes( (const uint8_t *)planes, sizeof (BS_WORD), lanes, count,
+                       i );
+    }
+}
+
+#undef BS_MUX
+#undef BS_XOR6
+#undef BS_XOR5
+#undef BS_XOR4
+#undef BS_XOR3
+#undef BS_NOT
+#undef BS_INLINE
+#undef BS_LANES
+
+#undef BS_SHR
+#undef BS_SHL
+#undef BS_XOR
+#undef BS_OR
+#undef BS_AND
+#undef BS_BYTES
+#undef BS_ONES
+#undef BS_ZERO
+#undef BS_TARGET
+#undef BS_FUNC
+#undef BS_WORD
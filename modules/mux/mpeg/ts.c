@@ -323,6 +323,106 @@ static inline void BufferChainClean( sout_buffer_chain_t *c )
     BufferChainInit( c );
 }
 
+/* 7 packets, 1316 bytes, fit in an Ethernet frame over UDP */
+#define TS_BLOCK_PACKETS 7
+
+/* TS packets of one muxing pass, written in place in the output blocks */
+typedef struct
+{
+    uint8_t    *p_data;
+    vlc_tick_t  i_dts;
+    uint32_t    i_flags;
+    block_t    *p_block; /* output block starting with this packet, or NULL */
+} ts_packet_t;
+
+typedef struct
+{
+    ts_packet_t *p_packets;
+    int          i_depth;
+    int          i_alloc;
+    int          i_block_packets; /* per output block */
+    block_t     *p_block; /* output block being filled */
+    block_t     *p_output; /* output block being dated */
+} ts_chain_t;
+
+static void TSChainInit( ts_chain_t *c, int i_block_packets )
+{
+    c->p_packets = NULL;
+    c->i_depth = 0;
+    c->i_alloc = 0;
+    c->i_block_packets = i_block_packets;
+    c->p_block = NULL;
+    c->p_output = NULL;
+}
+
+/* Forgets the packets, once their output blocks are all written */
+static void TSChainReset( ts_chain_t *c )
+{
+    c->i_depth = 0;
+    c->p_block = NULL;
+    c->p_output = NULL;
+}
+
+/* Makes the next packet start an output block */
+static inline void TSChainCut( ts_chain_t *c )
+{
+    c->p_block = NULL;
+}
+
+static ts_packet_t *TSChainAppend( ts_chain_t *c )
+{
+    if( c->i_depth == c->i_alloc )
+    {
+        int i_alloc = c->i_alloc ? c->i_alloc * 2 : 256;
+        ts_packet_t *p_packets = realloc( c->p_packets,
+                                          i_alloc * sizeof (*p_packets) );
+        if( unlikely(p_packets == NULL) )
+            return NULL;
+        c->p_packets = p_packets;
+        c->i_alloc = i_alloc;
+    }
+
+    ts_packet_t *p_ts = &c->p_packets[c->i_depth];
+
+    p_ts->p_block = NULL;
+    if( c->p_block == NULL ||
+        c->p_block->i_buffer >= (size_t)c->i_block_packets * 188 )
+    {
+        block_t *p_block = block_Alloc( c->i_block_packets * 188 );
+        if( unlikely(p_block == NULL) )
+            return NULL;
+        p_block->i_buffer = 0;
+        c->p_block = p_ts->p_block = p_block;
+    }
+    p_ts->p_data = &c->p_block->p_buffer[c->p_block->i_buffer];
+    p_ts->i_dts = 0;
+    p_ts->i_flags = 0;
+    c->p_block->i_buffer += 188;
+    c->i_depth++;
+    return p_ts;
+}
+
+/* Copies the packets of the tables */
+static void TSChainAppendBlock( void *opaque, block_t *p_block )
+{
+    ts_chain_t *c = opaque;
+
+    while( p_block )
+    {
+        block_t *p_next = p_block->p_next;
+        ts_packet_t *p_ts = TSChainAppend( c );
+
+        if( likely(p_ts != NULL) )
+        {
+            memcpy( p_ts->p_data, p_block->p_buffer, 188 );
+            p_ts->i_dts = p_block->i_dts;
+            p_ts->i_flags = p_block->i_flags;
+        }
+        block_Release( p_block );
+        p_block = p_next;
+    }
+}
+
 typedef struct
 {
     sout_buffer_chain_t chain_pes;
@@ -383,8 +483,12 @@ typedef struct
 
     csa_t           *csa;
     int             i_csa_pkt_size;
+    uint8_t         **pp_csa_packets; /* to scramble, in one batch */
+    int             i_csa_packets_alloc;
     bool            b_crypt_audio;
     bool            b_crypt_video;
+
+    ts_chain_t      chain_ts;
 } sout_mux_sys_t;
 
 
@@ -473,15 +577,19 @@ static int Mux      ( sout_mux_t * );
 
 static block_t *FixPES( sout_mux_t *p_mux, block_fifo_t *p_fifo );
 static block_t *Add_ADTS( block_t *, const es_format_t * );
-static void TSSchedule  ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+static void TSScramble  ( sout_mux_t *p_mux, ts_chain_t *p_chain_ts );
+static void TSSchedule  ( sout_mux_t *p_mux, ts_chain_t *p_chain_ts, int i_first,
                           vlc_tick_t i_pcr_length, vlc_tick_t i_pcr_dts );
-static void TSDate      ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+static void TSDate      ( sout_mux_t *p_mux, ts_chain_t *p_chain_ts,
+                          int i_first, int i_packet_count,
                           vlc_tick_t i_pcr_length, vlc_tick_t i_pcr_dts );
-static void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
-static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
+static void GetPAT( sout_mux_t *p_mux, ts_chain_t *c );
+static void GetPMT( sout_mux_t *p_mux, ts_chain_t *c );
 
-static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream, bool b_pcr );
-static void TSSetPCR( block_t *p_ts, vlc_tick_t i_dts );
+static ts_packet_t *TSNew( ts_chain_t *p_chain_ts, sout_input_sys_t *p_stream,
+                           bool b_pcr );
+static bool TSIsKeyFrame( const sout_input_sys_t *p_stream );
+static void TSSetPCR( uint8_t *p_ts, vlc_tick_t i_dts );
 
 static csa_t *csaSetup( vlc_object_t *p_this )
 {
@@ -740,6 +848,11 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->b_use_key_frames = var_GetBool( p_mux, SOUT_CFG_PREFIX "use-key-frames" );
 
+    /* Output as many packets per block as fit in a datagram */
+    int64_t i_mtu = var_InheritInteger( p_mux, "mtu" );
+    TSChainInit( &p_sys->chain_ts,
+                 VLC_CLIP( i_mtu / 188, 1, TS_BLOCK_PACKETS ) );
+
     p_mux->p_sys        = p_sys;
 
     p_sys->csa = csaSetup(p_this);
@@ -777,6 +890,8 @@ static void Close( vlc_object_t * p_this )
         free( p_sys->sdt.desc[i].psz_provider );
     }
 
+    free( p_sys->pp_csa_packets );
+    free( p_sys->chain_ts.p_packets );
     free( p_sys );
 }
 
@@ -1036,16 +1151,10 @@ static void DelStream( sout_mux_t *p_mux, sout_input_t *p_input )
     p_sys->i_pmt_version_number %= 32;
 }
 
-static void SetHeader( sout_buffer_chain_t *c,
-                        int depth )
+static void SetHeader( ts_chain_t *c, int depth )
 {
-    block_t *p_ts = BufferChainPeek( c );
-    while( depth > 0 )
-    {
-        p_ts = p_ts->p_next;
-        depth--;
-    }
-    p_ts->i_flags |= BLOCK_FLAG_HEADER;
+    if( depth < c->i_depth )
+        c->p_packets[depth].i_flags |= BLOCK_FLAG_HEADER;
 }
 
 static block_t *Pack_Opus(block_t *p_data)
@@ -1196,7 +1305,7 @@ static bool MuxStreams(sout_mux_t *p_mux )
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
     sout_input_sys_t *p_pcr_stream = (sout_input_sys_t*)p_sys->p_pcr_input->p_sys;
 
-    sout_buffer_chain_t chain_ts;
+    ts_chain_t *p_chain_ts = &p_sys->chain_ts;
     vlc_tick_t i_shaping_delay = p_pcr_stream->state.b_key_frame
         ? p_pcr_stream->state.i_pes_length
         : p_sys->i_shaping_delay;
@@ -1485,13 +1594,12 @@ static bool MuxStreams(sout_mux_t *p_mux )
     i_packet_count += (8 * i_pcr_length / p_sys->i_pcr_delay + 175) / 176;
 
     /* 3: mux PES into TS */
-    BufferChainInit( &chain_ts );
     /* append PAT/PMT  -> FIXME with big pcr delay it won't have enough pat/pmt */
     bool pat_was_previous = true; //This is to prevent unnecessary double PAT/PMT insertions
-    GetPAT( p_mux, &chain_ts );
-    GetPMT( p_mux, &chain_ts );
+    GetPAT( p_mux, p_chain_ts );
+    GetPMT( p_mux, p_chain_ts );
     int i_packet_pos = 0;
-    i_packet_count += chain_ts.i_depth;
+    i_packet_count += p_chain_ts->i_depth;
     /* msg_Dbg( p_mux, "estimated pck=%d", i_packet_count ); */
 
     const vlc_tick_t i_pcr_dts = p_pcr_stream->state.i_pes_dts;
@@ -1535,42 +1643,46 @@ static bool MuxStreams(sout_mux_t *p_mux )
             p_sys->i_pcr = i_pcr_dts + packet_length;
         }
 
-        /* Build the TS packet */
-        block_t *p_ts = TSNew( p_mux, p_stream, b_pcr );
-        if( p_sys->csa != NULL &&
-             (p_input->p_fmt->i_cat != AUDIO_ES || p_sys->b_crypt_audio) &&
-             (p_input->p_fmt->i_cat != VIDEO_ES || p_sys->b_crypt_video) )
-        {
-            p_ts->i_flags |= BLOCK_FLAG_SCRAMBLED;
-        }
-        i_packet_pos++;
-
         /* Write PAT/PMT before every keyframe if use-key-frames is enabled,
          * this helps to do segmenting with livehttp-output so it can cut segment
          * and start new one with pat,pmt,keyframe*/
         if( ( p_sys->b_use_key_frames ) &&
             ( p_input->p_fmt->i_cat == VIDEO_ES ) &&
-            ( p_ts->i_flags & BLOCK_FLAG_TYPE_I ) )
+            TSIsKeyFrame( p_stream ) )
         {
             if( likely( !pat_was_previous ) )
             {
-                int startcount = chain_ts.i_depth;
-                GetPAT( p_mux, &chain_ts );
-                GetPMT( p_mux, &chain_ts );
-                SetHeader( &chain_ts, startcount );
-                i_packet_count += (chain_ts.i_depth - startcount );
+                int startcount = p_chain_ts->i_depth;
+                /* the header gets its own output blocks */
+                TSChainCut( p_chain_ts );
+                GetPAT( p_mux, p_chain_ts );
+                GetPMT( p_mux, p_chain_ts );
+                SetHeader( p_chain_ts, startcount );
+                i_packet_count += (p_chain_ts->i_depth - startcount );
             } else {
-                SetHeader( &chain_ts, 0); //We just inserted pat/pmt,so just flag it instead of adding new one
+                SetHeader( p_chain_ts, 0); //We just inserted pat/pmt,so just flag it instead of adding new one
             }
         }
         pat_was_previous = false;
 
-        /* */
-        BufferChainAppend( &chain_ts, p_ts );
+        /* Build the TS packet */
+        ts_packet_t *p_ts = TSNew( p_chain_ts, p_stream, b_pcr );
+        if( unlikely(p_ts == NULL) )
+            break;
+        if( p_sys->csa != NULL &&
+             (p_input->p_fmt->i_cat != AUDIO_ES || p_sys->b_crypt_audio) &&
+             (p_input->p_fmt->i_cat != VIDEO_ES || p_sys->b_crypt_video) )
+        {
+            p_ts->i_flags |= BLOCK_FLAG_SCRAMBLED;
+        }
+        i_packet_pos++;
     }
 
-    /* 4: date and send */
-    TSSchedule( p_mux, &chain_ts, i_pcr_length, i_pcr_dts );
+    /* 4: scramble, date and send */
+    if( p_sys->csa != NULL )
+        TSScramble( p_mux, p_chain_ts );
+    TSSchedule( p_mux, p_chain_ts, 0, i_pcr_length, i_pcr_dts );
+    TSChainReset( p_chain_ts );
     return false;
 }
 
@@ -1705,14 +1817,50 @@ static block_t *Add_ADTS( block_t *p_data, const es_format_t *p_fmt )
     return p_new_block;
 }
 
-static void TSSchedule( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+/* Scrambles the packets flagged for it, all at once: the scrambler is much
+ * faster on many packets than one by one */
+static void TSScramble( sout_mux_t *p_mux, ts_chain_t *p_chain_ts )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    int i_count = 0;
+
+    if( p_sys->i_csa_packets_alloc < p_chain_ts->i_depth )
+    {
+        uint8_t **pp_packets = realloc( p_sys->pp_csa_packets,
+                                        p_chain_ts->i_alloc *
+                                        sizeof (*pp_packets) );
+        if( likely(pp_packets != NULL) )
+        {
+            p_sys->pp_csa_packets = pp_packets;
+            p_sys->i_csa_packets_alloc = p_chain_ts->i_alloc;
+        }
+    }
+
+    vlc_mutex_lock( &p_sys->csa_lock );
+    for( int i = 0; i < p_chain_ts->i_depth; i++ )
+    {
+        uint8_t *p_data = p_chain_ts->p_packets[i].p_data;
+
+        if( !(p_chain_ts->p_packets[i].i_flags & BLOCK_FLAG_SCRAMBLED) )
+            continue;
+        if( unlikely(p_sys->i_csa_packets_alloc < p_chain_ts->i_depth) )
+            /* one by one then */
+            csa_Encrypt( p_sys->csa, p_data, p_sys->i_csa_pkt_size );
+        else
+            p_sys->pp_csa_packets[i_count++] = p_data;
+    }
+    csa_EncryptBatch( p_sys->csa, p_sys->pp_csa_packets, i_count,
+                      p_sys->i_csa_pkt_size );
+    vlc_mutex_unlock( &p_sys->csa_lock );
+}
+
+/* Dates the packets from i_first on */
+static void TSSchedule( sout_mux_t *p_mux, ts_chain_t *p_chain_ts, int i_first,
                         vlc_tick_t i_pcr_length, vlc_tick_t i_pcr_dts )
 {
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
-    sout_buffer_chain_t new_chain;
-    int i_packet_count = p_chain_ts->i_depth;
-
-    BufferChainInit( &new_chain );
+    const ts_packet_t *p_packets = &p_chain_ts->p_packets[i_first];
+    int i_packet_count = p_chain_ts->i_depth - i_first;
 
     if ( unlikely(i_pcr_length <= 0) )
     {
@@ -1721,51 +1869,49 @@ static void TSSchedule( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
 
     for (int i = 0; i < i_packet_count; i++ )
     {
-        block_t *p_ts = BufferChainGet( p_chain_ts );
+        const ts_packet_t *p_ts = &p_packets[i];
         vlc_tick_t i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
 
-        BufferChainAppend( &new_chain, p_ts );
-
         if (!p_ts->i_dts || p_ts->i_dts + p_sys->i_dts_delay * 2/3 >= i_new_dts)
             continue;
 
         vlc_tick_t i_max_diff = i_new_dts - p_ts->i_dts;
         vlc_tick_t i_cut_dts = p_ts->i_dts;
 
-        p_ts = BufferChainPeek( p_chain_ts );
         i++;
         i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
-        while ( p_ts != NULL && i_new_dts - p_ts->i_dts >= i_max_diff )
+        while ( i < i_packet_count &&
+                i_new_dts - p_packets[i].i_dts >= i_max_diff )
         {
-            p_ts = BufferChainGet( p_chain_ts );
-            i_max_diff = i_new_dts - p_ts->i_dts;
-            i_cut_dts = p_ts->i_dts;
-            BufferChainAppend( &new_chain, p_ts );
+            i_max_diff = i_new_dts - p_packets[i].i_dts;
+            i_cut_dts = p_packets[i].i_dts;
 
-            p_ts = BufferChainPeek( p_chain_ts );
             i++;
             i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
         }
         msg_Dbg( p_mux, "adjusting rate at %"PRId64"/%"PRId64" (%d/%d)",
-                 i_cut_dts - i_pcr_dts, i_pcr_length, new_chain.i_depth,
-                 p_chain_ts->i_depth );
-        if ( new_chain.i_depth )
-            TSDate( p_mux, &new_chain, i_cut_dts - i_pcr_dts, i_pcr_dts );
-        if ( p_chain_ts->i_depth )
-            TSSchedule( p_mux, p_chain_ts, i_pcr_dts + i_pcr_length - i_cut_dts,
-                        i_cut_dts );
+                 i_cut_dts - i_pcr_dts, i_pcr_length, i,
+                 i_packet_count - i );
+        TSDate( p_mux, p_chain_ts, i_first, i, i_cut_dts - i_pcr_dts,
+                i_pcr_dts );
+        if ( i < i_packet_count )
+            TSSchedule( p_mux, p_chain_ts, i_first + i,
+                        i_pcr_dts + i_pcr_length - i_cut_dts, i_cut_dts );
         return;
     }
 
-    if ( new_chain.i_depth )
-        TSDate( p_mux, &new_chain, i_pcr_length, i_pcr_dts );
+    if ( i_packet_count )
+        TSDate( p_mux, p_chain_ts, i_first, i_packet_count, i_pcr_length,
+                i_pcr_dts );
 }
 
-static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+/* Dates i_packet_count packets from i_first on, and sends the output blocks
+ * they complete */
+static void TSDate( sout_mux_t *p_mux, ts_chain_t *p_chain_ts,
+                    int i_first, int i_packet_count,
                     vlc_tick_t i_pcr_length, vlc_tick_t i_pcr_dts )
 {
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
-    int i_packet_count = p_chain_ts->i_depth;
 
     if ( likely(i_pcr_length / 1000 > 0) )
     {
@@ -1789,35 +1935,54 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     /* msg_Dbg( p_mux, "real pck=%d", i_packet_count ); */
     for (int i = 0; i < i_packet_count; i++ )
     {
-        block_t *p_ts = BufferChainGet( p_chain_ts );
+        const int i_packet = i_first + i;
+        ts_packet_t *p_ts = &p_chain_ts->p_packets[i_packet];
         vlc_tick_t i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
 
-        p_ts->i_dts    = i_new_dts;
-        p_ts->i_length = i_pcr_length / i_packet_count;
+        p_ts->i_dts = i_new_dts;
 
         if( p_ts->i_flags & BLOCK_FLAG_CLOCK )
         {
             /* msg_Dbg( p_mux, "pcr=%lld ms", p_ts->i_dts / 1000 ); */
-            TSSetPCR( p_ts, p_ts->i_dts - p_sys->first_dts );
+            TSSetPCR( p_ts->p_data, p_ts->i_dts - p_sys->first_dts );
         }
-        if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
+        /* The output block takes the date of its first packet, and lasts
+         * as long as all its packets */
+        block_t *p_block = p_ts->p_block;
+        if( p_block != NULL )
         {
-            vlc_mutex_lock( &p_sys->csa_lock );
-            csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
-            vlc_mutex_unlock( &p_sys->csa_lock );
+            /* latency */
+            p_block->i_dts = i_new_dts + p_sys->i_shaping_delay * 3 / 2;
+            p_block->i_length = 0;
+            p_block->i_flags = p_ts->i_flags & (BLOCK_FLAG_HEADER |
+                                                BLOCK_FLAG_TYPE_I);
+            p_chain_ts->p_output = p_block;
         }
+        else
+            p_block = p_chain_ts->p_output;
 
-        /* latency */
-        p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
+        p_block->i_length += i_pcr_length / i_packet_count;
+        p_block->i_flags |= p_ts->i_flags & BLOCK_FLAG_CLOCK;
 
-        sout_AccessOutWrite( p_mux->p_access, p_ts );
+        if( i_packet + 1 == p_chain_ts->i_depth ||
+            p_chain_ts->p_packets[i_packet + 1].p_block != NULL )
+            sout_AccessOutWrite( p_mux->p_access, p_block );
     }
 }
 
-static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
-                       bool b_pcr )
+/* Whether the next packet of the stream starts a key frame */
+static bool TSIsKeyFrame( const sout_input_sys_t *p_stream )
+{
+    const block_t *p_pes = p_stream->state.chain_pes.p_first;
+
+    return p_stream->state.i_pes_used <= 0 &&
+           !(p_pes->i_flags & BLOCK_FLAG_NO_KEYFRAME) &&
+           (p_pes->i_flags & BLOCK_FLAG_TYPE_I);
+}
+
+static ts_packet_t *TSNew( ts_chain_t *p_chain_ts, sout_input_sys_t *p_stream,
+                           bool b_pcr )
 {
-    VLC_UNUSED(p_mux);
     block_t *p_pes = p_stream->state.chain_pes.p_first;
 
     bool b_new_pes = false;
@@ -1837,20 +2002,27 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
         b_adaptation_field = true;
     }
 
-    block_t *p_ts = block_Alloc( 188 );
+    /* Key frames start an output block, where segmenters may cut */
+    const bool b_key_frame = TSIsKeyFrame( p_stream );
+    if( b_key_frame )
+        TSChainCut( p_chain_ts );
+
+    ts_packet_t *p_ts = TSChainAppend( p_chain_ts );
+    if( unlikely(p_ts == NULL) )
+        return NULL;
 
-    if (b_new_pes && !(p_pes->i_flags & BLOCK_FLAG_NO_KEYFRAME) && p_pes->i_flags & BLOCK_FLAG_TYPE_I)
+    if( b_key_frame )
     {
         p_ts->i_flags |= BLOCK_FLAG_TYPE_I;
     }
 
     p_ts->i_dts = p_pes->i_dts;
 
-    p_ts->p_buffer[0] = 0x47;
-    p_ts->p_buffer[1] = ( b_new_pes ? 0x40 : 0x00 ) |
+    p_ts->p_data[0] = 0x47;
+    p_ts->p_data[1] = ( b_new_pes ? 0x40 : 0x00 ) |
         ( ( p_stream->ts.i_pid >> 8 )&0x1f );
-    p_ts->p_buffer[2] = p_stream->ts.i_pid & 0xff;
-    p_ts->p_buffer[3] = ( b_adaptation_field ? 0x30 : 0x10 ) |
+    p_ts->p_data[2] = p_stream->ts.i_pid & 0xff;
+    p_ts->p_data[3] = ( b_adaptation_field ? 0x30 : 0x10 ) |
         p_stream->ts.i_continuity_counter;
 
     p_stream->ts.i_continuity_counter = (p_stream->ts.i_continuity_counter+1)%16;
@@ -1863,28 +2035,28 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
         {
             p_ts->i_flags |= BLOCK_FLAG_CLOCK;
 
-            p_ts->p_buffer[4] = 7 + i_stuffing;
-            p_ts->p_buffer[5] = 1 << 4; /* PCR_flag */
+            p_ts->p_data[4] = 7 + i_stuffing;
+            p_ts->p_data[5] = 1 << 4; /* PCR_flag */
             if( p_stream->ts.b_discontinuity )
             {
-                p_ts->p_buffer[5] |= 0x80; /* flag TS dicontinuity */
+                p_ts->p_data[5] |= 0x80; /* flag TS dicontinuity */
                 p_stream->ts.b_discontinuity = false;
             }
-            memset(&p_ts->p_buffer[12], 0xff, i_stuffing);
+            memset(&p_ts->p_data[12], 0xff, i_stuffing);
         }
         else
         {
-            p_ts->p_buffer[4] = --i_stuffing;
+            p_ts->p_data[4] = --i_stuffing;
             if( i_stuffing-- )
             {
-                p_ts->p_buffer[5] = 0;
-                memset(&p_ts->p_buffer[6], 0xff, i_stuffing);
+                p_ts->p_data[5] = 0;
+                memset(&p_ts->p_data[6], 0xff, i_stuffing);
             }
         }
     }
 
     /* copy payload */
-    memcpy( &p_ts->p_buffer[188 - i_payload],
+    memcpy( &p_ts->p_data[188 - i_payload],
             &p_pes->p_buffer[p_stream->state.i_pes_used], i_payload );
 
     p_stream->state.i_pes_used += i_payload;
@@ -1917,31 +2089,31 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
     return p_ts;
 }
 
-static void TSSetPCR( block_t *p_ts, vlc_tick_t i_dts )
+static void TSSetPCR( uint8_t *p_ts, vlc_tick_t i_dts )
 {
     int64_t i_pcr = TO_SCALE_NZ(i_dts);
 
-    p_ts->p_buffer[6]  = ( i_pcr >> 25 )&0xff;
-    p_ts->p_buffer[7]  = ( i_pcr >> 17 )&0xff;
-    p_ts->p_buffer[8]  = ( i_pcr >> 9  )&0xff;
-    p_ts->p_buffer[9]  = ( i_pcr >> 1  )&0xff;
-    p_ts->p_buffer[10] = ( i_pcr << 7  )&0x80;
-    p_ts->p_buffer[10] |= 0x7e;
-    p_ts->p_buffer[11] = 0; /* we don't set PCR extension */
+    p_ts[6]  = ( i_pcr >> 25 )&0xff;
+    p_ts[7]  = ( i_pcr >> 17 )&0xff;
+    p_ts[8]  = ( i_pcr >> 9  )&0xff;
+    p_ts[9]  = ( i_pcr >> 1  )&0xff;
+    p_ts[10] = ( i_pcr << 7  )&0x80;
+    p_ts[10] |= 0x7e;
+    p_ts[11] = 0; /* we don't set PCR extension */
 }
 
-void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
+void GetPAT( sout_mux_t *p_mux, ts_chain_t *c )
 {
     sout_mux_sys_t       *p_sys = p_mux->p_sys;
 
     BuildPAT( p_sys->p_dvbpsi,
-              c, (PEStoTSCallback)BufferChainAppend,
+              c, TSChainAppendBlock,
               p_sys->i_tsid, p_sys->i_pat_version_number,
               &p_sys->pat,
               p_sys->i_num_pmt, p_sys->pmt, p_sys->i_pmt_program_number );
 }
 
-static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
+static void GetPMT( sout_mux_t *p_mux, ts_chain_t *c )
 {
     sout_mux_sys_t *p_sys = p_mux->p_sys;
     pes_mapped_stream_t mappeds[p_mux->i_nb_inputs];
@@ -1963,7 +2135,7 @@ static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
     }
 
     BuildPMT( p_sys->p_dvbpsi, VLC_OBJECT(p_mux), p_sys->standard,
-              c, (PEStoTSCallback)BufferChainAppend,
+              c, TSChainAppendBlock,
               p_sys->i_tsid, p_sys->i_pmt_version_number,
               ((sout_input_sys_t *)p_sys->p_pcr_input->p_sys)->ts.i_pid,
               &p_sys->sdt,
@@ -19,11 +19,108 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 #include <vlc_bits.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN)
+# include <arm_neon.h>
+# define HXXX_EP3B_NEON
+#endif
+
+/* Emulation prevention can only happen on a 0x03 byte following a 0x00.
+ * The scan functions return the number of bytes following p that can be
+ * read as is, up to end - p - 1, before the first such 0x00 0x03 pair. */
+static inline size_t hxxx_ep3b_scan_C( const uint8_t *p, const uint8_t *end )
+{
+    const uint8_t *q = p;
+    while( q + 1 < end && !(q[0] == 0x00 && q[1] == 0x03) )
+        q++;
+    return q - p;
+}
+
+#ifdef HAVE_AVX2_INTRINSICS
+__attribute__ ((__target__ ("avx2")))
+static inline size_t hxxx_ep3b_scan_AVX2( const uint8_t *p, const uint8_t *end )
+{
+    const __m256i zeros = _mm256_setzero_si256();
+    const __m256i threes = _mm256_set1_epi8( 0x03 );
+    const uint8_t *q = p;
+
+    for( ; end - q >= 32 + 1; q += 32 )
+    {
+        __m256i v0 = _mm256_loadu_si256( (const __m256i *) &q[0] );
+        __m256i v1 = _mm256_loadu_si256( (const __m256i *) &q[1] );
+        __m256i res = _mm256_and_si256( _mm256_cmpeq_epi8( v0, zeros ),
+                                        _mm256_cmpeq_epi8( v1, threes ) );
+        uint32_t match = _mm256_movemask_epi8( res );
+        if( match )
+            return q - p + ctz( match );
+    }
+    return q - p + hxxx_ep3b_scan_C( q, end );
+}
+#endif
+
+#ifdef HXXX_EP3B_NEON
+static inline size_t hxxx_ep3b_scan_NEON( const uint8_t *p, const uint8_t *end )
+{
+    const uint8x16_t zeros = vdupq_n_u8( 0x00 );
+    const uint8x16_t threes = vdupq_n_u8( 0x03 );
+    const uint8_t *q = p;
+
+    for( ; end - q >= 16 + 1; q += 16 )
+    {
+        uint8x16_t res = vandq_u8( vceqq_u8( vld1q_u8( &q[0] ), zeros ),
+                                   vceqq_u8( vld1q_u8( &q[1] ), threes ) );
+        uint64x2_t res64 = vreinterpretq_u64_u8( res );
+        uint64_t lo = vgetq_lane_u64( res64, 0 );
+        uint64_t hi = vgetq_lane_u64( res64, 1 );
+        if( lo )
+            return q - p + ctz( lo ) / 8;
+        if( hi )
+            return q - p + 8 + ctz( hi ) / 8;
+    }
+    return q - p + hxxx_ep3b_scan_C( q, end );
+}
+#endif
+
+static inline size_t hxxx_ep3b_scan( const uint8_t *p, const uint8_t *end )
+{
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        return hxxx_ep3b_scan_AVX2( p, end );
+#endif
+#ifdef HXXX_EP3B_NEON
+    if( vlc_CPU_ARM_NEON() )
+        return hxxx_ep3b_scan_NEON( p, end );
+#endif
+    return hxxx_ep3b_scan_C( p, end );
+}
+
+/* Below that many bytes, scanning ahead is not worth it */
+#define HXXX_EP3B_SCAN_MIN 32
 
 static inline uint8_t *hxxx_ep3b_to_rbsp( uint8_t *p, uint8_t *end, unsigned *pi_prev, size_t i_count )
 {
     for( size_t i=0; i<i_count; i++ )
     {
+        if( i_count - i >= HXXX_EP3B_SCAN_MIN && end - p > HXXX_EP3B_SCAN_MIN )
+        {
+            /* Skip the bytes without emulation prevention at once. Only the
+             * state of the 2 last bytes matters, the first one being real. */
+            const uint8_t *scan_end = ((size_t)(end - p) > i_count - i)
+                                    ? p + (i_count - i) + 1 : end;
+            size_t i_skip = hxxx_ep3b_scan( p, scan_end );
+            if( i_skip >= 2 )
+            {
+                p += i_skip;
+                i += i_skip - 1;
+                *pi_prev = (!p[-1] << 1) | (!p[0]);
+                continue;
+            }
+        }
+
         if( ++p >= end )
             return p;
 
@@ -74,7 +171,7 @@ struct hxxx_bsfw_ep3b_ctx_s
     size_t i_bytesize;
 };
 
-static void hxxx_bsfw_ep3b_ctx_init( struct hxxx_bsfw_ep3b_ctx_s *ctx )
+static inline void hxxx_bsfw_ep3b_ctx_init( struct hxxx_bsfw_ep3b_ctx_s *ctx )
 {
     ctx->i_prev = 0;
     ctx->i_bytepos = 0;
@@ -88,6 +185,14 @@ static size_t hxxx_ep3b_total_size( const uint8_t *p, const uint8_t *p_end )
     size_t i = 0;
     while( p < p_end )
     {
+        size_t i_skip = hxxx_ep3b_scan( p, p_end );
+        if( i_skip >= 2 )
+        {
+            p += i_skip;
+            i += i_skip;
+            i_prev = (!p[-1] << 1) | (!p[0]);
+        }
+
         uint8_t *n = hxxx_ep3b_to_rbsp( (uint8_t *)p, (uint8_t *)p_end, &i_prev, 1 );
         if( n > p )
             ++i;
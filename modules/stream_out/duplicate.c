@@ -56,6 +56,61 @@ static void *Add( sout_stream_t *, const es_format_t * );
 static void  Del( sout_stream_t *, void * );
 static int   Send( sout_stream_t *, void *, block_t * );
 
+/* Overflow policies of the asynchronous branches */
+enum
+{
+    OVERFLOW_BLOCK,
+    OVERFLOW_DROP_OLDEST,
+    OVERFLOW_DROP_NON_KEY,
+};
+
+static const char *const ppsz_overflow[] = {
+    "block", "drop-oldest", "drop-non-key",
+};
+
+#define QUEUE_DEFAULT  64
+#define QUEUE_MAX      65536
+#define STATS_INTERVAL VLC_TICK_FROM_SEC(10)
+
+typedef struct sout_stream_id_sys_t sout_stream_id_sys_t;
+
+typedef struct
+{
+    sout_stream_id_sys_t *id;
+    block_t              *p_block;
+} duplicate_entry_t;
+
+/* Bounded queue of an asynchronous branch, and the thread feeding it */
+typedef struct
+{
+    sout_stream_t *p_parent;
+    sout_stream_t *p_stream;
+    int           i_branch;
+    int           i_overflow;
+
+    vlc_thread_t  thread;
+    vlc_mutex_t   branch_lock; /* serializes the calls into the branch */
+
+    vlc_mutex_t   lock;
+    vlc_cond_t    wait;        /* signaled when a block is queued */
+    vlc_cond_t    wait_space;  /* signaled when a block is taken */
+    duplicate_entry_t *p_entries;
+    unsigned      i_size;
+    unsigned      i_first;
+    unsigned      i_count;
+    bool          b_busy;      /* a block is being sent */
+    bool          b_quit;
+
+    /* Statistics */
+    uint64_t      i_queued;
+    uint64_t      i_depth_sum;
+    unsigned      i_depth_max;
+    uint64_t      i_dropped;
+    uint64_t      i_waits;
+    vlc_tick_t    i_wait_time;
+    vlc_tick_t    i_last_report;
+} duplicate_queue_t;
+
 typedef struct
 {
     int             i_nb_streams;
@@ -66,16 +121,30 @@ typedef struct
 
     int             i_nb_select;
     char            **ppsz_select;
+
+    int                 i_nb_queues;
+    duplicate_queue_t   **pp_queues; /* NULL for synchronous branches */
 } sout_stream_sys_t;
 
-typedef struct
+struct sout_stream_id_sys_t
 {
     int                 i_nb_ids;
     void                **pp_ids;
-} sout_stream_id_sys_t;
+
+    enum es_format_category_e i_cat;
+    bool                *pb_wait_key; /* per branch, after a dropped block */
+};
 
 static bool ESSelected( const es_format_t *fmt, char *psz_select );
 
+static duplicate_queue_t *QueueNew( sout_stream_t *, sout_stream_t *, int,
+                                    unsigned );
+static void QueueDelete( duplicate_queue_t * );
+static void *QueueThread( void * );
+static void QueuePut( duplicate_queue_t *, sout_stream_id_sys_t *, block_t * );
+static void QueueDrain( duplicate_queue_t * );
+static void QueueReport( duplicate_queue_t * );
+
 /*****************************************************************************
  * Control
  *****************************************************************************/
@@ -92,9 +161,35 @@ static int Control( sout_stream_t *p_stream, int i_query, va_list args )
             void *spu_hl = va_arg(args, void *);
             for( int i = 0; i < id->i_nb_ids; i++ )
             {
-                if( id->pp_ids[i] )
-                    sout_StreamControl( p_sys->pp_streams[i], i_query,
-                                        id->pp_ids[i], spu_hl );
+                duplicate_queue_t *q = p_sys->pp_queues[i];
+
+                if( !id->pp_ids[i] )
+                    continue;
+                if( q != NULL )
+                    vlc_mutex_lock( &q->branch_lock );
+                sout_StreamControl( p_sys->pp_streams[i], i_query,
+                                    id->pp_ids[i], spu_hl );
+                if( q != NULL )
+                    vlc_mutex_unlock( &q->branch_lock );
+            }
+            return VLC_SUCCESS;
+        }
+
+        case SOUT_STREAM_EMPTY:
+        {
+            /* Only the asynchronous branches hold blocks here */
+            bool *pb_empty = va_arg(args, bool *);
+
+            *pb_empty = true;
+            for( int i = 0; i < p_sys->i_nb_queues && *pb_empty; i++ )
+            {
+                duplicate_queue_t *q = p_sys->pp_queues[i];
+
+                if( q == NULL )
+                    continue;
+                vlc_mutex_lock( &q->lock );
+                *pb_empty = q->i_count == 0 && !q->b_busy;
+                vlc_mutex_unlock( &q->lock );
             }
             return VLC_SUCCESS;
         }
@@ -121,6 +216,7 @@ static int Open( vlc_object_t *p_this )
     TAB_INIT( p_sys->i_nb_streams, p_sys->pp_streams );
     TAB_INIT( p_sys->i_nb_last_streams, p_sys->pp_last_streams );
     TAB_INIT( p_sys->i_nb_select, p_sys->ppsz_select );
+    TAB_INIT( p_sys->i_nb_queues, p_sys->pp_queues );
 
     for( p_cfg = p_stream->p_cfg; p_cfg != NULL; p_cfg = p_cfg->p_next )
     {
@@ -138,6 +234,7 @@ static int Open( vlc_object_t *p_this )
                 TAB_APPEND( p_sys->i_nb_last_streams, p_sys->pp_last_streams,
                     p_last );
                 TAB_APPEND( p_sys->i_nb_select,  p_sys->ppsz_select, NULL );
+                TAB_APPEND( p_sys->i_nb_queues, p_sys->pp_queues, NULL );
             }
         }
         else if( !strncmp( p_cfg->psz_name, "select", strlen( "select" ) ) )
@@ -159,6 +256,53 @@ static int Open( vlc_object_t *p_this )
                 }
             }
         }
+        else if( !strcmp( p_cfg->psz_name, "async" ) )
+        {
+            /* async[=queue depth]: the last destination is fed from its own
+             * thread, through a queue of that many blocks */
+            const char *psz = p_cfg->psz_value;
+            const int i_size = psz && *psz ? atoi( psz ) : QUEUE_DEFAULT;
+
+            if( p_sys->i_nb_queues > 0
+             && p_sys->pp_queues[p_sys->i_nb_queues - 1] == NULL
+             && i_size > 0 )
+            {
+                const int i = p_sys->i_nb_queues - 1;
+                duplicate_queue_t *q = QueueNew( p_stream,
+                                                 p_sys->pp_streams[i], i,
+                                                 __MIN( i_size, QUEUE_MAX ) );
+                if( q != NULL )
+                {
+                    msg_Dbg( p_stream, " * asynchronous, %u blocks queued",
+                             q->i_size );
+                    p_sys->pp_queues[i] = q;
+                }
+            }
+        }
+        else if( !strcmp( p_cfg->psz_name, "overflow" ) )
+        {
+            /* overflow=block|drop-oldest|drop-non-key: what to do when the
+             * queue of the last (asynchronous) destination is full */
+            duplicate_queue_t *q = p_sys->i_nb_queues > 0
+                ? p_sys->pp_queues[p_sys->i_nb_queues - 1] : NULL;
+            const char *psz = p_cfg->psz_value ? p_cfg->psz_value : "";
+            size_t i;
+
+            for( i = 0; i < ARRAY_SIZE(ppsz_overflow); i++ )
+                if( !strcmp( psz, ppsz_overflow[i] ) )
+                    break;
+
+            if( q == NULL )
+                msg_Err( p_stream, " * ignore overflow `%s' "
+                         "(the destination is not asynchronous)", psz );
+            else if( i == ARRAY_SIZE(ppsz_overflow) )
+                msg_Err( p_stream, " * ignore unknown overflow `%s'", psz );
+            else
+            {
+                msg_Dbg( p_stream, " * overflow `%s'", psz );
+                q->i_overflow = i;
+            }
+        }
         else
         {
             msg_Err( p_stream, " * ignore unknown option `%s'", p_cfg->psz_name );
@@ -173,6 +317,24 @@ static int Open( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    for( int i = 0; i < p_sys->i_nb_queues; i++ )
+    {
+        duplicate_queue_t *q = p_sys->pp_queues[i];
+
+        if( q == NULL )
+            continue;
+        /* The branches would all call into the next stream from their own
+         * threads */
+        if( p_stream->p_next != NULL )
+            msg_Warn( p_stream, "destination %d kept synchronous, as "
+                      "duplicate is not the last stream output", i );
+        else if( vlc_clone( &q->thread, QueueThread, q,
+                            VLC_THREAD_PRIORITY_OUTPUT ) == 0 )
+            continue;
+        QueueDelete( q );
+        p_sys->pp_queues[i] = NULL;
+    }
+
     p_stream->pf_add    = Add;
     p_stream->pf_del    = Del;
     p_stream->pf_send   = Send;
@@ -194,12 +356,26 @@ static void Close( vlc_object_t * p_this )
     msg_Dbg( p_stream, "closing a duplication" );
     for( int i = 0; i < p_sys->i_nb_streams; i++ )
     {
+        duplicate_queue_t *q = p_sys->pp_queues[i];
+
+        if( q != NULL )
+        {
+            vlc_mutex_lock( &q->lock );
+            q->b_quit = true;
+            vlc_cond_signal( &q->wait );
+            vlc_mutex_unlock( &q->lock );
+            vlc_join( q->thread, NULL );
+
+            QueueReport( q );
+            QueueDelete( q );
+        }
         sout_StreamChainDelete(p_sys->pp_streams[i], p_sys->pp_last_streams[i]);
         free( p_sys->ppsz_select[i] );
     }
     free( p_sys->pp_streams );
     free( p_sys->pp_last_streams );
     free( p_sys->ppsz_select );
+    free( p_sys->pp_queues );
 
     free( p_sys );
 }
@@ -218,6 +394,13 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
         return NULL;
 
     TAB_INIT( id->i_nb_ids, id->pp_ids );
+    id->i_cat = p_fmt->i_cat;
+    id->pb_wait_key = calloc( p_sys->i_nb_streams, sizeof( bool ) );
+    if( !id->pb_wait_key )
+    {
+        free( id );
+        return NULL;
+    }
 
     msg_Dbg( p_stream, "duplicated a new stream codec=%4.4s (es=%d group=%d)",
              (char*)&p_fmt->i_codec, p_fmt->i_id, p_fmt->i_group );
@@ -229,8 +412,13 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
         if( ESSelected( p_fmt, p_sys->ppsz_select[i_stream] ) )
         {
             sout_stream_t *out = p_sys->pp_streams[i_stream];
+            duplicate_queue_t *q = p_sys->pp_queues[i_stream];
 
+            if( q != NULL )
+                vlc_mutex_lock( &q->branch_lock );
             id_new = (void*)sout_StreamIdAdd( out, p_fmt );
+            if( q != NULL )
+                vlc_mutex_unlock( &q->branch_lock );
             if( id_new )
             {
                 msg_Dbg( p_stream, "    - added for output %d", i_stream );
@@ -274,11 +462,22 @@ static void Del( sout_stream_t *p_stream, void *_id )
         if( id->pp_ids[i_stream] )
         {
             sout_stream_t *out = p_sys->pp_streams[i_stream];
+            duplicate_queue_t *q = p_sys->pp_queues[i_stream];
+
+            if( q != NULL )
+            {
+                /* Let the branch take what is queued for it first */
+                QueueDrain( q );
+                vlc_mutex_lock( &q->branch_lock );
+            }
             sout_StreamIdDel( out, id->pp_ids[i_stream] );
+            if( q != NULL )
+                vlc_mutex_unlock( &q->branch_lock );
         }
     }
 
     free( id->pp_ids );
+    free( id->pb_wait_key );
     free( id );
 }
 
@@ -307,7 +506,11 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
             {
                 block_t *p_dup = block_Duplicate( p_buffer );
 
-                if( p_dup )
+                if( !p_dup )
+                    continue;
+                if( p_sys->pp_queues[i_stream] )
+                    QueuePut( p_sys->pp_queues[i_stream], id, p_dup );
+                else
                     sout_StreamIdSend( p_dup_stream, id->pp_ids[i_stream], p_dup );
             }
         }
@@ -315,7 +518,10 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
         if( i_stream < p_sys->i_nb_streams && id->pp_ids[i_stream] )
         {
             p_dup_stream = p_sys->pp_streams[i_stream];
-            sout_StreamIdSend( p_dup_stream, id->pp_ids[i_stream], p_buffer );
+            if( p_sys->pp_queues[i_stream] )
+                QueuePut( p_sys->pp_queues[i_stream], id, p_buffer );
+            else
+                sout_StreamIdSend( p_dup_stream, id->pp_ids[i_stream], p_buffer );
         }
         else
         {
@@ -327,6 +533,212 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * Asynchronous branches
+ *****************************************************************************/
+static duplicate_queue_t *QueueNew( sout_stream_t *p_parent,
+                                    sout_stream_t *p_branch, int i_branch,
+                                    unsigned i_size )
+{
+    duplicate_queue_t *q = calloc( 1, sizeof( *q ) );
+    if( !q )
+        return NULL;
+
+    q->p_entries = calloc( i_size, sizeof( *q->p_entries ) );
+    if( !q->p_entries )
+    {
+        free( q );
+        return NULL;
+    }
+    q->p_parent = p_parent;
+    q->p_stream = p_branch;
+    q->i_branch = i_branch;
+    q->i_overflow = OVERFLOW_BLOCK;
+    q->i_size = i_size;
+    vlc_mutex_init( &q->branch_lock );
+    vlc_mutex_init( &q->lock );
+    vlc_cond_init( &q->wait );
+    vlc_cond_init( &q->wait_space );
+    q->i_last_report = vlc_tick_now();
+    return q;
+}
+
+static void QueueDelete( duplicate_queue_t *q )
+{
+    for( unsigned i = 0; i < q->i_count; i++ )
+        block_Release( q->p_entries[(q->i_first + i) % q->i_size].p_block );
+    free( q->p_entries );
+    free( q );
+}
+
+static void QueueReport( duplicate_queue_t *q )
+{
+    vlc_mutex_lock( &q->lock );
+    const uint64_t i_queued = q->i_queued;
+    const uint64_t i_depth_sum = q->i_depth_sum;
+    const unsigned i_depth_max = q->i_depth_max;
+    const uint64_t i_dropped = q->i_dropped;
+    const uint64_t i_waits = q->i_waits;
+    const vlc_tick_t i_wait_time = q->i_wait_time;
+    q->i_last_report = vlc_tick_now();
+    vlc_mutex_unlock( &q->lock );
+
+    if( i_queued == 0 )
+        return;
+
+    msg_Dbg( q->p_parent, "destination %d: %"PRIu64" blocks queued, "
+             "%.1f deep on average, %u at most (of %u), %"PRIu64" dropped, "
+             "%"PRIu64" waits for %"PRId64" ms (%s)", q->i_branch,
+             i_queued, (double)i_depth_sum / i_queued, i_depth_max,
+             q->i_size, i_dropped, i_waits, MS_FROM_VLC_TICK( i_wait_time ),
+             ppsz_overflow[q->i_overflow] );
+}
+
+static void *QueueThread( void *data )
+{
+    duplicate_queue_t *q = data;
+
+    vlc_mutex_lock( &q->lock );
+    for( ;; )
+    {
+        while( q->i_count == 0 && !q->b_quit )
+            vlc_cond_wait( &q->wait, &q->lock );
+        if( q->i_count == 0 )
+            break;
+
+        duplicate_entry_t entry = q->p_entries[q->i_first];
+        q->i_first = (q->i_first + 1) % q->i_size;
+        q->i_count--;
+        q->b_busy = true;
+        vlc_cond_broadcast( &q->wait_space );
+        vlc_mutex_unlock( &q->lock );
+
+        vlc_mutex_lock( &q->branch_lock );
+        sout_StreamIdSend( q->p_stream, entry.id->pp_ids[q->i_branch],
+                           entry.p_block );
+        vlc_mutex_unlock( &q->branch_lock );
+
+        if( vlc_tick_now() - q->i_last_report >= STATS_INTERVAL )
+            QueueReport( q );
+
+        vlc_mutex_lock( &q->lock );
+        q->b_busy = false;
+        vlc_cond_broadcast( &q->wait_space );
+    }
+    vlc_mutex_unlock( &q->lock );
+    return NULL;
+}
+
+/* Video frames that other frames do not depend upon, as far as the
+ * packetizer tells */
+static bool BlockIsDroppable( const sout_stream_id_sys_t *id,
+                              const block_t *p_block )
+{
+    return id->i_cat == VIDEO_ES
+        && (p_block->i_flags & BLOCK_FLAG_TYPE_MASK) != 0
+        && !(p_block->i_flags & BLOCK_FLAG_TYPE_I);
+}
+
+/* Drops the newest droppable block in the queue. Its stream then skips
+ * blocks up to its next key frame, unless one is queued already. */
+static bool QueueDropNonKey( duplicate_queue_t *q )
+{
+    for( unsigned i = q->i_count; i-- > 0; )
+    {
+        duplicate_entry_t *p_entry = &q->p_entries[(q->i_first + i) % q->i_size];
+        sout_stream_id_sys_t *id = p_entry->id;
+
+        if( !BlockIsDroppable( id, p_entry->p_block ) )
+            continue;
+
+        block_Release( p_entry->p_block );
+        q->i_dropped++;
+
+        bool b_wait_key = true;
+        for( unsigned j = i + 1; j < q->i_count; j++ )
+        {
+            duplicate_entry_t *p_next =
+                &q->p_entries[(q->i_first + j) % q->i_size];
+
+            *p_entry = *p_next;
+            p_entry = p_next;
+            if( p_next->id == id )
+                b_wait_key = false;
+        }
+        q->i_count--;
+        if( b_wait_key )
+            id->pb_wait_key[q->i_branch] = true;
+        return true;
+    }
+    return false;
+}
+
+static void QueuePut( duplicate_queue_t *q, sout_stream_id_sys_t *id,
+                      block_t *p_block )
+{
+    const bool b_droppable = BlockIsDroppable( id, p_block );
+
+    vlc_mutex_lock( &q->lock );
+    if( q->i_overflow == OVERFLOW_DROP_NON_KEY && b_droppable
+     && (id->pb_wait_key[q->i_branch] || q->i_count == q->i_size) )
+    {
+        id->pb_wait_key[q->i_branch] = true;
+        q->i_dropped++;
+        vlc_mutex_unlock( &q->lock );
+        block_Release( p_block );
+        return;
+    }
+
+    if( q->i_count == q->i_size )
+    {
+        switch( q->i_overflow )
+        {
+            case OVERFLOW_DROP_OLDEST:
+                block_Release( q->p_entries[q->i_first].p_block );
+                q->i_first = (q->i_first + 1) % q->i_size;
+                q->i_count--;
+                q->i_dropped++;
+                break;
+            case OVERFLOW_DROP_NON_KEY:
+                QueueDropNonKey( q );
+                break;
+        }
+    }
+
+    if( q->i_count == q->i_size )
+    {
+        /* Blocks the input, and thus the other branches, until this one
+         * takes a block */
+        const vlc_tick_t i_start = vlc_tick_now();
+
+        while( q->i_count == q->i_size )
+            vlc_cond_wait( &q->wait_space, &q->lock );
+        q->i_waits++;
+        q->i_wait_time += vlc_tick_now() - i_start;
+    }
+
+    if( !b_droppable )
+        id->pb_wait_key[q->i_branch] = false;
+    q->p_entries[(q->i_first + q->i_count) % q->i_size] =
+        (duplicate_entry_t){ .id = id, .p_block = p_block };
+    q->i_count++;
+    q->i_queued++;
+    q->i_depth_sum += q->i_count;
+    if( q->i_count > q->i_depth_max )
+        q->i_depth_max = q->i_count;
+    vlc_cond_signal( &q->wait );
+    vlc_mutex_unlock( &q->lock );
+}
+
+/* Waits until the branch has taken every queued block */
+static void QueueDrain( duplicate_queue_t *q )
+{
+    vlc_mutex_lock( &q->lock );
+    while( q->i_count > 0 || q->b_busy )
+        vlc_cond_wait( &q->wait_space, &q->lock );
+    vlc_mutex_unlock( &q->lock );
+}
+
 /*****************************************************************************
  * Divers
  *****************************************************************************/
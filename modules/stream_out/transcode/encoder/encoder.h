@@ -39,6 +39,7 @@ typedef struct
             unsigned int    i_height, i_maxheight;
             bool            b_hurry_up;
             vlc_rational_t  fps;
+            unsigned int    i_gop; /* fixed key frame interval, or 0 */
             struct
             {
                 unsigned int i_count;
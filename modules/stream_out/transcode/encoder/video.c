@@ -286,6 +286,48 @@ void transcode_encoder_video_configure( vlc_object_t *p_obj,
              (const char *)&p_enc_in->i_chroma);
 }
 
+/* How the encoders follow the key frame options set for gop= */
+static const struct
+{
+    char psz_name[10];
+    enum
+    {
+        GOP_FIXED,    /* keyint, min-keyint and scenecut */
+        GOP_INTERVAL, /* keyint only, may add key frames at scene changes */
+        GOP_INTRA,    /* only key frames */
+    } support;
+} gop_encoders[] = {
+    { "avcodec",  GOP_INTERVAL },
+    { "daala",    GOP_INTERVAL },
+    { "jpeg",     GOP_INTRA },
+    { "png",      GOP_INTRA },
+    { "rtpvideo", GOP_INTRA },
+    { "x262",     GOP_FIXED },
+    { "x264",     GOP_FIXED },
+    { "x26410b",  GOP_FIXED },
+};
+
+static int CheckGOP( encoder_t *p_encoder, const module_t *p_module,
+                     unsigned i_gop )
+{
+    const char *psz_name = module_get_object( p_module );
+
+    for( size_t i = 0; i < ARRAY_SIZE(gop_encoders); i++ )
+    {
+        if( strcmp( gop_encoders[i].psz_name, psz_name ) )
+            continue;
+        if( gop_encoders[i].support == GOP_INTERVAL )
+            msg_Warn( p_encoder, "encoder %s may add key frames to the "
+                      "interval of %u pictures, at scene changes: key frames "
+                      "may not be aligned", psz_name, i_gop );
+        return VLC_SUCCESS;
+    }
+
+    msg_Err( p_encoder, "encoder %s cannot be given a fixed key frame "
+             "interval, remove gop=%u or use x264", psz_name, i_gop );
+    return VLC_EGENERIC;
+}
+
 int transcode_encoder_video_test( encoder_t *p_encoder,
                                   const transcode_encoder_config_t *p_cfg,
                                   const es_format_t *p_dec_fmtin,
@@ -333,6 +375,10 @@ int transcode_encoder_video_test( encoder_t *p_encoder,
         /* Close the encoder.
          * We'll open it only when we have the first frame. */
         module_unneed( p_encoder, p_module );
+
+        if( p_cfg->video.i_gop > 0 &&
+            CheckGOP( p_encoder, p_module, p_cfg->video.i_gop ) )
+            p_module = NULL;
     }
 
     if( likely(!p_encoder->fmt_in.video.i_chroma) ) /* always missing, and required by filter chain */
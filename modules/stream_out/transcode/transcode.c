@@ -35,6 +35,7 @@
 #include <vlc_plugin.h>
 #include <vlc_sout.h>
 #include <vlc_spu.h>
+#include <vlc_charset.h>
 
 #include "transcode.h"
 
@@ -79,6 +80,19 @@
 #define VFILTER_LONGTEXT N_( \
     "Video filters will be applied to the video streams (after overlays " \
     "are applied). You can enter a colon-separated list of filters." )
+#define RENDITION_TEXT N_("Video rendition")
+#define RENDITION_LONGTEXT N_( \
+    "Encodes the video once more from the same decoding, in the form " \
+    "{width=,height=,maxwidth=,maxheight=,scale=,vb=,venc=,vcodec=,id=}. " \
+    "Unset values are those of the video transcoding, and id is the ES id " \
+    "of the output. Can be given several times. At most one rendition can " \
+    "go without id, and it then keeps the ES id of the input." )
+#define GOP_TEXT N_("Key frame interval")
+#define GOP_LONGTEXT N_( \
+    "Forces a key frame every this many pictures, and no other, so that " \
+    "all the renditions can be segmented at the same points (0 to let " \
+    "the encoder decide). Only the x264 encoder follows it exactly, and " \
+    "the encoders without a key frame interval option are refused." )
 
 #define AENC_TEXT N_("Audio encoder")
 #define AENC_LONGTEXT N_( \
@@ -177,6 +191,10 @@ vlc_module_begin ()
                  MAXHEIGHT_LONGTEXT, true )
     add_module_list(SOUT_CFG_PREFIX "vfilter", "video filter", NULL,
                     VFILTER_TEXT, VFILTER_LONGTEXT)
+    add_string( SOUT_CFG_PREFIX "rendition", NULL, RENDITION_TEXT,
+                RENDITION_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "gop", 0, GOP_TEXT, GOP_LONGTEXT, true )
+        change_integer_range( 0, 65535 )
 
     set_section( N_("Audio"), NULL )
     add_module(SOUT_CFG_PREFIX "aenc", "encoder", NULL,
@@ -224,7 +242,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "high-priority", "maxwidth", "maxheight", "pool-size",
-    NULL
+    "rendition", "gop", NULL
 };
 
 /*****************************************************************************
@@ -332,6 +350,102 @@ static void SetVideoEncoderConfig( sout_stream_t *p_stream, transcode_encoder_co
         p_cfg->video.threads.i_priority = VLC_THREAD_PRIORITY_VIDEO;
 }
 
+/* Fixed key frame interval, unless the encoder options already set it.
+ * Only some encoders have these options, see transcode_encoder_video_test */
+static void SetGOPConfig( transcode_encoder_config_t *p_cfg, unsigned i_gop )
+{
+    char psz_gop[11];
+    snprintf( psz_gop, sizeof(psz_gop), "%u", i_gop );
+    p_cfg->video.i_gop = i_gop;
+
+    const char *const ppsz_opts[][2] = {
+        { "keyint", psz_gop }, { "min-keyint", psz_gop }, { "scenecut", "-1" },
+    };
+    for( size_t i = 0; i < ARRAY_SIZE(ppsz_opts); i++ )
+    {
+        config_chain_t *p_opt;
+        for( p_opt = p_cfg->p_config_chain; p_opt; p_opt = p_opt->p_next )
+            if( !strcmp( p_opt->psz_name, ppsz_opts[i][0] ) )
+                break;
+        if( p_opt )
+            continue;
+
+        p_opt = malloc( sizeof(*p_opt) );
+        if( unlikely(!p_opt) )
+            return;
+        p_opt->psz_name = strdup( ppsz_opts[i][0] );
+        p_opt->psz_value = strdup( ppsz_opts[i][1] );
+        p_opt->p_next = p_cfg->p_config_chain;
+        p_cfg->p_config_chain = p_opt;
+    }
+}
+
+static void SetRenditionConfig( sout_stream_t *p_stream,
+                                const transcode_encoder_config_t *p_vcfg,
+                                transcode_rendition_config_t *p_rend,
+                                const char *psz_opts )
+{
+    transcode_encoder_config_t *p_cfg = &p_rend->enc_cfg;
+
+    *p_cfg = *p_vcfg;
+    p_cfg->psz_name = p_vcfg->psz_name ? strdup( p_vcfg->psz_name ) : NULL;
+    p_cfg->psz_lang = p_vcfg->psz_lang ? strdup( p_vcfg->psz_lang ) : NULL;
+    p_cfg->p_config_chain = config_ChainDuplicate( p_vcfg->p_config_chain );
+    p_rend->i_id = 0;
+
+    config_chain_t *p_opts = NULL;
+    config_ChainParseOptions( &p_opts, psz_opts );
+
+    for( const config_chain_t *p_opt = p_opts; p_opt; p_opt = p_opt->p_next )
+    {
+        const char *psz_name = p_opt->psz_name;
+        const char *psz_value = p_opt->psz_value ? p_opt->psz_value : "";
+
+        if( !strcmp( psz_name, "width" ) )
+            p_cfg->video.i_width = atoi( psz_value );
+        else if( !strcmp( psz_name, "height" ) )
+            p_cfg->video.i_height = atoi( psz_value );
+        else if( !strcmp( psz_name, "maxwidth" ) )
+            p_cfg->video.i_maxwidth = atoi( psz_value );
+        else if( !strcmp( psz_name, "maxheight" ) )
+            p_cfg->video.i_maxheight = atoi( psz_value );
+        else if( !strcmp( psz_name, "scale" ) )
+            p_cfg->video.f_scale = us_atof( psz_value );
+        else if( !strcmp( psz_name, "vb" ) )
+        {
+            p_cfg->video.i_bitrate = atoi( psz_value );
+            if( p_cfg->video.i_bitrate < 16000 )
+                p_cfg->video.i_bitrate *= 1000;
+        }
+        else if( !strcmp( psz_name, "venc" ) )
+        {
+            free( p_cfg->psz_name );
+            config_ChainDestroy( p_cfg->p_config_chain );
+            p_cfg->psz_name = NULL;
+            p_cfg->p_config_chain = NULL;
+            free( config_ChainCreate( &p_cfg->psz_name,
+                                      &p_cfg->p_config_chain, psz_value ) );
+        }
+        else if( !strcmp( psz_name, "vcodec" ) )
+        {
+            char fcc[5] = "    \0";
+            memcpy( fcc, psz_value, __MIN( strlen( psz_value ), 4 ) );
+            p_cfg->i_codec = vlc_fourcc_GetCodecFromString( VIDEO_ES, fcc );
+        }
+        else if( !strcmp( psz_name, "id" ) )
+            p_rend->i_id = atoi( psz_value );
+        else
+            msg_Warn( p_stream, "unknown rendition option %s", psz_name );
+    }
+    config_ChainDestroy( p_opts );
+
+    msg_Dbg( p_stream, "rendition video=%4.4s %dx%d max %dx%d scaling: %f "
+             "%dkb/s", (char *)&p_cfg->i_codec,
+             p_cfg->video.i_width, p_cfg->video.i_height,
+             p_cfg->video.i_maxwidth, p_cfg->video.i_maxheight,
+             p_cfg->video.f_scale, p_cfg->video.i_bitrate / 1000 );
+}
+
 static void SetSPUEncoderConfig( sout_stream_t *p_stream, transcode_encoder_config_t *p_cfg )
 {
     char *psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "senc" );
@@ -378,6 +492,38 @@ static int Control( sout_stream_t *p_stream, int i_query, va_list args )
     return VLC_EGENERIC;
 }
 
+/* The renditions are output next to the other ES of the input, whose ids are
+ * not known here: only the one without id can take the id of the input ES */
+static bool CheckRenditionIds( sout_stream_t *p_stream )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    bool b_default = false;
+
+    for( int i = 0; i < p_sys->i_renditions; i++ )
+    {
+        int i_id = p_sys->p_renditions[i].i_id;
+
+        if( i_id == 0 )
+        {
+            if( b_default )
+            {
+                msg_Err( p_stream, "renditions without id: all but one "
+                         "rendition need an id" );
+                return false;
+            }
+            b_default = true;
+            continue;
+        }
+        for( int j = 0; j < i; j++ )
+            if( p_sys->p_renditions[j].i_id == i_id )
+            {
+                msg_Err( p_stream, "renditions with the same id %d", i_id );
+                return false;
+            }
+    }
+    return true;
+}
+
 /*****************************************************************************
  * Open:
  *****************************************************************************/
@@ -439,6 +585,31 @@ static int Open( vlc_object_t *p_this )
         free( psz_string );
     }
 
+    /* Video renditions */
+    for( const config_chain_t *p_opt = p_stream->p_cfg; p_opt; p_opt = p_opt->p_next )
+    {
+        if( strcmp( p_opt->psz_name, "rendition" ) || !p_opt->psz_value )
+            continue;
+
+        transcode_rendition_config_t *p_renditions =
+            realloc( p_sys->p_renditions,
+                     (p_sys->i_renditions + 1) * sizeof(*p_renditions) );
+        if( unlikely(!p_renditions) )
+            break;
+        p_sys->p_renditions = p_renditions;
+        SetRenditionConfig( p_stream, &p_sys->venc_cfg,
+                            &p_renditions[p_sys->i_renditions++],
+                            p_opt->psz_value );
+    }
+
+    const unsigned i_gop = var_GetInteger( p_stream, SOUT_CFG_PREFIX "gop" );
+    if( i_gop > 0 )
+    {
+        SetGOPConfig( &p_sys->venc_cfg, i_gop );
+        for( int i = 0; i < p_sys->i_renditions; i++ )
+            SetGOPConfig( &p_sys->p_renditions[i].enc_cfg, i_gop );
+    }
+
     /* Subpictures SOURCES parameters (not releated to subtitles stream) */
     psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "sfilter" );
     if( psz_string && *psz_string )
@@ -463,11 +634,34 @@ static int Open( vlc_object_t *p_this )
     p_sys->vfilters_cfg.video.b_reorient = p_sys->b_soverlay ||
                                            p_sys->vfilters_cfg.video.psz_spu_sources;
 
+    /* The renditions deinterlace before, and don't blend subtitles */
+    sout_filters_config_init( &p_sys->rfilters_cfg );
+    if( p_sys->i_renditions > 0 )
+    {
+        if( p_sys->vfilters_cfg.psz_filters )
+            p_sys->rfilters_cfg.psz_filters =
+                strdup( p_sys->vfilters_cfg.psz_filters );
+        if( p_sys->vfilters_cfg.video.psz_spu_sources )
+            p_sys->rfilters_cfg.video.psz_spu_sources =
+                strdup( p_sys->vfilters_cfg.video.psz_spu_sources );
+        p_sys->rfilters_cfg.video.b_reorient =
+            p_sys->vfilters_cfg.video.b_reorient;
+        if( p_sys->b_soverlay )
+            msg_Warn( p_stream, "subtitles are not overlaid on renditions" );
+    }
+
+    p_stream->p_sys     = p_sys;
+
+    if( !CheckRenditionIds( p_stream ) )
+    {
+        Close( p_this );
+        return VLC_EGENERIC;
+    }
+
     p_stream->pf_add    = Add;
     p_stream->pf_del    = Del;
     p_stream->pf_send   = Send;
     p_stream->pf_control = Control;
-    p_stream->p_sys     = p_sys;
 
     return VLC_SUCCESS;
 }
@@ -483,6 +677,11 @@ static void Close( vlc_object_t * p_this )
     transcode_encoder_config_clean( &p_sys->venc_cfg );
     sout_filters_config_clean( &p_sys->vfilters_cfg );
 
+    for( int i = 0; i < p_sys->i_renditions; i++ )
+        transcode_encoder_config_clean( &p_sys->p_renditions[i].enc_cfg );
+    free( p_sys->p_renditions );
+    sout_filters_config_clean( &p_sys->rfilters_cfg );
+
     transcode_encoder_config_clean( &p_sys->aenc_cfg );
     sout_filters_config_clean( &p_sys->afilters_cfg );
 
@@ -635,9 +834,16 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
             p_sys->id_master_sync = id;
         vlc_mutex_unlock( &p_sys->lock );
     }
-    else if( p_fmt->i_cat == VIDEO_ES && id->p_enccfg->i_codec )
+    else if( p_fmt->i_cat == VIDEO_ES &&
+             ( id->p_enccfg->i_codec || p_sys->i_renditions > 0 ) )
     {
-        success = !transcode_video_init(p_stream, p_fmt, id);
+        if( p_sys->i_renditions > 0 )
+            success = !transcode_video_renditions_init( p_stream, p_fmt, id,
+                                                        p_sys->p_renditions,
+                                                        p_sys->i_renditions,
+                                                        &p_sys->rfilters_cfg );
+        else
+            success = !transcode_video_init(p_stream, p_fmt, id);
         vlc_mutex_lock( &p_sys->lock );
         if( success && !p_sys->id_video )
             p_sys->id_video = id;
@@ -693,7 +899,7 @@ static void Del( sout_stream_t *p_stream, void *_id )
             if( id == p_sys->id_video )
                 p_sys->id_video = NULL;
             vlc_mutex_unlock( &p_sys->lock );
-            transcode_video_clean( id );
+            transcode_video_clean( p_stream, id );
             break;
         case SPU_ES:
             decoder_Destroy( id->p_decoder );
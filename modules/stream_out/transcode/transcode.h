@@ -41,6 +41,12 @@ void sout_filters_config_clean( sout_filters_config_t *p_cfg )
 
 typedef struct sout_stream_id_sys_t sout_stream_id_sys_t;
 
+typedef struct
+{
+    transcode_encoder_config_t enc_cfg;
+    int i_id; /**< ES id of the output, 0 for the default */
+} transcode_rendition_config_t;
+
 typedef struct
 {
     bool                  b_soverlay;
@@ -53,6 +59,12 @@ typedef struct
     transcode_encoder_config_t venc_cfg;
     sout_filters_config_t vfilters_cfg;
 
+    /* Video renditions, sharing the decoder and the vfilters_cfg
+     * deinterlacer, with their own scaling and encoding */
+    int                   i_renditions;
+    transcode_rendition_config_t *p_renditions;
+    sout_filters_config_t rfilters_cfg;
+
     /* SPU */
     transcode_encoder_config_t senc_cfg;
 
@@ -151,6 +163,12 @@ struct sout_stream_id_sys_t
     /* Sync */
     date_t          next_input_pts; /**< Incoming calculated PTS */
     vlc_tick_t      i_drift; /** how much buffer is ahead of calculated PTS */
+
+    /* Video renditions: the ids encoding the pictures of this one, or the
+     * encoding thread of a rendition */
+    int                    i_renditions;
+    sout_stream_id_sys_t **pp_renditions;
+    struct transcode_rendition *p_rendition;
 };
 
 struct decoder_owner
@@ -207,7 +225,7 @@ int  transcode_audio_init   ( sout_stream_t *, const es_format_t *,
 
 /* VIDEO */
 
-void transcode_video_clean  ( sout_stream_id_sys_t * );
+void transcode_video_clean  ( sout_stream_t *, sout_stream_id_sys_t * );
 int  transcode_video_process( sout_stream_t *, sout_stream_id_sys_t *,
                                      block_t *, block_t ** );
 int transcode_video_get_output_dimensions( sout_stream_id_sys_t *,
@@ -215,3 +233,7 @@ int transcode_video_get_output_dimensions( sout_stream_id_sys_t *,
 void transcode_video_push_spu( sout_stream_t *, sout_stream_id_sys_t *, subpicture_t * );
 int  transcode_video_init    ( sout_stream_t *, const es_format_t *,
                                sout_stream_id_sys_t *);
+int  transcode_video_renditions_init( sout_stream_t *, const es_format_t *,
+                                      sout_stream_id_sys_t *,
+                                      const transcode_rendition_config_t *, int,
+                                      const sout_filters_config_t * );
@@ -102,9 +102,11 @@ static int video_update_format_decoder( decoder_t *p_dec, vlc_video_context *vct
 
     vlc_mutex_lock( &id->fifo.lock );
 
-    const es_format_t *p_enc_in = transcode_encoder_format_in( id->encoder );
+    /* Renditions check their own conversions when they configure */
+    const es_format_t *p_enc_in = id->encoder ?
+        transcode_encoder_format_in( id->encoder ) : NULL;
 
-    if( p_enc_in->i_codec == p_dec->fmt_out.i_codec ||
+    if( ( p_enc_in && p_enc_in->i_codec == p_dec->fmt_out.i_codec ) ||
         video_format_IsSimilar( &id->decoder_out.video, &p_dec->fmt_out.video ) )
     {
         vlc_mutex_unlock( &id->fifo.lock );
@@ -120,6 +122,9 @@ static int video_update_format_decoder( decoder_t *p_dec, vlc_video_context *vct
 
     vlc_mutex_unlock( &id->fifo.lock );
 
+    if( p_enc_in == NULL )
+        return 0;
+
     msg_Dbg( p_obj, "Checking if filter chain %4.4s -> %4.4s is possible",
                  (char *)&p_dec->fmt_out.i_codec, (char*)&p_enc_in->i_codec );
     test_chain = filter_chain_NewVideo( p_obj, false, NULL );
@@ -168,13 +173,9 @@ static picture_t *transcode_dequeue_all_pics( sout_stream_id_sys_t *id )
     return p_pics;
 }
 
-int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
-                          sout_stream_id_sys_t *id )
+static int transcode_video_decoder_open( sout_stream_t *p_stream,
+                                        sout_stream_id_sys_t *id )
 {
-    msg_Dbg( p_stream,
-             "creating video transcoding from fcc=`%4.4s' to fcc=`%4.4s'",
-             (char*)&p_fmt->i_codec, (char*)&id->p_enccfg->i_codec );
-
     id->fifo.pic.first = NULL;
     id->fifo.pic.last = &id->fifo.pic.first;
     id->b_transcode = true;
@@ -213,7 +214,19 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
         es_format_Copy( &id->decoder_out, &id->p_decoder->fmt_out );
         id->decoder_vctx_out = NULL /* TODO id->p_decoder->vctx_out*/;
     }
+    return VLC_SUCCESS;
+}
+
+static void transcode_video_decoder_close( sout_stream_id_sys_t *id )
+{
+    module_unneed( id->p_decoder, id->p_decoder->p_module );
+    id->p_decoder->p_module = NULL;
+    es_format_Clean( &id->decoder_out );
+}
 
+static int transcode_video_encoder_init( sout_stream_t *p_stream,
+                                         sout_stream_id_sys_t *id )
+{
     /*
      * Open encoder.
      * Because some info about the decoded input will only be available
@@ -228,9 +241,6 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
     struct encoder_owner *p_enc_owner = (struct encoder_owner*)sout_EncoderCreate(p_stream, sizeof(struct encoder_owner));
     if ( unlikely(p_enc_owner == NULL))
     {
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
-        es_format_Clean( &id->decoder_out );
         es_format_Clean( &encoder_tested_fmt_in );
         return VLC_EGENERIC;
     }
@@ -243,9 +253,6 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
                                 id->p_decoder->fmt_out.i_codec,
                                 &encoder_tested_fmt_in ) )
     {
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
-        es_format_Clean( &id->decoder_out );
         es_format_Clean( &encoder_tested_fmt_in );
         return VLC_EGENERIC;
     }
@@ -253,20 +260,14 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
     p_enc_owner = (struct encoder_owner *)sout_EncoderCreate(p_stream, sizeof(struct encoder_owner));
     if ( unlikely(p_enc_owner == NULL))
     {
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
         es_format_Clean( &encoder_tested_fmt_in );
-        es_format_Clean( &id->decoder_out );
         return VLC_EGENERIC;
     }
 
     id->encoder = transcode_encoder_new( &p_enc_owner->enc, &encoder_tested_fmt_in );
     if( !id->encoder )
     {
-        module_unneed( id->p_decoder, id->p_decoder->p_module );
-        id->p_decoder->p_module = NULL;
         es_format_Clean( &encoder_tested_fmt_in );
-        es_format_Clean( &id->decoder_out );
         return VLC_EGENERIC;
     }
     p_enc_owner->id = id;
@@ -280,9 +281,29 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
     return VLC_SUCCESS;
 }
 
+int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
+                          sout_stream_id_sys_t *id )
+{
+    msg_Dbg( p_stream,
+             "creating video transcoding from fcc=`%4.4s' to fcc=`%4.4s'",
+             (char*)&p_fmt->i_codec, (char*)&id->p_enccfg->i_codec );
+
+    if( transcode_video_decoder_open( p_stream, id ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
+
+    if( transcode_video_encoder_init( p_stream, id ) != VLC_SUCCESS )
+    {
+        transcode_video_decoder_close( id );
+        return VLC_EGENERIC;
+    }
+
+    return VLC_SUCCESS;
+}
+
 static const struct filter_video_callbacks transcode_filter_video_cbs =
 {
     transcode_video_filter_buffer_new, transcode_video_filter_hold_device,
+    NULL,
 };
 
 /* Take care of the scaling and chroma conversions. */
@@ -421,11 +442,21 @@ static int transcode_video_filters_init( sout_stream_t *p_stream,
     return VLC_SUCCESS;
 }
 
-void transcode_video_clean( sout_stream_id_sys_t *id )
+static void transcode_rendition_delete( sout_stream_t *, sout_stream_id_sys_t * );
+
+void transcode_video_clean( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
 {
+    /* Stop renditions */
+    for( int i = 0; i < id->i_renditions; i++ )
+        transcode_rendition_delete( p_stream, id->pp_renditions[i] );
+    free( id->pp_renditions );
+
     /* Close encoder */
-    transcode_encoder_close( id->encoder );
-    transcode_encoder_delete( id->encoder );
+    if( id->encoder )
+    {
+        transcode_encoder_close( id->encoder );
+        transcode_encoder_delete( id->encoder );
+    }
 
     es_format_Clean( &id->decoder_out );
 
@@ -525,11 +556,618 @@ static void tag_last_block_with_flag( block_t **out, int i_flag )
     }
 }
 
+static int transcode_video_configure( sout_stream_t *p_stream,
+                                      sout_stream_id_sys_t *id,
+                                      picture_t *p_pic )
+{
+    if( !transcode_encoder_opened(id->encoder) ) /* Configure Encoder input/output */
+    {
+        /* A rendition does not run in the thread of the decoder */
+        const video_format_t *p_dec_out = id->p_rendition ?
+            &p_pic->format : &id->p_decoder->fmt_out.video;
+
+        assert( !id->p_f_chain && !id->p_uf_chain );
+        transcode_encoder_video_configure( VLC_OBJECT(p_stream),
+                                           p_dec_out,
+                                           id->p_enccfg,
+                                           &p_pic->format,
+                                           picture_GetVideoContext(p_pic),
+                                           id->encoder );
+        /* will be opened below */
+    }
+    else /* picture format has changed */
+    {
+        msg_Info( p_stream, "aspect-ratio changed, reiniting. %i -> %i : %i -> %i.",
+                    id->decoder_out.video.i_sar_num, p_pic->format.i_sar_num,
+                    id->decoder_out.video.i_sar_den, p_pic->format.i_sar_den
+                );
+        /* Close filters, encoder format input can't change */
+        transcode_remove_filters( &id->p_f_chain );
+        transcode_remove_filters( &id->p_conv_nonstatic );
+        transcode_remove_filters( &id->p_conv_static );
+        transcode_remove_filters( &id->p_uf_chain );
+        transcode_remove_filters( &id->p_final_conv_static );
+        if( id->p_spu_blender )
+            filter_DeleteBlend( id->p_spu_blender );
+        id->p_spu_blender = NULL;
+
+        video_format_Clean( &id->decoder_out.video );
+    }
+
+    video_format_Copy( &id->decoder_out.video, &p_pic->format );
+    transcode_video_framerate_apply( &p_pic->format, &id->decoder_out.video );
+    transcode_video_sar_apply( &p_pic->format, &id->decoder_out.video );
+    id->decoder_vctx_out = picture_GetVideoContext(p_pic);
+
+    if( !transcode_video_filters_configured( id ) )
+    {
+        /* The frame rate of renditions is converted before them */
+        if( transcode_video_filters_init( p_stream,
+                                          id->p_filterscfg,
+                                          (id->p_enccfg->video.fps.num > 0) &&
+                                          !id->p_rendition,
+                                          &id->decoder_out,
+                                          id->decoder_vctx_out,
+                                          transcode_encoder_format_in( id->encoder ),
+                                          id ) != VLC_SUCCESS )
+            return VLC_EGENERIC;
+    }
+
+    /* Store the current encoder input chroma to detect whether we need
+     * a converter in p_final_conv_static. The encoder will override it
+     * if it needs any different format or chroma. */
+    es_format_t filter_fmt_out;
+    es_format_Copy( &filter_fmt_out, transcode_encoder_format_in( id->encoder ) );
+    bool is_encoder_open = transcode_encoder_opened( id->encoder );
+
+    /* Start missing encoder */
+    if( !is_encoder_open &&
+        transcode_encoder_open( id->encoder, id->p_enccfg ) != VLC_SUCCESS )
+    {
+        msg_Err( p_stream, "cannot find video encoder (module:%s fourcc:%4.4s). "
+                           "Take a look few lines earlier to see possible reason.",
+                           id->p_enccfg->psz_name ? id->p_enccfg->psz_name : "any",
+                           (char *)&id->p_enccfg->i_codec );
+        es_format_Clean(&filter_fmt_out);
+        return VLC_EGENERIC;
+    }
+
+    /* The fmt_in may have been overriden by the encoder. */
+    const es_format_t *encoder_fmt_in = transcode_encoder_format_in( id->encoder );
+
+    /* In case the encoder wasn't open yet, check if we need to add
+     * a converter between last user filter and encoder. */
+    if( !is_encoder_open &&
+        filter_fmt_out.i_codec != encoder_fmt_in->i_codec )
+    {
+        if ( !id->p_final_conv_static )
+            id->p_final_conv_static =
+                filter_chain_NewVideo( p_stream, false, NULL );
+        filter_chain_Reset( id->p_final_conv_static,
+                            &filter_fmt_out,
+                            //encoder_vctx_in,
+                            NULL,
+                            encoder_fmt_in );
+        filter_chain_AppendConverter( id->p_final_conv_static, NULL );
+    }
+    es_format_Clean(&filter_fmt_out);
+
+    msg_Dbg( p_stream, "destination (after video filters) %ux%u",
+                       transcode_encoder_format_in( id->encoder )->video.i_width,
+                       transcode_encoder_format_in( id->encoder )->video.i_height );
+    return VLC_SUCCESS;
+}
+
+static void transcode_video_encode( sout_stream_id_sys_t *id, picture_t *p_pic,
+                                    block_t **out )
+{
+    /* Run the filter and output chains; first with the picture,
+     * and then with NULL as many times as we need until they
+     * stop outputting frames.
+     */
+    for ( picture_t *p_in = p_pic; ; p_in = NULL /* drain second time */ )
+    {
+        /* Run filter chain */
+        filter_chain_t * primary_chains[] = { id->p_f_chain,
+                                              id->p_conv_nonstatic,
+                                              id->p_conv_static };
+        for( size_t i=0; p_in && i<ARRAY_SIZE(primary_chains); i++ )
+        {
+            if( !primary_chains[i] )
+                continue;
+            p_in = filter_chain_VideoFilter( primary_chains[i], p_in );
+        }
+
+        if( !p_in )
+            break;
+
+        for ( ;; p_in = NULL /* drain second time */ )
+        {
+            /* Run user specified filter chain */
+            filter_chain_t * secondary_chains[] = { id->p_uf_chain,
+                                                    id->p_final_conv_static };
+            for( size_t i=0; p_in && i<ARRAY_SIZE(secondary_chains); i++ )
+            {
+                if( !secondary_chains[i] )
+                    continue;
+                p_in = filter_chain_VideoFilter( secondary_chains[i], p_in );
+            }
+
+            if( !p_in )
+                break;
+
+            /* Blend subpictures */
+            p_in = RenderSubpictures( id, p_in );
+
+            if( p_in )
+            {
+                block_t *p_encoded = transcode_encoder_encode( id->encoder, p_in );
+                if( p_encoded )
+                    block_ChainAppend( out, p_encoded );
+                picture_Release( p_in );
+            }
+        }
+    }
+}
+
+static int transcode_video_end_of_sequence( sout_stream_t *p_stream,
+                                            sout_stream_id_sys_t *id,
+                                            block_t **out )
+{
+    msg_Info( p_stream, "Drain/restart on EOS" );
+    if( transcode_encoder_drain( id->encoder, out ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
+    transcode_encoder_close( id->encoder );
+    /* Close filters */
+    transcode_remove_filters( &id->p_f_chain );
+    transcode_remove_filters( &id->p_conv_nonstatic );
+    transcode_remove_filters( &id->p_conv_static );
+    transcode_remove_filters( &id->p_uf_chain );
+    transcode_remove_filters( &id->p_final_conv_static );
+    tag_last_block_with_flag( out, BLOCK_FLAG_END_OF_SEQUENCE );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Renditions: the pictures of one decoder, deinterlaced and converted to the
+ * output frame rate once, are scaled and encoded by a thread per rendition.
+ * Each rendition is a video ES of its own downstream.
+ *****************************************************************************/
+struct transcode_rendition
+{
+    sout_stream_t *p_stream;
+    int            i_es_id;
+    vlc_thread_t   thread;
+
+    vlc_mutex_t    lock;
+    vlc_cond_t     wait;      /**< pictures to encode, or quit */
+    vlc_cond_t     wait_done; /**< a picture was taken or encoded */
+    picture_t     *p_first;
+    picture_t    **pp_last;
+    unsigned       i_count;
+    unsigned       i_max;
+    bool           b_busy;
+    bool           b_ready;   /**< the encoder has been opened */
+    bool           b_error;
+    bool           b_quit;
+    block_t       *p_out;
+};
+
+static void *RenditionThread( void *data )
+{
+    sout_stream_id_sys_t *id = data;
+    struct transcode_rendition *p_rend = id->p_rendition;
+    sout_stream_t *p_stream = p_rend->p_stream;
+
+    vlc_mutex_lock( &p_rend->lock );
+    for( ;; )
+    {
+        while( p_rend->p_first == NULL && !p_rend->b_quit )
+            vlc_cond_wait( &p_rend->wait, &p_rend->lock );
+        if( p_rend->p_first == NULL )
+            break;
+
+        picture_t *p_pic = p_rend->p_first;
+        p_rend->p_first = p_pic->p_next;
+        if( p_rend->p_first == NULL )
+            p_rend->pp_last = &p_rend->p_first;
+        p_pic->p_next = NULL;
+        p_rend->i_count--;
+        p_rend->b_busy = true;
+        bool b_error = p_rend->b_error;
+        vlc_cond_signal( &p_rend->wait_done );
+        vlc_mutex_unlock( &p_rend->lock );
+
+        block_t *p_out = NULL;
+
+        if( !b_error &&
+            ( !transcode_encoder_opened( id->encoder ) ||
+              !video_format_IsSimilar( &id->decoder_out.video, &p_pic->format ) ) &&
+            transcode_video_configure( p_stream, id, p_pic ) != VLC_SUCCESS )
+            b_error = true;
+
+        if( b_error )
+            picture_Release( p_pic );
+        else
+        {
+            transcode_video_encode( id, p_pic, &p_out );
+            if( id->p_enccfg->video.threads.i_count >= 1 )
+                block_ChainAppend( &p_out,
+                                   transcode_encoder_get_output_async( id->encoder ) );
+        }
+
+        vlc_mutex_lock( &p_rend->lock );
+        block_ChainAppend( &p_rend->p_out, p_out );
+        p_rend->b_error = b_error;
+        p_rend->b_ready = !b_error;
+        p_rend->b_busy = false;
+        vlc_cond_signal( &p_rend->wait_done );
+    }
+    vlc_mutex_unlock( &p_rend->lock );
+
+    return NULL;
+}
+
+static void transcode_rendition_put( sout_stream_id_sys_t *id, picture_t *p_pic )
+{
+    struct transcode_rendition *p_rend = id->p_rendition;
+
+    vlc_mutex_lock( &p_rend->lock );
+    while( p_rend->i_count >= p_rend->i_max && !p_rend->b_error )
+        vlc_cond_wait( &p_rend->wait_done, &p_rend->lock );
+    if( p_rend->b_error )
+    {
+        vlc_mutex_unlock( &p_rend->lock );
+        picture_Release( p_pic );
+        return;
+    }
+    *p_rend->pp_last = p_pic;
+    p_rend->pp_last = &p_pic->p_next;
+    p_rend->i_count++;
+    vlc_cond_signal( &p_rend->wait );
+    vlc_mutex_unlock( &p_rend->lock );
+}
+
+/* Takes the output of a rendition, once it has encoded all its pictures if
+ * b_wait is set. Returns whether its encoder can be used. */
+static bool transcode_rendition_dequeue( sout_stream_id_sys_t *id, bool b_wait,
+                                         block_t **out )
+{
+    struct transcode_rendition *p_rend = id->p_rendition;
+
+    vlc_mutex_lock( &p_rend->lock );
+    while( b_wait && ( p_rend->p_first || p_rend->b_busy ) )
+        vlc_cond_wait( &p_rend->wait_done, &p_rend->lock );
+    block_ChainAppend( out, p_rend->p_out );
+    p_rend->p_out = NULL;
+    bool b_ready = p_rend->b_ready && !p_rend->b_error;
+    vlc_mutex_unlock( &p_rend->lock );
+
+    return b_ready;
+}
+
+static int transcode_rendition_send( sout_stream_t *p_stream,
+                                     sout_stream_id_sys_t *p_parent,
+                                     sout_stream_id_sys_t *id,
+                                     bool b_ready, block_t *p_out )
+{
+    struct transcode_rendition *p_rend = id->p_rendition;
+
+    if( b_ready && !id->downstream_id )
+    {
+        es_format_t fmt;
+        es_format_Init( &fmt, VIDEO_ES, 0 );
+        es_format_Copy( &fmt, &p_parent->p_decoder->fmt_in );
+        fmt.i_id = p_rend->i_es_id;
+
+        id->downstream_id =
+            id->pf_transcode_downstream_add( p_stream, &fmt,
+                                             transcode_encoder_format_out( id->encoder ) );
+        es_format_Clean( &fmt );
+        if( !id->downstream_id )
+        {
+            msg_Err( p_stream, "cannot output transcoded rendition %d",
+                     p_rend->i_es_id );
+            vlc_mutex_lock( &p_rend->lock );
+            p_rend->b_error = true;
+            vlc_mutex_unlock( &p_rend->lock );
+        }
+    }
+
+    if( !p_out )
+        return VLC_SUCCESS;
+    if( !id->downstream_id )
+    {
+        block_ChainRelease( p_out );
+        return VLC_EGENERIC;
+    }
+    return sout_StreamIdSend( p_stream->p_next, id->downstream_id, p_out );
+}
+
+static sout_stream_id_sys_t *
+transcode_rendition_new( sout_stream_t *p_stream, sout_stream_id_sys_t *p_parent,
+                         const transcode_rendition_config_t *p_cfg,
+                         const sout_filters_config_t *p_filterscfg, int i_es_id )
+{
+    sout_stream_id_sys_t *id = calloc( 1, sizeof( *id ) );
+    struct transcode_rendition *p_rend = malloc( sizeof( *p_rend ) );
+    if( unlikely( !id || !p_rend ) )
+    {
+        free( id );
+        free( p_rend );
+        return NULL;
+    }
+
+    vlc_mutex_init( &id->fifo.lock );
+    id->b_transcode = true;
+    id->pf_transcode_downstream_add = p_parent->pf_transcode_downstream_add;
+    /* Only to test the encoder, the decoder belongs to the parent */
+    id->p_decoder = p_parent->p_decoder;
+    id->p_filterscfg = p_filterscfg;
+    id->p_enccfg = &p_cfg->enc_cfg;
+    es_format_Init( &id->decoder_out, VIDEO_ES, 0 );
+
+    if( transcode_video_encoder_init( p_stream, id ) != VLC_SUCCESS )
+    {
+        es_format_Clean( &id->decoder_out );
+        free( id );
+        free( p_rend );
+        return NULL;
+    }
+
+    p_rend->p_stream = p_stream;
+    p_rend->i_es_id = i_es_id;
+    vlc_mutex_init( &p_rend->lock );
+    vlc_cond_init( &p_rend->wait );
+    vlc_cond_init( &p_rend->wait_done );
+    p_rend->p_first = NULL;
+    p_rend->pp_last = &p_rend->p_first;
+    p_rend->i_count = 0;
+    p_rend->i_max = __MAX( p_cfg->enc_cfg.video.threads.pool_size, 1 );
+    p_rend->b_busy = p_rend->b_ready = p_rend->b_error = p_rend->b_quit = false;
+    p_rend->p_out = NULL;
+    id->p_rendition = p_rend;
+
+    if( vlc_clone( &p_rend->thread, RenditionThread, id,
+                   p_cfg->enc_cfg.video.threads.i_priority ) )
+    {
+        msg_Err( p_stream, "cannot spawn rendition thread" );
+        transcode_encoder_delete( id->encoder );
+        es_format_Clean( &id->decoder_out );
+        free( id );
+        free( p_rend );
+        return NULL;
+    }
+
+    msg_Dbg( p_stream, "rendition %d to fcc=`%4.4s'", i_es_id,
+             (char *)&p_cfg->enc_cfg.i_codec );
+    return id;
+}
+
+static void transcode_rendition_delete( sout_stream_t *p_stream,
+                                        sout_stream_id_sys_t *id )
+{
+    struct transcode_rendition *p_rend = id->p_rendition;
+
+    vlc_mutex_lock( &p_rend->lock );
+    p_rend->b_quit = true;
+    vlc_cond_signal( &p_rend->wait );
+    vlc_mutex_unlock( &p_rend->lock );
+    vlc_join( p_rend->thread, NULL );
+
+    assert( p_rend->p_first == NULL );
+    block_ChainRelease( p_rend->p_out );
+    free( p_rend );
+    id->p_rendition = NULL;
+
+    transcode_video_clean( p_stream, id );
+    if( id->downstream_id )
+        sout_StreamIdDel( p_stream->p_next, id->downstream_id );
+    free( id );
+}
+
+int transcode_video_renditions_init( sout_stream_t *p_stream,
+                                     const es_format_t *p_fmt,
+                                     sout_stream_id_sys_t *id,
+                                     const transcode_rendition_config_t *p_cfgs,
+                                     int i_cfgs,
+                                     const sout_filters_config_t *p_filterscfg )
+{
+    msg_Dbg( p_stream, "creating %d video renditions from fcc=`%4.4s'",
+             i_cfgs, (char*)&p_fmt->i_codec );
+
+    bool b_default = false, b_input_id = false;
+    for( int i = 0; i < i_cfgs; i++ )
+    {
+        b_default |= p_cfgs[i].i_id == 0;
+        b_input_id |= p_cfgs[i].i_id == p_fmt->i_id;
+    }
+    if( b_default && b_input_id )
+    {
+        msg_Err( p_stream, "rendition id %d is the one of the rendition "
+                 "without id", p_fmt->i_id );
+        return VLC_EGENERIC;
+    }
+
+    if( transcode_video_decoder_open( p_stream, id ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
+
+    id->pp_renditions = vlc_alloc( i_cfgs, sizeof( *id->pp_renditions ) );
+    if( unlikely( !id->pp_renditions ) )
+        goto error;
+
+    for( int i = 0; i < i_cfgs; i++ )
+    {
+        /* The rendition without id replaces the input ES */
+        int i_es_id = p_cfgs[i].i_id ? p_cfgs[i].i_id : p_fmt->i_id;
+
+        sout_stream_id_sys_t *p_rend =
+            transcode_rendition_new( p_stream, id, &p_cfgs[i],
+                                     p_filterscfg, i_es_id );
+        if( !p_rend )
+            goto error;
+        id->pp_renditions[id->i_renditions++] = p_rend;
+    }
+
+    return VLC_SUCCESS;
+
+error:
+    for( int i = 0; i < id->i_renditions; i++ )
+        transcode_rendition_delete( p_stream, id->pp_renditions[i] );
+    free( id->pp_renditions );
+    id->pp_renditions = NULL;
+    id->i_renditions = 0;
+    transcode_video_decoder_close( id );
+    return VLC_EGENERIC;
+}
+
+/* Deinterlacing and frame rate conversion, for all the renditions */
+static int transcode_video_renditions_filters_init( sout_stream_t *p_stream,
+                                                    sout_stream_id_sys_t *id,
+                                                    picture_t *p_pic )
+{
+    if( id->p_f_chain )
+    {
+        msg_Info( p_stream, "picture format changed, reiniting renditions" );
+        transcode_remove_filters( &id->p_f_chain );
+    }
+
+    video_format_Clean( &id->decoder_out.video );
+    video_format_Copy( &id->decoder_out.video, &p_pic->format );
+    transcode_video_framerate_apply( &p_pic->format, &id->decoder_out.video );
+    transcode_video_sar_apply( &p_pic->format, &id->decoder_out.video );
+    id->decoder_vctx_out = picture_GetVideoContext(p_pic);
+
+    filter_owner_t owner = {
+        .video = &transcode_filter_video_cbs,
+        .sys = id,
+    };
+    id->p_f_chain = filter_chain_NewVideo( p_stream, false, &owner );
+    if( !id->p_f_chain )
+        return VLC_EGENERIC;
+    filter_chain_Reset( id->p_f_chain, &id->decoder_out, id->decoder_vctx_out,
+                        &id->decoder_out );
+
+    if( id->p_filterscfg->video.psz_deinterlace != NULL &&
+        !filter_chain_AppendFilter( id->p_f_chain,
+                                    id->p_filterscfg->video.psz_deinterlace,
+                                    id->p_filterscfg->video.p_deinterlace_cfg,
+                                    &id->decoder_out ) )
+        return VLC_EGENERIC;
+
+    if( id->p_enccfg->video.fps.num > 0 )
+    {
+        es_format_t fmt;
+        es_format_Copy( &fmt, filter_chain_GetFmtOut( id->p_f_chain ) );
+        fmt.video.i_frame_rate = id->p_enccfg->video.fps.num;
+        fmt.video.i_frame_rate_base = __MAX( id->p_enccfg->video.fps.den, 1 );
+
+        filter_t *p_fps = filter_chain_AppendFilter( id->p_f_chain, "fps",
+                                                     NULL, &fmt );
+        es_format_Clean( &fmt );
+        if( !p_fps )
+            return VLC_EGENERIC;
+    }
+
+    debug_format( p_stream, filter_chain_GetFmtOut( id->p_f_chain ) );
+    return VLC_SUCCESS;
+}
+
+static int transcode_video_renditions_process( sout_stream_t *p_stream,
+                                               sout_stream_id_sys_t *id,
+                                               block_t *in )
+{
+    bool b_eos = in && (in->i_flags & BLOCK_FLAG_END_OF_SEQUENCE);
+
+    int ret = id->p_decoder->pf_decode( id->p_decoder, in );
+    if( ret != VLCDEC_SUCCESS )
+        return VLC_EGENERIC;
+
+    picture_t *p_pics = transcode_dequeue_all_pics( id );
+
+    while( p_pics )
+    {
+        picture_t *p_pic = p_pics;
+        p_pics = p_pic->p_next;
+        p_pic->p_next = NULL;
+
+        if( !id->b_error &&
+            ( !id->p_f_chain ||
+              !video_format_IsSimilar( &id->decoder_out.video, &p_pic->format ) ) &&
+            transcode_video_renditions_filters_init( p_stream, id, p_pic ) != VLC_SUCCESS )
+        {
+            msg_Err( p_stream, "cannot deinterlace or convert the frame rate "
+                               "for the renditions" );
+            id->b_error = true;
+        }
+        if( id->b_error )
+        {
+            picture_Release( p_pic );
+            continue;
+        }
+
+        for( picture_t *p_in = filter_chain_VideoFilter( id->p_f_chain, p_pic );
+             p_in != NULL;
+             p_in = filter_chain_VideoFilter( id->p_f_chain, NULL ) )
+        {
+            /* Each rendition queues its own picture, sharing the planes */
+            for( int i = 0; i + 1 < id->i_renditions; i++ )
+            {
+                picture_t *p_clone = picture_Clone( p_in );
+                if( unlikely( !p_clone ) )
+                    continue;
+                picture_CopyProperties( p_clone, p_in );
+                transcode_rendition_put( id->pp_renditions[i], p_clone );
+            }
+            transcode_rendition_put( id->pp_renditions[id->i_renditions - 1],
+                                     p_in );
+        }
+    }
+
+    if( b_eos )
+        transcode_remove_filters( &id->p_f_chain );
+
+    /* The output of a rendition is sent from here, and its encoder is only
+     * drained once its thread is done with it. */
+    int i_ret = VLC_SUCCESS;
+    for( int i = 0; i < id->i_renditions; i++ )
+    {
+        sout_stream_id_sys_t *p_rend = id->pp_renditions[i];
+        const bool b_drain = b_eos || in == NULL;
+        block_t *p_out = NULL;
+
+        bool b_ready = transcode_rendition_dequeue( p_rend, b_drain, &p_out );
+        if( b_drain && b_ready && transcode_encoder_opened( p_rend->encoder ) )
+        {
+            if( b_eos )
+            {
+                if( transcode_video_end_of_sequence( p_stream, p_rend,
+                                                     &p_out ) != VLC_SUCCESS )
+                    msg_Warn( p_stream, "Draining rendition %d failed",
+                              p_rend->p_rendition->i_es_id );
+            }
+            else if( transcode_encoder_drain( p_rend->encoder,
+                                              &p_out ) != VLC_SUCCESS )
+                msg_Warn( p_stream, "Flushing rendition %d failed",
+                          p_rend->p_rendition->i_es_id );
+        }
+
+        if( transcode_rendition_send( p_stream, id, p_rend,
+                                      b_ready, p_out ) != VLC_SUCCESS )
+            i_ret = VLC_EGENERIC;
+    }
+
+    return id->b_error ? VLC_EGENERIC : i_ret;
+}
+
 int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                     block_t *in, block_t **out )
 {
     *out = NULL;
 
+    if( id->i_renditions > 0 )
+        return transcode_video_renditions_process( p_stream, id, in );
+
     bool b_eos = in && (in->i_flags & BLOCK_FLAG_END_OF_SEQUENCE);
 
     int ret = id->p_decoder->pf_decode( id->p_decoder, in );
@@ -556,94 +1194,8 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
         if( p_pic && ( unlikely(!transcode_encoder_opened(id->encoder)) ||
               !video_format_IsSimilar( &id->decoder_out.video, &p_pic->format ) ) )
         {
-            if( !transcode_encoder_opened(id->encoder) ) /* Configure Encoder input/output */
-            {
-                assert( !id->p_f_chain && !id->p_uf_chain );
-                transcode_encoder_video_configure( VLC_OBJECT(p_stream),
-                                                   &id->p_decoder->fmt_out.video,
-                                                   id->p_enccfg,
-                                                   &p_pic->format,
-                                                   picture_GetVideoContext(p_pic),
-                                                   id->encoder );
-                /* will be opened below */
-            }
-            else /* picture format has changed */
-            {
-                msg_Info( p_stream, "aspect-ratio changed, reiniting. %i -> %i : %i -> %i.",
-                            id->decoder_out.video.i_sar_num, p_pic->format.i_sar_num,
-                            id->decoder_out.video.i_sar_den, p_pic->format.i_sar_den
-                        );
-                /* Close filters, encoder format input can't change */
-                transcode_remove_filters( &id->p_f_chain );
-                transcode_remove_filters( &id->p_conv_nonstatic );
-                transcode_remove_filters( &id->p_conv_static );
-                transcode_remove_filters( &id->p_uf_chain );
-                transcode_remove_filters( &id->p_final_conv_static );
-                if( id->p_spu_blender )
-                    filter_DeleteBlend( id->p_spu_blender );
-                id->p_spu_blender = NULL;
-
-                video_format_Clean( &id->decoder_out.video );
-            }
-
-            video_format_Copy( &id->decoder_out.video, &p_pic->format );
-            transcode_video_framerate_apply( &p_pic->format, &id->decoder_out.video );
-            transcode_video_sar_apply( &p_pic->format, &id->decoder_out.video );
-            id->decoder_vctx_out = picture_GetVideoContext(p_pic);
-
-            if( !transcode_video_filters_configured( id ) )
-            {
-                if( transcode_video_filters_init( p_stream,
-                                                  id->p_filterscfg,
-                                                 (id->p_enccfg->video.fps.num > 0),
-                                                 &id->decoder_out,
-                                                 id->decoder_vctx_out,
-                                                 transcode_encoder_format_in( id->encoder ),
-                                                 id ) != VLC_SUCCESS )
-                    goto error;
-            }
-
-            /* Store the current encoder input chroma to detect whether we need
-             * a converter in p_final_conv_static. The encoder will override it
-             * if it needs any different format or chroma. */
-            es_format_t filter_fmt_out;
-            es_format_Copy( &filter_fmt_out, transcode_encoder_format_in( id->encoder ) );
-            bool is_encoder_open = transcode_encoder_opened( id->encoder );
-
-            /* Start missing encoder */
-            if( !is_encoder_open &&
-                transcode_encoder_open( id->encoder, id->p_enccfg ) != VLC_SUCCESS )
-            {
-                msg_Err( p_stream, "cannot find video encoder (module:%s fourcc:%4.4s). "
-                                   "Take a look few lines earlier to see possible reason.",
-                                   id->p_enccfg->psz_name ? id->p_enccfg->psz_name : "any",
-                                   (char *)&id->p_enccfg->i_codec );
+            if( transcode_video_configure( p_stream, id, p_pic ) != VLC_SUCCESS )
                 goto error;
-            }
-
-            /* The fmt_in may have been overriden by the encoder. */
-            const es_format_t *encoder_fmt_in = transcode_encoder_format_in( id->encoder );
-
-            /* In case the encoder wasn't open yet, check if we need to add
-             * a converter between last user filter and encoder. */
-            if( !is_encoder_open &&
-                filter_fmt_out.i_codec != encoder_fmt_in->i_codec )
-            {
-                if ( !id->p_final_conv_static )
-                    id->p_final_conv_static =
-                        filter_chain_NewVideo( p_stream, false, NULL );
-                filter_chain_Reset( id->p_final_conv_static,
-                                    &filter_fmt_out,
-                                    //encoder_vctx_in,
-                                    NULL,
-                                    encoder_fmt_in );
-                filter_chain_AppendConverter( id->p_final_conv_static, NULL );
-            }
-            es_format_Clean(&filter_fmt_out);
-
-            msg_Dbg( p_stream, "destination (after video filters) %ux%u",
-                               transcode_encoder_format_in( id->encoder )->video.i_width,
-                               transcode_encoder_format_in( id->encoder )->video.i_height );
 
             if( !id->downstream_id )
                 id->downstream_id =
@@ -658,67 +1210,12 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
             }
         }
 
-        /* Run the filter and output chains; first with the picture,
-         * and then with NULL as many times as we need until they
-         * stop outputting frames.
-         */
-        for ( picture_t *p_in = p_pic; ; p_in = NULL /* drain second time */ )
-        {
-            /* Run filter chain */
-            filter_chain_t * primary_chains[] = { id->p_f_chain,
-                                                  id->p_conv_nonstatic,
-                                                  id->p_conv_static };
-            for( size_t i=0; p_in && i<ARRAY_SIZE(primary_chains); i++ )
-            {
-                if( !primary_chains[i] )
-                    continue;
-                p_in = filter_chain_VideoFilter( primary_chains[i], p_in );
-            }
-
-            if( !p_in )
-                break;
-
-            for ( ;; p_in = NULL /* drain second time */ )
-            {
-                /* Run user specified filter chain */
-                filter_chain_t * secondary_chains[] = { id->p_uf_chain,
-                                                        id->p_final_conv_static };
-                for( size_t i=0; p_in && i<ARRAY_SIZE(secondary_chains); i++ )
-                {
-                    if( !secondary_chains[i] )
-                        continue;
-                    p_in = filter_chain_VideoFilter( secondary_chains[i], p_in );
-                }
-
-                if( !p_in )
-                    break;
-
-                /* Blend subpictures */
-                p_in = RenderSubpictures( id, p_in );
-
-                if( p_in )
-                {
-                    block_t *p_encoded = transcode_encoder_encode( id->encoder, p_in );
-                    if( p_encoded )
-                        block_ChainAppend( out, p_encoded );
-                    picture_Release( p_in );
-                }
-            }
-        }
+        transcode_video_encode( id, p_pic, out );
 
         if( b_eos )
         {
-            msg_Info( p_stream, "Drain/restart on EOS" );
-            if( transcode_encoder_drain( id->encoder, out ) != VLC_SUCCESS )
+            if( transcode_video_end_of_sequence( p_stream, id, out ) != VLC_SUCCESS )
                 goto error;
-            transcode_encoder_close( id->encoder );
-            /* Close filters */
-            transcode_remove_filters( &id->p_f_chain );
-            transcode_remove_filters( &id->p_conv_nonstatic );
-            transcode_remove_filters( &id->p_conv_static );
-            transcode_remove_filters( &id->p_uf_chain );
-            transcode_remove_filters( &id->p_final_conv_static );
-            tag_last_block_with_flag( out, BLOCK_FLAG_END_OF_SEQUENCE );
             b_eos = false;
         }
 
@@ -1193,6 +1193,26 @@ static size_t SegmentsToTextAndStyles( filter_t *p_filter, const text_segment_t
     return i_nb_char;
 }
 
+/**
+ * Returns a key of the settings that Render() reads each time it is called,
+ * so that the owner can tell when an earlier rendering became stale.
+ */
+static uint64_t RenderSettings( filter_t *p_filter )
+{
+    const uint64_t settings[] = {
+        var_InheritInteger( p_filter, "sub-text-scale" ),
+        var_InheritInteger( p_filter, "freetype-color" ),
+        var_InheritInteger( p_filter, "freetype-background-opacity" ),
+        var_InheritInteger( p_filter, "freetype-background-color" ),
+        var_InheritBool( p_filter, "freetype-yuvp" ),
+    };
+    uint64_t key = UINT64_C(0xcbf29ce484222325); /* FNV-1a */
+
+    for( size_t i = 0; i < ARRAY_SIZE(settings); i++ )
+        key = (key ^ settings[i]) * UINT64_C(0x100000001b3);
+    return key;
+}
+
 /**
  * This function renders a text subpicture region into another one.
  * It also calculates the size needed for this string, and renders the
@@ -1520,6 +1540,7 @@ static int Create( vlc_object_t *p_this )
     }
 
     p_filter->pf_render = Render;
+    p_filter->pf_render_settings = RenderSettings;
 
     return VLC_SUCCESS;
 
@@ -149,7 +149,7 @@ static vlc_decoder_device * HoldChainDecoderDevice(vlc_object_t *o, void *sys)
 
 static const struct filter_video_callbacks filter_video_chain_cbs =
 {
-    BufferChainNew, HoldChainDecoderDevice,
+    BufferChainNew, HoldChainDecoderDevice, NULL,
 };
 
 /*****************************************************************************
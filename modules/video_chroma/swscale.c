@@ -28,6 +28,7 @@
 # include "config.h"
 #endif
 #include <assert.h>
+#include <stdatomic.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -38,6 +39,14 @@
 #include <libswscale/swscale.h>
 #include <libswscale/version.h>
 
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100)
+/* Bands of output lines can be scaled separately, with one context each */
+# include <libavutil/frame.h>
+# define SWS_SLICES
+# define SLICES_MAX      16 /* as many as the video-filter-threads maximum */
+# define SLICE_MIN_LINES 32
+#endif
+
 #ifdef __APPLE__
 # include <TargetConditionals.h>
 #endif
@@ -105,6 +114,18 @@ typedef struct
     bool b_copy;
     bool b_swap_uvi;
     bool b_swap_uvo;
+
+#ifdef SWS_SLICES
+    /* Parameters of ctx, to create the contexts of the other slices */
+    int i_fmti, i_fmto, i_flags;
+    int i_src_width, i_src_height;
+    int i_dst_width, i_dst_height;
+
+    vlc_mutex_t lock; /* for slice_ctx */
+    struct SwsContext *slice_ctx[SLICES_MAX]; /* the first one is unused */
+    AVFrame *frame_src;
+    AVFrame *frame_dst;
+#endif
 } filter_sys_t;
 
 static picture_t *Filter( filter_t *, picture_t * );
@@ -158,6 +179,19 @@ static int OpenScaler( vlc_object_t *p_this )
     if( ( p_filter->p_sys = p_sys = calloc(1, sizeof(filter_sys_t)) ) == NULL )
         return VLC_ENOMEM;
 
+#ifdef SWS_SLICES
+    vlc_mutex_init( &p_sys->lock );
+    p_sys->frame_src = av_frame_alloc();
+    p_sys->frame_dst = av_frame_alloc();
+    if( !p_sys->frame_src || !p_sys->frame_dst )
+    {
+        av_frame_free( &p_sys->frame_src );
+        av_frame_free( &p_sys->frame_dst );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+#endif
+
     /* Set CPU capabilities */
     p_sys->i_cpu_mask = GetSwsCpuMask();
 
@@ -187,6 +221,10 @@ static int OpenScaler( vlc_object_t *p_this )
     {
         if( p_sys->p_filter )
             sws_freeFilter( p_sys->p_filter );
+#ifdef SWS_SLICES
+        av_frame_free( &p_sys->frame_src );
+        av_frame_free( &p_sys->frame_dst );
+#endif
         free( p_sys );
         return VLC_EGENERIC;
     }
@@ -217,6 +255,10 @@ static void CloseScaler( vlc_object_t *p_this )
     Clean( p_filter );
     if( p_sys->p_filter )
         sws_freeFilter( p_sys->p_filter );
+#ifdef SWS_SLICES
+    av_frame_free( &p_sys->frame_src );
+    av_frame_free( &p_sys->frame_dst );
+#endif
     free( p_sys );
 }
 
@@ -304,6 +346,9 @@ static int GetParameters( ScalerConfiguration *p_cfg,
     GetFfmpegChroma( &i_fmti, p_fmti );
     GetFfmpegChroma( &i_fmto, p_fmto );
 
+    const int i_fmti_a = i_fmti;
+    const int i_fmto_a = i_fmto;
+
     if( p_fmti->i_chroma == p_fmto->i_chroma )
     {
         if( p_fmti->i_chroma == VLC_CODEC_YUVP && ALLOW_YUVP )
@@ -316,6 +361,16 @@ static int GetParameters( ScalerConfiguration *p_cfg,
     FixParameters( &i_fmti, &b_has_ai, &b_swap_uvi, p_fmti->i_chroma );
     FixParameters( &i_fmto, &b_has_ao, &b_swap_uvo, p_fmto->i_chroma );
 
+    /* Scale the alpha plane along with the others when libswscale can,
+     * rather than through intermediate grey pictures */
+    if( b_has_ai && b_has_ao && i_fmti_a >= 0 && i_fmto_a >= 0 &&
+        sws_isSupportedInput( i_fmti_a ) && sws_isSupportedOutput( i_fmto_a ) )
+    {
+        i_fmti = i_fmti_a;
+        i_fmto = i_fmto_a;
+        b_has_ai = b_has_ao = false;
+    }
+
 #if !defined (__ANDROID__) && !defined(TARGET_OS_IPHONE)
     /* FIXME TODO removed when ffmpeg is fixed
      * Without SWS_ACCURATE_RND the quality is really bad for some conversions */
@@ -463,6 +518,15 @@ static int Init( filter_t *p_filter )
     p_sys->fmt_out = *p_fmto;
     p_sys->b_swap_uvi = cfg.b_swap_uvi;
     p_sys->b_swap_uvo = cfg.b_swap_uvo;
+#ifdef SWS_SLICES
+    p_sys->i_fmti = cfg.i_fmti;
+    p_sys->i_fmto = cfg.i_fmto;
+    p_sys->i_flags = cfg.i_sws_flags | p_sys->i_cpu_mask;
+    p_sys->i_src_width = i_fmti_visible_width;
+    p_sys->i_src_height = p_fmti->i_visible_height;
+    p_sys->i_dst_width = i_fmto_visible_width;
+    p_sys->i_dst_height = p_fmto->i_visible_height;
+#endif
 
     return VLC_SUCCESS;
 }
@@ -487,6 +551,15 @@ static void Clean( filter_t *p_filter )
     if( p_sys->ctx )
         sws_freeContext( p_sys->ctx );
 
+#ifdef SWS_SLICES
+    for( unsigned i = 1; i < SLICES_MAX; i++ )
+    {
+        if( p_sys->slice_ctx[i] )
+            sws_freeContext( p_sys->slice_ctx[i] );
+        p_sys->slice_ctx[i] = NULL;
+    }
+#endif
+
     /* We have to set it to null has we call be called again :( */
     p_sys->ctx = NULL;
     p_sys->ctxA = NULL;
@@ -583,6 +656,125 @@ static void SwapUV( picture_t *p_dst, const picture_t *p_src )
     picture_CopyPixels( p_dst, &tmp );
 }
 
+#ifdef SWS_SLICES
+static void NoFree( void *opaque, uint8_t *data )
+{
+    VLC_UNUSED(opaque); VLC_UNUSED(data);
+}
+
+/* libswscale references the frames it works on, so the planes are wrapped
+ * in a buffer which does not own them */
+static int WrapPixels( AVFrame *frame, uint8_t *const pp_pixel[4],
+                       const int pi_pitch[4], int i_fmt,
+                       int i_width, int i_height )
+{
+    frame->buf[0] = av_buffer_create( pp_pixel[0], 0, NoFree, NULL, 0 );
+    if( !frame->buf[0] )
+        return VLC_ENOMEM;
+
+    for( unsigned i = 0; i < 4; i++ )
+    {
+        frame->data[i] = pp_pixel[i];
+        frame->linesize[i] = pi_pitch[i];
+    }
+    frame->format = i_fmt;
+    frame->width = i_width;
+    frame->height = i_height;
+    return VLC_SUCCESS;
+}
+
+static struct SwsContext *GetSliceContext( filter_sys_t *p_sys,
+                                           unsigned i_slice )
+{
+    struct SwsContext *ctx;
+
+    if( i_slice == 0 )
+        return p_sys->ctx;
+    if( i_slice >= SLICES_MAX )
+        return NULL;
+
+    vlc_mutex_lock( &p_sys->lock );
+    ctx = p_sys->slice_ctx[i_slice];
+    if( !ctx )
+        ctx = p_sys->slice_ctx[i_slice] =
+            sws_getContext( p_sys->i_src_width, p_sys->i_src_height,
+                            p_sys->i_fmti,
+                            p_sys->i_dst_width, p_sys->i_dst_height,
+                            p_sys->i_fmto, p_sys->i_flags,
+                            p_sys->p_filter, NULL, 0 );
+    vlc_mutex_unlock( &p_sys->lock );
+    return ctx;
+}
+
+typedef struct
+{
+    unsigned i_align;
+    atomic_bool b_failed;
+} convert_slices_t;
+
+static void ConvertSlice( filter_t *p_filter, void *opaque,
+                          unsigned i_slice, unsigned i_slices )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    convert_slices_t *p_job = opaque;
+    const unsigned i_height = p_sys->i_dst_height;
+
+    /* Every context scales the whole input, so that all the bands of the
+     * output are the same as with a single context */
+    unsigned i_lines = __MAX( (i_height + i_slices - 1) / i_slices,
+                              SLICE_MIN_LINES );
+    i_lines = (i_lines + p_job->i_align - 1) / p_job->i_align * p_job->i_align;
+
+    const unsigned i_start = i_slice * i_lines;
+    if( i_start >= i_height )
+        return;
+    i_lines = __MIN( i_lines, i_height - i_start );
+
+    struct SwsContext *ctx = GetSliceContext( p_sys, i_slice );
+    if( !ctx )
+    {
+        atomic_store( &p_job->b_failed, true );
+        return;
+    }
+    if( sws_frame_start( ctx, p_sys->frame_dst, p_sys->frame_src ) < 0 ||
+        sws_send_slice( ctx, 0, p_sys->i_src_height ) < 0 ||
+        sws_receive_slice( ctx, i_start, i_lines ) < 0 )
+        atomic_store( &p_job->b_failed, true );
+    sws_frame_end( ctx );
+}
+
+/* Scales bands of output lines on the worker threads of the filter owner */
+static int ConvertSlices( filter_t *p_filter,
+                          uint8_t *const src[4], const int src_stride[4],
+                          uint8_t *const dst[4], const int dst_stride[4] )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    convert_slices_t job = {
+        .i_align = sws_receive_slice_alignment( p_sys->ctx ),
+    };
+
+    /* libswscale wants all the bands aligned, including the last one */
+    if( p_sys->i_dst_height < 2 * SLICE_MIN_LINES ||
+        p_sys->i_dst_height % job.i_align )
+        return VLC_EGENERIC;
+
+    int i_ret = VLC_ENOMEM;
+    if( WrapPixels( p_sys->frame_src, src, src_stride, p_sys->i_fmti,
+                    p_sys->i_src_width, p_sys->i_src_height ) ||
+        WrapPixels( p_sys->frame_dst, dst, dst_stride, p_sys->i_fmto,
+                    p_sys->i_dst_width, p_sys->i_dst_height ) )
+        goto out;
+
+    atomic_init( &job.b_failed, false );
+    filter_ExecuteSlices( p_filter, ConvertSlice, &job, 0 );
+    i_ret = atomic_load( &job.b_failed ) ? VLC_EGENERIC : VLC_SUCCESS;
+out:
+    av_frame_unref( p_sys->frame_src );
+    av_frame_unref( p_sys->frame_dst );
+    return i_ret;
+}
+#endif
+
 static void Convert( filter_t *p_filter, struct SwsContext *ctx,
                      picture_t *p_dst, picture_t *p_src, int i_height,
                      int i_plane_count, bool b_swap_uvi, bool b_swap_uvo )
@@ -611,6 +803,13 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
     for (size_t i = 0; i < ARRAY_SIZE(src); i++)
         csrc[i] = src[i];
 
+#ifdef SWS_SLICES
+    /* The alpha plane, when scaled separately, is left to a single thread */
+    if( ctx == p_sys->ctx &&
+        ConvertSlices( p_filter, src, src_stride, dst, dst_stride ) == VLC_SUCCESS )
+        return;
+#endif
+
 #if LIBSWSCALE_VERSION_INT  >= ((0<<16)+(5<<8)+0)
     sws_scale( ctx, csrc, src_stride, 0, i_height,
                dst, dst_stride );
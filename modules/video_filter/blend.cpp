@@ -32,6 +32,7 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include "filter_picture.h"
+#include "blend_simd.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -84,6 +85,20 @@ public:
     {
         return true;
     }
+    uint8_t *getPixels(unsigned plane, unsigned dx, unsigned dy,
+                       unsigned rx, unsigned ry, unsigned size) const
+    {
+        const plane_t *p = &picture->p[plane];
+        return &p->p_pixels[(y + dy) / ry * p->i_pitch + (x + dx) / rx * size];
+    }
+    bool isEvenLine(unsigned dy) const
+    {
+        return ((y + dy) % 2) == 0;
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
 
 protected:
     template <unsigned ry>
@@ -561,6 +576,159 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
+/*****************************************************************************
+ * Line based blending
+ *****************************************************************************/
+/* The most common cases are blended a line at a time by vector kernels,
+ * giving the same results as the templates above. */
+namespace {
+
+/* Gets a source line as 8-bit Y, U, V and A rows */
+static void GetLineYUVA(const uint8_t *row[4], uint8_t *tmp,
+                        const CPicture &src, unsigned dy, unsigned width)
+{
+    if (src.getFormat()->i_chroma == VLC_CODEC_YUVA) {
+        for (unsigned i = 0; i < 4; i++)
+            row[i] = src.getPixels(i, 0, dy, 1, 1, 1);
+        return;
+    }
+
+    const uint8_t *rgba = src.getPixels(0, 0, dy, 1, 1, 4);
+    uint8_t *yuva[4];
+    for (unsigned i = 0; i < 4; i++)
+        row[i] = yuva[i] = &tmp[i * width];
+    for (unsigned x = 0; x < width; x++, rgba += 4) {
+        /* transparent pixels are left alone, whatever their color */
+        if (rgba[3] != 0)
+            rgb_to_yuv(&yuva[0][x], &yuva[1][x], &yuva[2][x],
+                       rgba[0], rgba[1], rgba[2]);
+        yuva[3][x] = rgba[3];
+    }
+}
+
+/* Gets a source line as packed RGBA */
+static const uint8_t *GetLineRGBA(uint8_t *tmp, const CPicture &src,
+                                  unsigned dy, unsigned width)
+{
+    if (src.getFormat()->i_chroma == VLC_CODEC_RGBA)
+        return src.getPixels(0, 0, dy, 1, 1, 4);
+
+    const uint8_t *yuva[4];
+    for (unsigned i = 0; i < 4; i++)
+        yuva[i] = src.getPixels(i, 0, dy, 1, 1, 1);
+    for (unsigned x = 0; x < width; x++) {
+        tmp[4 * x + 3] = yuva[3][x];
+        if (yuva[3][x] == 0)
+            continue;
+
+        int r, g, b;
+        yuv_to_rgb(&r, &g, &b, yuva[0][x], yuva[1][x], yuva[2][x]);
+        tmp[4 * x + 0] = r;
+        tmp[4 * x + 1] = g;
+        tmp[4 * x + 2] = b;
+    }
+    return tmp;
+}
+
+/* 4:2:0 destinations only take the chroma of the source pixels on even
+ * lines and columns */
+static void BlendLines420(const blend_row_ops_t *ops, uint8_t *tmp,
+                          const CPicture &dst, const CPicture &src,
+                          unsigned width, unsigned height, int alpha)
+{
+    const vlc_fourcc_t chroma = dst.getFormat()->i_chroma;
+    const bool semiplanar = chroma == VLC_CODEC_NV12 ||
+                            chroma == VLC_CODEC_NV21;
+    const bool swap_uv = chroma == VLC_CODEC_YV12 ||
+                         chroma == VLC_CODEC_NV21;
+    const bool high = chroma == VLC_CODEC_I420_10L;
+    const unsigned first = dst.getX() % 2;
+    const unsigned cwidth = (width - first + 1) / 2;
+
+    uint8_t *a   = tmp;
+    uint8_t *cs  = &a[width + 1];
+    uint8_t *ca  = &cs[width + 1];
+    uint8_t *cvt = &ca[width + 1];
+
+    for (unsigned dy = 0; dy < height; dy++) {
+        const uint8_t *row[4];
+        GetLineYUVA(row, cvt, src, dy, width);
+        ops->alpha(a, row[3], alpha, width);
+
+        if (high)
+            ops->merge10((uint16_t *)dst.getPixels(0, 0, dy, 1, 1, 2),
+                         row[0], a, width);
+        else
+            ops->merge8(dst.getPixels(0, 0, dy, 1, 1, 1), row[0], a, width);
+
+        if (!dst.isEvenLine(dy) || cwidth == 0)
+            continue;
+
+        if (semiplanar) {
+            ops->pair(cs, &row[swap_uv ? 2 : 1][first],
+                          &row[swap_uv ? 1 : 2][first], cwidth);
+            ops->pair(ca, &a[first], &a[first], cwidth);
+            ops->merge8(dst.getPixels(1, first, dy, 2, 2, 2), cs, ca,
+                        2 * cwidth);
+            continue;
+        }
+
+        ops->even(ca, &a[first], cwidth);
+        for (unsigned i = 1; i <= 2; i++) {
+            const unsigned plane = swap_uv ? 3 - i : i;
+
+            ops->even(cs, &row[i][first], cwidth);
+            if (high)
+                ops->merge10((uint16_t *)dst.getPixels(plane, first, dy,
+                                                       2, 2, 2),
+                             cs, ca, cwidth);
+            else
+                ops->merge8(dst.getPixels(plane, first, dy, 2, 2, 1),
+                            cs, ca, cwidth);
+        }
+    }
+}
+
+static void BlendLinesRGB32(const blend_row_ops_t *ops, uint8_t *tmp,
+                            const CPicture &dst, const CPicture &src,
+                            unsigned width, unsigned height, int alpha)
+{
+    int r, g, b;
+    if (GetPackedRgbIndexes(dst.getFormat(), &r, &g, &b) != VLC_SUCCESS) {
+        r = 0;
+        g = 1;
+        b = 2;
+    }
+
+    blend_rgb32_map_t map;
+    blend_InitRGB32Map(&map, r, g, b);
+
+    for (unsigned dy = 0; dy < height; dy++)
+        ops->merge_rgb32(dst.getPixels(0, 0, dy, 1, 1, 4),
+                         GetLineRGBA(tmp, src, dy, width), alpha, width, &map);
+}
+
+typedef void (*blend_lines_function_t)(const blend_row_ops_t *, uint8_t *,
+                                       const CPicture &, const CPicture &,
+                                       unsigned, unsigned, int);
+
+static const struct {
+    vlc_fourcc_t           dst;
+    blend_lines_function_t blend;
+} blend_lines[] = {
+    { VLC_CODEC_I420,     BlendLines420 },
+    { VLC_CODEC_J420,     BlendLines420 },
+    { VLC_CODEC_YV12,     BlendLines420 },
+    { VLC_CODEC_NV12,     BlendLines420 },
+    { VLC_CODEC_NV21,     BlendLines420 },
+#ifndef WORDS_BIGENDIAN
+    { VLC_CODEC_I420_10L, BlendLines420 },
+#endif
+    { VLC_CODEC_RGB32,    BlendLinesRGB32 },
+};
+
+} // namespace
+
 namespace {
 
 static const struct {
@@ -638,10 +806,21 @@ static const struct {
 };
 
 struct filter_sys_t {
-    filter_sys_t() : blend(NULL)
+    filter_sys_t() : blend(NULL), blend_lines(NULL), ops(NULL),
+                     tmp(NULL), tmp_size(0)
     {
     }
+    ~filter_sys_t()
+    {
+        free(tmp);
+    }
     blend_function_t blend;
+
+    /* vector code, if the chromas and the CPU allow */
+    blend_lines_function_t blend_lines;
+    const blend_row_ops_t *ops;
+    uint8_t *tmp;
+    size_t tmp_size;
 };
 
 } // namespace
@@ -671,13 +850,31 @@ static void Blend(filter_t *filter,
     video_format_FixRgb(&filter->fmt_out.video);
     video_format_FixRgb(&filter->fmt_in.video);
 
-    sys->blend(CPicture(dst, &filter->fmt_out.video,
-                        filter->fmt_out.video.i_x_offset + x_offset,
-                        filter->fmt_out.video.i_y_offset + y_offset),
-               CPicture(src, &filter->fmt_in.video,
-                        filter->fmt_in.video.i_x_offset,
-                        filter->fmt_in.video.i_y_offset),
-               width, height, alpha);
+    const CPicture dst_data(dst, &filter->fmt_out.video,
+                            filter->fmt_out.video.i_x_offset + x_offset,
+                            filter->fmt_out.video.i_y_offset + y_offset);
+    const CPicture src_data(src, &filter->fmt_in.video,
+                            filter->fmt_in.video.i_x_offset,
+                            filter->fmt_in.video.i_y_offset);
+
+    if (sys->blend_lines != NULL && alpha <= 255) {
+        /* a few lines of temporary samples */
+        size_t size = 8 * (size_t)width + 16;
+        if (size > sys->tmp_size) {
+            uint8_t *tmp = (uint8_t *)realloc(sys->tmp, size);
+            if (tmp != NULL) {
+                sys->tmp = tmp;
+                sys->tmp_size = size;
+            }
+        }
+        if (size <= sys->tmp_size) {
+            sys->blend_lines(sys->ops, sys->tmp, dst_data, src_data,
+                             width, height, alpha);
+            return;
+        }
+    }
+
+    sys->blend(dst_data, src_data, width, height, alpha);
 }
 
 static int Open(vlc_object_t *object)
@@ -699,6 +896,17 @@ static int Open(vlc_object_t *object)
         return VLC_EGENERIC;
     }
 
+    sys->ops = blend_GetRowOps();
+    if (sys->ops != NULL &&
+        (src == VLC_CODEC_YUVA || src == VLC_CODEC_RGBA)) {
+        for (size_t i = 0; i < ARRAY_SIZE(blend_lines); i++) {
+            if (blend_lines[i].dst == dst)
+                sys->blend_lines = blend_lines[i].blend;
+        }
+        if (sys->blend_lines != NULL)
+            msg_Dbg(filter, "using %s blending", sys->ops->name);
+    }
+
     filter->pf_video_blend = Blend;
     filter->p_sys          = sys;
     return VLC_SUCCESS;
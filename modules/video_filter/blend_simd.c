@@ -0,0 +1,640 @@
+/*****************************************************************************
+ * blend_simd.c: vector kernels for the blend filter
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "blend_simd.h"
+
+#if defined(HAVE_SSE2_INTRINSICS) && defined(CAN_COMPILE_SSE4_1)
+# include <smmintrin.h>
+# define BLEND_SSE4_1 __attribute__ ((__target__ ("sse4.1")))
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+# define BLEND_AVX2 __attribute__ ((__target__ ("avx2")))
+#endif
+#ifdef __ARM_NEON
+# include <arm_neon.h>
+# define BLEND_NEON
+#endif
+
+/*****************************************************************************
+ * Scalar code, for the samples left over by the vector loops
+ *****************************************************************************/
+static inline unsigned div255(unsigned v)
+{
+    /* Same as blend.cpp */
+    return ((v >> 8) + v + 1) >> 8;
+}
+
+static inline void AlphaTail(uint8_t *a, const uint8_t *src, unsigned alpha,
+                             unsigned i, unsigned n)
+{
+    for (; i < n; i++)
+        a[i] = div255(alpha * src[i]);
+}
+
+static inline void EvenTail(uint8_t *dst, const uint8_t *src,
+                            unsigned i, unsigned n)
+{
+    for (; i < n; i++)
+        dst[i] = src[2 * i];
+}
+
+static inline void PairTail(uint8_t *dst, const uint8_t *lo,
+                            const uint8_t *hi, unsigned i, unsigned n)
+{
+    for (; i < n; i++)
+    {
+        dst[2 * i]     = lo[2 * i];
+        dst[2 * i + 1] = hi[2 * i];
+    }
+}
+
+static inline void Merge8Tail(uint8_t *dst, const uint8_t *src,
+                              const uint8_t *a, unsigned i, unsigned n)
+{
+    for (; i < n; i++)
+        dst[i] = div255((255 - a[i]) * dst[i] + src[i] * a[i]);
+}
+
+static inline void Merge10Tail(uint16_t *dst, const uint8_t *src,
+                               const uint8_t *a, unsigned i, unsigned n)
+{
+    for (; i < n; i++)
+        if (a[i] != 0)
+            dst[i] = div255((255 - a[i]) * dst[i]
+                            + (src[i] * 1023 / 255) * a[i]);
+}
+
+static inline void MergeRGB32Tail(uint8_t *dst, const uint8_t *rgba,
+                                  unsigned alpha, unsigned i, unsigned n,
+                                  const blend_rgb32_map_t *map)
+{
+    for (; i < n; i++)
+    {
+        const uint8_t *s = &rgba[4 * i];
+        uint8_t *d = &dst[4 * i];
+        unsigned a = div255(alpha * s[3]);
+
+        for (unsigned c = 0; c < 3; c++)
+        {
+            uint8_t *p = &d[map->offset[c]];
+            *p = div255((255 - a) * *p + s[c] * a);
+        }
+    }
+}
+
+void blend_InitRGB32Map(blend_rgb32_map_t *map, int r, int g, int b)
+{
+    const int offset[3] = { r, g, b };
+
+    for (unsigned c = 0; c < 3; c++)
+        map->offset[c] = offset[c];
+
+    memset(map->color, 0x80, sizeof (map->color));
+    memset(map->alpha, 0x80, sizeof (map->alpha));
+    for (unsigned p = 0; p < 16; p += 4)
+        for (unsigned c = 0; c < 3; c++)
+        {
+            map->color[p + offset[c]] = p + c;
+            map->alpha[p + offset[c]] = p + 3;
+        }
+}
+
+/*****************************************************************************
+ * SSE4.1
+ *****************************************************************************/
+#ifdef BLEND_SSE4_1
+/* ((v >> 8) + v + 1) >> 8 on 16-bit lanes, v being at most 255 * 255 */
+BLEND_SSE4_1
+static inline __m128i Div255_SSE4_1(__m128i v)
+{
+    v = _mm_add_epi16(v, _mm_srli_epi16(v, 8));
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_set1_epi16(1)), 8);
+}
+
+BLEND_SSE4_1
+static inline __m128i Scale_SSE4_1(__m128i s, __m128i alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), alpha);
+    __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), alpha);
+
+    return _mm_packus_epi16(Div255_SSE4_1(lo), Div255_SSE4_1(hi));
+}
+
+BLEND_SSE4_1
+static inline __m128i Merge_SSE4_1(__m128i d, __m128i s, __m128i a)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    __m128i alo = _mm_unpacklo_epi8(a, zero);
+    __m128i ahi = _mm_unpackhi_epi8(a, zero);
+    __m128i lo = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(max, alo)),
+        _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), alo));
+    __m128i hi = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(max, ahi)),
+        _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), ahi));
+
+    return _mm_packus_epi16(Div255_SSE4_1(lo), Div255_SSE4_1(hi));
+}
+
+BLEND_SSE4_1
+static void Alpha_SSE4_1(uint8_t *a, const uint8_t *src, unsigned alpha,
+                         unsigned n)
+{
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= n; i += 16)
+        _mm_storeu_si128((__m128i *)&a[i],
+            Scale_SSE4_1(_mm_loadu_si128((const __m128i *)&src[i]), va));
+    AlphaTail(a, src, alpha, i, n);
+}
+
+BLEND_SSE4_1
+static void Even_SSE4_1(uint8_t *dst, const uint8_t *src, unsigned n)
+{
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    unsigned i = 0;
+
+    /* do not read past src[2 * (n - 1)] */
+    for (; i + 16 < n; i += 16)
+    {
+        __m128i s0 = _mm_loadu_si128((const __m128i *)&src[2 * i]);
+        __m128i s1 = _mm_loadu_si128((const __m128i *)&src[2 * i + 16]);
+
+        _mm_storeu_si128((__m128i *)&dst[i],
+                         _mm_packus_epi16(_mm_and_si128(s0, mask),
+                                          _mm_and_si128(s1, mask)));
+    }
+    EvenTail(dst, src, i, n);
+}
+
+BLEND_SSE4_1
+static void Pair_SSE4_1(uint8_t *dst, const uint8_t *lo, const uint8_t *hi,
+                        unsigned n)
+{
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    unsigned i = 0;
+
+    for (; i + 8 < n; i += 8)
+    {
+        __m128i l = _mm_loadu_si128((const __m128i *)&lo[2 * i]);
+        __m128i h = _mm_loadu_si128((const __m128i *)&hi[2 * i]);
+
+        _mm_storeu_si128((__m128i *)&dst[2 * i],
+                         _mm_or_si128(_mm_and_si128(l, mask),
+                                      _mm_slli_epi16(h, 8)));
+    }
+    PairTail(dst, lo, hi, i, n);
+}
+
+BLEND_SSE4_1
+static void Merge8_SSE4_1(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                          unsigned n)
+{
+    unsigned i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+        __m128i s = _mm_loadu_si128((const __m128i *)&src[i]);
+        __m128i va = _mm_loadu_si128((const __m128i *)&a[i]);
+
+        _mm_storeu_si128((__m128i *)&dst[i], Merge_SSE4_1(d, s, va));
+    }
+    Merge8Tail(dst, src, a, i, n);
+}
+
+BLEND_SSE4_1
+static void Merge10_SSE4_1(uint16_t *dst, const uint8_t *src,
+                           const uint8_t *a, unsigned n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    const __m128i one = _mm_set1_epi32(1);
+    unsigned i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[i]);
+        __m128i s = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)&src[i]));
+        __m128i va = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)&a[i]));
+
+        /* s * 1023 / 255 is s * 4 + (s >= 85) + (s >= 170) + (s >= 255) */
+        __m128i s10 = _mm_slli_epi16(s, 2);
+        s10 = _mm_sub_epi16(s10, _mm_cmpgt_epi16(s, _mm_set1_epi16(84)));
+        s10 = _mm_sub_epi16(s10, _mm_cmpgt_epi16(s, _mm_set1_epi16(169)));
+        s10 = _mm_sub_epi16(s10, _mm_cmpeq_epi16(s, max));
+
+        __m128i ia = _mm_sub_epi16(max, va);
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(d, s10),
+                                    _mm_unpacklo_epi16(ia, va));
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(d, s10),
+                                    _mm_unpackhi_epi16(ia, va));
+        lo = _mm_add_epi32(lo, _mm_srli_epi32(lo, 8));
+        lo = _mm_srli_epi32(_mm_add_epi32(lo, one), 8);
+        hi = _mm_add_epi32(hi, _mm_srli_epi32(hi, 8));
+        hi = _mm_srli_epi32(_mm_add_epi32(hi, one), 8);
+
+        __m128i r = _mm_packus_epi32(lo, hi);
+        r = _mm_blendv_epi8(r, d, _mm_cmpeq_epi16(va, zero));
+        _mm_storeu_si128((__m128i *)&dst[i], r);
+    }
+    Merge10Tail(dst, src, a, i, n);
+}
+
+BLEND_SSE4_1
+static void MergeRGB32_SSE4_1(uint8_t *dst, const uint8_t *rgba,
+                              unsigned alpha, unsigned n,
+                              const blend_rgb32_map_t *map)
+{
+    const __m128i color = _mm_loadu_si128((const __m128i *)map->color);
+    const __m128i amask = _mm_loadu_si128((const __m128i *)map->alpha);
+    const __m128i va = _mm_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)&rgba[4 * i]);
+        __m128i d = _mm_loadu_si128((const __m128i *)&dst[4 * i]);
+        __m128i a = Scale_SSE4_1(_mm_shuffle_epi8(s, amask), va);
+
+        _mm_storeu_si128((__m128i *)&dst[4 * i],
+                         Merge_SSE4_1(d, _mm_shuffle_epi8(s, color), a));
+    }
+    MergeRGB32Tail(dst, rgba, alpha, i, n, map);
+}
+
+static const blend_row_ops_t ops_sse4_1 = {
+    Alpha_SSE4_1, Even_SSE4_1, Pair_SSE4_1,
+    Merge8_SSE4_1, Merge10_SSE4_1, MergeRGB32_SSE4_1, "SSE4.1",
+};
+#endif
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#ifdef BLEND_AVX2
+BLEND_AVX2
+static inline __m256i Div255_AVX2(__m256i v)
+{
+    v = _mm256_add_epi16(v, _mm256_srli_epi16(v, 8));
+    return _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_set1_epi16(1)), 8);
+}
+
+BLEND_AVX2
+static inline __m256i Scale_AVX2(__m256i s, __m256i alpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), alpha);
+    __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), alpha);
+
+    /* unpacking and packing within the same lanes keeps the order */
+    return _mm256_packus_epi16(Div255_AVX2(lo), Div255_AVX2(hi));
+}
+
+BLEND_AVX2
+static inline __m256i Merge_AVX2(__m256i d, __m256i s, __m256i a)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16(255);
+    __m256i alo = _mm256_unpacklo_epi8(a, zero);
+    __m256i ahi = _mm256_unpackhi_epi8(a, zero);
+    __m256i lo = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero),
+                           _mm256_sub_epi16(max, alo)),
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), alo));
+    __m256i hi = _mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero),
+                           _mm256_sub_epi16(max, ahi)),
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), ahi));
+
+    return _mm256_packus_epi16(Div255_AVX2(lo), Div255_AVX2(hi));
+}
+
+BLEND_AVX2
+static void Alpha_AVX2(uint8_t *a, const uint8_t *src, unsigned alpha,
+                       unsigned n)
+{
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 32 <= n; i += 32)
+        _mm256_storeu_si256((__m256i *)&a[i],
+            Scale_AVX2(_mm256_loadu_si256((const __m256i *)&src[i]), va));
+    AlphaTail(a, src, alpha, i, n);
+}
+
+BLEND_AVX2
+static void Even_AVX2(uint8_t *dst, const uint8_t *src, unsigned n)
+{
+    const __m256i mask = _mm256_set1_epi16(0x00FF);
+    unsigned i = 0;
+
+    /* do not read past src[2 * (n - 1)] */
+    for (; i + 32 < n; i += 32)
+    {
+        __m256i s0 = _mm256_loadu_si256((const __m256i *)&src[2 * i]);
+        __m256i s1 = _mm256_loadu_si256((const __m256i *)&src[2 * i + 32]);
+        __m256i r = _mm256_packus_epi16(_mm256_and_si256(s0, mask),
+                                        _mm256_and_si256(s1, mask));
+
+        /* packing interleaves the 64-bit halves of s0 and s1 */
+        _mm256_storeu_si256((__m256i *)&dst[i],
+                            _mm256_permute4x64_epi64(r, 0xD8));
+    }
+    EvenTail(dst, src, i, n);
+}
+
+BLEND_AVX2
+static void Pair_AVX2(uint8_t *dst, const uint8_t *lo, const uint8_t *hi,
+                      unsigned n)
+{
+    const __m256i mask = _mm256_set1_epi16(0x00FF);
+    unsigned i = 0;
+
+    for (; i + 16 < n; i += 16)
+    {
+        __m256i l = _mm256_loadu_si256((const __m256i *)&lo[2 * i]);
+        __m256i h = _mm256_loadu_si256((const __m256i *)&hi[2 * i]);
+
+        _mm256_storeu_si256((__m256i *)&dst[2 * i],
+                            _mm256_or_si256(_mm256_and_si256(l, mask),
+                                            _mm256_slli_epi16(h, 8)));
+    }
+    PairTail(dst, lo, hi, i, n);
+}
+
+BLEND_AVX2
+static void Merge8_AVX2(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                        unsigned n)
+{
+    unsigned i = 0;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i d = _mm256_loadu_si256((const __m256i *)&dst[i]);
+        __m256i s = _mm256_loadu_si256((const __m256i *)&src[i]);
+        __m256i va = _mm256_loadu_si256((const __m256i *)&a[i]);
+
+        _mm256_storeu_si256((__m256i *)&dst[i], Merge_AVX2(d, s, va));
+    }
+    Merge8Tail(dst, src, a, i, n);
+}
+
+BLEND_AVX2
+static void Merge10_AVX2(uint16_t *dst, const uint8_t *src,
+                         const uint8_t *a, unsigned n)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16(255);
+    const __m256i one = _mm256_set1_epi32(1);
+    unsigned i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i d = _mm256_loadu_si256((const __m256i *)&dst[i]);
+        __m256i s = _mm256_cvtepu8_epi16(
+                        _mm_loadu_si128((const __m128i *)&src[i]));
+        __m256i va = _mm256_cvtepu8_epi16(
+                        _mm_loadu_si128((const __m128i *)&a[i]));
+
+        /* s * 1023 / 255 is s * 4 + (s >= 85) + (s >= 170) + (s >= 255) */
+        __m256i s10 = _mm256_slli_epi16(s, 2);
+        s10 = _mm256_sub_epi16(s10,
+                               _mm256_cmpgt_epi16(s, _mm256_set1_epi16(84)));
+        s10 = _mm256_sub_epi16(s10,
+                               _mm256_cmpgt_epi16(s, _mm256_set1_epi16(169)));
+        s10 = _mm256_sub_epi16(s10, _mm256_cmpeq_epi16(s, max));
+
+        __m256i ia = _mm256_sub_epi16(max, va);
+        __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(d, s10),
+                                       _mm256_unpacklo_epi16(ia, va));
+        __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(d, s10),
+                                       _mm256_unpackhi_epi16(ia, va));
+        lo = _mm256_add_epi32(lo, _mm256_srli_epi32(lo, 8));
+        lo = _mm256_srli_epi32(_mm256_add_epi32(lo, one), 8);
+        hi = _mm256_add_epi32(hi, _mm256_srli_epi32(hi, 8));
+        hi = _mm256_srli_epi32(_mm256_add_epi32(hi, one), 8);
+
+        __m256i r = _mm256_packus_epi32(lo, hi);
+        r = _mm256_blendv_epi8(r, d, _mm256_cmpeq_epi16(va, zero));
+        _mm256_storeu_si256((__m256i *)&dst[i], r);
+    }
+    Merge10Tail(dst, src, a, i, n);
+}
+
+BLEND_AVX2
+static void MergeRGB32_AVX2(uint8_t *dst, const uint8_t *rgba,
+                            unsigned alpha, unsigned n,
+                            const blend_rgb32_map_t *map)
+{
+    /* the shuffles work within 128-bit lanes, as the maps do */
+    const __m256i color = _mm256_broadcastsi128_si256(
+                            _mm_loadu_si128((const __m128i *)map->color));
+    const __m256i amask = _mm256_broadcastsi128_si256(
+                            _mm_loadu_si128((const __m128i *)map->alpha));
+    const __m256i va = _mm256_set1_epi16(alpha);
+    unsigned i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i *)&rgba[4 * i]);
+        __m256i d = _mm256_loadu_si256((const __m256i *)&dst[4 * i]);
+        __m256i a = Scale_AVX2(_mm256_shuffle_epi8(s, amask), va);
+
+        _mm256_storeu_si256((__m256i *)&dst[4 * i],
+                            Merge_AVX2(d, _mm256_shuffle_epi8(s, color), a));
+    }
+    MergeRGB32Tail(dst, rgba, alpha, i, n, map);
+}
+
+static const blend_row_ops_t ops_avx2 = {
+    Alpha_AVX2, Even_AVX2, Pair_AVX2,
+    Merge8_AVX2, Merge10_AVX2, MergeRGB32_AVX2, "AVX2",
+};
+#endif
+
+/*****************************************************************************
+ * NEON
+ *****************************************************************************/
+#ifdef BLEND_NEON
+/* ((v >> 8) + v + 1) >> 8, narrowed */
+static inline uint8x8_t Div255_NEON(uint16x8_t v)
+{
+    v = vaddq_u16(v, vshrq_n_u16(v, 8));
+    return vshrn_n_u16(vaddq_u16(v, vdupq_n_u16(1)), 8);
+}
+
+static inline uint8x16_t Scale_NEON(uint8x16_t s, uint8x8_t alpha)
+{
+    return vcombine_u8(Div255_NEON(vmull_u8(vget_low_u8(s), alpha)),
+                       Div255_NEON(vmull_u8(vget_high_u8(s), alpha)));
+}
+
+static inline uint8x16_t Merge_NEON(uint8x16_t d, uint8x16_t s, uint8x16_t a)
+{
+    uint8x16_t ia = vmvnq_u8(a); /* 255 - a */
+    uint16x8_t lo = vmull_u8(vget_low_u8(d), vget_low_u8(ia));
+    uint16x8_t hi = vmull_u8(vget_high_u8(d), vget_high_u8(ia));
+
+    lo = vmlal_u8(lo, vget_low_u8(s), vget_low_u8(a));
+    hi = vmlal_u8(hi, vget_high_u8(s), vget_high_u8(a));
+    return vcombine_u8(Div255_NEON(lo), Div255_NEON(hi));
+}
+
+static void Alpha_NEON(uint8_t *a, const uint8_t *src, unsigned alpha,
+                       unsigned n)
+{
+    const uint8x8_t va = vdup_n_u8(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= n; i += 16)
+        vst1q_u8(&a[i], Scale_NEON(vld1q_u8(&src[i]), va));
+    AlphaTail(a, src, alpha, i, n);
+}
+
+static void Even_NEON(uint8_t *dst, const uint8_t *src, unsigned n)
+{
+    unsigned i = 0;
+
+    /* do not read past src[2 * (n - 1)] */
+    for (; i + 16 < n; i += 16)
+        vst1q_u8(&dst[i], vld2q_u8(&src[2 * i]).val[0]);
+    EvenTail(dst, src, i, n);
+}
+
+static void Pair_NEON(uint8_t *dst, const uint8_t *lo, const uint8_t *hi,
+                      unsigned n)
+{
+    unsigned i = 0;
+
+    for (; i + 16 < n; i += 16)
+    {
+        uint8x16x2_t r;
+
+        r.val[0] = vld2q_u8(&lo[2 * i]).val[0];
+        r.val[1] = vld2q_u8(&hi[2 * i]).val[0];
+        vst2q_u8(&dst[2 * i], r);
+    }
+    PairTail(dst, lo, hi, i, n);
+}
+
+static void Merge8_NEON(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                        unsigned n)
+{
+    unsigned i = 0;
+
+    for (; i + 16 <= n; i += 16)
+        vst1q_u8(&dst[i], Merge_NEON(vld1q_u8(&dst[i]), vld1q_u8(&src[i]),
+                                     vld1q_u8(&a[i])));
+    Merge8Tail(dst, src, a, i, n);
+}
+
+static inline uint16x4_t Div255x32_NEON(uint32x4_t v)
+{
+    v = vaddq_u32(v, vshrq_n_u32(v, 8));
+    return vshrn_n_u32(vaddq_u32(v, vdupq_n_u32(1)), 8);
+}
+
+static void Merge10_NEON(uint16_t *dst, const uint8_t *src,
+                         const uint8_t *a, unsigned n)
+{
+    unsigned i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        uint16x8_t d = vld1q_u16(&dst[i]);
+        uint16x8_t s = vmovl_u8(vld1_u8(&src[i]));
+        uint16x8_t va = vmovl_u8(vld1_u8(&a[i]));
+
+        /* s * 1023 / 255 is s * 4 + (s >= 85) + (s >= 170) + (s >= 255);
+         * the comparisons give all ones, i.e. -1 */
+        uint16x8_t s10 = vshlq_n_u16(s, 2);
+        s10 = vsubq_u16(s10, vcgtq_u16(s, vdupq_n_u16(84)));
+        s10 = vsubq_u16(s10, vcgtq_u16(s, vdupq_n_u16(169)));
+        s10 = vsubq_u16(s10, vceqq_u16(s, vdupq_n_u16(255)));
+
+        uint16x8_t ia = vsubq_u16(vdupq_n_u16(255), va);
+        uint32x4_t lo = vmull_u16(vget_low_u16(d), vget_low_u16(ia));
+        uint32x4_t hi = vmull_u16(vget_high_u16(d), vget_high_u16(ia));
+        lo = vmlal_u16(lo, vget_low_u16(s10), vget_low_u16(va));
+        hi = vmlal_u16(hi, vget_high_u16(s10), vget_high_u16(va));
+
+        uint16x8_t r = vcombine_u16(Div255x32_NEON(lo), Div255x32_NEON(hi));
+        vst1q_u16(&dst[i], vbslq_u16(vceqq_u16(va, vdupq_n_u16(0)), d, r));
+    }
+    Merge10Tail(dst, src, a, i, n);
+}
+
+static void MergeRGB32_NEON(uint8_t *dst, const uint8_t *rgba,
+                            unsigned alpha, unsigned n,
+                            const blend_rgb32_map_t *map)
+{
+    const uint8x8_t va = vdup_n_u8(alpha);
+    unsigned i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16x4_t s = vld4q_u8(&rgba[4 * i]);
+        uint8x16x4_t d = vld4q_u8(&dst[4 * i]);
+        uint8x16_t a = Scale_NEON(s.val[3], va);
+
+        for (unsigned c = 0; c < 3; c++)
+        {
+            unsigned o = map->offset[c];
+            d.val[o] = Merge_NEON(d.val[o], s.val[c], a);
+        }
+        vst4q_u8(&dst[4 * i], d);
+    }
+    MergeRGB32Tail(dst, rgba, alpha, i, n, map);
+}
+
+static const blend_row_ops_t ops_neon = {
+    Alpha_NEON, Even_NEON, Pair_NEON,
+    Merge8_NEON, Merge10_NEON, MergeRGB32_NEON, "NEON",
+};
+#endif
+
+const blend_row_ops_t *blend_GetRowOps(void)
+{
+#ifdef BLEND_AVX2
+    if (vlc_CPU_AVX2())
+        return &ops_avx2;
+#endif
+#ifdef BLEND_SSE4_1
+    if (vlc_CPU_SSE4_1())
+        return &ops_sse4_1;
+#endif
+#ifdef BLEND_NEON
+    if (vlc_CPU_ARM_NEON())
+        return &ops_neon;
+#endif
+    return NULL;
+}
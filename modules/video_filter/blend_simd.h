@@ -0,0 +1,69 @@
+/*****************************************************************************
+ * blend_simd.h: vector kernels for the blend filter
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_BLEND_SIMD_H
+#define VLC_BLEND_SIMD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Byte layout of a 32-bit RGB destination */
+typedef struct
+{
+    unsigned offset[3]; /* of R, G and B */
+    uint8_t  color[16]; /* RGBA source byte of each destination byte */
+    uint8_t  alpha[16]; /* source alpha byte, or 0x80 where untouched */
+} blend_rgb32_map_t;
+
+/* Kernels blending one line. They give the same results as the generic
+ * per-pixel code of blend.cpp. */
+typedef struct
+{
+    /* a[i] = alpha * src[i] / 255 */
+    void (*alpha)(uint8_t *a, const uint8_t *src, unsigned alpha, unsigned n);
+    /* dst[i] = src[2 * i] */
+    void (*even)(uint8_t *dst, const uint8_t *src, unsigned n);
+    /* dst[2 * i] = lo[2 * i] and dst[2 * i + 1] = hi[2 * i] */
+    void (*pair)(uint8_t *dst, const uint8_t *lo, const uint8_t *hi,
+                 unsigned n);
+    /* dst[i] = (dst[i] * (255 - a[i]) + src[i] * a[i]) / 255 */
+    void (*merge8)(uint8_t *dst, const uint8_t *src, const uint8_t *a,
+                   unsigned n);
+    /* same onto 10-bit samples, the source being scaled to 10 bits, and
+     * samples with a null a[i] being left alone */
+    void (*merge10)(uint16_t *dst, const uint8_t *src, const uint8_t *a,
+                    unsigned n);
+    /* RGBA pixels, scaled by alpha / 255, onto 32-bit RGB pixels */
+    void (*merge_rgb32)(uint8_t *dst, const uint8_t *rgba, unsigned alpha,
+                        unsigned n, const blend_rgb32_map_t *);
+    const char *name;
+} blend_row_ops_t;
+
+/* Returns the kernels for the CPU, or NULL if there are none */
+const blend_row_ops_t *blend_GetRowOps(void);
+
+void blend_InitRGB32Map(blend_rgb32_map_t *, int r, int g, int b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -58,12 +58,20 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define BASE_IMAGE_TEXT N_("Image to be blended onto")
 #define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
 
+#define BASE_WIDTH_TEXT N_("Width of the base image")
+#define BASE_HEIGHT_TEXT N_("Height of the base image")
+#define SIZE_LONGTEXT N_("Size of the generated image, if no image file " \
+                         "is given")
+
 #define BASE_CHROMA_TEXT N_("Chroma for the base image")
 #define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded in")
 
 #define BLEND_IMAGE_TEXT N_("Image which will be blended")
 #define BLEND_IMAGE_LONGTEXT N_("The image blended onto the base image")
 
+#define BLEND_WIDTH_TEXT N_("Width of the blend image")
+#define BLEND_HEIGHT_TEXT N_("Height of the blend image")
+
 #define BLEND_CHROMA_TEXT N_("Chroma for the blend image")
 #define BLEND_CHROMA_LONGTEXT N_("Chroma which the blend image will be loaded" \
                                  " in")
@@ -88,19 +96,28 @@ vlc_module_begin ()
                  BASE_IMAGE_TEXT, BASE_IMAGE_LONGTEXT)
     add_string( CFG_PREFIX "base-chroma", "I420", BASE_CHROMA_TEXT,
               BASE_CHROMA_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "base-width", 1920, 16, 8192,
+              BASE_WIDTH_TEXT, SIZE_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "base-height", 1080, 16, 8192,
+              BASE_HEIGHT_TEXT, SIZE_LONGTEXT, false )
 
     set_section( N_("Blend image"), NULL )
     add_loadfile(CFG_PREFIX "blend-image", NULL,
                  BLEND_IMAGE_TEXT, BLEND_IMAGE_LONGTEXT)
     add_string( CFG_PREFIX "blend-chroma", "YUVA", BLEND_CHROMA_TEXT,
               BLEND_CHROMA_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "blend-width", 1280, 16, 8192,
+              BLEND_WIDTH_TEXT, SIZE_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "blend-height", 200, 16, 8192,
+              BLEND_HEIGHT_TEXT, SIZE_LONGTEXT, false )
 
     set_callbacks( Create, Destroy )
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
-    "blend-chroma", NULL
+    "loops", "alpha", "base-image", "base-chroma", "base-width",
+    "base-height", "blend-image", "blend-chroma", "blend-width",
+    "blend-height", NULL
 };
 
 /*****************************************************************************
@@ -118,18 +135,59 @@ typedef struct
     vlc_fourcc_t i_blend_chroma;
 } filter_sys_t;
 
+/* Generates a picture, for benchmarking without image files: gradients,
+ * with mostly transparent or opaque pixels like subtitles */
+static picture_t *blendbench_CreateImage( vlc_fourcc_t i_chroma,
+                                          unsigned i_width, unsigned i_height )
+{
+    video_format_t fmt;
+    picture_t *p_pic;
+
+    video_format_Init( &fmt, i_chroma );
+    video_format_Setup( &fmt, i_chroma, i_width, i_height,
+                        i_width, i_height, 1, 1 );
+    video_format_FixRgb( &fmt );
+    p_pic = picture_NewFromFormat( &fmt );
+    video_format_Clean( &fmt );
+    if( p_pic == NULL )
+        return NULL;
+
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_pic->p[i];
+
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+            {
+                uint8_t v = x * 7 + y * 3 + i * 64;
+                if( v < 96 )
+                    v = 0;
+                else if( v > 160 )
+                    v = 255;
+                p->p_pixels[y * p->i_pitch + x] = v;
+            }
+    }
+    return p_pic;
+}
+
 static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
-                                 vlc_fourcc_t i_chroma, char *psz_file, const char *psz_name )
+                                 vlc_fourcc_t i_chroma, char *psz_file, const char *psz_name,
+                                 unsigned i_width, unsigned i_height )
 {
-    image_handler_t *p_image;
-    video_format_t fmt_out;
+    if( psz_file == NULL || *psz_file == '\0' )
+        *pp_pic = blendbench_CreateImage( i_chroma, i_width, i_height );
+    else
+    {
+        image_handler_t *p_image;
+        video_format_t fmt_out;
 
-    video_format_Init( &fmt_out, i_chroma );
+        video_format_Init( &fmt_out, i_chroma );
 
-    p_image = image_HandlerCreate( p_this );
-    *pp_pic = image_ReadUrl( p_image, psz_file, &fmt_out );
-    video_format_Clean( &fmt_out );
-    image_HandlerDelete( p_image );
+        p_image = image_HandlerCreate( p_this );
+        *pp_pic = image_ReadUrl( p_image, psz_file, &fmt_out );
+        video_format_Clean( &fmt_out );
+        image_HandlerDelete( p_image );
+    }
 
     if( *pp_pic == NULL )
     {
@@ -179,7 +237,9 @@ static int Create( vlc_object_t *p_this )
         VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
     psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
     i_ret = blendbench_LoadImage( p_this, &p_sys->p_base_image,
-                                  p_sys->i_base_chroma, psz_cmd, "Base" );
+                                  p_sys->i_base_chroma, psz_cmd, "Base",
+                                  var_CreateGetInteger( p_filter, CFG_PREFIX "base-width" ),
+                                  var_CreateGetInteger( p_filter, CFG_PREFIX "base-height" ) );
     free( psz_temp );
     free( psz_cmd );
     if( i_ret != VLC_SUCCESS )
@@ -194,7 +254,9 @@ static int Create( vlc_object_t *p_this )
         ? 0 : VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
     psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
     i_ret = blendbench_LoadImage( p_this, &p_sys->p_blend_image, p_sys->i_blend_chroma,
-                                  psz_cmd, "Blend" );
+                                  psz_cmd, "Blend",
+                                  var_CreateGetInteger( p_filter, CFG_PREFIX "blend-width" ),
+                                  var_CreateGetInteger( p_filter, CFG_PREFIX "blend-height" ) );
 
     free( psz_temp );
     free( psz_cmd );
@@ -258,8 +320,9 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     }
     time = vlc_tick_now() - time;
 
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              secf_from_vlc_tick(time) );
+    msg_Info( p_filter, "Blended %d %4.4s images onto %4.4s in %f sec",
+              p_sys->i_loops, (const char *)&p_sys->i_blend_chroma,
+              (const char *)&p_sys->i_base_chroma, secf_from_vlc_tick(time) );
     msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
               (float) p_sys->i_loops / time * CLOCK_FREQ,
               (float) p_sys->i_loops / time * CLOCK_FREQ *
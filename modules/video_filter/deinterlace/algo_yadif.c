@@ -46,6 +46,38 @@
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
 
+/* Whether 16-bit samples fit the vector line filters */
+static bool ShortSamples( vlc_fourcc_t i_chroma )
+{
+    switch( i_chroma )
+    {
+#ifdef WORDS_BIGENDIAN
+        case VLC_CODEC_I420_9B:
+        case VLC_CODEC_I420_10B:
+        case VLC_CODEC_I420_12B:
+        case VLC_CODEC_I422_9B:
+        case VLC_CODEC_I422_10B:
+        case VLC_CODEC_I422_12B:
+        case VLC_CODEC_I444_9B:
+        case VLC_CODEC_I444_10B:
+        case VLC_CODEC_I444_12B:
+#else
+        case VLC_CODEC_I420_9L:
+        case VLC_CODEC_I420_10L:
+        case VLC_CODEC_I420_12L:
+        case VLC_CODEC_I422_9L:
+        case VLC_CODEC_I422_10L:
+        case VLC_CODEC_I422_12L:
+        case VLC_CODEC_I444_9L:
+        case VLC_CODEC_I444_10L:
+        case VLC_CODEC_I444_12L:
+#endif
+            return true;
+        default:
+            return false;
+    }
+}
+
 int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src )
 {
     return RenderYadif( p_filter, p_dst, p_src, 0, 0 );
@@ -109,26 +141,31 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
     if( p_prev && p_cur && p_next )
     {
         /* */
-        void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
-                       int w, int prefs, int mrefs, int parity, int mode);
+        const unsigned i_pixel_size = p_sys->chroma->pixel_size;
+        yadif_line_t filter = NULL;
 
+        if( i_pixel_size == 1 || ShortSamples( p_filter->fmt_in.video.i_chroma ) )
+            filter = yadif_GetVectorLine( i_pixel_size );
+
+        if( filter == NULL && i_pixel_size == 2 )
+            filter = yadif_filter_line_c_16bit;
+        else if( filter == NULL )
+        {
 #if defined(HAVE_X86ASM)
-        if( vlc_CPU_SSSE3() )
-            filter = vlcpriv_yadif_filter_line_ssse3;
-        else
-        if( vlc_CPU_SSE2() )
-            filter = vlcpriv_yadif_filter_line_sse2;
-        else
+            if( vlc_CPU_SSSE3() )
+                filter = vlcpriv_yadif_filter_line_ssse3;
+            else
+            if( vlc_CPU_SSE2() )
+                filter = vlcpriv_yadif_filter_line_sse2;
+            else
 #if defined(__i386__)
-        if( vlc_CPU_MMXEXT() )
-            filter = vlcpriv_yadif_filter_line_mmxext;
-        else
+            if( vlc_CPU_MMXEXT() )
+                filter = vlcpriv_yadif_filter_line_mmxext;
+            else
 #endif
 #endif
-            filter = yadif_filter_line_c;
-
-        if( p_sys->chroma->pixel_size == 2 )
-            filter = yadif_filter_line_c_16bit;
+                filter = yadif_filter_line_c;
+        }
 
         for( int n = 0; n < p_dst->i_planes; n++ )
         {
@@ -155,7 +192,7 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
                             &prevp->p_pixels[y * prevp->i_pitch],
                             &curp->p_pixels[y * curp->i_pitch],
                             &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
+                            dstp->i_visible_pitch / i_pixel_size,
                             y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
                             y  - 1  ?  -curp->i_pitch : curp->i_pitch,
                             yadif_parity,
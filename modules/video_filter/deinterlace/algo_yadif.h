@@ -90,4 +90,24 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
  */
 int RenderYadifSingle( filter_t *p_filter, picture_t *p_dst, picture_t *p_src );
 
+/**
+ * Yadif line filter, as in yadif.h.
+ *
+ * w is in samples, prefs and mrefs are in bytes.
+ */
+typedef void (*yadif_line_t)( uint8_t *dst, uint8_t *prev, uint8_t *cur,
+                              uint8_t *next, int w, int prefs, int mrefs,
+                              int parity, int mode );
+
+/**
+ * Returns the vectorised Yadif line filter for the CPU, if any.
+ *
+ * 16-bit samples are only supported if they have no more than 12 bits
+ * in the native byte order.
+ *
+ * @param i_pixel_size Size of a sample in bytes: 1 or 2.
+ * @return Line filter, or NULL to use the regular ones.
+ */
+yadif_line_t yadif_GetVectorLine( unsigned i_pixel_size );
+
 #endif
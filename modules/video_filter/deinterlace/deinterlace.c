@@ -365,6 +365,8 @@ static struct filter_mode_t filter_mode [] = {
                  { false, true, false, false }, false, true },
     { "yadif2x", .pf_render_ordered = RenderYadif,
                  { true, true, false, false }, false, true },
+    /* X, phosphor and IVTC only handle 8-bit samples, and only have MMXEXT
+     * code: high bit depth pictures are blended instead */
     { "x", .pf_render_single_pic = RenderX,
                  { false, false, false, false }, false, false },
     { "phosphor", .pf_render_ordered = RenderPhosphor,
@@ -387,7 +389,7 @@ static void SetFilterMethod( filter_t *p_filter, const char *mode, bool pack )
     filter_sys_t *p_sys = p_filter->p_sys;
 
     if ( mode == NULL || !strcmp( mode, "auto" ) )
-        mode = "x";
+        mode = p_sys->chroma->pixel_size > 1 ? "yadif" : "x";
 
     for ( size_t i = 0; i < ARRAY_SIZE(filter_mode); i++ )
     {
@@ -542,6 +544,14 @@ notsupp:
         p_sys->pf_merge = MergeAltivec;
     else
 #endif
+#if defined(HAVE_AVX2_INTRINSICS)
+    if( vlc_CPU_AVX2() )
+    {
+        p_sys->pf_merge = pixel_size == 1 ? Merge8BitAVX2 : Merge16BitAVX2;
+        p_sys->pf_end_merge = NULL;
+    }
+    else
+#endif
 #if defined(CAN_COMPILE_SSE2)
     if( vlc_CPU_SSE2() )
     {
@@ -0,0 +1,246 @@
+/*****************************************************************************
+ * yadif_simd.c : vector versions of the Yadif line filter
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <stdint.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "common.h"      /* FFMIN3 et al. */
+#include "algo_yadif.h"
+
+#if defined(HAVE_SSE2_INTRINSICS) && defined(CAN_COMPILE_SSE4_1)
+#   include <smmintrin.h>
+#   define YADIF_SSE4_1 __attribute__ ((__target__ ("sse4.1")))
+#endif
+#if defined(HAVE_AVX2_INTRINSICS)
+#   include <immintrin.h>
+#   define YADIF_AVX2 __attribute__ ((__target__ ("avx2")))
+#endif
+
+#if defined(YADIF_SSE4_1) || defined(YADIF_AVX2)
+/* The C line filters, for the pixels left over by the vector loops */
+#include "yadif.h"
+
+/* Same as the FILTER macro of yadif.h, on vectors of 16-bit lanes.
+ *
+ * The sums of three sample differences fit in a signed 16-bit lane as long
+ * as samples have no more than 12 bits. sz is the size of a sample in bytes.
+ * The lane operations are the V* macros defined for each instruction set. */
+#define YADIF_SCORE(j) \
+    VADD(VADD(VABS(VSUB(m[2+(j)], p[2-(j)])), \
+              VABS(VSUB(m[3+(j)], p[3-(j)]))), \
+              VABS(VSUB(m[4+(j)], p[4-(j)])))
+
+#define YADIF_CHECK(j, mask) \
+    do { \
+        const V s = YADIF_SCORE(j); \
+        mask = VAND(mask, VLT(s, score)); \
+        score = VSEL(score, s, mask); \
+        pred = VSEL(pred, VSRA1(VADD(m[3+(j)], p[3-(j)])), mask); \
+    } while (0)
+
+#define YADIF_LINE(name, sz, tail) \
+VTARGET \
+static void name(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, \
+                 int w, int prefs, int mrefs, int parity, int mode) \
+{ \
+    const uint8_t *prev2 = parity ? prev : cur ; \
+    const uint8_t *next2 = parity ? cur  : next; \
+    const V ones = VSET1(-1); \
+    int x; \
+ \
+    for (x = 0; x + VLANES <= w; x += VLANES) { \
+        const ptrdiff_t o = x * (sz); \
+        V m[7], p[7]; \
+ \
+        /* cur[mrefs-3] to cur[mrefs+3], and the same around prefs */ \
+        for (int k = 0; k < 7; k++) { \
+            m[k] = VLOAD##sz(cur + o + mrefs + (k - 3) * (sz)); \
+            p[k] = VLOAD##sz(cur + o + prefs + (k - 3) * (sz)); \
+        } \
+ \
+        const V c = m[3], e = p[3]; \
+        const V p2 = VLOAD##sz(prev2 + o), n2 = VLOAD##sz(next2 + o); \
+        const V d = VSRA1(VADD(p2, n2)); \
+        const V temporal_diff0 = VABS(VSUB(p2, n2)); \
+        const V temporal_diff1 = \
+            VSRA1(VADD(VABS(VSUB(VLOAD##sz(prev + o + mrefs), c)), \
+                       VABS(VSUB(VLOAD##sz(prev + o + prefs), e)))); \
+        const V temporal_diff2 = \
+            VSRA1(VADD(VABS(VSUB(VLOAD##sz(next + o + mrefs), c)), \
+                       VABS(VSUB(VLOAD##sz(next + o + prefs), e)))); \
+        V diff = VMAX(VMAX(VSRA1(temporal_diff0), temporal_diff1), \
+                      temporal_diff2); \
+        V pred = VSRA1(VADD(c, e)); \
+        V score = VADD(YADIF_SCORE(0), ones); \
+        V mask; \
+ \
+        /* CHECK(-2) is only tried if CHECK(-1) succeeded, and so on */ \
+        mask = ones; \
+        YADIF_CHECK(-1, mask); \
+        YADIF_CHECK(-2, mask); \
+        mask = ones; \
+        YADIF_CHECK( 1, mask); \
+        YADIF_CHECK( 2, mask); \
+ \
+        if (mode < 2) { \
+            const V b = VSRA1(VADD(VLOAD##sz(prev2 + o + 2 * mrefs), \
+                                   VLOAD##sz(next2 + o + 2 * mrefs))); \
+            const V f = VSRA1(VADD(VLOAD##sz(prev2 + o + 2 * prefs), \
+                                   VLOAD##sz(next2 + o + 2 * prefs))); \
+            const V de = VSUB(d, e), dc = VSUB(d, c); \
+            const V bc = VSUB(b, c), fe = VSUB(f, e); \
+            const V max = VMAX(VMAX(de, dc), VMIN(bc, fe)); \
+            const V min = VMIN(VMIN(de, dc), VMAX(bc, fe)); \
+ \
+            diff = VMAX(VMAX(diff, min), VSUB(VSET1(0), max)); \
+        } \
+ \
+        /* diff is never negative */ \
+        pred = VMIN(VMAX(pred, VSUB(d, diff)), VADD(d, diff)); \
+        VSTORE##sz(dst + o, pred); \
+    } \
+ \
+    if (x < w) \
+        tail(dst + x * (sz), prev + x * (sz), cur + x * (sz), \
+             next + x * (sz), w - x, prefs, mrefs, parity, mode); \
+}
+#endif
+
+/*****************************************************************************
+ * SSE4.1
+ *****************************************************************************/
+#ifdef YADIF_SSE4_1
+#define V          __m128i
+#define VLANES     8
+#define VTARGET    YADIF_SSE4_1
+#define VLOAD1(p)  _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(p)))
+#define VLOAD2(p)  _mm_loadu_si128((const __m128i *)(p))
+#define VSTORE1(p, v) _mm_storel_epi64((__m128i *)(p), _mm_packus_epi16(v, v))
+#define VSTORE2(p, v) _mm_storeu_si128((__m128i *)(p), v)
+#define VSET1      _mm_set1_epi16
+#define VADD       _mm_add_epi16
+#define VSUB       _mm_sub_epi16
+#define VABS       _mm_abs_epi16
+#define VMIN       _mm_min_epi16
+#define VMAX       _mm_max_epi16
+#define VAND       _mm_and_si128
+#define VSRA1(v)   _mm_srai_epi16(v, 1)
+#define VLT(a, b)  _mm_cmplt_epi16(a, b)
+#define VSEL(a, b, mask) _mm_blendv_epi8(a, b, mask)
+
+YADIF_LINE(yadif_filter_line_sse4_1, 1, yadif_filter_line_c)
+YADIF_LINE(yadif_filter_line_sse4_1_16bit, 2, yadif_filter_line_c_16bit)
+
+#undef V
+#undef VLANES
+#undef VTARGET
+#undef VLOAD1
+#undef VLOAD2
+#undef VSTORE1
+#undef VSTORE2
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VABS
+#undef VMIN
+#undef VMAX
+#undef VAND
+#undef VSRA1
+#undef VLT
+#undef VSEL
+#endif
+
+/*****************************************************************************
+ * AVX2
+ *****************************************************************************/
+#ifdef YADIF_AVX2
+#define V          __m256i
+#define VLANES     16
+#define VTARGET    YADIF_AVX2
+#define VLOAD1(p)  _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+#define VLOAD2(p)  _mm256_loadu_si256((const __m256i *)(p))
+#define VSTORE1(p, v) \
+    _mm_storeu_si128((__m128i *)(p), \
+                     _mm_packus_epi16(_mm256_castsi256_si128(v), \
+                                      _mm256_extracti128_si256(v, 1)))
+#define VSTORE2(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+#define VSET1      _mm256_set1_epi16
+#define VADD       _mm256_add_epi16
+#define VSUB       _mm256_sub_epi16
+#define VABS       _mm256_abs_epi16
+#define VMIN       _mm256_min_epi16
+#define VMAX       _mm256_max_epi16
+#define VAND       _mm256_and_si256
+#define VSRA1(v)   _mm256_srai_epi16(v, 1)
+#define VLT(a, b)  _mm256_cmpgt_epi16(b, a)
+#define VSEL(a, b, mask) _mm256_blendv_epi8(a, b, mask)
+
+YADIF_LINE(yadif_filter_line_avx2, 1, yadif_filter_line_c)
+YADIF_LINE(yadif_filter_line_avx2_16bit, 2, yadif_filter_line_c_16bit)
+
+#undef V
+#undef VLANES
+#undef VTARGET
+#undef VLOAD1
+#undef VLOAD2
+#undef VSTORE1
+#undef VSTORE2
+#undef VSET1
+#undef VADD
+#undef VSUB
+#undef VABS
+#undef VMIN
+#undef VMAX
+#undef VAND
+#undef VSRA1
+#undef VLT
+#undef VSEL
+#endif
+
+yadif_line_t yadif_GetVectorLine( unsigned i_pixel_size )
+{
+    assert( i_pixel_size == 1 || i_pixel_size == 2 );
+
+#ifdef YADIF_AVX2
+    if( vlc_CPU_AVX2() )
+        return i_pixel_size == 1 ? yadif_filter_line_avx2
+                                 : yadif_filter_line_avx2_16bit;
+#endif
+#ifdef YADIF_SSE4_1
+    if( vlc_CPU_SSE4_1() )
+    {
+# ifdef HAVE_X86ASM
+        /* yadif_x86.asm does as well for 8-bit samples */
+        if( i_pixel_size == 1 )
+            return NULL;
+# endif
+        return i_pixel_size == 1 ? yadif_filter_line_sse4_1
+                                 : yadif_filter_line_sse4_1_16bit;
+    }
+#endif
+    VLC_UNUSED( i_pixel_size );
+    return NULL;
+}
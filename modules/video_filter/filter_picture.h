@@ -162,3 +162,36 @@ static inline picture_t *CopyInfoAndRelease( picture_t *p_outpic, picture_t *p_i
 
     return p_outpic;
 }
+
+/*****************************************************************************
+ * Slices
+ *****************************************************************************/
+/* Gets the lines of band i_slice out of i_slices of a plane */
+static inline void GetPlaneSlice( const plane_t *p_plane, unsigned i_slice,
+                                  unsigned i_slices, int *pi_first,
+                                  int *pi_last )
+{
+    *pi_first = p_plane->i_visible_lines * i_slice / i_slices;
+    *pi_last = p_plane->i_visible_lines * (i_slice + 1) / i_slices;
+}
+
+/* Sets the planes of p_slice to band i_slice out of i_slices of p_pic, so
+ * that whole picture routines can process a band. Only the format and the
+ * planes are valid in p_slice. */
+static inline void GetPictureSlice( picture_t *p_slice, const picture_t *p_pic,
+                                    unsigned i_slice, unsigned i_slices )
+{
+    p_slice->format = p_pic->format;
+    p_slice->i_planes = p_pic->i_planes;
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        const plane_t *p_plane = &p_pic->p[i];
+        int i_first, i_last;
+
+        GetPlaneSlice( p_plane, i_slice, i_slices, &i_first, &i_last );
+        p_slice->p[i] = *p_plane;
+        p_slice->p[i].p_pixels += i_first * p_plane->i_pitch;
+        p_slice->p[i].i_lines = i_last - i_first;
+        p_slice->p[i].i_visible_lines = i_last - i_first;
+    }
+}
@@ -98,6 +98,7 @@ typedef struct
 
     type_t *pt_distribution;
     type_t *pt_buffer;
+    size_t pi_buffer_offset[PICTURE_PLANE_MAX]; /* plane start in pt_buffer */
     type_t *pt_scale;
 } filter_sys_t;
 
@@ -186,12 +187,111 @@ static void Destroy( vlc_object_t *p_this )
     free( p_sys );
 }
 
+/* Parameters of a picture, shared by all its slices */
+typedef struct
+{
+    const picture_t *p_pic;
+    picture_t *p_outpic;
+} gaussianblur_slice_t;
+
+/* First pass: blur the lines of the band into pt_buffer */
+static void FilterHorizontal( filter_t *p_filter, void *opaque,
+                              unsigned i_slice, unsigned i_slices )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const gaussianblur_slice_t *p_job = opaque;
+    const picture_t *p_pic = p_job->p_pic;
+    const int i_dim = p_sys->i_dim;
+    const type_t *pt_distribution = p_sys->pt_distribution;
+
+    for( int i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
+    {
+        type_t *pt_buffer = p_sys->pt_buffer + p_sys->pi_buffer_offset[i_plane];
+        const uint8_t *p_in = p_pic->p[i_plane].p_pixels;
+
+        const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
+        const int i_in_pitch = p_pic->p[i_plane].i_pitch;
+
+        const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
+
+        int i_first, i_last;
+        GetPlaneSlice( &p_pic->p[i_plane], i_slice, i_slices,
+                       &i_first, &i_last );
+
+        for( int i_line = i_first; i_line < i_last; i_line++ )
+        {
+            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
+            {
+                type_t t_value = 0;
+                const int c = i_line*i_in_pitch+i_col;
+                for( int x = __MAX( -i_dim, -i_col*(x_factor+1) );
+                     x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
+                     x++ )
+                {
+                    t_value += pt_distribution[x+i_dim] *
+                               p_in[c+(x>>x_factor)];
+                }
+                pt_buffer[c] = t_value;
+            }
+        }
+    }
+}
+
+/* Second pass: blur the columns of pt_buffer into the band of the output */
+static void FilterVertical( filter_t *p_filter, void *opaque,
+                            unsigned i_slice, unsigned i_slices )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const gaussianblur_slice_t *p_job = opaque;
+    const picture_t *p_pic = p_job->p_pic;
+    picture_t *p_outpic = p_job->p_outpic;
+    const int i_dim = p_sys->i_dim;
+    const type_t *pt_distribution = p_sys->pt_distribution;
+    const type_t *pt_scale = p_sys->pt_scale;
+
+    for( int i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
+    {
+        const type_t *pt_buffer =
+            p_sys->pt_buffer + p_sys->pi_buffer_offset[i_plane];
+        uint8_t *p_out = p_outpic->p[i_plane].p_pixels;
+
+        const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
+        const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
+        const int i_in_pitch = p_pic->p[i_plane].i_pitch;
+
+        const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
+        const int y_factor = p_pic->p[Y_PLANE].i_visible_lines/i_visible_lines-1;
+
+        int i_first, i_last;
+        GetPlaneSlice( &p_pic->p[i_plane], i_slice, i_slices,
+                       &i_first, &i_last );
+
+        for( int i_line = i_first; i_line < i_last; i_line++ )
+        {
+            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
+            {
+                type_t t_value = 0;
+                const int c = i_line*i_in_pitch+i_col;
+                for( int y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
+                     y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
+                     y++ )
+                {
+                    t_value += pt_distribution[y+i_dim] *
+                               pt_buffer[c+(y>>y_factor)*i_in_pitch];
+                }
+
+                const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_in_pitch<<x_factor)+(i_col<<x_factor)];
+                p_out[i_line * p_outpic->p[i_plane].i_pitch + i_col] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
+            }
+        }
+    }
+}
+
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     picture_t *p_outpic;
     filter_sys_t *p_sys = p_filter->p_sys;
     const int i_dim = p_sys->i_dim;
-    type_t *pt_buffer;
     type_t *pt_scale;
     const type_t *pt_distribution = p_sys->pt_distribution;
 
@@ -205,12 +305,23 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     }
     if( !p_sys->pt_buffer )
     {
-        p_sys->pt_buffer = realloc_or_free( p_sys->pt_buffer,
-                               p_pic->p[Y_PLANE].i_visible_lines *
-                               p_pic->p[Y_PLANE].i_pitch * sizeof( type_t ) );
+        /* One area per plane, as the slices cover all the planes */
+        size_t i_size = 0;
+        for( int i_plane = 0; i_plane < p_pic->i_planes; i_plane++ )
+        {
+            p_sys->pi_buffer_offset[i_plane] = i_size;
+            i_size += p_pic->p[i_plane].i_visible_lines *
+                      p_pic->p[i_plane].i_pitch;
+        }
+        p_sys->pt_buffer = vlc_alloc( i_size, sizeof( type_t ) );
+        if( !p_sys->pt_buffer )
+        {
+            picture_Release( p_outpic );
+            picture_Release( p_pic );
+            return NULL;
+        }
     }
 
-    pt_buffer = p_sys->pt_buffer;
     if( !p_sys->pt_scale )
     {
         const int i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
@@ -243,55 +354,10 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         }
     }
 
-    pt_scale = p_sys->pt_scale;
-    for( int i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
-    {
-
-        uint8_t *p_in = p_pic->p[i_plane].p_pixels;
-        uint8_t *p_out = p_outpic->p[i_plane].p_pixels;
-
-        const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
-        const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
-        const int i_in_pitch = p_pic->p[i_plane].i_pitch;
-
-        const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
-        const int y_factor = p_pic->p[Y_PLANE].i_visible_lines/i_visible_lines-1;
-
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
-        {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-                const int c = i_line*i_in_pitch+i_col;
-                for( int x = __MAX( -i_dim, -i_col*(x_factor+1) );
-                     x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
-                     x++ )
-                {
-                    t_value += pt_distribution[x+i_dim] *
-                               p_in[c+(x>>x_factor)];
-                }
-                pt_buffer[c] = t_value;
-            }
-        }
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
-        {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-                const int c = i_line*i_in_pitch+i_col;
-                for( int y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
-                     y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
-                     y++ )
-                {
-                    t_value += pt_distribution[y+i_dim] *
-                               pt_buffer[c+(y>>y_factor)*i_in_pitch];
-                }
-
-                const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_in_pitch<<x_factor)+(i_col<<x_factor)];
-                p_out[i_line * p_outpic->p[i_plane].i_pitch + i_col] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
-            }
-        }
-    }
+    /* The vertical pass reads lines blurred by other slices */
+    gaussianblur_slice_t job = { .p_pic = p_pic, .p_outpic = p_outpic };
+    filter_ExecuteSlices( p_filter, FilterHorizontal, &job, 0 );
+    filter_ExecuteSlices( p_filter, FilterVertical, &job, 0 );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
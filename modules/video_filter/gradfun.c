@@ -108,6 +108,7 @@ typedef struct
     int              radius;
     const vlc_chroma_description_t *chroma;
     struct vf_priv_s cfg;
+    size_t           buf_size; /* per plane, in cfg.buf */
 } filter_sys_t;
 
 static int Open(vlc_object_t *object)
@@ -172,6 +173,42 @@ static void Close(vlc_object_t *object)
     free(sys);
 }
 
+typedef struct
+{
+    const picture_t *src;
+    picture_t       *dst;
+} gradfun_slice_t;
+
+static void FilterPlane(filter_t *filter, void *opaque,
+                        unsigned i, unsigned planes)
+{
+    const gradfun_slice_t *job = opaque;
+    filter_sys_t *sys = filter->p_sys;
+    const video_format_t *fmt = &filter->fmt_in.video;
+    const plane_t *srcp = &job->src->p[i];
+    plane_t       *dstp = &job->dst->p[i];
+
+    /* The blur is a running sum along the lines, so the planes are the
+     * slices, each with its own scratch buffer */
+    struct vf_priv_s cfg = sys->cfg;
+    if (cfg.buf)
+        cfg.buf += i * sys->buf_size;
+    VLC_UNUSED(planes);
+
+    const vlc_chroma_description_t *chroma = sys->chroma;
+    int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
+    int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
+    int r = (cfg.radius  * chroma->p[i].w.num / chroma->p[i].w.den +
+             cfg.radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
+    r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
+    if (__MIN(w, h) > 2 * r && cfg.buf) {
+        filter_plane(&cfg, dstp->p_pixels, srcp->p_pixels,
+                     w, h, dstp->i_pitch, srcp->i_pitch, r);
+    } else {
+        plane_CopyPixels(dstp, srcp);
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     filter_sys_t *sys = filter->p_sys;
@@ -193,27 +230,16 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     cfg->thresh = (1 << 15) / strength;
     if (cfg->radius != radius) {
         cfg->radius = radius;
-        cfg->buf    = aligned_alloc(16,
-                                   (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) * sizeof(*cfg->buf));
+        /* keep each plane buffer 16-bytes aligned */
+        sys->buf_size = ((((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2
+                         + 32) + 7) & ~7;
+        aligned_free(cfg->buf);
+        cfg->buf    = aligned_alloc(16, PICTURE_PLANE_MAX * sys->buf_size
+                                        * sizeof(*cfg->buf));
     }
 
-    for (int i = 0; i < dst->i_planes; i++) {
-        const plane_t *srcp = &src->p[i];
-        plane_t       *dstp = &dst->p[i];
-
-        const vlc_chroma_description_t *chroma = sys->chroma;
-        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
-        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
-        int r = (cfg->radius  * chroma->p[i].w.num / chroma->p[i].w.den +
-                 cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
-        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
-        if (__MIN(w, h) > 2 * r && cfg->buf) {
-            filter_plane(cfg, dstp->p_pixels, srcp->p_pixels,
-                         w, h, dstp->i_pitch, srcp->i_pitch, r);
-        } else {
-            plane_CopyPixels(dstp, srcp);
-        }
-    }
+    gradfun_slice_t job = { .src = src, .dst = dst };
+    filter_ExecuteSlices(filter, FilterPlane, &job, dst->i_planes);
 
     picture_CopyProperties(dst, src);
     picture_Release(src);
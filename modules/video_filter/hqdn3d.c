@@ -137,11 +137,14 @@ static int Open(vlc_object_t *this)
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
     }
-    cfg->Line = malloc(wmax*sizeof(unsigned int));
-    if (!cfg->Line) {
+    /* One line buffer per plane, as planes are denoised concurrently */
+    cfg->Line[0] = malloc(3*wmax*sizeof(unsigned int));
+    if (!cfg->Line[0]) {
         free(sys);
         return VLC_ENOMEM;
     }
+    cfg->Line[1] = cfg->Line[0] + wmax;
+    cfg->Line[2] = cfg->Line[1] + wmax;
 
     config_ChainParse(filter, FILTER_PREFIX, filter_options,
                       filter->p_cfg);
@@ -182,10 +185,36 @@ static void Close(vlc_object_t *this)
     for (int i = 0; i < 3; ++i) {
         free(cfg->Frame[i]);
     }
-    free(cfg->Line);
+    free(cfg->Line[0]);
     free(sys);
 }
 
+/*****************************************************************************
+ * FilterPlane
+ *****************************************************************************/
+typedef struct
+{
+    const picture_t *src;
+    picture_t *dst;
+} hqdn3d_slice_t;
+
+static void FilterPlane(filter_t *filter, void *opaque,
+                        unsigned plane, unsigned planes)
+{
+    const hqdn3d_slice_t *job = opaque;
+    filter_sys_t *sys = filter->p_sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+    /* luma coefficients for the first plane, chroma for the others */
+    int *spat = cfg->Coefs[plane ? 2 : 0];
+    int *temp = cfg->Coefs[plane ? 3 : 1];
+
+    VLC_UNUSED(planes);
+    deNoise(job->src->p[plane].p_pixels, job->dst->p[plane].p_pixels,
+            cfg->Line[plane], &cfg->Frame[plane], sys->w[plane], sys->h[plane],
+            job->src->p[plane].i_pitch, job->dst->p[plane].i_pitch,
+            spat, spat, temp);
+}
+
 /*****************************************************************************
  * Filter
  *****************************************************************************/
@@ -218,24 +247,10 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     }
     vlc_mutex_unlock( &sys->coefs_mutex );
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
+    /* The spatial filter is recursive along the lines, so the planes are
+     * the slices */
+    hqdn3d_slice_t job = { .src = src, .dst = dst };
+    filter_ExecuteSlices(filter, FilterPlane, &job, 3);
 
     if(unlikely(!cfg->Frame[0] || !cfg->Frame[1] || !cfg->Frame[2]))
     {
@@ -31,8 +31,11 @@
 //===========================================================================//
 
 struct vf_priv_s {
-        int Coefs[4][512*16];
-        unsigned int *Line;
+        /* The previous frame has 8 more bits of precision, so temporal
+         * differences up to 255.996 index up to 16 entries past 255:
+         * those stay null, as for 255 */
+        int Coefs[4][512*16+16];
+        unsigned int *Line[3];
         unsigned short *Frame[3];
 };
 
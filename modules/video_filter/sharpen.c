@@ -168,11 +168,12 @@ static void Destroy( vlc_object_t *p_this )
         const unsigned data_sz = sizeof(data_t);                        \
         const int i_src_line_len = p_pic->p[Y_PLANE].i_pitch / data_sz; \
         const int i_out_line_len = p_outpic->p[Y_PLANE].i_pitch / data_sz; \
-        const int sigma = atomic_load(&p_sys->sigma);         \
                                                                         \
-        memcpy(p_out, p_src, i_visible_pitch);                          \
+        if( i_first == 0 )                                              \
+            memcpy(p_out, p_src, i_visible_pitch);                      \
                                                                         \
-        for( unsigned i = 1; i < i_visible_lines - 1; i++ )             \
+        for( unsigned i = __MAX(i_first, 1u);                           \
+             i < __MIN(i_last, i_visible_lines - 1); i++ )              \
         {                                                               \
             p_out[i * i_out_line_len] = p_src[i * i_src_line_len];      \
                                                                         \
@@ -199,18 +200,54 @@ static void Destroy( vlc_object_t *p_this )
             p_out[i * i_out_line_len + i_visible_pitch / data_sz - 1] = \
                 p_src[i * i_src_line_len + i_visible_pitch / data_sz - 1];  \
         }                                                               \
-        memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],          \
-               &p_src[(i_visible_lines - 1) * i_src_line_len],          \
-               i_visible_pitch);                                        \
+        if( i_last == i_visible_lines )                                 \
+            memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],      \
+                   &p_src[(i_visible_lines - 1) * i_src_line_len],      \
+                   i_visible_pitch);                                    \
     } while (0)
 
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+/* Parameters of a picture, shared by all its slices */
+typedef struct
 {
+    const picture_t *p_pic;
     picture_t *p_outpic;
+    int sigma;
+} sharpen_slice_t;
+
+static void FilterSlice( filter_t *p_filter, void *opaque,
+                         unsigned i_slice, unsigned i_slices )
+{
+    const sharpen_slice_t *p_job = opaque;
+    const picture_t *p_pic = p_job->p_pic;
+    picture_t *p_outpic = p_job->p_outpic;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
+    const int sigma = p_job->sigma;
     const unsigned i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
     const unsigned i_visible_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
+    int first, last;
+
+    VLC_UNUSED(p_filter);
+    GetPlaneSlice( &p_pic->p[Y_PLANE], i_slice, i_slices, &first, &last );
+
+    const unsigned i_first = first, i_last = last;
+
+    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
+        SHARPEN_FRAME(255, uint8_t);
+    else
+        SHARPEN_FRAME(1023, uint16_t);
+
+    /* The chroma planes are copied band by band too */
+    picture_t in, out;
+    GetPictureSlice( &in, p_pic, i_slice, i_slices );
+    GetPictureSlice( &out, p_outpic, i_slice, i_slices );
+    plane_CopyPixels( &out.p[U_PLANE], &in.p[U_PLANE] );
+    plane_CopyPixels( &out.p[V_PLANE], &in.p[V_PLANE] );
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
 
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
@@ -220,14 +257,13 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     }
 
     filter_sys_t *p_sys = p_filter->p_sys;
+    sharpen_slice_t job = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .sigma = atomic_load(&p_sys->sigma),
+    };
 
-    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
-        SHARPEN_FRAME(255, uint8_t);
-    else
-        SHARPEN_FRAME(1023, uint16_t);
-
-    plane_CopyPixels( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE] );
-    plane_CopyPixels( &p_outpic->p[V_PLANE], &p_pic->p[V_PLANE] );
+    filter_ExecuteSlices( p_filter, FilterSlice, &job, 0 );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
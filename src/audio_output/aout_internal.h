@@ -121,6 +121,7 @@ aout_volume_t *aout_volume_New(vlc_object_t *, const audio_replay_gain_t *);
 #define aout_volume_New(o, g) aout_volume_New(VLC_OBJECT(o), g)
 int aout_volume_SetFormat(aout_volume_t *, vlc_fourcc_t);
 void aout_volume_SetVolume(aout_volume_t *, float);
+float aout_volume_GetGain(aout_volume_t *);
 int aout_volume_Amplify(aout_volume_t *, block_t *);
 void aout_volume_Delete(aout_volume_t *);
 
@@ -191,6 +192,8 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *, const vlc_clock_t *,
                                          const aout_filters_cfg_t *cfg) VLC_USED;
 void aout_FiltersResetClock(aout_filters_t *filters);
 void aout_FiltersSetClockDelay(aout_filters_t *filters, vlc_tick_t delay);
+void aout_FiltersSetGain(aout_filters_t *filters, float gain);
+bool aout_FiltersAmplified(aout_filters_t *filters);
 bool aout_FiltersCanResample (aout_filters_t *filters);
 
 #endif /* !LIBVLC_AOUT_INTERNAL_H */
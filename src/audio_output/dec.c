@@ -450,6 +450,8 @@ int aout_DecPlay(audio_output_t *aout, block_t *block)
             vlc_mutex_unlock (&owner->vp.lock);
         }
 
+        aout_FiltersSetGain(owner->filters,
+                            aout_volume_GetGain(owner->volume));
         block = aout_FiltersPlay(owner->filters, block, owner->sync.rate);
         if (block == NULL)
             return ret;
@@ -458,8 +460,9 @@ int aout_DecPlay(audio_output_t *aout, block_t *block)
     const vlc_tick_t original_pts = owner->original_pts;
     owner->original_pts = VLC_TICK_INVALID;
 
-    /* Software volume */
-    aout_volume_Amplify (owner->volume, block);
+    /* Software volume, unless the filters applied it already */
+    if (owner->filters == NULL || !aout_FiltersAmplified(owner->filters))
+        aout_volume_Amplify (owner->volume, block);
 
     /* Update delay */
     if (owner->sync.request_delay != owner->sync.delay)
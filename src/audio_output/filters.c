@@ -40,7 +40,8 @@
 #include "aout_internal.h"
 #include "../video_output/vout_internal.h" /* for vout_Request */
 
-static filter_t *CreateFilter(vlc_object_t *obj, vlc_clock_t *clock,
+static filter_t *CreateFilter(vlc_object_t *obj,
+                              const filter_owner_t *owner,
                               const char *type, const char *name,
                               const audio_sample_format_t *infmt,
                               const audio_sample_format_t *outfmt,
@@ -50,7 +51,8 @@ static filter_t *CreateFilter(vlc_object_t *obj, vlc_clock_t *clock,
     if (unlikely(filter == NULL))
         return NULL;
 
-    filter->owner.sys = clock;
+    if (owner != NULL)
+        filter->owner = *owner;
     filter->p_cfg = cfg;
     filter->fmt_in.audio = *infmt;
     filter->fmt_in.i_codec = infmt->i_format;
@@ -88,10 +90,11 @@ static filter_t *CreateFilter(vlc_object_t *obj, vlc_clock_t *clock,
 }
 
 static filter_t *FindConverter (vlc_object_t *obj,
+                                const filter_owner_t *owner,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
-    return CreateFilter(obj, NULL, "audio converter", NULL, infmt, outfmt,
+    return CreateFilter(obj, owner, "audio converter", NULL, infmt, outfmt,
                         NULL, true);
 }
 
@@ -120,7 +123,8 @@ static void aout_FiltersPipelineDestroy(filter_t *const *filters, unsigned n)
     }
 }
 
-static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
+static filter_t *TryFormat (vlc_object_t *obj, const filter_owner_t *owner,
+                            vlc_fourcc_t codec,
                             audio_sample_format_t *restrict fmt)
 {
     audio_sample_format_t output = *fmt;
@@ -129,7 +133,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
     output.i_format = codec;
     aout_FormatPrepare (&output);
 
-    filter_t *filter = FindConverter (obj, fmt, &output);
+    filter_t *filter = FindConverter (obj, owner, fmt, &output);
     if (filter != NULL)
         *fmt = output;
     return filter;
@@ -143,13 +147,15 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
  * @param max size of filters table [IN]
  * @param infmt input audio format
  * @param outfmt output audio format
+ * @param owner owner of the filters, if converting to FL32 with the software
+ *              gain, or NULL
  * @return 0 on success, -1 on failure
  */
 static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
                                       unsigned *count, unsigned max,
                                  const audio_sample_format_t *restrict infmt,
                                  const audio_sample_format_t *restrict outfmt,
-                                 bool headphones)
+                                 const filter_owner_t *owner, bool headphones)
 {
     aout_FormatsPrint (obj, "conversion:", infmt, outfmt);
     max -= *count;
@@ -161,6 +167,9 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
     audio_sample_format_t input = *infmt;
     unsigned n = 0;
 
+    if (outfmt->i_format != VLC_CODEC_FL32)
+        owner = NULL;
+
     if (!AOUT_FMT_LINEAR(&input))
     {
         msg_Err(obj, "Can't convert non linear input");
@@ -177,7 +186,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
             if (n == max)
                 goto overflow;
 
-            filter_t *f = TryFormat (obj, VLC_CODEC_FL32, &input);
+            filter_t *f = TryFormat (obj, NULL, VLC_CODEC_FL32, &input);
             if (f == NULL)
             {
                 msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -206,7 +215,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         config_chain_t *cfg = NULL;
         if (headphones)
             config_ChainParseOptions(&cfg, "{headphones=true}");
-        filter_t *f = CreateFilter(obj, NULL, filter_type, NULL,
+        filter_t *f = CreateFilter(obj, owner, filter_type, NULL,
                                    &input, &output, cfg, true);
         if (cfg)
             config_ChainDestroy(cfg);
@@ -231,7 +240,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         audio_sample_format_t output = input;
         output.i_rate = outfmt->i_rate;
 
-        filter_t *f = FindConverter (obj, &input, &output);
+        filter_t *f = FindConverter (obj, owner, &input, &output);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -249,7 +258,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         if (max == 0)
             goto overflow;
 
-        filter_t *f = TryFormat (obj, outfmt->i_format, &input);
+        filter_t *f = TryFormat (obj, owner, outfmt->i_format, &input);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -349,12 +358,32 @@ struct aout_filters
     filter_t *resampler; /**< The resampler */
     int resampling; /**< Current resampling (Hz) */
     vlc_clock_t *clock;
+    float gain; /**< Software gain of the next block */
+    filter_t *gain_filter; /**< Last stage, which may apply the gain */
+    bool amplified; /**< Whether the last stage applies the gain */
 
     unsigned count; /**< Number of filters */
     filter_t *tab[AOUT_MAX_FILTERS]; /**< Configured user filters
         (e.g. equalization) and their conversions */
 };
 
+static float aout_FiltersGetGain(filter_t *filter)
+{
+    aout_filters_t *filters = filter->owner.sys;
+
+    /* Only the last stage of the chain applies the gain. Once it took it,
+     * every output sample went through it, drained or resampled ones
+     * included. */
+    if (filter != filters->gain_filter)
+        return 1.f;
+    filters->amplified = true;
+    return filters->gain;
+}
+
+static const struct filter_audio_callbacks aout_filters_callbacks = {
+    .get_gain = aout_FiltersGetGain,
+};
+
 /** Callback for visualization selection */
 static int VisualizationCallback (vlc_object_t *obj, const char *var,
                                   vlc_value_t oldval, vlc_value_t newval,
@@ -415,7 +444,8 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
         return -1;
     }
 
-    filter_t *filter = CreateFilter(obj, filters->clock, type, name,
+    const filter_owner_t owner = { .sys = filters->clock };
+    filter_t *filter = CreateFilter(obj, &owner, type, name,
                                     infmt, outfmt, cfg, false);
     if (filter == NULL)
     {
@@ -425,7 +455,8 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
 
     /* convert to the filter input format if necessary */
     if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                                    max - 1, infmt, &filter->fmt_in.audio, false))
+                                    max - 1, infmt, &filter->fmt_in.audio,
+                                    NULL, false))
     {
         msg_Err (filter, "cannot add user %s \"%s\" (skipped)", type, name);
         module_unneed (filter, filter->p_module);
@@ -498,6 +529,9 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
     filters->rate_filter = NULL;
     filters->resampler = NULL;
     filters->resampling = 0;
+    filters->gain = 1.f;
+    filters->gain_filter = NULL;
+    filters->amplified = false;
     filters->count = 0;
     if (clock)
     {
@@ -521,7 +555,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
         if (!AOUT_FMTS_IDENTICAL(infmt, outfmt))
         {
             aout_FormatsPrint (obj, "pass-through:", infmt, outfmt);
-            filters->tab[0] = FindConverter(obj, infmt, outfmt);
+            filters->tab[0] = FindConverter(obj, NULL, infmt, outfmt);
             if (filters->tab[0] == NULL)
             {
                 msg_Err (obj, "cannot setup pass-through");
@@ -547,7 +581,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
         output_format.i_rate = input_format.i_rate;
         if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
                                   AOUT_MAX_FILTERS, &input_format, &output_format,
-                                  cfg->headphones))
+                                  NULL, cfg->headphones))
         {
             msg_Warn (obj, "cannot setup audio renderer pipeline");
             /* Fallback to bitmap without any conversions */
@@ -569,7 +603,8 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
         audio_sample_format_t input_phys_format = input_format;
         aout_SetWavePhysicalChannels(&input_phys_format);
 
-        filter_t *f = FindConverter (obj, &input_format, &input_phys_format);
+        filter_t *f = FindConverter (obj, NULL, &input_format,
+                                     &input_phys_format);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find channel converter");
@@ -619,14 +654,23 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
                      &input_format, &output_format, NULL);
     free(visual);
 
-    /* convert to the output format (minus resampling) if necessary */
+    /* convert to the output format (minus resampling) if necessary; the last
+     * converter or channel mixer can apply the software gain on the way */
+    const filter_owner_t owner = {
+        .audio = &aout_filters_callbacks,
+        .sys = filters,
+    };
+    const unsigned count = filters->count;
     output_format.i_rate = input_format.i_rate;
     if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                              AOUT_MAX_FILTERS, &input_format, &output_format, false))
+                              AOUT_MAX_FILTERS, &input_format, &output_format,
+                              &owner, false))
     {
         msg_Err (obj, "cannot setup filtering pipeline");
         goto error;
     }
+    if (filters->count > count)
+        filters->gain_filter = filters->tab[filters->count - 1];
     input_format = output_format;
 
     /* insert the resampler */
@@ -699,6 +743,24 @@ void aout_FiltersDelete (vlc_object_t *obj, aout_filters_t *filters)
     free (filters);
 }
 
+/**
+ * Sets the software gain that the filters chain may apply to the next
+ * blocks, on its way to the output format.
+ */
+void aout_FiltersSetGain(aout_filters_t *filters, float gain)
+{
+    filters->gain = gain;
+}
+
+/**
+ * Tells whether the software gain was applied by the filters chain, so that
+ * the output blocks must not be amplified again.
+ */
+bool aout_FiltersAmplified(aout_filters_t *filters)
+{
+    return filters->amplified;
+}
+
 bool aout_FiltersCanResample (aout_filters_t *filters)
 {
     return (filters->resampler != NULL);
@@ -127,6 +127,17 @@ void aout_volume_SetVolume(aout_volume_t *vol, float factor)
     vol->output_factor = factor;
 }
 
+/**
+ * Returns the replay gain and software volume multiplier.
+ */
+float aout_volume_GetGain(aout_volume_t *vol)
+{
+    if (unlikely(vol == NULL) || vol->module == NULL)
+        return 1.f;
+
+    return vol->output_factor * atomic_load(&vol->gain_factor);
+}
+
 /**
  * Applies replay gain and software volume to an audio buffer.
  */
@@ -135,9 +146,7 @@ int aout_volume_Amplify(aout_volume_t *vol, block_t *block)
     if (unlikely(vol == NULL) || vol->module == NULL)
         return -1;
 
-    float amp = vol->output_factor * atomic_load(&vol->gain_factor);
-
-    vol->object.amplify(&vol->object, block, amp);
+    vol->object.amplify(&vol->object, block, aout_volume_GetGain(vol));
     return 0;
 }
 
@@ -32,6 +32,7 @@
 #include <fcntl.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
 
@@ -105,6 +106,320 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+static_assert ((BLOCK_PADDING % BLOCK_ALIGN) == 0,
+               "BLOCK_PADDING must be a multiple of BLOCK_ALIGN");
+
+/*
+ * Block cache
+ *
+ * Small blocks are allocated with a payload size rounded up to a power of two
+ * (size class). Released small blocks are kept in a per-thread cache, so that
+ * the many short-lived packet blocks do not go through the heap. When a thread
+ * cache is full, half of it is moved to a shared depot, from which other
+ * threads (typically the producer of those blocks) refill their own cache.
+ */
+#if defined (__SANITIZE_ADDRESS__)
+# define BLOCK_CACHE_DISABLED
+#elif defined (__has_feature)
+# if __has_feature(address_sanitizer)
+#  define BLOCK_CACHE_DISABLED
+# endif
+#endif
+
+#ifndef BLOCK_CACHE_DISABLED
+
+/** Smallest size class (256 bytes) */
+#define BLOCK_CACHE_MIN_SHIFT 8
+/** Number of size classes (up to 32 KiB) */
+#define BLOCK_CACHE_CLASSES   8
+/** Maximum bytes of each size class in each thread cache */
+#define BLOCK_CACHE_THREAD_SIZE (64 << 10)
+/** Maximum bytes of each size class in the shared depot */
+#define BLOCK_CACHE_DEPOT_SIZE  (1 << 20)
+/** Allocations between two updates of the global statistics */
+#define BLOCK_CACHE_STATS_PERIOD 256
+
+struct block_cache_list
+{
+    block_t *first;
+    unsigned count;
+};
+
+struct block_cache
+{
+    struct block_cache_list classes[BLOCK_CACHE_CLASSES];
+    /* Statistics not yet accounted globally */
+    unsigned hits;
+    unsigned misses;
+    ssize_t cached;
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    struct block_cache_list classes[BLOCK_CACHE_CLASSES];
+} block_depot = { VLC_STATIC_MUTEX, { { NULL, 0 } } };
+
+static atomic_uint_fast64_t block_cache_hits = ATOMIC_VAR_INIT(0);
+static atomic_uint_fast64_t block_cache_misses = ATOMIC_VAR_INIT(0);
+static atomic_size_t block_cache_cached = ATOMIC_VAR_INIT(0);
+
+static size_t block_cache_ClassSize(unsigned cls)
+{
+    return (size_t)1 << (cls + BLOCK_CACHE_MIN_SHIFT);
+}
+
+/** Returns the size class of a payload size, or BLOCK_CACHE_CLASSES */
+static unsigned block_cache_Class(size_t size)
+{
+    unsigned cls = 0;
+
+    while (cls < BLOCK_CACHE_CLASSES && size > block_cache_ClassSize(cls))
+        cls++;
+    return cls;
+}
+
+static unsigned block_cache_ThreadMax(unsigned cls)
+{
+    return BLOCK_CACHE_THREAD_SIZE >> (cls + BLOCK_CACHE_MIN_SHIFT);
+}
+
+static unsigned block_cache_DepotMax(unsigned cls)
+{
+    return BLOCK_CACHE_DEPOT_SIZE >> (cls + BLOCK_CACHE_MIN_SHIFT);
+}
+
+static void block_cache_FlushStats(struct block_cache *cache)
+{
+    atomic_fetch_add_explicit(&block_cache_hits, cache->hits,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&block_cache_misses, cache->misses,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&block_cache_cached, cache->cached,
+                              memory_order_relaxed);
+    cache->hits = cache->misses = 0;
+    cache->cached = 0;
+}
+
+/** Moves up to count blocks from the head of a list to another one */
+static void block_cache_Move(struct block_cache_list *restrict dst,
+                             struct block_cache_list *restrict src,
+                             unsigned count)
+{
+    while (count-- > 0 && src->first != NULL)
+    {
+        block_t *block = src->first;
+
+        src->first = block->p_next;
+        src->count--;
+        block->p_next = dst->first;
+        dst->first = block;
+        dst->count++;
+    }
+}
+
+static thread_local struct block_cache *block_cache_local;
+/* Set once the cache of the thread is destroyed: during thread exit, the
+ * blocks still released by other thread-specific destructors are freed
+ * directly, rather than creating a new cache that would leak. */
+static thread_local bool block_cache_destroyed;
+
+static void block_cache_Destroy(void *data)
+{
+    struct block_cache *cache = data;
+
+    /* Hand the blocks of the exiting thread over to the depot */
+    vlc_mutex_lock(&block_depot.lock);
+    for (unsigned cls = 0; cls < BLOCK_CACHE_CLASSES; cls++)
+    {
+        struct block_cache_list *list = &cache->classes[cls];
+        struct block_cache_list *depot = &block_depot.classes[cls];
+        unsigned room = block_cache_DepotMax(cls) - __MIN(depot->count,
+                                                   block_cache_DepotMax(cls));
+
+        block_cache_Move(depot, list, room);
+    }
+    vlc_mutex_unlock(&block_depot.lock);
+
+    for (unsigned cls = 0; cls < BLOCK_CACHE_CLASSES; cls++)
+    {
+        struct block_cache_list *list = &cache->classes[cls];
+
+        while (list->first != NULL)
+        {
+            block_t *block = list->first;
+
+            list->first = block->p_next;
+            cache->cached -= block_cache_ClassSize(cls);
+            free(block);
+        }
+    }
+    block_cache_FlushStats(cache);
+    free(cache);
+    block_cache_local = NULL;
+    block_cache_destroyed = true;
+}
+
+static vlc_threadvar_t block_cache_key;
+static bool block_cache_key_created;
+
+static void block_cache_Init(void)
+{
+    if (vlc_threadvar_create(&block_cache_key, block_cache_Destroy))
+        abort();
+    block_cache_key_created = true;
+}
+
+#ifdef __GNUC__
+/* Frees the depot when libvlccore is unloaded. The caches of the threads
+ * still running are leaked, as they cannot be reached from here. */
+__attribute__((destructor))
+static void block_cache_Deinit(void)
+{
+    if (!block_cache_key_created)
+        return;
+
+    vlc_threadvar_delete(&block_cache_key);
+
+    vlc_mutex_lock(&block_depot.lock);
+    for (unsigned cls = 0; cls < BLOCK_CACHE_CLASSES; cls++)
+    {
+        struct block_cache_list *depot = &block_depot.classes[cls];
+
+        while (depot->first != NULL)
+        {
+            block_t *block = depot->first;
+
+            depot->first = block->p_next;
+            free(block);
+        }
+        depot->count = 0;
+    }
+    vlc_mutex_unlock(&block_depot.lock);
+}
+#endif
+
+static struct block_cache *block_cache_Get(void)
+{
+    struct block_cache *cache = block_cache_local;
+
+    if (likely(cache != NULL))
+        return cache;
+    if (unlikely(block_cache_destroyed))
+        return NULL;
+
+    static vlc_once_t once = VLC_STATIC_ONCE;
+    vlc_once(&once, block_cache_Init);
+
+    cache = calloc(1, sizeof (*cache));
+    if (unlikely(cache == NULL))
+        return NULL;
+    if (vlc_threadvar_set(block_cache_key, cache))
+    {
+        free(cache);
+        return NULL;
+    }
+    block_cache_local = cache;
+    return cache;
+}
+
+static block_t *block_cache_Pop(unsigned cls)
+{
+    struct block_cache *cache = block_cache_Get();
+    if (unlikely(cache == NULL))
+        return NULL;
+
+    struct block_cache_list *list = &cache->classes[cls];
+
+    if (list->first == NULL)
+    {   /* Refill half of the thread cache from the depot */
+        vlc_mutex_lock(&block_depot.lock);
+        block_cache_Move(list, &block_depot.classes[cls],
+                         block_cache_ThreadMax(cls) / 2);
+        vlc_mutex_unlock(&block_depot.lock);
+    }
+
+    block_t *block = list->first;
+    if (block != NULL)
+    {
+        list->first = block->p_next;
+        list->count--;
+        cache->hits++;
+        cache->cached -= block_cache_ClassSize(cls);
+    }
+    else
+        cache->misses++;
+
+    if (cache->hits + cache->misses >= BLOCK_CACHE_STATS_PERIOD)
+        block_cache_FlushStats(cache);
+    return block;
+}
+
+/** Keeps a block for reuse, returns false if it should be freed */
+static bool block_cache_Push(unsigned cls, block_t *block)
+{
+    struct block_cache *cache = block_cache_Get();
+    if (unlikely(cache == NULL))
+        return false;
+
+    struct block_cache_list *list = &cache->classes[cls];
+    const unsigned max = block_cache_ThreadMax(cls);
+
+    if (list->count >= max)
+    {   /* Move half of the thread cache to the depot */
+        struct block_cache_list *depot = &block_depot.classes[cls];
+        bool full;
+
+        vlc_mutex_lock(&block_depot.lock);
+        full = depot->count >= block_cache_DepotMax(cls);
+        if (!full)
+            block_cache_Move(depot, list, max / 2);
+        vlc_mutex_unlock(&block_depot.lock);
+
+        if (full)
+            return false;
+    }
+
+    block->p_next = list->first;
+    list->first = block;
+    list->count++;
+    cache->cached += block_cache_ClassSize(cls);
+    return true;
+}
+
+static void block_cached_Release (block_t *block)
+{
+    assert (block->p_start == (unsigned char *)(block + 1));
+
+    size_t size = block->i_size - (BLOCK_ALIGN + 2 * BLOCK_PADDING);
+    unsigned cls = block_cache_Class(size);
+
+    assert (cls < BLOCK_CACHE_CLASSES && block_cache_ClassSize(cls) == size);
+    if (!block_cache_Push(cls, block))
+        free (block);
+}
+
+static const struct vlc_block_callbacks block_cached_cbs =
+{
+    block_cached_Release,
+};
+#endif /* BLOCK_CACHE_DISABLED */
+
+void block_cache_Stats(struct vlc_block_cache_stats *stats)
+{
+#ifndef BLOCK_CACHE_DISABLED
+    stats->hits = atomic_load_explicit(&block_cache_hits,
+                                       memory_order_relaxed);
+    stats->misses = atomic_load_explicit(&block_cache_misses,
+                                         memory_order_relaxed);
+    stats->cached = atomic_load_explicit(&block_cache_cached,
+                                         memory_order_relaxed);
+#else
+    stats->hits = stats->misses = 0;
+    stats->cached = 0;
+#endif
+}
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -113,19 +428,34 @@ block_t *block_Alloc (size_t size)
         return NULL;
     }
 
+    const struct vlc_block_callbacks *cbs = &block_generic_cbs;
+    size_t capacity = size;
+    block_t *b = NULL;
+
+#ifndef BLOCK_CACHE_DISABLED
+    unsigned cls = block_cache_Class(size);
+    if (cls < BLOCK_CACHE_CLASSES)
+    {
+        cbs = &block_cached_cbs;
+        capacity = block_cache_ClassSize(cls);
+        b = block_cache_Pop(cls);
+    }
+#endif
+
     /* 2 * BLOCK_PADDING: pre + post padding */
     const size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
-                       + size;
-    if (unlikely(alloc <= size))
+                       + capacity;
+    if (unlikely(alloc <= capacity))
         return NULL;
 
-    block_t *b = malloc (alloc);
-    if (unlikely(b == NULL))
-        return NULL;
+    if (b == NULL)
+    {
+        b = malloc (alloc);
+        if (unlikely(b == NULL))
+            return NULL;
+    }
 
-    block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
-    static_assert ((BLOCK_PADDING % BLOCK_ALIGN) == 0,
-                   "BLOCK_PADDING must be a multiple of BLOCK_ALIGN");
+    block_Init(b, cbs, b + 1, alloc - sizeof (*b));
     b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
     b->p_buffer = (void *)(((uintptr_t)b->p_buffer) & ~(BLOCK_ALIGN - 1));
     b->i_buffer = size;
@@ -40,8 +40,39 @@ typedef struct chained_filter_t
     struct chained_filter_t *prev, *next;
     vlc_mouse_t *mouse;
     picture_t *pending;
+    vlc_tick_t time; /**< Time spent filtering */
+    uint64_t pictures; /**< Number of filtered pictures */
 } chained_filter_t;
 
+/** Slices of one picture, queued in the slice pool */
+typedef struct filter_slice_job_t
+{
+    struct filter_slice_job_t *next_job;
+    filter_t *filter;
+    filter_slice_cb cb;
+    void *opaque;
+    unsigned slices; /**< Number of slices of the picture */
+    unsigned next; /**< Next slice to process */
+    unsigned pending; /**< Slices not processed yet */
+    vlc_cond_t done_wait; /**< Signaled when the last slice is done */
+} filter_slice_job_t;
+
+/** Worker threads shared by all the video filter chains of the process, so
+ * that several chains do not multiply the thread count. The pool grows to
+ * the largest thread count any chain asks for, while each chain splits its
+ * pictures according to its own count. */
+typedef struct
+{
+    vlc_mutex_t lock;
+    vlc_cond_t work_wait; /**< Signaled when slices are queued */
+    filter_slice_job_t *first, **pp_last; /**< Jobs with slices left */
+    unsigned refs;
+    bool quit;
+
+    unsigned threads_count;
+    vlc_thread_t threads[];
+} filter_slice_pool_t;
+
 /* */
 struct filter_chain_t
 {
@@ -56,6 +87,8 @@ struct filter_chain_t
     bool b_allow_fmt_out_change; /**< Each filter can change the output */
     const char *filter_cap; /**< Filter modules capability */
     const char *conv_cap; /**< Converter modules capability */
+    filter_slice_pool_t *pool; /**< Slice threads (held on first use) */
+    unsigned threads; /**< Slice threads count, including the caller */
 };
 
 /**
@@ -83,6 +116,8 @@ static filter_chain_t *filter_chain_NewInner( vlc_object_t *obj,
     chain->b_allow_fmt_out_change = fmt_out_change;
     chain->filter_cap = cap;
     chain->conv_cap = conv_cap;
+    chain->pool = NULL;
+    chain->threads = 0;
     return chain;
 }
 
@@ -134,9 +169,191 @@ static vlc_decoder_device * filter_chain_HoldDecoderDevice(vlc_object_t *o, void
     return chain->parent_video_owner.video->hold_device(o, chain->parent_video_owner.sys);
 }
 
+#define SLICE_THREADS_MAX 16 /* including the calling thread */
+
+static vlc_mutex_t slice_pool_lock = VLC_STATIC_MUTEX;
+static filter_slice_pool_t *slice_pool = NULL;
+
+/** Processes the slices left of a job, with the pool locked */
+static void SlicePoolRun( filter_slice_pool_t *pool, filter_slice_job_t *job )
+{
+    while( job->next < job->slices )
+    {
+        unsigned slice = job->next++;
+
+        if( job->next == job->slices )
+        {   /* Nothing left to hand out: dequeue the job */
+            filter_slice_job_t **pp = &pool->first;
+            while( *pp != job )
+                pp = &(*pp)->next_job;
+            *pp = job->next_job;
+            if( pool->pp_last == &job->next_job )
+                pool->pp_last = pp;
+        }
+
+        vlc_mutex_unlock( &pool->lock );
+        job->cb( job->filter, job->opaque, slice, job->slices );
+        vlc_mutex_lock( &pool->lock );
+
+        assert( job->pending > 0 );
+        if( --job->pending == 0 )
+            vlc_cond_signal( &job->done_wait );
+    }
+}
+
+static void *SliceThread( void *data )
+{
+    filter_slice_pool_t *pool = data;
+
+    vlc_mutex_lock( &pool->lock );
+    while( !pool->quit )
+    {
+        if( pool->first != NULL )
+            SlicePoolRun( pool, pool->first );
+        else
+            vlc_cond_wait( &pool->work_wait, &pool->lock );
+    }
+    vlc_mutex_unlock( &pool->lock );
+    return NULL;
+}
+
+/** Holds the process slice pool, creating it or adding threads to it so
+ * that it has *count threads if possible; *count is lowered otherwise */
+static filter_slice_pool_t *SlicePoolHold( unsigned *restrict countp )
+{
+    const unsigned count = *countp;
+
+    assert( count < SLICE_THREADS_MAX );
+
+    vlc_mutex_lock( &slice_pool_lock );
+    filter_slice_pool_t *pool = slice_pool;
+    if( pool == NULL )
+    {
+        pool = malloc( sizeof (*pool)
+                       + (SLICE_THREADS_MAX - 1) * sizeof (pool->threads[0]) );
+        if( unlikely(pool == NULL) )
+            goto out;
+
+        vlc_mutex_init( &pool->lock );
+        vlc_cond_init( &pool->work_wait );
+        pool->first = NULL;
+        pool->pp_last = &pool->first;
+        pool->refs = 0;
+        pool->quit = false;
+        pool->threads_count = 0;
+    }
+
+    while( pool->threads_count < count )
+    {
+        if( vlc_clone( &pool->threads[pool->threads_count], SliceThread, pool,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+            break;
+        pool->threads_count++;
+    }
+    if( pool->threads_count == 0 )
+    {
+        free( pool );
+        pool = NULL;
+    }
+    else
+    {
+        pool->refs++;
+        slice_pool = pool;
+        if( *countp > pool->threads_count )
+            *countp = pool->threads_count;
+    }
+out:
+    vlc_mutex_unlock( &slice_pool_lock );
+    return pool;
+}
+
+static void SlicePoolRelease( filter_slice_pool_t *pool )
+{
+    vlc_mutex_lock( &slice_pool_lock );
+    assert( pool == slice_pool );
+    if( --pool->refs > 0 )
+    {
+        vlc_mutex_unlock( &slice_pool_lock );
+        return;
+    }
+    slice_pool = NULL;
+    vlc_mutex_unlock( &slice_pool_lock );
+
+    vlc_mutex_lock( &pool->lock );
+    assert( pool->first == NULL );
+    pool->quit = true;
+    vlc_cond_broadcast( &pool->work_wait );
+    vlc_mutex_unlock( &pool->lock );
+
+    for( unsigned i = 0; i < pool->threads_count; i++ )
+        vlc_join( pool->threads[i], NULL );
+    free( pool );
+}
+
+static void filter_chain_Execute( filter_t *filter, filter_slice_cb cb,
+                                  void *opaque, unsigned slices )
+{
+    filter_chain_t *chain = filter->owner.sys;
+
+    if( chain->threads == 0 )
+    {
+        int64_t threads = var_InheritInteger( chain->obj,
+                                              "video-filter-threads" );
+        chain->threads = threads > 0 ? __MIN(threads, SLICE_THREADS_MAX)
+                                     : __MIN(vlc_GetCPUCount(),
+                                             SLICE_THREADS_MAX);
+        if( chain->threads > 1 )
+        {
+            unsigned workers = chain->threads - 1;
+
+            chain->pool = SlicePoolHold( &workers );
+            chain->threads = workers + 1;
+        }
+        if( chain->pool == NULL )
+            chain->threads = 1;
+        msg_Dbg( chain->obj, "processing filter slices with %u thread(s)",
+                 chain->threads );
+    }
+
+    if( slices == 0 )
+        slices = chain->threads;
+
+    filter_slice_pool_t *pool = chain->pool;
+    if( pool == NULL || slices == 1 )
+    {
+        for( unsigned i = 0; i < slices; i++ )
+            cb( filter, opaque, i, slices );
+        return;
+    }
+
+    /* The calling thread processes slices too, then waits for the others
+     * once per picture */
+    filter_slice_job_t job = {
+        .next_job = NULL,
+        .filter = filter,
+        .cb = cb,
+        .opaque = opaque,
+        .slices = slices,
+        .next = 0,
+        .pending = slices,
+    };
+    vlc_cond_init( &job.done_wait );
+
+    vlc_mutex_lock( &pool->lock );
+    *pool->pp_last = &job;
+    pool->pp_last = &job.next_job;
+    vlc_cond_broadcast( &pool->work_wait );
+
+    SlicePoolRun( pool, &job );
+    while( job.pending > 0 )
+        vlc_cond_wait( &job.done_wait, &pool->lock );
+    vlc_mutex_unlock( &pool->lock );
+}
+
 static const struct filter_video_callbacks filter_chain_video_cbs =
 {
     filter_chain_VideoBufferNew, filter_chain_HoldDecoderDevice,
+    filter_chain_Execute,
 };
 
 #undef filter_chain_NewVideo
@@ -178,6 +395,8 @@ void filter_chain_Delete( filter_chain_t *p_chain )
         vlc_video_context_Release( p_chain->vctx_in );
     es_format_Clean( &p_chain->fmt_out );
 
+    if( p_chain->pool != NULL )
+        SlicePoolRelease( p_chain->pool );
     free( p_chain );
 }
 /**
@@ -275,6 +494,8 @@ static filter_t *filter_chain_AppendInner( filter_chain_t *chain,
         vlc_mouse_Init( mouse );
     chained->mouse = mouse;
     chained->pending = NULL;
+    chained->time = 0;
+    chained->pictures = 0;
 
     msg_Dbg( chain->obj, "Filter '%s' (%p) appended to chain",
              (name != NULL) ? name : module_get_name(filter->p_module, false),
@@ -328,6 +549,13 @@ void filter_chain_DeleteFilter( filter_chain_t *chain, filter_t *filter )
         chain->last = chained->prev;
     }
 
+    if( chained->pictures > 0 )
+        msg_Dbg( chain->obj, "Filter '%s' (%p) processed %"PRIu64" pictures, "
+                 "%"PRId64" us per picture",
+                 module_get_name( filter->p_module, false ), (void *)filter,
+                 chained->pictures,
+                 US_FROM_VLC_TICK( chained->time / chained->pictures ) );
+
     module_unneed( filter, filter->p_module );
 
     msg_Dbg( chain->obj, "Filter %p removed from chain", (void *)filter );
@@ -427,7 +655,11 @@ static picture_t *FilterChainVideoFilter( chained_filter_t *f, picture_t *p_pic
     for( ; f != NULL; f = f->next )
     {
         filter_t *p_filter = &f->filter;
+        vlc_tick_t start = vlc_tick_now();
+
         p_pic = p_filter->pf_video_filter( p_filter, p_pic );
+        f->time += vlc_tick_now() - start;
+        f->pictures++;
         if( !p_pic )
             break;
         if( f->pending )
@@ -103,6 +103,10 @@ void picture_Reset( picture_t *p_picture )
 /*****************************************************************************
  *
  *****************************************************************************/
+/* Alignment of the plane pitches, as large as that of the allocations, so
+ * that decoders can render directly, e.g. libavcodec with AVX-512 */
+#define PICTURE_PITCH_ALIGN 64
+
 static int LCM( int a, int b )
 {
     return a * b / GCD( a, b );
@@ -137,9 +141,9 @@ int picture_Setup( picture_t *p_picture, const video_format_t *restrict fmt )
 
     /* We want V (width/height) to respect:
         (V * p_dsc->p[i].w.i_num) % p_dsc->p[i].w.i_den == 0
-        (V * p_dsc->p[i].w.i_num/p_dsc->p[i].w.i_den * p_dsc->i_pixel_size) % 16 == 0
-       Which is respected if you have
-       V % lcm( p_dsc->p[0..planes].w.i_den * 16) == 0
+        (V * p_dsc->p[i].w.i_num/p_dsc->p[i].w.i_den * p_dsc->i_pixel_size) % A == 0
+       with A = PICTURE_PITCH_ALIGN. Which is respected if you have
+       V % lcm( p_dsc->p[0..planes].w.i_den * A / gcd(A, p_dsc->p[0..planes].w.i_num * p_dsc->i_pixel_size) ) == 0
     */
     unsigned i_modulo_w = 1;
     unsigned i_modulo_h = 1;
@@ -147,7 +151,10 @@ int picture_Setup( picture_t *p_picture, const video_format_t *restrict fmt )
 
     for( unsigned i = 0; i < p_dsc->plane_count; i++ )
     {
-        i_modulo_w = LCM( i_modulo_w, 16 * p_dsc->p[i].w.den );
+        const unsigned i_bytes = p_dsc->p[i].w.num * p_dsc->pixel_size;
+
+        i_modulo_w = LCM( i_modulo_w, p_dsc->p[i].w.den * PICTURE_PITCH_ALIGN
+                                      / GCD( PICTURE_PITCH_ALIGN, i_bytes ) );
         i_modulo_h = LCM( i_modulo_h, 16 * p_dsc->p[i].h.den );
         if( i_ratio_h < p_dsc->p[i].h.den )
             i_ratio_h = p_dsc->p[i].h.den;
@@ -185,7 +192,7 @@ int picture_Setup( picture_t *p_picture, const video_format_t *restrict fmt )
                              * p_dsc->pixel_size;
         p->i_pixel_pitch = p_dsc->pixel_size;
 
-        assert( (p->i_pitch % 16) == 0 );
+        assert( (p->i_pitch % PICTURE_PITCH_ALIGN) == 0 );
     }
     p_picture->i_planes = p_dsc->plane_count;
 
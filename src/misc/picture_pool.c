@@ -27,6 +27,7 @@
 #endif
 #include <assert.h>
 #include <limits.h>
+#include <stdalign.h>
 #include <stdatomic.h>
 #include <stdlib.h>
 
@@ -34,19 +35,24 @@
 #include <vlc_picture_pool.h>
 #include "picture.h"
 
-#define POOL_MAX (CHAR_BIT * sizeof (unsigned long long))
+/* Availability of the pictures, one bit per picture */
+#define POOL_WORD_BITS (CHAR_BIT * sizeof (unsigned long long))
 
-static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
+struct picture_pool_slot {
+    picture_pool_t *pool;
+    picture_t *picture;
+};
 
 struct picture_pool_t {
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
-    bool               canceled;
-    unsigned long long available;
-    atomic_ushort      refs;
-    unsigned short     picture_count;
-    picture_t  *picture[];
+    atomic_bool        canceled;
+    atomic_uint        waiters;
+    atomic_uint        refs;
+    unsigned           picture_count;
+    atomic_ullong     *available;
+    struct picture_pool_slot slots[];
 };
 
 static void picture_pool_Destroy(picture_pool_t *pool)
@@ -55,68 +61,124 @@ static void picture_pool_Destroy(picture_pool_t *pool)
         return;
 
     atomic_thread_fence(memory_order_acquire);
-    aligned_free(pool);
+    free(pool);
 }
 
 void picture_pool_Release(picture_pool_t *pool)
 {
     for (unsigned i = 0; i < pool->picture_count; i++)
-        picture_Release(pool->picture[i]);
+        picture_Release(pool->slots[i].picture);
     picture_pool_Destroy(pool);
 }
 
-static void picture_pool_ReleasePicture(picture_t *clone)
+/**
+ * Takes an available picture out of the pool, without locking.
+ *
+ * \return the picture offset, or -1 if none is available
+ */
+static int picture_pool_Take(picture_pool_t *pool)
 {
-    picture_priv_t *priv = (picture_priv_t *)clone;
-    uintptr_t sys = (uintptr_t)priv->gc.opaque;
-    picture_pool_t *pool = (void *)(sys & ~(POOL_MAX - 1));
-    unsigned offset = sys & (POOL_MAX - 1);
-    picture_t *picture = pool->picture[offset];
+    const unsigned words = (pool->picture_count + POOL_WORD_BITS - 1)
+                           / POOL_WORD_BITS;
 
-    picture_Release(picture);
+    for (unsigned w = 0; w < words; w++)
+    {
+        atomic_ullong *word = &pool->available[w];
+        unsigned long long available = atomic_load(word);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
+        while (available != 0)
+        {
+            int i = ctz(available);
+
+            /* On failure, available is reloaded with the current bits */
+            if (atomic_compare_exchange_weak(word, &available,
+                                             available & ~(1ULL << i)))
+                return w * POOL_WORD_BITS + i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Puts a picture back into the pool, and wakes a waiting thread up if any.
+ */
+static void picture_pool_Put(picture_pool_t *pool, unsigned offset)
+{
+    const unsigned long long bit = 1ULL << (offset % POOL_WORD_BITS);
+    unsigned long long old;
+
+    old = atomic_fetch_or(&pool->available[offset / POOL_WORD_BITS], bit);
+    assert(!(old & bit));
+    (void) old;
+
+    /* A waiter registers before checking the pool a last time. Either it
+     * sees the picture, or this sees it, and signals it with the lock held so
+     * that the wake-up cannot get lost. */
+    if (atomic_load(&pool->waiters) > 0)
+    {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
 
+static void picture_pool_ReleasePicture(picture_t *clone)
+{
+    picture_priv_t *priv = (picture_priv_t *)clone;
+    struct picture_pool_slot *slot = priv->gc.opaque;
+    picture_pool_t *pool = slot->pool;
+
+    picture_Release(slot->picture);
+    picture_pool_Put(pool, slot - pool->slots);
     picture_pool_Destroy(pool);
 }
 
 static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
                                             unsigned offset)
 {
-    picture_t *picture = pool->picture[offset];
-    uintptr_t sys = ((uintptr_t)pool) + offset;
+    struct picture_pool_slot *slot = &pool->slots[offset];
+    picture_t *clone = picture_InternalClone(slot->picture,
+                                             picture_pool_ReleasePicture,
+                                             slot);
+    if (unlikely(clone == NULL)) {
+        picture_pool_Put(pool, offset);
+        return NULL;
+    }
 
-    return picture_InternalClone(picture, picture_pool_ReleasePicture,
-                                 (void*)sys);
+    assert(clone->p_next == NULL);
+    atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+    return clone;
 }
 
 picture_pool_t *picture_pool_New(unsigned count, picture_t *const *tab)
 {
-    if (unlikely(count > POOL_MAX))
-        return NULL;
-
+    const unsigned words = (count + POOL_WORD_BITS - 1) / POOL_WORD_BITS;
     picture_pool_t *pool;
-    size_t size = sizeof (*pool) + count * sizeof (picture_t *);
+    size_t size = sizeof (*pool) + count * sizeof (pool->slots[0]);
 
-    size += (-size) & (POOL_MAX - 1);
-    pool = aligned_alloc(POOL_MAX, size);
+    size += (-size) & (alignof (atomic_ullong) - 1);
+    pool = malloc(size + words * sizeof (atomic_ullong));
     if (unlikely(pool == NULL))
         return NULL;
 
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
-    if (count == POOL_MAX)
-        pool->available = ~0ULL;
-    else
-        pool->available = (1ULL << count) - 1;
+    atomic_init(&pool->canceled, false);
+    atomic_init(&pool->waiters, 0);
     atomic_init(&pool->refs,  1);
     pool->picture_count = count;
-    memcpy(pool->picture, tab, count * sizeof (picture_t *));
-    pool->canceled = false;
+    pool->available = (atomic_ullong *)(((char *)pool) + size);
+
+    for (unsigned i = 0; i < count; i++) {
+        pool->slots[i].pool = pool;
+        pool->slots[i].picture = tab[i];
+    }
+    for (unsigned w = 0; w < words; w++) {
+        unsigned bits = count - w * POOL_WORD_BITS;
+
+        atomic_init(&pool->available[w],
+                    bits >= POOL_WORD_BITS ? ~0ULL : (1ULL << bits) - 1);
+    }
     return pool;
 }
 
@@ -169,68 +231,49 @@ error:
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    unsigned long long available;
-
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-    available = pool->available;
-
-    while (available != 0)
-    {
-        int i = ctz(available);
-
-        if (unlikely(pool->canceled))
-            break;
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-        pool->available &= ~(1ULL << i);
-        vlc_mutex_unlock(&pool->lock);
-        available &= ~(1ULL << i);
-
-        picture_t *clone = picture_pool_ClonePicture(pool, i);
-        if (clone != NULL) {
-            assert(clone->p_next == NULL);
-            atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
-        }
-        return clone;
-    }
+    if (unlikely(atomic_load_explicit(&pool->canceled, memory_order_relaxed)))
+        return NULL;
 
-    vlc_mutex_unlock(&pool->lock);
-    return NULL;
+    int i = picture_pool_Take(pool);
+    if (i < 0)
+        return NULL;
+    return picture_pool_ClonePicture(pool, i);
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    while (pool->available == 0)
+    int i = picture_pool_Take(pool);
+    if (i < 0)
     {
-        if (pool->canceled)
+        vlc_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->waiters, 1);
+
+        while ((i = picture_pool_Take(pool)) < 0)
         {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
+            if (atomic_load_explicit(&pool->canceled, memory_order_relaxed))
+                break;
+            vlc_cond_wait(&pool->wait, &pool->lock);
         }
-        vlc_cond_wait(&pool->wait, &pool->lock);
-    }
 
-    int i = ctz(pool->available);
-    pool->available &= ~(1ULL << i);
-    vlc_mutex_unlock(&pool->lock);
+        atomic_fetch_sub(&pool->waiters, 1);
+        vlc_mutex_unlock(&pool->lock);
 
-    picture_t *clone = picture_pool_ClonePicture(pool, i);
-    if (clone != NULL) {
-        assert(clone->p_next == NULL);
-        atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+        if (i < 0)
+            return NULL;
     }
-    return clone;
+    return picture_pool_ClonePicture(pool, i);
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
     vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    pool->canceled = canceled;
+    atomic_store_explicit(&pool->canceled, canceled, memory_order_relaxed);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
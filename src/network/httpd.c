@@ -54,6 +54,9 @@
 #ifdef HAVE_POLL
 # include <poll.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+#endif
 
 #if defined(_WIN32)
 #   include <winsock2.h>
@@ -68,10 +71,17 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
+/* Stream data blocks sent to a client at once */
+#define HTTPD_CL_BLOCKS 16
+
+typedef struct httpd_worker_t httpd_worker_t;
+typedef struct httpd_stream_block_t httpd_stream_block_t;
+
 static void httpd_ClientDestroy(httpd_client_t *cl);
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
+static void httpd_ClientKill(httpd_client_t *cl);
+static void httpd_StreamBlockRelease(httpd_stream_block_t *);
 
-/* each host run in his own thread */
+/* each host runs its own worker threads */
 struct httpd_host_t
 {
     struct vlc_object_t obj;
@@ -85,7 +95,10 @@ struct httpd_host_t
     unsigned     nfd;
     unsigned     port;
 
-    vlc_thread_t thread;
+    /* clients are spread over the workers, each one serving its own */
+    httpd_worker_t *workers;
+    unsigned        worker_count;
+
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
@@ -95,13 +108,29 @@ struct httpd_host_t
      * */
     struct vlc_list urls;
 
-    size_t client_count;
-    struct vlc_list clients;
-
     /* TLS data */
     vlc_tls_server_t *p_tls;
 };
 
+struct httpd_worker_t
+{
+    httpd_host_t *host;
+    vlc_thread_t  thread;
+#ifdef HAVE_SYS_EPOLL_H
+    int           epfd;
+#endif
+
+    /* protects the clients of this worker, and their state */
+    vlc_mutex_t     lock;
+    /* clients waiting for socket events */
+    struct vlc_list clients;
+    /* clients waiting for stream data, or dead ones to be destroyed */
+    struct vlc_list waiting;
+    size_t          client_count;
+
+    vlc_tick_t      next_sweep; /* next check of activity timeouts */
+};
+
 
 struct httpd_url_t
 {
@@ -142,8 +171,13 @@ struct httpd_client_t
     httpd_url_t *url;
     vlc_tls_t   *sock;
 
+    httpd_worker_t *worker;
     struct vlc_list node;
 
+    int     fd;             /* socket to poll */
+    short   i_poll_events;  /* polled events, 0 if not polled */
+    bool    b_waiting;      /* in the worker waiting list */
+
     bool    b_stream_mode;
     uint8_t i_state;
 
@@ -162,6 +196,13 @@ struct httpd_client_t
      */
     int64_t i_keyframe_wait_to_pass;
 
+    /* Stream data being sent, shared with the other clients of the stream,
+     * and the last block queued, from which the stream is followed */
+    httpd_stream_block_t *pp_blocks[HTTPD_CL_BLOCKS];
+    struct iovec          p_iov[HTTPD_CL_BLOCKS];
+    unsigned              i_blocks;
+    httpd_stream_block_t *p_cursor;
+
     /* */
     httpd_message_t query;  /* client -> httpd */
     httpd_message_t answer; /* httpd -> client */
@@ -588,6 +629,30 @@ void httpd_RedirectDelete(httpd_redirect_t *rdir)
 /*****************************************************************************
  * High Level Funtions: httpd_stream_t
  *****************************************************************************/
+/* Stream data, shared by all the clients sending it */
+struct httpd_stream_block_t
+{
+    httpd_stream_block_t *p_next;   /* protected by the stream lock */
+    bool        b_dropped;          /* out of the stream, p_next is invalid */
+    atomic_uint refs;
+
+    int64_t     i_pos;              /* absolute position from beginning */
+    size_t      i_size;
+    uint8_t     p_data[];
+};
+
+static void httpd_StreamBlockRelease(httpd_stream_block_t *block)
+{
+    if (atomic_fetch_sub_explicit(&block->refs, 1, memory_order_acq_rel) == 1)
+        free(block);
+}
+
+static httpd_stream_block_t *httpd_StreamBlockHold(httpd_stream_block_t *block)
+{
+    atomic_fetch_add_explicit(&block->refs, 1, memory_order_relaxed);
+    return block;
+}
+
 struct httpd_stream_t
 {
     vlc_mutex_t lock;
@@ -607,9 +672,13 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    httpd_stream_block_t *p_last_keyframe; /* NULL if out of the chain */
+
+    /* chain of the last blocks, from the oldest */
+    httpd_stream_block_t *p_first;
+    httpd_stream_block_t *p_last;
+    size_t      i_buffer_size;      /* maximum size of the chain */
+    size_t      i_buffer;           /* current size of the chain */
     int64_t     i_buffer_pos;       /* absolute position from beginning */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
 
@@ -628,45 +697,59 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
         return VLC_SUCCESS;
 
     if (answer->i_body_offset > 0) {
-        int     i_pos;
+        httpd_stream_block_t *block;
+
+        vlc_mutex_lock(&stream->lock);
+        if (cl->p_cursor == NULL) {
+            /* first data, or the next block at this position */
+            block = stream->p_first;
+            while (block != NULL && block->i_pos < answer->i_body_offset)
+                block = block->p_next;
+        } else if (cl->p_cursor->b_dropped)
+            block = stream->p_last; /* this client isn't fast enough */
+        else
+            block = cl->p_cursor->p_next;
 
-        if (answer->i_body_offset >= stream->i_buffer_pos)
+        if (block == NULL) {
+            vlc_mutex_unlock(&stream->lock);
             return VLC_EGENERIC;    /* wait, no data available */
+        }
 
         if (cl->i_keyframe_wait_to_pass >= 0) {
-            if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
+            if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass) {
                 /* still waiting for the next keyframe */
+                vlc_mutex_unlock(&stream->lock);
                 return VLC_EGENERIC;
+            }
 
             /* seek to the new keyframe */
-            answer->i_body_offset = stream->i_last_keyframe_seen_pos;
+            block = stream->p_last_keyframe ? stream->p_last_keyframe
+                                            : stream->p_last;
             cl->i_keyframe_wait_to_pass = -1;
         }
 
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
-            answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
-
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
-
-        if (i_write > HTTPD_CL_BUFSIZE)
-            i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
+        /* queue the blocks, they are sent without copy */
+        assert(cl->i_blocks == 0);
+        for (; block != NULL && cl->i_blocks < HTTPD_CL_BLOCKS;
+             block = block->p_next) {
+            cl->pp_blocks[cl->i_blocks] = httpd_StreamBlockHold(block);
+            cl->p_iov[cl->i_blocks].iov_base = block->p_data;
+            cl->p_iov[cl->i_blocks].iov_len = block->i_size;
+            cl->i_blocks++;
+        }
+        block = cl->pp_blocks[cl->i_blocks - 1];
+        vlc_mutex_unlock(&stream->lock);
 
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
+        if (cl->p_cursor != NULL)
+            httpd_StreamBlockRelease(cl->p_cursor);
+        cl->p_cursor = httpd_StreamBlockHold(block);
 
         /* using HTTPD_MSG_ANSWER -> data available */
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
         answer->i_type   = HTTPD_MSG_ANSWER;
 
-        answer->i_body = i_write;
-        answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
-
-        answer->i_body_offset += i_write;
+        answer->i_body_offset = block->i_pos + block->i_size;
 
         return VLC_SUCCESS;
     } else {
@@ -752,7 +835,6 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
         return NULL;
 
     stream->psz_mime = NULL;
-    stream->p_buffer = NULL;
 
     stream->url = httpd_UrlNew(host, psz_url, psz_user, psz_password);
     if (!stream->url)
@@ -769,10 +851,10 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->i_header = 0;
     stream->p_header = NULL;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
-
-    stream->p_buffer = malloc(stream->i_buffer_size);
-    if (stream->p_buffer == NULL)
-        goto error;
+    stream->i_buffer = 0;
+    stream->p_first = NULL;
+    stream->p_last = NULL;
+    stream->p_last_keyframe = NULL;
 
     /* We set to 1 to make life simpler
      * (this way i_body_offset can never be 0) */
@@ -819,22 +901,21 @@ int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
     return VLC_SUCCESS;
 }
 
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
+/* Drops the oldest block of the chain, clients still sending it keep it */
+static void httpd_StreamDropFirst(httpd_stream_t *stream)
 {
-    int i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    int i_count = i_data;
-    while (i_count > 0) {
-        int i_copy = __MIN(i_count, stream->i_buffer_size - i_pos);
-
-        /* Ok, we can't go past the end of our buffer */
-        memcpy(&stream->p_buffer[i_pos], p_data, i_copy);
-
-        i_pos = (i_pos + i_copy) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
-    }
-
-    stream->i_buffer_pos += i_data;
+    httpd_stream_block_t *block = stream->p_first;
+
+    stream->p_first = block->p_next;
+    if (stream->p_first == NULL)
+        stream->p_last = NULL;
+    if (stream->p_last_keyframe == block)
+        stream->p_last_keyframe = NULL;
+
+    stream->i_buffer -= block->i_size;
+    block->b_dropped = true;
+    block->p_next = NULL;
+    httpd_StreamBlockRelease(block);
 }
 
 int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
@@ -842,17 +923,40 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
     if (!p_block || !p_block->p_buffer)
         return VLC_SUCCESS;
 
+    /* the only copy of the data, whatever the number of clients */
+    httpd_stream_block_t *block = malloc(sizeof (*block) + p_block->i_buffer);
+    if (unlikely(block == NULL))
+        return VLC_ENOMEM;
+
+    block->p_next = NULL;
+    block->b_dropped = false;
+    atomic_init(&block->refs, 1);
+    block->i_size = p_block->i_buffer;
+    memcpy(block->p_data, p_block->p_buffer, p_block->i_buffer);
+
     vlc_mutex_lock(&stream->lock);
 
     /* save this pointer (to be used by new connection) */
     stream->i_buffer_last_pos = stream->i_buffer_pos;
 
+    block->i_pos = stream->i_buffer_pos;
     if (p_block->i_flags & BLOCK_FLAG_TYPE_I) {
         stream->b_has_keyframes = true;
         stream->i_last_keyframe_seen_pos = stream->i_buffer_pos;
+        stream->p_last_keyframe = block;
     }
 
-    httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
+    if (stream->p_last != NULL)
+        stream->p_last->p_next = block;
+    else
+        stream->p_first = block;
+    stream->p_last = block;
+    stream->i_buffer += block->i_size;
+    stream->i_buffer_pos += block->i_size;
+
+    while (stream->i_buffer > stream->i_buffer_size
+        && stream->p_first != block)
+        httpd_StreamDropFirst(stream);
 
     vlc_mutex_unlock(&stream->lock);
     return VLC_SUCCESS;
@@ -868,14 +972,18 @@ void httpd_StreamDelete(httpd_stream_t *stream)
     free(stream->p_http_headers);
     free(stream->psz_mime);
     free(stream->p_header);
-    free(stream->p_buffer);
+    while (stream->p_first != NULL)
+        httpd_StreamDropFirst(stream);
     free(stream);
 }
 
 /*****************************************************************************
  * Low level
  *****************************************************************************/
-static void* httpd_HostThread(void *);
+static void* httpd_WorkerThread(void *);
+static int httpd_WorkerInit(httpd_host_t *, httpd_worker_t *);
+static void httpd_WorkerClean(httpd_worker_t *);
+static void httpd_HostStop(httpd_host_t *);
 static httpd_host_t *httpd_HostCreate(vlc_object_t *, const char *,
                                        const char *, vlc_tls_server_t *);
 
@@ -958,6 +1066,8 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
 
     char *hostname = var_InheritString(p_this, hostvar);
 
+    host->workers = NULL;
+    host->worker_count = 0;
     host->fds = net_ListenTCP(p_this, hostname, port);
     free(hostname);
 
@@ -969,16 +1079,32 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
 
     host->port     = port;
     vlc_list_init(&host->urls);
-    host->client_count = 0;
-    vlc_list_init(&host->clients);
     host->p_tls    = p_tls;
 
-    /* create the thread */
-    if (vlc_clone(&host->thread, httpd_HostThread, host,
-                   VLC_THREAD_PRIORITY_LOW)) {
-        msg_Err(p_this, "cannot spawn http host thread");
+    /* create the worker threads */
+    unsigned count = var_InheritInteger(p_this, "http-threads");
+    if (count < 1)
+        count = 1;
+
+    host->workers = vlc_alloc(count, sizeof (*host->workers));
+    if (unlikely(host->workers == NULL))
         goto error;
+
+    for (host->worker_count = 0; host->worker_count < count;
+         host->worker_count++) {
+        httpd_worker_t *w = &host->workers[host->worker_count];
+
+        if (httpd_WorkerInit(host, w))
+            goto error;
+
+        if (vlc_clone(&w->thread, httpd_WorkerThread, w,
+                       VLC_THREAD_PRIORITY_LOW)) {
+            msg_Err(p_this, "cannot spawn http host thread");
+            httpd_WorkerClean(w);
+            goto error;
+        }
     }
+    msg_Dbg(host, "HTTP host serving with %u thread(s)", count);
 
     /* now add it to httpd */
     vlc_list_append(&host->node, &httpd.hosts);
@@ -990,6 +1116,7 @@ error:
     vlc_mutex_unlock(&httpd.mutex);
 
     if (host) {
+        httpd_HostStop(host);
         net_ListenClose(host->fds);
         vlc_object_delete(host);
     }
@@ -1001,8 +1128,6 @@ error:
 /* delete a host */
 void httpd_HostDelete(httpd_host_t *host)
 {
-    httpd_client_t *client;
-
     vlc_mutex_lock(&httpd.mutex);
 
     if (atomic_fetch_sub_explicit(&host->ref, 1, memory_order_relaxed) > 1) {
@@ -1013,16 +1138,10 @@ void httpd_HostDelete(httpd_host_t *host)
     }
 
     vlc_list_remove(&host->node);
-    vlc_cancel(host->thread);
-    vlc_join(host->thread, NULL);
+    httpd_HostStop(host);
 
     msg_Dbg(host, "HTTP host removed");
 
-    vlc_list_foreach(client, &host->clients, node) {
-        msg_Warn(host, "client still connected");
-        httpd_ClientDestroy(client);
-    }
-
     assert(vlc_list_is_empty(&host->urls));
     vlc_tls_ServerDelete(host->p_tls);
     net_ListenClose(host->fds);
@@ -1077,7 +1196,7 @@ httpd_url_t *httpd_UrlNew(httpd_host_t *host, const char *psz_url,
     }
 
     vlc_list_append(&url->node, &host->urls);
-    vlc_cond_signal(&host->wait);
+    vlc_cond_broadcast(&host->wait);
     vlc_mutex_unlock(&host->lock);
 
     return url;
@@ -1111,22 +1230,37 @@ void httpd_UrlDelete(httpd_url_t *url)
 
     vlc_mutex_lock(&host->lock);
     vlc_list_remove(&url->node);
+    vlc_mutex_unlock(&host->lock);
 
-    free(url->psz_url);
-    free(url->psz_user);
-    free(url->psz_password);
+    /* No client can bind to the url anymore. Detach the bound ones, under
+     * their worker lock so that no callback is running, and let their
+     * worker destroy them. */
+    for (unsigned i = 0; i < host->worker_count; i++) {
+        httpd_worker_t *w = &host->workers[i];
 
-    vlc_list_foreach(client, &host->clients, node) {
-        if (client->url != url)
-            continue;
+        vlc_mutex_lock(&w->lock);
+        vlc_list_foreach(client, &w->clients, node) {
+            if (client->url != url)
+                continue;
 
-        /* TODO complete it */
-        msg_Warn(host, "force closing connections");
-        host->client_count--;
-        httpd_ClientDestroy(client);
+            /* TODO complete it */
+            msg_Warn(host, "force closing connections");
+            httpd_ClientKill(client);
+        }
+        vlc_list_foreach(client, &w->waiting, node) {
+            if (client->url != url)
+                continue;
+
+            msg_Warn(host, "force closing connections");
+            httpd_ClientKill(client);
+        }
+        vlc_mutex_unlock(&w->lock);
     }
+
+    free(url->psz_url);
+    free(url->psz_user);
+    free(url->psz_password);
     free(url);
-    vlc_mutex_unlock(&host->lock);
 }
 
 static void httpd_MsgInit(httpd_message_t *msg)
@@ -1208,6 +1342,8 @@ static void httpd_ClientInit(httpd_client_t *cl, vlc_tick_t now)
     cl->p_buffer = xmalloc(cl->i_buffer_size);
     cl->i_keyframe_wait_to_pass = -1;
     cl->b_stream_mode = false;
+    cl->i_blocks = 0;
+    cl->p_cursor = NULL;
 
     httpd_MsgInit(&cl->query);
     httpd_MsgInit(&cl->answer);
@@ -1225,16 +1361,29 @@ char* httpd_ServerIP(const httpd_client_t *cl, char *ip, int *port)
 
 static void httpd_ClientDestroy(httpd_client_t *cl)
 {
+    httpd_worker_t *w = cl->worker;
+
+#ifdef HAVE_SYS_EPOLL_H
+    if (cl->i_poll_events != 0)
+        epoll_ctl(w->epfd, EPOLL_CTL_DEL, cl->fd, NULL);
+#endif
     vlc_list_remove(&cl->node);
+    w->client_count--;
     vlc_tls_Close(cl->sock);
     httpd_MsgClean(&cl->answer);
     httpd_MsgClean(&cl->query);
 
+    for (unsigned i = 0; i < cl->i_blocks; i++)
+        httpd_StreamBlockRelease(cl->pp_blocks[i]);
+    if (cl->p_cursor != NULL)
+        httpd_StreamBlockRelease(cl->p_cursor);
+
     free(cl->p_buffer);
     free(cl);
 }
 
-static httpd_client_t *httpd_ClientNew(vlc_tls_t *sock, vlc_tick_t now)
+static httpd_client_t *httpd_ClientNew(httpd_worker_t *w, vlc_tls_t *sock,
+                                       vlc_tick_t now)
 {
     httpd_client_t *cl = malloc(sizeof(httpd_client_t));
 
@@ -1242,6 +1391,10 @@ static httpd_client_t *httpd_ClientNew(vlc_tls_t *sock, vlc_tick_t now)
 
     cl->sock    = sock;
     cl->url     = NULL;
+    cl->worker  = w;
+    cl->fd      = vlc_tls_GetFD(sock);
+    cl->i_poll_events = 0;
+    cl->b_waiting = false;
 
     httpd_ClientInit(cl, now);
     return cl;
@@ -1570,9 +1723,37 @@ static void httpd_ClientRecv(httpd_client_t *cl)
         cl->i_activity_timeout = 0;
 }
 
+/* Sends the queued stream blocks, and releases those sent completely */
+static ssize_t httpd_ClientSendBlocks(httpd_client_t *cl)
+{
+    vlc_tls_t *sock = cl->sock;
+    ssize_t i_len = sock->ops->writev(sock, cl->p_iov, cl->i_blocks);
+    if (i_len < 0)
+        return i_len;
+
+    size_t i_sent = i_len;
+    unsigned i = 0;
+
+    while (i < cl->i_blocks && i_sent >= cl->p_iov[i].iov_len) {
+        i_sent -= cl->p_iov[i].iov_len;
+        httpd_StreamBlockRelease(cl->pp_blocks[i]);
+        i++;
+    }
+    if (i_sent > 0) {
+        cl->p_iov[i].iov_base = (uint8_t *)cl->p_iov[i].iov_base + i_sent;
+        cl->p_iov[i].iov_len -= i_sent;
+    }
+
+    cl->i_blocks -= i;
+    memmove(cl->pp_blocks, &cl->pp_blocks[i],
+            cl->i_blocks * sizeof (*cl->pp_blocks));
+    memmove(cl->p_iov, &cl->p_iov[i], cl->i_blocks * sizeof (*cl->p_iov));
+    return i_len;
+}
+
 static void httpd_ClientSend(httpd_client_t *cl)
 {
-    int i_len;
+    ssize_t i_len;
 
     if (cl->i_buffer < 0) {
         /* We need to create the header */
@@ -1605,12 +1786,16 @@ static void httpd_ClientSend(httpd_client_t *cl)
         cl->i_buffer_size = (uint8_t*)p - cl->p_buffer;
     }
 
-    i_len = httpd_NetSend(cl, &cl->p_buffer[cl->i_buffer],
-                           cl->i_buffer_size - cl->i_buffer);
-    if (i_len >= 0) {
-        cl->i_buffer += i_len;
+    if (cl->i_buffer < cl->i_buffer_size) {
+        i_len = httpd_NetSend(cl, &cl->p_buffer[cl->i_buffer],
+                               cl->i_buffer_size - cl->i_buffer);
+        if (i_len > 0)
+            cl->i_buffer += i_len;
+    } else
+        i_len = httpd_ClientSendBlocks(cl);
 
-        if (cl->i_buffer >= cl->i_buffer_size) {
+    if (i_len >= 0) {
+        if (cl->i_buffer >= cl->i_buffer_size && cl->i_blocks == 0) {
             if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0) {
                 /* catch more body data */
                 int     i_msg = cl->query.i_type;
@@ -1632,7 +1817,7 @@ static void httpd_ClientSend(httpd_client_t *cl)
 
                 cl->answer.i_body = 0;
                 cl->answer.p_body = NULL;
-            } else /* send finished */
+            } else if (cl->i_blocks == 0) /* send finished */
                 cl->i_state = HTTPD_CLIENT_SEND_DONE;
         }
     } else {
@@ -1699,368 +1884,586 @@ auth_failed:
     return false;
 }
 
-static void httpdLoop(httpd_host_t *host)
+/* Runs a state transition that does not need the socket */
+static void httpd_ClientProcess(httpd_host_t *host, httpd_client_t *cl)
 {
-    struct pollfd ufd[host->nfd + host->client_count];
-    unsigned nfd;
-    for (nfd = 0; nfd < host->nfd; nfd++) {
-        ufd[nfd].fd = host->fds[nfd];
-        ufd[nfd].events = POLLIN;
-        ufd[nfd].revents = 0;
-    }
+    int64_t i_offset;
+
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVE_DONE: {
+            httpd_message_t *answer = &cl->answer;
+            httpd_message_t *query  = &cl->query;
+
+            httpd_MsgInit(answer);
+
+            /* Handle what we received */
+            switch (query->i_type) {
+                case HTTPD_MSG_ANSWER:
+                    cl->url     = NULL;
+                    cl->i_state = HTTPD_CLIENT_DEAD;
+                    break;
+
+                case HTTPD_MSG_OPTIONS:
+                    answer->i_type   = HTTPD_MSG_ANSWER;
+                    answer->i_proto  = query->i_proto;
+                    answer->i_status = 200;
+                    answer->i_body = 0;
+                    answer->p_body = NULL;
+
+                    httpd_MsgAdd(answer, "Server", "VLC/%s", VERSION);
+                    httpd_MsgAdd(answer, "Content-Length", "0");
+
+                    switch(query->i_proto) {
+                    case HTTPD_PROTO_HTTP:
+                        answer->i_version = 1;
+                        httpd_MsgAdd(answer, "Allow", "GET,HEAD,POST,OPTIONS");
+                        break;
 
-    vlc_mutex_lock(&host->lock);
-    /* add all socket that should be read/write and close dead connection */
-    while (vlc_list_is_empty(&host->urls)) {
-        mutex_cleanup_push(&host->lock);
-        vlc_cond_wait(&host->wait, &host->lock);
-        vlc_cleanup_pop();
-    }
+                    case HTTPD_PROTO_RTSP:
+                        answer->i_version = 0;
 
-    vlc_tick_t now = vlc_tick_now();
-    bool b_low_delay = false;
-    httpd_client_t *cl;
+                        const char *p = httpd_MsgGet(query, "Cseq");
+                        if (p)
+                            httpd_MsgAdd(answer, "Cseq", "%s", p);
+                        p = httpd_MsgGet(query, "Timestamp");
+                        if (p)
+                            httpd_MsgAdd(answer, "Timestamp", "%s", p);
 
-    int canc = vlc_savecancel();
-    vlc_list_foreach(cl, &host->clients, node) {
-        int64_t i_offset;
+                        p = httpd_MsgGet(query, "Require");
+                        if (p) {
+                            answer->i_status = 551;
+                            httpd_MsgAdd(query, "Unsupported", "%s", p);
+                        }
 
-        if (cl->i_state == HTTPD_CLIENT_DEAD
-         || (cl->i_activity_timeout > 0
-          && cl->i_activity_date + cl->i_activity_timeout < now)) {
-            host->client_count--;
-            httpd_ClientDestroy(cl);
-            continue;
-        }
+                        httpd_MsgAdd(answer, "Public", "DESCRIBE,SETUP,"
+                                "TEARDOWN,PLAY,PAUSE,GET_PARAMETER");
+                        break;
+                    }
 
-        struct pollfd *pufd = ufd + nfd;
-        assert (pufd < ufd + ARRAY_SIZE (ufd));
+                    if (httpd_MsgGet(&cl->query, "Connection") != NULL)
+                        httpd_MsgAdd(answer, "Connection", "close");
 
-        pufd->events = pufd->revents = 0;
+                    cl->i_buffer = -1;  /* Force the creation of the answer in
+                                         * httpd_ClientSend */
+                    cl->i_state = HTTPD_CLIENT_SENDING;
+                    break;
 
-        switch (cl->i_state) {
-            case HTTPD_CLIENT_RECEIVING:
-            case HTTPD_CLIENT_TLS_HS_IN:
-                pufd->events = POLLIN;
-                break;
+                case HTTPD_MSG_NONE:
+                    if (query->i_proto == HTTPD_PROTO_NONE) {
+                        cl->url = NULL;
+                        cl->i_state = HTTPD_CLIENT_DEAD;
+                    } else {
+                        /* unimplemented */
+                        answer->i_proto  = query->i_proto ;
+                        answer->i_type   = HTTPD_MSG_ANSWER;
+                        answer->i_version= 0;
+                        answer->i_status = 501;
 
-            case HTTPD_CLIENT_SENDING:
-            case HTTPD_CLIENT_TLS_HS_OUT:
-                pufd->events = POLLOUT;
-                break;
+                        char *p;
+                        answer->i_body = httpd_HtmlError (&p, 501, NULL);
+                        answer->p_body = (uint8_t *)p;
+                        httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+                        httpd_MsgAdd(answer, "Connection", "close");
 
-            case HTTPD_CLIENT_RECEIVE_DONE: {
-                httpd_message_t *answer = &cl->answer;
-                httpd_message_t *query  = &cl->query;
+                        cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
+                        cl->i_state = HTTPD_CLIENT_SENDING;
+                    }
+                    break;
 
-                httpd_MsgInit(answer);
+                default: {
+                    httpd_url_t *url;
+                    int i_msg = query->i_type;
+                    bool b_auth_failed = false;
 
-                /* Handle what we received */
-                switch (query->i_type) {
-                    case HTTPD_MSG_ANSWER:
-                        cl->url     = NULL;
-                        cl->i_state = HTTPD_CLIENT_DEAD;
-                        break;
+                    /* Search the url and trigger callbacks */
+                    vlc_mutex_lock(&host->lock);
+                    vlc_list_foreach(url, &host->urls, node) {
+                        if (strcmp(url->psz_url, query->psz_url))
+                            continue;
+                        if (!url->catch[i_msg].cb)
+                            continue;
 
-                    case HTTPD_MSG_OPTIONS:
-                        answer->i_type   = HTTPD_MSG_ANSWER;
-                        answer->i_proto  = query->i_proto;
-                        answer->i_status = 200;
-                        answer->i_body = 0;
-                        answer->p_body = NULL;
+                        if (answer) {
+                            b_auth_failed = !httpdAuthOk(url->psz_user,
+                               url->psz_password,
+                               httpd_MsgGet(query, "Authorization")); /* BASIC id */
+                            if (b_auth_failed)
+                               break;
+                        }
 
-                        httpd_MsgAdd(answer, "Server", "VLC/%s", VERSION);
-                        httpd_MsgAdd(answer, "Content-Length", "0");
+                        if (url->catch[i_msg].cb(url->catch[i_msg].p_sys, cl, answer, query))
+                            continue;
 
-                        switch(query->i_proto) {
-                        case HTTPD_PROTO_HTTP:
-                            answer->i_version = 1;
-                            httpd_MsgAdd(answer, "Allow", "GET,HEAD,POST,OPTIONS");
-                            break;
+                        if (answer->i_proto == HTTPD_PROTO_NONE)
+                            cl->i_buffer = cl->i_buffer_size; /* Raw answer from a CGI */
+                        else
+                            cl->i_buffer = -1;
 
-                        case HTTPD_PROTO_RTSP:
-                            answer->i_version = 0;
+                        /* only one url can answer */
+                        answer = NULL;
+                        if (!cl->url)
+                            cl->url = url;
+                    }
+                    vlc_mutex_unlock(&host->lock);
 
-                            const char *p = httpd_MsgGet(query, "Cseq");
-                            if (p)
-                                httpd_MsgAdd(answer, "Cseq", "%s", p);
-                            p = httpd_MsgGet(query, "Timestamp");
-                            if (p)
-                                httpd_MsgAdd(answer, "Timestamp", "%s", p);
+                    if (answer) {
+                        answer->i_proto  = query->i_proto;
+                        answer->i_type   = HTTPD_MSG_ANSWER;
+                        answer->i_version= 0;
+
+                       if (b_auth_failed) {
+                            httpd_MsgAdd(answer, "WWW-Authenticate",
+                                    "Basic realm=\"VLC stream\"");
+                            answer->i_status = 401;
+                        } else
+                            answer->i_status = 404; /* no url registered */
+
+                        char *p;
+                        answer->i_body = httpd_HtmlError (&p, answer->i_status,
+                                query->psz_url);
+                        answer->p_body = (uint8_t *)p;
+
+                        cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
+                        httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+                        httpd_MsgAdd(answer, "Content-Type", "%s", "text/html");
+                        if (httpd_MsgGet(&cl->query, "Connection") != NULL)
+                            httpd_MsgAdd(answer, "Connection", "close");
+                    }
 
-                            p = httpd_MsgGet(query, "Require");
-                            if (p) {
-                                answer->i_status = 551;
-                                httpd_MsgAdd(query, "Unsupported", "%s", p);
-                            }
+                    cl->i_state = HTTPD_CLIENT_SENDING;
+                }
+            }
+            break;
+        }
 
-                            httpd_MsgAdd(answer, "Public", "DESCRIBE,SETUP,"
-                                    "TEARDOWN,PLAY,PAUSE,GET_PARAMETER");
-                            break;
-                        }
+        case HTTPD_CLIENT_SEND_DONE:
+            if (!cl->b_stream_mode || cl->answer.i_body_offset == 0) {
+                bool do_close = false;
 
-                        if (httpd_MsgGet(&cl->query, "Connection") != NULL)
-                            httpd_MsgAdd(answer, "Connection", "close");
+                cl->url = NULL;
 
-                        cl->i_buffer = -1;  /* Force the creation of the answer in
-                                             * httpd_ClientSend */
-                        cl->i_state = HTTPD_CLIENT_SENDING;
-                        break;
+                if (cl->query.i_proto != HTTPD_PROTO_HTTP
+                 || cl->query.i_version > 0)
+                {
+                    const char *psz_connection = httpd_MsgGet(&cl->answer,
+                                                             "Connection");
+                    if (psz_connection != NULL)
+                        do_close = !strcasecmp(psz_connection, "close");
+                }
+                else
+                    do_close = true;
 
-                    case HTTPD_MSG_NONE:
-                        if (query->i_proto == HTTPD_PROTO_NONE) {
-                            cl->url = NULL;
-                            cl->i_state = HTTPD_CLIENT_DEAD;
-                        } else {
-                            /* unimplemented */
-                            answer->i_proto  = query->i_proto ;
-                            answer->i_type   = HTTPD_MSG_ANSWER;
-                            answer->i_version= 0;
-                            answer->i_status = 501;
-
-                            char *p;
-                            answer->i_body = httpd_HtmlError (&p, 501, NULL);
-                            answer->p_body = (uint8_t *)p;
-                            httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
-                            httpd_MsgAdd(answer, "Connection", "close");
+                if (!do_close) {
+                    httpd_MsgClean(&cl->query);
+                    httpd_MsgInit(&cl->query);
 
-                            cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
-                            cl->i_state = HTTPD_CLIENT_SENDING;
-                        }
-                        break;
+                    cl->i_buffer = 0;
+                    cl->i_buffer_size = 1000;
+                    free(cl->p_buffer);
+                    // Allocate an extra byte for the null terminating byte
+                    cl->p_buffer = xmalloc(cl->i_buffer_size + 1);
+                    cl->i_state = HTTPD_CLIENT_RECEIVING;
+                } else
+                    cl->i_state = HTTPD_CLIENT_DEAD;
+                httpd_MsgClean(&cl->answer);
+            } else {
+                i_offset = cl->answer.i_body_offset;
+                httpd_MsgClean(&cl->answer);
 
-                    default: {
-                        httpd_url_t *url;
-                        int i_msg = query->i_type;
-                        bool b_auth_failed = false;
-
-                        /* Search the url and trigger callbacks */
-                        vlc_list_foreach(url, &host->urls, node) {
-                            if (strcmp(url->psz_url, query->psz_url))
-                                continue;
-                            if (!url->catch[i_msg].cb)
-                                continue;
-
-                            if (answer) {
-                                b_auth_failed = !httpdAuthOk(url->psz_user,
-                                   url->psz_password,
-                                   httpd_MsgGet(query, "Authorization")); /* BASIC id */
-                                if (b_auth_failed)
-                                   break;
-                            }
-
-                            if (url->catch[i_msg].cb(url->catch[i_msg].p_sys, cl, answer, query))
-                                continue;
-
-                            if (answer->i_proto == HTTPD_PROTO_NONE)
-                                cl->i_buffer = cl->i_buffer_size; /* Raw answer from a CGI */
-                            else
-                                cl->i_buffer = -1;
-
-                            /* only one url can answer */
-                            answer = NULL;
-                            if (!cl->url)
-                                cl->url = url;
-                        }
+                cl->answer.i_body_offset = i_offset;
+                free(cl->p_buffer);
+                cl->p_buffer = NULL;
+                cl->i_buffer = 0;
+                cl->i_buffer_size = 0;
 
-                        if (answer) {
-                            answer->i_proto  = query->i_proto;
-                            answer->i_type   = HTTPD_MSG_ANSWER;
-                            answer->i_version= 0;
-
-                           if (b_auth_failed) {
-                                httpd_MsgAdd(answer, "WWW-Authenticate",
-                                        "Basic realm=\"VLC stream\"");
-                                answer->i_status = 401;
-                            } else
-                                answer->i_status = 404; /* no url registered */
-
-                            char *p;
-                            answer->i_body = httpd_HtmlError (&p, answer->i_status,
-                                    query->psz_url);
-                            answer->p_body = (uint8_t *)p;
-
-                            cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
-                            httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
-                            httpd_MsgAdd(answer, "Content-Type", "%s", "text/html");
-                            if (httpd_MsgGet(&cl->query, "Connection") != NULL)
-                                httpd_MsgAdd(answer, "Connection", "close");
-                        }
+                cl->i_state = HTTPD_CLIENT_WAITING;
+            }
+            break;
 
-                        cl->i_state = HTTPD_CLIENT_SENDING;
-                    }
-                }
-                break;
+        case HTTPD_CLIENT_WAITING:
+            i_offset = cl->answer.i_body_offset;
+            int i_msg = cl->query.i_type;
+
+            httpd_MsgInit(&cl->answer);
+            cl->answer.i_body_offset = i_offset;
+
+            cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
+                    &cl->answer, &cl->query);
+            if (cl->answer.i_type != HTTPD_MSG_NONE) {
+                /* we have new data, so re-enter send mode */
+                cl->i_buffer      = 0;
+                cl->p_buffer      = cl->answer.p_body;
+                cl->i_buffer_size = cl->answer.i_body;
+                cl->answer.p_body = NULL;
+                cl->answer.i_body = 0;
+                cl->i_state = HTTPD_CLIENT_SENDING;
             }
+    }
+}
 
-            case HTTPD_CLIENT_SEND_DONE:
-                if (!cl->b_stream_mode || cl->answer.i_body_offset == 0) {
-                    bool do_close = false;
+static bool httpd_ClientTimedOut(const httpd_client_t *cl, vlc_tick_t now)
+{
+    return cl->i_activity_timeout > 0
+        && cl->i_activity_date + cl->i_activity_timeout < now;
+}
 
-                    cl->url = NULL;
+/* Sets the socket events the worker waits for */
+static int httpd_ClientArm(httpd_client_t *cl, short events)
+{
+    if (events != 0)
+        cl->fd = vlc_tls_GetPollFD(cl->sock, &events);
+    if (events == cl->i_poll_events)
+        return 0;
 
-                    if (cl->query.i_proto != HTTPD_PROTO_HTTP
-                     || cl->query.i_version > 0)
-                    {
-                        const char *psz_connection = httpd_MsgGet(&cl->answer,
-                                                                 "Connection");
-                        if (psz_connection != NULL)
-                            do_close = !strcasecmp(psz_connection, "close");
-                    }
-                    else
-                        do_close = true;
-
-                    if (!do_close) {
-                        httpd_MsgClean(&cl->query);
-                        httpd_MsgInit(&cl->query);
-
-                        cl->i_buffer = 0;
-                        cl->i_buffer_size = 1000;
-                        free(cl->p_buffer);
-                        // Allocate an extra byte for the null terminating byte
-                        cl->p_buffer = xmalloc(cl->i_buffer_size + 1);
-                        cl->i_state = HTTPD_CLIENT_RECEIVING;
-                    } else
-                        cl->i_state = HTTPD_CLIENT_DEAD;
-                    httpd_MsgClean(&cl->answer);
-                } else {
-                    i_offset = cl->answer.i_body_offset;
-                    httpd_MsgClean(&cl->answer);
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event ev = {
+        .events = ((events & POLLIN) ? EPOLLIN : 0)
+                | ((events & POLLOUT) ? EPOLLOUT : 0),
+        .data.ptr = cl,
+    };
+    int op = (events == 0) ? EPOLL_CTL_DEL
+           : (cl->i_poll_events == 0) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+
+    if (epoll_ctl(cl->worker->epfd, op, cl->fd, &ev)) {
+        msg_Err(cl->worker->host, "cannot poll client: %s",
+                vlc_strerror_c(errno));
+        if (op != EPOLL_CTL_ADD)
+            epoll_ctl(cl->worker->epfd, EPOLL_CTL_DEL, cl->fd, NULL);
+        cl->i_poll_events = 0;
+        return -1;
+    }
+#endif
+    cl->i_poll_events = events;
+    return 0;
+}
 
-                    cl->answer.i_body_offset = i_offset;
-                    free(cl->p_buffer);
-                    cl->p_buffer = NULL;
-                    cl->i_buffer = 0;
-                    cl->i_buffer_size = 0;
+/* Runs the client up to its next wait, and files it accordingly */
+static void httpd_ClientUpdate(httpd_client_t *cl)
+{
+    httpd_worker_t *w = cl->worker;
+    short events = 0;
 
-                    cl->i_state = HTTPD_CLIENT_WAITING;
-                }
-                break;
+    while (cl->i_state == HTTPD_CLIENT_RECEIVE_DONE
+        || cl->i_state == HTTPD_CLIENT_SEND_DONE)
+        httpd_ClientProcess(w->host, cl);
 
-            case HTTPD_CLIENT_WAITING:
-                i_offset = cl->answer.i_body_offset;
-                int i_msg = cl->query.i_type;
+    /* poll for new stream data right away */
+    if (cl->i_state == HTTPD_CLIENT_WAITING)
+        httpd_ClientProcess(w->host, cl);
 
-                httpd_MsgInit(&cl->answer);
-                cl->answer.i_body_offset = i_offset;
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVING:
+        case HTTPD_CLIENT_TLS_HS_IN:
+            events = POLLIN;
+            break;
 
-                cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
-                        &cl->answer, &cl->query);
-                if (cl->answer.i_type != HTTPD_MSG_NONE) {
-                    /* we have new data, so re-enter send mode */
-                    cl->i_buffer      = 0;
-                    cl->p_buffer      = cl->answer.p_body;
-                    cl->i_buffer_size = cl->answer.i_body;
-                    cl->answer.p_body = NULL;
-                    cl->answer.i_body = 0;
-                    cl->i_state = HTTPD_CLIENT_SENDING;
-                }
+        case HTTPD_CLIENT_SENDING:
+        case HTTPD_CLIENT_TLS_HS_OUT:
+            events = POLLOUT;
+            break;
+    }
+
+    if (httpd_ClientArm(cl, events))
+        cl->i_state = HTTPD_CLIENT_DEAD;
+
+    bool b_waiting = cl->i_poll_events == 0;
+    if (b_waiting != cl->b_waiting) {
+        vlc_list_remove(&cl->node);
+        vlc_list_append(&cl->node, b_waiting ? &w->waiting : &w->clients);
+        cl->b_waiting = b_waiting;
+    }
+}
+
+/* Detaches a client from its url, the worker will destroy it */
+static void httpd_ClientKill(httpd_client_t *cl)
+{
+    cl->url = NULL;
+    cl->i_state = HTTPD_CLIENT_DEAD;
+    httpd_ClientUpdate(cl);
+}
+
+static void httpd_ClientEvent(httpd_client_t *cl, vlc_tick_t now)
+{
+    cl->i_activity_date = now;
+
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
+        case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
+        case HTTPD_CLIENT_TLS_HS_IN:
+        case HTTPD_CLIENT_TLS_HS_OUT:
+            httpd_ClientTlsHandshake(cl->worker->host, cl);
+            break;
+    }
+    httpd_ClientUpdate(cl);
+}
+
+/* Accepts a new connection on a listening socket */
+static void httpd_WorkerAccept(httpd_worker_t *w, int fd, vlc_tick_t now)
+{
+    httpd_host_t *host = w->host;
+
+    fd = vlc_accept (fd, NULL, NULL, true);
+    if (fd == -1)
+        return; /* taken by another worker */
+    setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
+            &(int){ 1 }, sizeof(int));
+
+    vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
+    if (unlikely(sk == NULL))
+    {
+        vlc_close(fd);
+        return;
+    }
+
+    if (host->p_tls != NULL)
+    {
+        const char *alpn[] = { "http/1.1", NULL };
+        vlc_tls_t *tls;
+
+        tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
+        if (tls == NULL)
+        {
+            vlc_tls_SessionDelete(sk);
+            return;
         }
+        sk = tls;
+    }
+
+    httpd_client_t *cl = httpd_ClientNew(w, sk, now);
+    if (unlikely(cl == NULL))
+    {
+        vlc_tls_Close(sk);
+        return;
+    }
 
-        pufd->fd = vlc_tls_GetPollFD(cl->sock, &pufd->events);
+    if (host->p_tls != NULL)
+        cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
 
-        if (pufd->events != 0)
-            nfd++;
+    w->client_count++;
+    vlc_list_append(&cl->node, &w->clients);
+    httpd_ClientUpdate(cl);
+}
+
+/* Serves the clients waiting for stream data, and destroys the dead ones.
+ * Other clients only need to be looked at once in a while for timeouts. */
+static void httpd_WorkerSweep(httpd_worker_t *w, vlc_tick_t now)
+{
+    httpd_client_t *cl;
+
+    vlc_list_foreach(cl, &w->waiting, node) {
+        if (cl->i_state == HTTPD_CLIENT_DEAD || httpd_ClientTimedOut(cl, now))
+            httpd_ClientDestroy(cl);
         else
-            b_low_delay = true;
+            httpd_ClientUpdate(cl);
     }
-    vlc_mutex_unlock(&host->lock);
-    vlc_restorecancel(canc);
 
+    if (now < w->next_sweep)
+        return;
+
+    vlc_list_foreach(cl, &w->clients, node)
+        if (cl->i_state == HTTPD_CLIENT_DEAD || httpd_ClientTimedOut(cl, now))
+            httpd_ClientDestroy(cl);
+
+    w->next_sweep = now + VLC_TICK_FROM_SEC(1);
+}
+
+/* Returns the poll timeout of the worker, in milliseconds */
+static int httpd_WorkerTimeout(httpd_worker_t *w)
+{
     /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
-    while (poll(ufd, nfd, b_low_delay ? 20 : -1) < 0)
+    if (!vlc_list_is_empty(&w->waiting))
+        return 20;
+    if (w->client_count == 0)
+        return -1;
+
+    vlc_tick_t delay = w->next_sweep - vlc_tick_now();
+    return (delay > 0) ? MS_FROM_VLC_TICK(delay) + 1 : 0;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+# define HTTPD_EVENTS 64
+
+static void httpdLoop(httpd_worker_t *w)
+{
+    httpd_host_t *host = w->host;
+    struct epoll_event ev[HTTPD_EVENTS];
+    int n;
+
+    vlc_mutex_lock(&w->lock);
+    int timeout = httpd_WorkerTimeout(w);
+    vlc_mutex_unlock(&w->lock);
+
+    while ((n = epoll_wait(w->epfd, ev, ARRAY_SIZE(ev), timeout)) < 0)
     {
         if (errno != EINTR)
             msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
     }
 
-    canc = vlc_savecancel();
-    vlc_mutex_lock(&host->lock);
+    int canc = vlc_savecancel();
+    vlc_mutex_lock(&w->lock);
 
-    /* Handle client sockets */
-    now = vlc_tick_now();
-    nfd = host->nfd;
+    vlc_tick_t now = vlc_tick_now();
 
-    vlc_list_foreach(cl, &host->clients, node) {
-        const struct pollfd *pufd = &ufd[nfd];
+    for (int i = 0; i < n; i++) {
+        httpd_client_t *cl = ev[i].data.ptr;
 
-        assert(pufd < &ufd[ARRAY_SIZE(ufd)]);
+        if (cl != NULL)
+            httpd_ClientEvent(cl, now);
+        else /* Handle server sockets (accept new connections) */
+            for (unsigned j = 0; j < host->nfd; j++)
+                httpd_WorkerAccept(w, host->fds[j], now);
+    }
 
-        if (vlc_tls_GetFD(cl->sock) != pufd->fd)
-            continue; // we were not waiting for this client
-        ++nfd;
-        if (pufd->revents == 0)
-            continue; // no event received
+    httpd_WorkerSweep(w, now);
 
-        cl->i_activity_date = now;
+    vlc_mutex_unlock(&w->lock);
+    vlc_restorecancel(canc);
+}
+#else
+static void httpdLoop(httpd_worker_t *w)
+{
+    httpd_host_t *host = w->host;
+    /* clients are only added and destroyed by this thread */
+    struct pollfd ufd[host->nfd + w->client_count];
+    httpd_client_t *ucl[ARRAY_SIZE(ufd)];
+    unsigned nfd;
 
-        switch (cl->i_state) {
-            case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
-            case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
-            case HTTPD_CLIENT_TLS_HS_IN:
-            case HTTPD_CLIENT_TLS_HS_OUT:
-                httpd_ClientTlsHandshake(host, cl);
-                break;
-        }
+    for (nfd = 0; nfd < host->nfd; nfd++) {
+        ufd[nfd].fd = host->fds[nfd];
+        ufd[nfd].events = POLLIN;
+        ufd[nfd].revents = 0;
+        ucl[nfd] = NULL;
     }
 
-    /* Handle server sockets (accept new connections) */
-    for (nfd = 0; nfd < host->nfd; nfd++) {
-        int fd = ufd[nfd].fd;
+    vlc_mutex_lock(&w->lock);
+    httpd_client_t *cl;
 
-        assert (fd == host->fds[nfd]);
+    vlc_list_foreach(cl, &w->clients, node) {
+        assert(nfd < ARRAY_SIZE(ufd));
+        ufd[nfd].fd = cl->fd;
+        ufd[nfd].events = cl->i_poll_events;
+        ufd[nfd].revents = 0;
+        ucl[nfd++] = cl;
+    }
+    int timeout = httpd_WorkerTimeout(w);
+    vlc_mutex_unlock(&w->lock);
 
-        if (ufd[nfd].revents == 0)
-            continue;
+    while (poll(ufd, nfd, timeout) < 0)
+    {
+        if (errno != EINTR)
+            msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+    }
 
-        /* */
-        fd = vlc_accept (fd, NULL, NULL, true);
-        if (fd == -1)
-            continue;
-        setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
-                &(int){ 1 }, sizeof(int));
+    int canc = vlc_savecancel();
+    vlc_mutex_lock(&w->lock);
 
-        vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
-        if (unlikely(sk == NULL))
-        {
-            vlc_close(fd);
-            continue;
-        }
+    vlc_tick_t now = vlc_tick_now();
 
-        if (host->p_tls != NULL)
-        {
-            const char *alpn[] = { "http/1.1", NULL };
-            vlc_tls_t *tls;
+    for (unsigned i = 0; i < nfd; i++) {
+        if (ufd[i].revents == 0)
+            continue; // no event received
 
-            tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
-            if (tls == NULL)
-            {
-                vlc_tls_SessionDelete(sk);
-                continue;
-            }
-            sk = tls;
+        if (ucl[i] != NULL)
+            httpd_ClientEvent(ucl[i], now);
+        else /* Handle server sockets (accept new connections) */
+            httpd_WorkerAccept(w, ufd[i].fd, now);
+    }
+
+    httpd_WorkerSweep(w, now);
+
+    vlc_mutex_unlock(&w->lock);
+    vlc_restorecancel(canc);
+}
+#endif
+
+static void* httpd_WorkerThread(void *data)
+{
+    httpd_worker_t *w = data;
+    httpd_host_t *host = w->host;
+
+    while (atomic_load_explicit(&host->ref, memory_order_relaxed) > 0) {
+        /* do not accept connections until there is something to serve */
+        vlc_mutex_lock(&host->lock);
+        while (vlc_list_is_empty(&host->urls)) {
+            mutex_cleanup_push(&host->lock);
+            vlc_cond_wait(&host->wait, &host->lock);
+            vlc_cleanup_pop();
         }
+        vlc_mutex_unlock(&host->lock);
 
-        cl = httpd_ClientNew(sk, now);
+        httpdLoop(w);
+    }
+    return NULL;
+}
 
-        if (host->p_tls != NULL)
-            cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
+static int httpd_WorkerInit(httpd_host_t *host, httpd_worker_t *w)
+{
+    w->host = host;
+    vlc_mutex_init(&w->lock);
+    vlc_list_init(&w->clients);
+    vlc_list_init(&w->waiting);
+    w->client_count = 0;
+    w->next_sweep = vlc_tick_now();
+
+#ifdef HAVE_SYS_EPOLL_H
+    w->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (w->epfd == -1) {
+        msg_Err(host, "cannot create polling set: %s", vlc_strerror_c(errno));
+        return -1;
+    }
 
-        host->client_count++;
-        vlc_list_append(&cl->node, &host->clients);
+    /* every worker waits for new connections, but only one gets woken up */
+    for (unsigned i = 0; i < host->nfd; i++) {
+        struct epoll_event ev = {
+            .events = EPOLLIN
+# ifdef EPOLLEXCLUSIVE
+                    | EPOLLEXCLUSIVE
+# endif
+                    ,
+            .data.ptr = NULL,
+        };
+
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, host->fds[i], &ev)) {
+            msg_Err(host, "cannot poll socket: %s", vlc_strerror_c(errno));
+            vlc_close(w->epfd);
+            return -1;
+        }
     }
+#endif
+    return 0;
+}
 
-    vlc_mutex_unlock(&host->lock);
-    vlc_restorecancel(canc);
+static void httpd_WorkerClean(httpd_worker_t *w)
+{
+    httpd_client_t *client;
+
+    vlc_list_foreach(client, &w->clients, node) {
+        msg_Warn(w->host, "client still connected");
+        httpd_ClientDestroy(client);
+    }
+    vlc_list_foreach(client, &w->waiting, node) {
+        if (client->i_state != HTTPD_CLIENT_DEAD)
+            msg_Warn(w->host, "client still connected");
+        httpd_ClientDestroy(client);
+    }
+#ifdef HAVE_SYS_EPOLL_H
+    vlc_close(w->epfd);
+#endif
 }
 
-static void* httpd_HostThread(void *data)
+/* Stops and cleans the running workers */
+static void httpd_HostStop(httpd_host_t *host)
 {
-    httpd_host_t *host = data;
+    for (unsigned i = 0; i < host->worker_count; i++)
+        vlc_cancel(host->workers[i].thread);
 
-    while (atomic_load_explicit(&host->ref, memory_order_relaxed) > 0)
-        httpdLoop(host);
-    return NULL;
+    for (unsigned i = 0; i < host->worker_count; i++) {
+        vlc_join(host->workers[i].thread, NULL);
+        httpd_WorkerClean(&host->workers[i]);
+    }
+    free(host->workers);
+    host->workers = NULL;
+    host->worker_count = 0;
 }
 
 int httpd_StreamSetHTTPHeaders(httpd_stream_t * p_stream,
@@ -86,11 +86,108 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+#define CACHE_BLOCKS 1024
+
+static void *test_block_cache_Release (void *data)
+{
+    block_t **blocks = data;
+
+    for (size_t i = 0; i < CACHE_BLOCKS; i++)
+        block_Release (blocks[i]);
+    return NULL;
+}
+
+static vlc_threadvar_t late_key;
+
+static void test_block_cache_LateRelease (void *data)
+{
+    block_t *block = data;
+
+    /* Release in a second round of destructors, after the block cache of
+     * the thread is destroyed */
+    if (block->i_flags == 0)
+    {
+        block->i_flags = 1;
+        vlc_threadvar_set (late_key, block);
+        return;
+    }
+    block_Release (block);
+}
+
+static void *test_block_cache_Exit (void *data)
+{
+    (void) data;
+    block_Release (block_Alloc (188));
+    vlc_threadvar_set (late_key, block_Alloc (188));
+    return NULL;
+}
+
+static void test_block_cache (void)
+{
+    struct vlc_block_cache_stats before, after;
+    block_t *blocks[CACHE_BLOCKS];
+
+    block_cache_Stats (&before);
+
+    /* Same thread */
+    for (size_t i = 0; i < CACHE_BLOCKS; i++)
+    {
+        block_t *block = block_Alloc (188);
+        assert (block != NULL);
+        assert (block->i_buffer == 188);
+        assert (((uintptr_t)block->p_buffer % 32) == 0);
+        memset (block->p_buffer, i, block->i_buffer);
+        block_Release (block);
+    }
+
+    /* Produced in this thread, released in another one */
+    for (int round = 0; round < 4; round++)
+    {
+        for (size_t i = 0; i < CACHE_BLOCKS; i++)
+        {
+            blocks[i] = block_Alloc (1316);
+            assert (blocks[i] != NULL);
+            memset (blocks[i]->p_buffer, i, blocks[i]->i_buffer);
+        }
+
+        vlc_thread_t th;
+        int val = vlc_clone (&th, test_block_cache_Release, blocks,
+                             VLC_THREAD_PRIORITY_LOW);
+        assert (val == 0);
+        vlc_join (th, NULL);
+    }
+
+    block_cache_Stats (&after);
+#if !defined (__SANITIZE_ADDRESS__)
+    assert (after.hits > before.hits);
+    assert (after.misses >= before.misses);
+#endif
+
+    /* Released while the thread exits */
+    int val = vlc_threadvar_create (&late_key, test_block_cache_LateRelease);
+    assert (val == 0);
+    for (int i = 0; i < 4; i++)
+    {
+        vlc_thread_t th;
+        val = vlc_clone (&th, test_block_cache_Exit, NULL,
+                         VLC_THREAD_PRIORITY_LOW);
+        assert (val == 0);
+        vlc_join (th, NULL);
+    }
+    vlc_threadvar_delete (&late_key);
+
+    /* Large blocks are not cached */
+    block_t *block = block_Alloc (1 << 20);
+    assert (block != NULL);
+    block_Release (block);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_cache ();
     return 0;
 }
 
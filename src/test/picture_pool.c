@@ -22,6 +22,7 @@
 # include "config.h"
 #endif
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #undef NDEBUG
 #include <assert.h>
@@ -31,6 +32,9 @@
 #include <vlc_picture_pool.h>
 
 #define PICTURES 10
+#define LARGE_PICTURES 200 /* more than fit in a bitmap word */
+#define THREADS 16
+#define ITERATIONS 20000
 
 const char vlc_module_name[] = "test_picture_pool";
 
@@ -108,6 +112,100 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+static void test_large(void)
+{
+    picture_t *pics[LARGE_PICTURES];
+
+    pool = picture_pool_NewFromFormat(&fmt, LARGE_PICTURES);
+    assert(pool != NULL);
+    assert(picture_pool_GetSize(pool) == LARGE_PICTURES);
+
+    for (unsigned i = 0; i < LARGE_PICTURES; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+        for (unsigned j = 0; j < i; j++)
+            assert(pics[j]->p[0].p_pixels != pics[i]->p[0].p_pixels);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+
+    /* the last picture of the last bitmap word */
+    void *plane = pics[LARGE_PICTURES - 1]->p[0].p_pixels;
+    picture_Release(pics[LARGE_PICTURES - 1]);
+    pics[LARGE_PICTURES - 1] = picture_pool_Wait(pool);
+    assert(pics[LARGE_PICTURES - 1] != NULL);
+    assert(pics[LARGE_PICTURES - 1]->p[0].p_pixels == plane);
+
+    for (unsigned i = 0; i < LARGE_PICTURES; i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(pool);
+}
+
+/* Each picture must only be handed out to one thread at a time */
+static void *planes[PICTURES];
+static atomic_bool busy[PICTURES];
+
+static void *stress_thread(void *data)
+{
+    unsigned seed = (uintptr_t)data;
+
+    for (unsigned n = 0; n < ITERATIONS; n++) {
+        seed = seed * 1103515245 + 12345;
+
+        picture_t *pic = (seed & 0x10000) ? picture_pool_Wait(pool)
+                                          : picture_pool_Get(pool);
+        if (pic == NULL)
+            continue;
+
+        unsigned i = 0;
+        while (planes[i] != pic->p[0].p_pixels)
+            assert(++i < PICTURES);
+
+        assert(!atomic_exchange(&busy[i], true));
+        if (seed & 0x20000)
+            picture_Hold(pic), picture_Release(pic);
+        atomic_store(&busy[i], false);
+        picture_Release(pic);
+    }
+    return NULL;
+}
+
+static void test_stress(void)
+{
+    vlc_thread_t threads[THREADS];
+    picture_t *pics[PICTURES];
+
+    pool = picture_pool_NewFromFormat(&fmt, PICTURES);
+    assert(pool != NULL);
+
+    for (unsigned i = 0; i < PICTURES; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+        planes[i] = pics[i]->p[0].p_pixels;
+        atomic_init(&busy[i], false);
+    }
+    for (unsigned i = 0; i < PICTURES; i++)
+        picture_Release(pics[i]);
+
+    /* more threads than pictures, so that some of them wait */
+    static_assert(THREADS > PICTURES, "Not enough threads");
+    for (unsigned i = 0; i < THREADS; i++)
+        assert(!vlc_clone(&threads[i], stress_thread, (void *)(uintptr_t)i,
+                          VLC_THREAD_PRIORITY_LOW));
+    for (unsigned i = 0; i < THREADS; i++)
+        vlc_join(threads[i], NULL);
+
+    /* all the pictures went back to the pool */
+    for (unsigned i = 0; i < PICTURES; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+    for (unsigned i = 0; i < PICTURES; i++)
+        picture_Release(pics[i]);
+
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -124,6 +222,8 @@ int main(void)
 
     test(false);
     test(true);
+    test_large();
+    test_stress();
 
     return 0;
 }
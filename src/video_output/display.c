@@ -308,7 +308,7 @@ static vlc_decoder_device * DisplayHoldDecoderDevice(vlc_object_t *o, void *sys)
 }
 
 static const struct filter_video_callbacks vout_display_filter_cbs = {
-    VideoBufferNew, DisplayHoldDecoderDevice,
+    VideoBufferNew, DisplayHoldDecoderDevice, NULL,
 };
 
 static int VoutDisplayCreateRender(vout_display_t *vd)
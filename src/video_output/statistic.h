@@ -23,6 +23,12 @@
 #ifndef LIBVLC_VOUT_STATISTIC_H
 # define LIBVLC_VOUT_STATISTIC_H
 # include <stdatomic.h>
+# include <vlc_vout.h>
+
+/* Number of frame timings kept, and of queued pictures remembered to compute
+ * the latencies. Both must be powers of two. */
+#define VOUT_STATISTIC_FRAMES 256
+#define VOUT_STATISTIC_QUEUED 64
 
 /* NOTE: Both statistics are atomic on their own, so one might be older than
  * the other one. Currently, only one of them is updated at a time, so this
@@ -30,12 +36,25 @@
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+
+    /* Per-frame history, protected by lock */
+    vlc_mutex_t lock;
+    struct {
+        vlc_tick_t pts;
+        vlc_tick_t date;
+    } queued[VOUT_STATISTIC_QUEUED];
+    uint64_t queued_count;
+    vout_frame_timing_t frames[VOUT_STATISTIC_FRAMES];
+    uint64_t frames_count;
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    vlc_mutex_init(&stat->lock);
+    stat->queued_count = 0;
+    stat->frames_count = 0;
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -64,4 +83,57 @@ static inline void vout_statistic_AddLost(vout_statistic_t *stat, int lost)
     atomic_fetch_add_explicit(&stat->lost, lost, memory_order_relaxed);
 }
 
+/* Remembers when a picture was queued to the video output */
+static inline void vout_statistic_AddQueued(vout_statistic_t *stat,
+                                            vlc_tick_t pts, vlc_tick_t date)
+{
+    vlc_mutex_lock(&stat->lock);
+    size_t i = stat->queued_count++ % VOUT_STATISTIC_QUEUED;
+    stat->queued[i].pts = pts;
+    stat->queued[i].date = date;
+    vlc_mutex_unlock(&stat->lock);
+}
+
+/* Records the timings of a displayed or dropped picture. The latency is
+ * computed from the last queued picture with a timestamp not after the
+ * frame one, as filters may create or retime pictures. */
+static inline void vout_statistic_AddFrame(vout_statistic_t *stat,
+                                           const vout_frame_timing_t *frame)
+{
+    vlc_mutex_lock(&stat->lock);
+    vout_frame_timing_t *entry =
+        &stat->frames[stat->frames_count++ % VOUT_STATISTIC_FRAMES];
+
+    *entry = *frame;
+    entry->latency = VLC_TICK_INVALID;
+
+    uint64_t count = stat->queued_count < VOUT_STATISTIC_QUEUED ?
+                     stat->queued_count : VOUT_STATISTIC_QUEUED;
+    for (uint64_t i = 1; i <= count; i++) {
+        size_t j = (stat->queued_count - i) % VOUT_STATISTIC_QUEUED;
+        if (stat->queued[j].pts <= frame->pts) {
+            entry->latency = frame->date - stat->queued[j].date;
+            break;
+        }
+    }
+    vlc_mutex_unlock(&stat->lock);
+}
+
+/* Copies the last frame timings, oldest first */
+static inline size_t vout_statistic_GetFrames(vout_statistic_t *stat,
+                                              vout_frame_timing_t *frames,
+                                              size_t max)
+{
+    vlc_mutex_lock(&stat->lock);
+    uint64_t count = stat->frames_count < VOUT_STATISTIC_FRAMES ?
+                     stat->frames_count : VOUT_STATISTIC_FRAMES;
+    if (count > max)
+        count = max;
+    for (uint64_t i = 0; i < count; i++)
+        frames[i] = stat->frames[(stat->frames_count - count + i)
+                                 % VOUT_STATISTIC_FRAMES];
+    vlc_mutex_unlock(&stat->lock);
+    return count;
+}
+
 #endif
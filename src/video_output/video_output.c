@@ -223,6 +223,14 @@ void vout_GetResetStatistic(vout_thread_t *vout, unsigned *restrict displayed,
     vout_statistic_GetReset( &vout->p->statistic, displayed, lost );
 }
 
+size_t vout_GetFrameTimings(vout_thread_t *vout, vout_frame_timing_t *frames,
+                            size_t max)
+{
+    if (vout->p->dummy)
+        return 0;
+    return vout_statistic_GetFrames(&vout->p->statistic, frames, max);
+}
+
 bool vout_IsEmpty(vout_thread_t *vout)
 {
     assert(!vout->p->dummy);
@@ -349,6 +357,8 @@ void vout_PutPicture(vout_thread_t *vout, picture_t *picture)
 {
     assert(!vout->p->dummy);
     picture->p_next = NULL;
+    vout_statistic_AddQueued(&vout->p->statistic, picture->date,
+                             vlc_tick_now());
     picture_fifo_Push(vout->p->decoder_fifo, picture);
     vout_control_Wake(&vout->p->control);
 }
@@ -917,6 +927,13 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse,
                         late_threshold = VOUT_DISPLAY_LATE_THRESHOLD;
                     if (late > late_threshold) {
                         msg_Warn(vout, "picture is too late to be displayed (missing %"PRId64" ms)", MS_FROM_VLC_TICK(late));
+                        vout_frame_timing_t timing = {
+                            .pts = decoded->date,
+                            .date = date,
+                            .slip = late,
+                            .status = VOUT_FRAME_DROPPED_LATE,
+                        };
+                        vout_statistic_AddFrame(&vout->p->statistic, &timing);
                         picture_Release(decoded);
                         vout_statistic_AddLost(&vout->p->statistic, 1);
                         continue;
@@ -975,7 +992,7 @@ static vlc_decoder_device * VoutHoldDecoderDevice(vlc_object_t *o, void *sys)
 }
 
 static const struct filter_video_callbacks vout_video_cbs = {
-    NULL, VoutHoldDecoderDevice,
+    NULL, VoutHoldDecoderDevice, NULL,
 };
 
 static picture_t *ConvertRGB32AndBlend(vout_thread_t *vout, picture_t *pic,
@@ -1035,6 +1052,10 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     vout_thread_sys_t *sys = vout->p;
 
     picture_t *torender = picture_Hold(sys->displayed.current);
+    vout_frame_timing_t timing = {
+        .pts = torender->date,
+        .date = vlc_tick_now(),
+    };
 
     vout_chrono_Start(&sys->render);
 
@@ -1042,8 +1063,13 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     picture_t *filtered = filter_chain_VideoFilter(sys->filter.chain_interactive, torender);
     vlc_mutex_unlock(&sys->filter.lock);
 
-    if (!filtered)
+    if (!filtered) {
+        timing.status = VOUT_FRAME_DROPPED_FILTER;
+        timing.render = vlc_tick_now() - timing.date;
+        timing.date += timing.render;
+        vout_statistic_AddFrame(&sys->statistic, &timing);
         return VLC_EGENERIC;
+    }
 
     if (filtered->date != sys->displayed.current->date)
         msg_Warn(vout, "Unsupported timestamp modifications done by chain_interactive");
@@ -1195,6 +1221,11 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
         if (subpic != NULL)
             subpicture_Delete(subpic);
+
+        timing.status = VOUT_FRAME_DROPPED_CONVERT;
+        timing.render = vlc_tick_now() - timing.date;
+        timing.date += timing.render;
+        vout_statistic_AddFrame(&sys->statistic, &timing);
         return VLC_EGENERIC;
     }
 
@@ -1202,6 +1233,7 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         picture_BlendSubpicture(todisplay, sys->spu_blend, subpic);
 
     system_now = vlc_tick_now();
+    timing.render = system_now - timing.date;
     const vlc_tick_t pts = todisplay->date;
     vlc_tick_t system_pts = is_forced ? system_now :
         vlc_clock_ConvertToSystem(sys->clock, system_now, pts, sys->rate);
@@ -1214,11 +1246,13 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
         is_forced = true;
     }
 
+    const vlc_tick_t expected_pts = system_pts;
     const unsigned frame_rate = todisplay->format.i_frame_rate;
     const unsigned frame_rate_base = todisplay->format.i_frame_rate_base;
 
     if (vd->prepare != NULL)
         vd->prepare(vd, todisplay, do_dr_spu ? subpic : NULL, system_pts);
+    timing.prepare = vlc_tick_now() - system_now;
 
     vout_chrono_Stop(&sys->render);
 #if 0
@@ -1260,12 +1294,19 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
                           frame_rate, frame_rate_base);
 
     /* Display the direct buffer returned by vout_RenderPicture */
+    timing.date = vlc_tick_now();
     vout_display_Display(vd, todisplay);
     vlc_mutex_unlock(&sys->display_lock);
 
     if (subpic)
         subpicture_Delete(subpic);
 
+    timing.pts = pts;
+    timing.status = VOUT_FRAME_DISPLAYED;
+    timing.forced = is_forced;
+    if (!is_forced)
+        timing.slip = timing.date - expected_pts;
+    vout_statistic_AddFrame(&sys->statistic, &timing);
     vout_statistic_AddDisplayed(&sys->statistic, 1);
 
     return VLC_SUCCESS;
@@ -1549,10 +1590,10 @@ static int vout_Start(vout_thread_t *vout, vlc_video_context *vctx, const vout_c
     sys->filter.src_vctx = vctx ? vlc_video_context_Hold(vctx) : NULL;
 
     static const struct filter_video_callbacks static_cbs = {
-        VoutVideoFilterStaticNewPicture, VoutHoldDecoderDevice,
+        VoutVideoFilterStaticNewPicture, VoutHoldDecoderDevice, NULL,
     };
     static const struct filter_video_callbacks interactive_cbs = {
-        VoutVideoFilterInteractiveNewPicture, VoutHoldDecoderDevice,
+        VoutVideoFilterInteractiveNewPicture, VoutHoldDecoderDevice, NULL,
     };
     filter_owner_t owner = {
         .video = &static_cbs,
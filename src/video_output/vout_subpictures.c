@@ -75,6 +75,31 @@ typedef struct VLC_VECTOR(struct spu_channel) spu_channel_vector;
 typedef struct VLC_VECTOR(subpicture_t *) spu_prerender_vector;
 #define SPU_CHROMALIST_COUNT 8
 
+/* Scaled and converted region pictures, kept across subpictures */
+#define SPU_CACHE_SIZE    8
+#define SPU_CACHE_MAX_AGE 250 /* in calls to spu_Render() */
+
+typedef struct {
+    uint64_t   hash;     /**< hash of the key */
+    uint8_t    *key;     /**< all the inputs of the picture, serialized */
+    size_t     key_size;
+    picture_t  *picture; /**< final region picture, NULL if unused */
+    video_format_t fmt;  /**< rendered text region format */
+    int        dx, dy;   /**< rendered text region offset */
+    uint64_t   last_use; /**< spu_Render() call of the last hit */
+} spu_cache_entry_t;
+
+typedef struct {
+    spu_cache_entry_t entries[SPU_CACHE_SIZE];
+    uint8_t         *key;      /**< key being built */
+    size_t          key_size;
+    size_t          key_alloc;
+    bool            key_error; /**< the key could not be built */
+    uint64_t        date;      /**< number of spu_Render() calls */
+    uint64_t        hits;
+    uint64_t        misses;
+} spu_cache_t;
+
 struct spu_private_t {
     vlc_mutex_t  lock;            /* lock to protect all followings fields */
     input_thread_t *input;
@@ -126,6 +151,9 @@ struct spu_private_t {
         vlc_fourcc_t    chroma_list[SPU_CHROMALIST_COUNT+1];
     } prerender;
 
+    spu_cache_t cache;                  /**< scaled and converted regions */
+    spu_cache_t text_cache;       /**< rendered text, protected by textlock */
+
     /* */
     vlc_tick_t          last_sort_date;
     vout_thread_t       *vout;
@@ -305,6 +333,279 @@ static filter_t *SpuRenderCreateAndLoadScale(vlc_object_t *object,
     return scale;
 }
 
+/*****************************************************************************
+ * Region cache
+ *****************************************************************************
+ * Producers often send the same content again in new subpictures: logos and
+ * marquees from subpicture sources, repeated subtitle pages, OSD. Their
+ * rendered text, and their scaled and converted pictures are kept, so that
+ * they are only produced once. An entry is found by the hash of its key, but
+ * the key holds every input of the picture, and is compared in full. The
+ * pictures are shared and must not be modified.
+ *****************************************************************************/
+static void SpuCacheInit(spu_cache_t *cache)
+{
+    for (size_t i = 0; i < SPU_CACHE_SIZE; i++) {
+        cache->entries[i].key = NULL;
+        cache->entries[i].picture = NULL;
+    }
+    cache->key = NULL;
+    cache->key_alloc = 0;
+    cache->date = 0;
+    cache->hits = cache->misses = 0;
+}
+
+static void SpuCacheEntryClean(spu_cache_entry_t *entry)
+{
+    picture_Release(entry->picture);
+    entry->picture = NULL;
+    free(entry->key);
+    entry->key = NULL;
+    video_format_Clean(&entry->fmt);
+}
+
+/* Drops the pictures which were not used for a while */
+static void SpuCacheExpire(spu_cache_t *cache, bool all)
+{
+    for (size_t i = 0; i < SPU_CACHE_SIZE; i++) {
+        spu_cache_entry_t *entry = &cache->entries[i];
+
+        if (entry->picture != NULL &&
+            (all || cache->date - entry->last_use > SPU_CACHE_MAX_AGE))
+            SpuCacheEntryClean(entry);
+    }
+}
+
+static void SpuCacheClean(spu_t *spu, spu_cache_t *cache, const char *name)
+{
+    SpuCacheExpire(cache, true);
+    free(cache->key);
+    if (cache->hits + cache->misses > 0)
+        msg_Dbg(spu, "%s cache: %"PRIu64" hit(s), %"PRIu64" miss(es)",
+                name, cache->hits, cache->misses);
+}
+
+static void SpuCacheKeyStart(spu_cache_t *cache)
+{
+    cache->key_size = 0;
+    cache->key_error = false;
+}
+
+static void SpuCacheKeyAppend(spu_cache_t *cache, const void *data, size_t size)
+{
+    if (cache->key_error)
+        return;
+    if (size > cache->key_alloc - cache->key_size) {
+        size_t alloc = __MAX(cache->key_size + size, 2 * cache->key_alloc);
+        uint8_t *key = realloc(cache->key, alloc);
+        if (unlikely(key == NULL)) {
+            cache->key_error = true;
+            return;
+        }
+        cache->key = key;
+        cache->key_alloc = alloc;
+    }
+    memcpy(&cache->key[cache->key_size], data, size);
+    cache->key_size += size;
+}
+
+static void SpuCacheKeyAppendString(spu_cache_t *cache, const char *str)
+{
+    /* NULL and empty strings differ */
+    const size_t size = str != NULL ? strlen(str) : SIZE_MAX;
+
+    SpuCacheKeyAppend(cache, &size, sizeof(size));
+    if (str != NULL)
+        SpuCacheKeyAppend(cache, str, size);
+}
+
+static void SpuCacheKeyAppendFormat(spu_cache_t *cache,
+                                    const video_format_t *fmt)
+{
+    const uint32_t params[] = {
+        fmt->i_chroma, fmt->i_width, fmt->i_height,
+        fmt->i_x_offset, fmt->i_y_offset,
+        fmt->i_visible_width, fmt->i_visible_height,
+        fmt->i_sar_num, fmt->i_sar_den,
+        fmt->i_rmask, fmt->i_gmask, fmt->i_bmask,
+        fmt->primaries, fmt->transfer, fmt->space, fmt->color_range,
+        fmt->p_palette != NULL,
+    };
+    SpuCacheKeyAppend(cache, params, sizeof(params));
+
+    if (fmt->p_palette != NULL)
+        SpuCacheKeyAppend(cache, fmt->p_palette,
+                          sizeof(fmt->p_palette->i_entries) +
+                          fmt->p_palette->i_entries *
+                          sizeof(fmt->p_palette->palette[0]));
+}
+
+/* Key of the scaled or converted picture of a region */
+static void SpuCacheKeyPicture(spu_cache_t *cache,
+                               const subpicture_region_t *region,
+                               unsigned dst_width, unsigned dst_height,
+                               bool convert_chroma, vlc_fourcc_t dst_chroma)
+{
+    const video_format_t *fmt = &region->fmt;
+    const picture_t *picture = region->p_picture;
+    const uint32_t params[] = {
+        dst_width, dst_height, convert_chroma, dst_chroma,
+    };
+
+    SpuCacheKeyStart(cache);
+    SpuCacheKeyAppend(cache, params, sizeof(params));
+    SpuCacheKeyAppendFormat(cache, fmt);
+
+    /* The pixels up to the end of the visible area, offset included */
+    for (int i = 0; i < picture->i_planes; i++) {
+        const plane_t *p = &picture->p[i];
+        const size_t bytes = __MIN((size_t)p->i_pitch, p->i_visible_pitch +
+            ((uint64_t)fmt->i_x_offset * p->i_visible_pitch +
+             fmt->i_visible_width - 1) / fmt->i_visible_width);
+        const int lines = __MIN(p->i_lines, p->i_visible_lines +
+            (int)(((uint64_t)fmt->i_y_offset * p->i_visible_lines +
+                   fmt->i_visible_height - 1) / fmt->i_visible_height));
+
+        for (int y = 0; y < lines; y++)
+            SpuCacheKeyAppend(cache, &p->p_pixels[y * p->i_pitch], bytes);
+    }
+}
+
+static void SpuCacheKeyAppendStyle(spu_cache_t *cache,
+                                   const text_style_t *style)
+{
+    const bool set = style != NULL;
+
+    SpuCacheKeyAppend(cache, &set, sizeof(set));
+    if (!set)
+        return;
+
+    SpuCacheKeyAppendString(cache, style->psz_fontname);
+    SpuCacheKeyAppendString(cache, style->psz_monofontname);
+
+    int32_t relsize;
+    static_assert(sizeof(relsize) == sizeof(style->f_font_relsize),
+                  "unexpected float size");
+    memcpy(&relsize, &style->f_font_relsize, sizeof(relsize));
+
+    const int32_t params[] = {
+        style->i_features, style->i_style_flags, relsize,
+        style->i_font_size, style->i_font_color, style->i_font_alpha,
+        style->i_spacing,
+        style->i_outline_color, style->i_outline_alpha,
+        style->i_outline_width,
+        style->i_shadow_color, style->i_shadow_alpha, style->i_shadow_width,
+        style->i_background_color, style->i_background_alpha,
+        style->e_wrapinfo,
+    };
+    SpuCacheKeyAppend(cache, params, sizeof(params));
+}
+
+/* Key of the rendered text of a region. The position is part of it, as it
+ * limits the width available to the text. */
+static void SpuCacheKeyText(spu_cache_t *cache, filter_t *text,
+                            const subpicture_region_t *region,
+                            const vlc_fourcc_t *chroma_list)
+{
+    SpuCacheKeyStart(cache);
+
+    const uint64_t settings = text->pf_render_settings(text);
+    SpuCacheKeyAppend(cache, &settings, sizeof(settings));
+
+    const int32_t params[] = {
+        text->fmt_out.video.i_width, text->fmt_out.video.i_height,
+        region->i_x, region->i_y, region->i_align, region->i_text_align,
+        region->b_noregionbg, region->b_gridmode, region->b_balanced_text,
+        region->i_max_width, region->i_max_height,
+    };
+    SpuCacheKeyAppend(cache, params, sizeof(params));
+    SpuCacheKeyAppendFormat(cache, &region->fmt);
+
+    size_t chromas = 0;
+    while (chroma_list[chromas] != 0)
+        chromas++;
+    SpuCacheKeyAppend(cache, chroma_list, (chromas + 1) * sizeof(*chroma_list));
+
+    for (const text_segment_t *seg = region->p_text; seg; seg = seg->p_next) {
+        SpuCacheKeyAppendString(cache, seg->psz_text);
+        SpuCacheKeyAppendStyle(cache, seg->style);
+        for (const text_segment_ruby_t *ruby = seg->p_ruby; ruby;
+             ruby = ruby->p_next) {
+            SpuCacheKeyAppendString(cache, ruby->psz_base);
+            SpuCacheKeyAppendString(cache, ruby->psz_rt);
+        }
+        SpuCacheKeyAppendString(cache, NULL); /* end of the ruby list */
+    }
+}
+
+static uint64_t SpuCacheHash(const uint8_t *p, size_t size)
+{
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+
+    for (; size >= 8; size -= 8, p += 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        hash = (hash ^ v) * UINT64_C(0x100000001b3);
+    }
+    for (; size > 0; size--, p++)
+        hash = (hash ^ *p) * UINT64_C(0x100000001b3);
+    return hash;
+}
+
+/* Looks up the key built last, returns NULL if there is none */
+static spu_cache_entry_t *SpuCacheGet(spu_cache_t *cache)
+{
+    if (cache->key_error)
+        return NULL;
+
+    const uint64_t hash = SpuCacheHash(cache->key, cache->key_size);
+    for (size_t i = 0; i < SPU_CACHE_SIZE; i++) {
+        spu_cache_entry_t *entry = &cache->entries[i];
+
+        if (entry->picture != NULL && entry->hash == hash &&
+            entry->key_size == cache->key_size &&
+            !memcmp(entry->key, cache->key, cache->key_size)) {
+            entry->last_use = cache->date;
+            cache->hits++;
+            return entry;
+        }
+    }
+    cache->misses++;
+    return NULL;
+}
+
+/* Stores a picture for the key built last */
+static spu_cache_entry_t *SpuCachePut(spu_cache_t *cache, picture_t *picture)
+{
+    if (cache->key_error)
+        return NULL;
+
+    uint8_t *key = malloc(cache->key_size);
+    if (unlikely(key == NULL))
+        return NULL;
+    memcpy(key, cache->key, cache->key_size);
+
+    /* Use a free entry, or the least recently used one */
+    spu_cache_entry_t *entry = &cache->entries[0];
+    for (size_t i = 1; i < SPU_CACHE_SIZE && entry->picture != NULL; i++) {
+        spu_cache_entry_t *other = &cache->entries[i];
+
+        if (other->picture == NULL || other->last_use < entry->last_use)
+            entry = other;
+    }
+
+    if (entry->picture != NULL)
+        SpuCacheEntryClean(entry);
+    entry->hash = SpuCacheHash(key, cache->key_size);
+    entry->key = key;
+    entry->key_size = cache->key_size;
+    entry->picture = picture_Hold(picture);
+    video_format_Init(&entry->fmt, 0);
+    entry->dx = entry->dy = 0;
+    entry->last_use = cache->date;
+    return entry;
+}
+
 static void SpuRenderText(spu_t *spu,
                           subpicture_region_t *region,
                           int i_original_width,
@@ -335,8 +636,37 @@ static void SpuRenderText(spu_t *spu,
         text->fmt_out.video.i_height         =
         text->fmt_out.video.i_visible_height = i_original_height;
 
-        if ( region->p_text )
+        if ( region->p_text && text->pf_render_settings == NULL )
             text->pf_render(text, region, region, chroma_list);
+        else if ( region->p_text )
+        {
+            /* Reuse the rendering of the same text */
+            spu_cache_t *cache = &sys->text_cache;
+            const int x = region->i_x, y = region->i_y;
+
+            SpuCacheKeyText(cache, text, region, chroma_list);
+            spu_cache_entry_t *entry = SpuCacheGet(cache);
+            if (entry != NULL)
+            {
+                video_format_Clean(&region->fmt);
+                video_format_Copy(&region->fmt, &entry->fmt);
+                region->p_picture = picture_Hold(entry->picture);
+                region->i_x = x + entry->dx;
+                region->i_y = y + entry->dy;
+            }
+            else if (text->pf_render(text, region, region, chroma_list) == VLC_SUCCESS
+                  && region->fmt.i_chroma != VLC_CODEC_TEXT
+                  && region->p_picture != NULL)
+            {
+                entry = SpuCachePut(cache, region->p_picture);
+                if (entry != NULL)
+                {
+                    video_format_Copy(&entry->fmt, &region->fmt);
+                    entry->dx = region->i_x - x;
+                    entry->dy = region->i_y - y;
+                }
+            }
+        }
     }
     vlc_mutex_unlock(&sys->textlock);
 }
@@ -973,6 +1303,20 @@ static void SpuRenderRegion(spu_t *spu,
             }
         }
 
+        /* Reuse the picture of a region with the same content */
+        if (!region->p_private && dst_width > 0 && dst_height > 0) {
+            SpuCacheKeyPicture(&sys->cache, region, dst_width, dst_height,
+                               convert_chroma, chroma_list[0]);
+
+            spu_cache_entry_t *cached = SpuCacheGet(&sys->cache);
+            if (cached) {
+                picture_t *picture = cached->picture;
+                region->p_private = subpicture_region_private_New(&picture->format);
+                if (region->p_private)
+                    region->p_private->p_picture = picture_Hold(picture);
+            }
+        }
+
         /* Scale if needed into cache */
         if (!region->p_private && dst_width > 0 && dst_height > 0) {
             filter_t *scale = sys->scale;
@@ -1004,25 +1348,31 @@ static void SpuRenderRegion(spu_t *spu,
                  picture->format.i_visible_height != dst_height ||
                  (convert_chroma && !using_palette)))
             {
-                scale->fmt_in.video  = picture->format;
-                scale->fmt_out.video = picture->format;
-                if (using_palette)
-                    scale->fmt_in.video.i_chroma = chroma_list[0];
-                if (convert_chroma)
-                    scale->fmt_out.i_codec        =
-                    scale->fmt_out.video.i_chroma = chroma_list[0];
-
-                scale->fmt_out.video.i_width  = dst_width;
-                scale->fmt_out.video.i_height = dst_height;
-
-                scale->fmt_out.video.i_visible_width =
-                    spu_scale_w(region->fmt.i_visible_width, scale_size);
-                scale->fmt_out.video.i_visible_height =
-                    spu_scale_h(region->fmt.i_visible_height, scale_size);
-
-                picture = scale->pf_video_filter(scale, picture);
-                if (!picture)
-                    msg_Err(spu, "scaling failed");
+                if (scale == NULL) {
+                    msg_Err(spu, "no subpicture scaler");
+                    picture_Release(picture);
+                    picture = NULL;
+                } else {
+                    scale->fmt_in.video  = picture->format;
+                    scale->fmt_out.video = picture->format;
+                    if (using_palette)
+                        scale->fmt_in.video.i_chroma = chroma_list[0];
+                    if (convert_chroma)
+                        scale->fmt_out.i_codec        =
+                        scale->fmt_out.video.i_chroma = chroma_list[0];
+
+                    scale->fmt_out.video.i_width  = dst_width;
+                    scale->fmt_out.video.i_height = dst_height;
+
+                    scale->fmt_out.video.i_visible_width =
+                        spu_scale_w(region->fmt.i_visible_width, scale_size);
+                    scale->fmt_out.video.i_visible_height =
+                        spu_scale_h(region->fmt.i_visible_height, scale_size);
+
+                    picture = scale->pf_video_filter(scale, picture);
+                    if (!picture)
+                        msg_Err(spu, "scaling failed");
+                }
             }
 
             /* */
@@ -1030,10 +1380,9 @@ static void SpuRenderRegion(spu_t *spu,
                 region->p_private = subpicture_region_private_New(&picture->format);
                 if (region->p_private) {
                     region->p_private->p_picture = picture;
-                    if (!region->p_private->p_picture) {
-                        subpicture_region_private_Delete(region->p_private);
-                        region->p_private = NULL;
-                    }
+                    /* the producer might still write to its own picture */
+                    if (picture != region->p_picture)
+                        SpuCachePut(&sys->cache, picture);
                 } else {
                     picture_Release(picture);
                 }
@@ -1607,6 +1956,9 @@ static void spu_Cleanup(spu_t *spu)
     for (size_t i = 0; i < sys->channels.size; ++i)
         spu_channel_Clean(sys, &sys->channels.data[i]);
 
+    SpuCacheClean(spu, &sys->cache, "region");
+    SpuCacheClean(spu, &sys->text_cache, "text");
+
     vlc_vector_destroy(&sys->channels);
 
     vlc_vector_clear(&sys->prerender.vector);
@@ -1685,12 +2037,16 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     sys->prerender.chroma_list[0] = 0;
     sys->prerender.chroma_list[SPU_CHROMALIST_COUNT] = 0;
 
+    SpuCacheInit(&sys->cache);
+    SpuCacheInit(&sys->text_cache);
+
     /* Load text and scale module */
     sys->text = SpuRenderCreateAndLoadText(spu);
     vlc_mutex_init(&sys->textlock);
 
     /* XXX spu->p_scale is used for all conversion/scaling except yuvp to
-     * yuva/rgba */
+     * yuva/rgba. Without it, only subpictures at the video scale and in a
+     * chroma of the display, or YUVP, can be rendered. */
     sys->scale = SpuRenderCreateAndLoadScale(VLC_OBJECT(spu),
                                              VLC_CODEC_YUVA, VLC_CODEC_RGBA, true);
 
@@ -1700,7 +2056,7 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
                                                   VLC_CODEC_YUVP, VLC_CODEC_YUVA, false);
 
 
-    if (!sys->source_chain || !sys->filter_chain || !sys->text || !sys->scale
+    if (!sys->source_chain || !sys->filter_chain || !sys->text
      || !sys->scale_yuvp)
     {
         sys->vout = NULL;
@@ -1737,6 +2093,8 @@ void spu_Attach(spu_t *spu, input_thread_t *input)
         if (spu->p->text)
             FilterRelease(spu->p->text);
         spu->p->text = SpuRenderCreateAndLoadText(spu);
+        /* the new renderer may render differently */
+        SpuCacheExpire(&spu->p->text_cache, true);
         vlc_mutex_unlock(&spu->p->textlock);
     }
     vlc_mutex_unlock(&spu->p->lock);
@@ -1949,6 +2307,13 @@ subpicture_t *spu_Render(spu_t *spu,
 
     vlc_mutex_lock(&sys->lock);
 
+    sys->cache.date++;
+    SpuCacheExpire(&sys->cache, false);
+    vlc_mutex_lock(&sys->textlock);
+    sys->text_cache.date++;
+    SpuCacheExpire(&sys->text_cache, false);
+    vlc_mutex_unlock(&sys->textlock);
+
     size_t subpicture_count;
 
     /* Get an array of subpictures to render */
@@ -209,6 +209,100 @@ static void test_media_player_pause_stop(const char** argv, int argc)
     libvlc_release (vlc);
 }
 
+struct time_wait
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    unsigned changes;
+};
+
+static void on_time_changed(const struct libvlc_event_t *event, void *data)
+{
+    (void) event;
+    struct time_wait *tw = data;
+
+    vlc_mutex_lock(&tw->lock);
+    tw->changes++;
+    vlc_cond_signal(&tw->wait);
+    vlc_mutex_unlock(&tw->lock);
+}
+
+static void test_media_player_frame_timings(const char** argv, int argc)
+{
+    libvlc_video_frame_timing_t timings[8];
+    int count;
+
+    test_log ("Testing frame timings\n");
+
+    libvlc_instance_t *vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    libvlc_media_t *md = libvlc_media_new_location (vlc,
+        "mock://video_track_count=1;length=100000000");
+    assert (md != NULL);
+
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media (md);
+    assert (mp != NULL);
+    libvlc_media_release (md);
+
+    struct time_wait tw = { .changes = 0 };
+    vlc_mutex_init (&tw.lock);
+    vlc_cond_init (&tw.wait);
+
+    libvlc_event_manager_t *em = libvlc_media_player_event_manager (mp);
+    int res = libvlc_event_attach (em, libvlc_MediaPlayerTimeChanged,
+                                   on_time_changed, &tw);
+    assert (!res);
+
+    play_and_wait (mp);
+
+    /* check again each time the playback advances, for up to 10 seconds */
+    vlc_tick_t deadline = vlc_tick_now () + VLC_TICK_FROM_SEC(10);
+    unsigned changes = 0;
+    while ((count = libvlc_video_get_frame_timings (mp, 0, timings, 8)) < 8)
+    {
+        vlc_mutex_lock (&tw.lock);
+        while (tw.changes == changes)
+            if (vlc_cond_timedwait (&tw.wait, &tw.lock, deadline))
+                break;
+        changes = tw.changes;
+        vlc_mutex_unlock (&tw.lock);
+        assert (vlc_tick_now () < deadline);
+    }
+
+    libvlc_event_detach (em, libvlc_MediaPlayerTimeChanged,
+                         on_time_changed, &tw);
+
+    for (int i = 0; i < count; i++)
+    {
+        assert (timings[i].i_render >= 0 && timings[i].i_prepare >= 0);
+        if (i > 0)
+            assert (timings[i].i_date >= timings[i - 1].i_date);
+        if (timings[i].i_status == libvlc_video_frame_displayed)
+            assert (timings[i].i_latency >= 0);
+    }
+
+    char path[] = "/tmp/libvlc_frame_timingsXXXXXX";
+    int fd = mkstemp (path);
+    assert (fd >= 0);
+    close (fd);
+
+    assert (libvlc_video_dump_frame_timings (mp, 0, path) == 0);
+
+    FILE *stream = fopen (path, "r");
+    assert (stream != NULL);
+    char line[256];
+    unsigned lines = 0;
+    while (fgets (line, sizeof (line), stream) != NULL)
+        lines++;
+    fclose (stream);
+    unlink (path);
+    assert (lines > 8); /* header and at least as many frames as above */
+
+    libvlc_media_player_stop_async (mp);
+    libvlc_media_player_release (mp);
+    libvlc_release (vlc);
+}
 
 int main (void)
 {
@@ -217,6 +311,7 @@ int main (void)
     test_media_player_set_media (test_defaults_args, test_defaults_nargs);
     test_media_player_play_stop (test_defaults_args, test_defaults_nargs);
     test_media_player_pause_stop (test_defaults_args, test_defaults_nargs);
+    test_media_player_frame_timings (test_defaults_args, test_defaults_nargs);
 
     return 0;
 }
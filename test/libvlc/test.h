@@ -39,6 +39,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <signal.h>
 
@@ -100,4 +101,49 @@ static inline void test_init (void)
     setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
 }
 
+/*********************************************************************
+ * Helpers for the kernel tests and benchmarks
+ */
+
+static inline uint32_t *test_rand_state (void)
+{
+    static uint32_t state = 1;
+    return &state;
+}
+
+/* Restarts the sequence of test_rand() */
+static inline void test_srand (uint32_t seed)
+{
+    *test_rand_state() = seed;
+}
+
+/* 16 pseudo-random bits, the same sequence on every platform (unlike
+ * rand()), so that failures can be reproduced */
+static inline unsigned test_rand (void)
+{
+    uint32_t *state = test_rand_state();
+
+    *state = *state * 1103515245 + 12345;
+    return *state >> 16;
+}
+
+/* Parses the "bench [count [rounds]]" command line of the tests that
+ * double as benchmarks. Returns false if there are no arguments, so the
+ * tests should run. Otherwise lifts the time limit, overrides the default
+ * count and rounds (if not NULL) with the given non-zero values, and
+ * returns true. */
+static inline bool test_bench_args (int argc, char *argv[], size_t *count,
+                                    unsigned *rounds)
+{
+    if (argc <= 1)
+        return false;
+
+    alarm (0); /* no time limit for benchmarks */
+    if (argc > 2 && strtoul(argv[2], NULL, 0) > 0)
+        *count = strtoul(argv[2], NULL, 0);
+    if (rounds != NULL && argc > 3 && strtoul(argv[3], NULL, 0) > 0)
+        *rounds = strtoul(argv[3], NULL, 0);
+    return true;
+}
+
 #endif /* TEST_H */
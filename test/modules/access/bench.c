@@ -0,0 +1,165 @@
+/*****************************************************************************
+ * bench.c: local file inputs micro benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Times reading a whole file through the regular file input, the
+ * memory-mapped one and the io_uring one, as demuxers do:
+ *
+ *   test_modules_access_bench [megabytes | file]
+ */
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_stream.h>
+#include <vlc_fs.h>
+#include <vlc_url.h>
+
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define RUNS 3
+#define READ_SIZE (188 * 1024)
+
+static vlc_tick_t cpu_time( void )
+{
+    struct rusage ru;
+    getrusage( RUSAGE_SELF, &ru );
+    return vlc_tick_from_timeval( &ru.ru_utime ) +
+           vlc_tick_from_timeval( &ru.ru_stime );
+}
+
+static const char *const inputs[] = {
+    "read",
+    "mmap",
+#ifdef HAVE_LINUX_IO_URING_H
+    "uring",
+#endif
+};
+
+static int run( const char *psz_url, unsigned i_input, bool b_block )
+{
+    const char * argv[] = {
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        NULL, /* last: --file-mmap or --file-uring */
+    };
+    char psz_option[16];
+
+    snprintf( psz_option, sizeof(psz_option), "--file-%s", inputs[i_input] );
+    argv[ARRAY_SIZE(argv) - 1] = psz_option;
+
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(argv) - (i_input == 0),
+                                         argv );
+    assert( vlc != NULL );
+
+    uint8_t *p_buf = malloc( READ_SIZE );
+    assert( p_buf != NULL );
+
+    uint64_t i_total = 0;
+    vlc_tick_t cpu = cpu_time();
+    vlc_tick_t start = vlc_tick_now();
+    for( unsigned i = 0; i < RUNS; i++ )
+    {
+        stream_t *s = vlc_stream_NewURL( vlc->p_libvlc_int, psz_url );
+        if( s == NULL )
+        {
+            free( p_buf );
+            libvlc_release( vlc );
+            return 1;
+        }
+
+        if( b_block )
+        {
+            block_t *p_block;
+            while( (p_block = vlc_stream_ReadBlock( s )) != NULL )
+            {
+                i_total += p_block->i_buffer;
+                block_Release( p_block );
+            }
+        }
+        else
+        {
+            ssize_t i_read;
+            while( (i_read = vlc_stream_Read( s, p_buf, READ_SIZE )) > 0 )
+                i_total += i_read;
+        }
+        vlc_stream_Delete( s );
+    }
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    cpu = cpu_time() - cpu;
+
+    printf( "%-5s %-5s %8.1f MiB/s, %6"PRId64" ms cpu (%"PRIu64" MiB)\n",
+            inputs[i_input], b_block ? "block" : "bytes",
+            (double) i_total / (1 << 20) / secf_from_vlc_tick( elapsed ),
+            MS_FROM_VLC_TICK(cpu), i_total >> 20 );
+
+    free( p_buf );
+    libvlc_release( vlc );
+    return 0;
+}
+
+int main( int argc, char *argv[] )
+{
+    char psz_tmp_path[] = "/tmp/libvlc_XXXXXX";
+    const char *psz_path = psz_tmp_path;
+    char *psz_url;
+    int i_ret = 0;
+
+    test_init();
+
+    unsigned long i_size = 256;
+    if( argc > 1 )
+    {
+        char *end;
+        i_size = strtoul( argv[1], &end, 0 );
+        if( *end != '\0' )
+            psz_path = argv[1];
+    }
+
+    if( psz_path == psz_tmp_path )
+    {
+        int fd = vlc_mkstemp( psz_tmp_path );
+        assert( fd != -1 );
+
+        uint8_t p_buf[65536];
+        for( size_t i = 0; i < sizeof(p_buf); i++ )
+            p_buf[i] = i * 31;
+        for( unsigned long i = 0; i < i_size * 16; i++ )
+            assert( write( fd, p_buf, sizeof(p_buf) ) == sizeof(p_buf) );
+        close( fd );
+    }
+
+    psz_url = vlc_path2uri( psz_path, NULL );
+    assert( psz_url != NULL );
+
+    /* warm the page cache */
+    run( psz_url, 0, false );
+
+    for( unsigned i = 0; i < 2 * ARRAY_SIZE(inputs) && i_ret == 0; i++ )
+        i_ret = run( psz_url, i % ARRAY_SIZE(inputs), i >= ARRAY_SIZE(inputs) );
+
+    free( psz_url );
+    if( psz_path == psz_tmp_path )
+        unlink( psz_tmp_path );
+    return i_ret;
+}
@@ -0,0 +1,109 @@
+/*****************************************************************************
+ * mmap.c: test for the memory-mapped file input
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Checks that a file truncated while it is being read is not mapped past
+ * its new end, which would raise SIGBUS, and is still read up to it */
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_access.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_url.h>
+
+#include <unistd.h>
+
+#define WINDOW (4 << 20) /* size of the mappings of the module */
+#define SIZE   (2 * WINDOW + 12345)
+#define KEPT   (WINDOW + 1000) /* size after truncation */
+
+static uint8_t pattern( uint64_t offset )
+{
+    return offset * 31 + (offset >> 12);
+}
+
+static void check( const block_t *block, uint64_t offset )
+{
+    for( size_t i = 0; i < block->i_buffer; i++ )
+        assert( block->p_buffer[i] == pattern( offset + i ) );
+}
+
+int main( void )
+{
+    char psz_path[] = "/tmp/libvlc_XXXXXX";
+    const char *argv[] = {
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        "--file-mmap",
+    };
+
+    test_init();
+
+    int fd = vlc_mkstemp( psz_path );
+    assert( fd != -1 );
+
+    uint8_t *p_buf = malloc( SIZE );
+    assert( p_buf != NULL );
+    for( size_t i = 0; i < SIZE; i++ )
+        p_buf[i] = pattern( i );
+    assert( write( fd, p_buf, SIZE ) == SIZE );
+    free( p_buf );
+
+    char *psz_url = vlc_path2uri( psz_path, NULL );
+    assert( psz_url != NULL );
+
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(argv), argv );
+    assert( vlc != NULL );
+
+    stream_t *s = vlc_access_NewMRL( VLC_OBJECT(vlc->p_libvlc_int), psz_url );
+    assert( s != NULL );
+    assert( s->pf_block != NULL ); /* mapped, not read */
+
+    block_t *first = vlc_stream_ReadBlock( s );
+    assert( first != NULL && first->i_buffer == WINDOW );
+    check( first, 0 );
+
+    assert( ftruncate( fd, KEPT ) == 0 );
+
+    uint64_t offset = first->i_buffer;
+    block_t *block;
+    while( (block = vlc_stream_ReadBlock( s )) != NULL )
+    {
+        check( block, offset );
+        offset += block->i_buffer;
+        block_Release( block );
+    }
+    assert( offset == KEPT );
+
+    /* the window mapped before the truncation is still within the file */
+    check( first, 0 );
+    block_Release( first );
+
+    vlc_stream_Delete( s );
+    libvlc_release( vlc );
+    free( psz_url );
+    close( fd );
+    unlink( psz_path );
+    return 0;
+}
@@ -0,0 +1,325 @@
+/*****************************************************************************
+ * format.c: test and benchmark for the PCM format converters
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Checks the vector sample converters against the C ones, bit for bit,
+ * including in place, and the conversions to FL32 with a gain against a
+ * conversion followed by a multiplication.
+ *
+ * With arguments, times every implementation of every conversion instead:
+ *
+ *   test_modules_audio_filter_format bench [samples [rounds]]
+ */
+
+#include "../../libvlc/test.h"
+
+#include <float.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+
+#include "../modules/audio_filter/converter/format_kernels.c"
+#include "samples.h"
+
+#define MAX_SAMPLES 1024
+#define GUARD       64 /* bytes checked past the end of the output */
+
+/* Uniform in [-1.25, 1.25), rounding ties, and values out of range */
+static double rnd_real( uint32_t v )
+{
+    static const double scales[] = { 128., 32768., 2147483648. };
+    static const double special[] = {
+        0., -0., 1., -1., 127. / 128., 32767. / 32768., 1.5, -1.5,
+        FLT_MAX, -FLT_MAX, DBL_MAX, -DBL_MAX, FLT_MIN, -DBL_MIN,
+        1e-40, -1e-40, 4294967296., -4294967296.,
+    };
+
+    VLC_UNUSED(v);
+    switch( test_rand() & 7 )
+    {
+        case 0:
+        case 1:
+        {   /* halfway between two output values */
+            const double k = (double)(test_rand() % 65536) - 32768.;
+            return (k + .5) / scales[test_rand() % 3];
+        }
+        case 2:
+            if( test_rand() & 1 )
+                return (test_rand() & 1) ? INFINITY : -INFINITY;
+            return special[test_rand() % ARRAY_SIZE(special)];
+        default:
+            return ((test_rand() * 65536. + test_rand()) / 4294967296. - .5)
+                   * 2.5;
+    }
+}
+
+static void test_kernel( const format_kernels_t *k, const char *name,
+                         format_kernel_t convert )
+{
+    const unsigned src_size = aout_BitsPerSample( k->src ) / 8;
+    const unsigned dst_size = aout_BitsPerSample( k->dst ) / 8;
+    uint8_t *src = malloc( MAX_SAMPLES * 8 );
+    uint8_t *ref = malloc( MAX_SAMPLES * 8 + GUARD );
+    uint8_t *dst = malloc( MAX_SAMPLES * 8 + GUARD );
+    assert( src != NULL && ref != NULL && dst != NULL );
+
+    test_log( "checking %4.4s->%4.4s %s\n", (const char *)&k->src,
+              (const char *)&k->dst, name );
+
+    for( size_t n = 0; n <= MAX_SAMPLES; n += (n < 80) ? 1 : 101 )
+        for( unsigned round = 0; round < 8; round++ )
+        {
+            fill_samples( src, k->src, n, rnd_real );
+            memset( ref, 0xA5, n * dst_size + GUARD );
+            memset( dst, 0xA5, n * dst_size + GUARD );
+
+            k->c( ref, src, n );
+            convert( dst, src, n );
+            if( memcmp( ref, dst, n * dst_size + GUARD ) )
+            {
+                for( size_t i = 0; i < n; i++ )
+                    if( memcmp( &ref[i * dst_size], &dst[i * dst_size],
+                                dst_size ) )
+                    {
+                        test_log( "%s: %zu samples, mismatch at %zu\n", name,
+                                  n, i );
+                        break;
+                    }
+                abort();
+            }
+
+            if( dst_size > src_size )
+                continue;
+
+            /* in place, as the audio filter does */
+            memcpy( dst, src, n * src_size );
+            convert( dst, dst, n );
+            if( memcmp( ref, dst, n * dst_size ) )
+            {
+                test_log( "%s: %zu samples in place, mismatch\n", name, n );
+                abort();
+            }
+        }
+
+    free( dst );
+    free( ref );
+    free( src );
+}
+
+static void test_gain_kernel( const format_gain_kernels_t *k, const char *name,
+                              format_gain_kernel_t convert )
+{
+    /* Including gains making the scaling factor subnormal or infinite */
+    static const float gains[] = {
+        0.f, -0.f, .5f, 1.f, 1.37f, 2.f, -3.f, 1e-30f, 1e-40f, 1e30f,
+        INFINITY,
+    };
+    const unsigned src_size = aout_BitsPerSample( k->src ) / 8;
+    const format_kernels_t *plain = format_FindKernels( k->src,
+                                                        VLC_CODEC_FL32 );
+    uint8_t *src = malloc( MAX_SAMPLES * 8 );
+    float *ref = malloc( MAX_SAMPLES * 8 + GUARD );
+    float *dst = malloc( MAX_SAMPLES * 8 + GUARD ); /* large enough in place */
+    assert( src != NULL && ref != NULL && dst != NULL && plain != NULL );
+
+    test_log( "checking %4.4s->f32l with gain %s\n", (const char *)&k->src,
+              name );
+
+    for( size_t n = 0; n <= MAX_SAMPLES; n += (n < 80) ? 1 : 101 )
+        for( size_t g = 0; g < ARRAY_SIZE(gains); g++ )
+        {
+            fill_samples( src, k->src, n, rnd_real );
+            memset( ref, 0xA5, n * sizeof (float) + GUARD );
+            memset( dst, 0xA5, n * sizeof (float) + GUARD );
+
+            plain->c( ref, src, n );
+            for( size_t i = 0; i < n; i++ )
+                ref[i] *= gains[g];
+            convert( dst, src, n, gains[g] );
+            if( memcmp( ref, dst, n * sizeof (float) + GUARD ) )
+            {
+                for( size_t i = 0; i < n; i++ )
+                    if( memcmp( &ref[i], &dst[i], sizeof (float) ) )
+                    {
+                        test_log( "%s: %zu samples, gain %g, mismatch at "
+                                  "%zu\n", name, n, (double)gains[g], i );
+                        break;
+                    }
+                abort();
+            }
+
+            if( sizeof (float) > src_size )
+                continue;
+
+            memcpy( dst, src, n * src_size );
+            convert( dst, dst, n, gains[g] );
+            if( memcmp( ref, dst, n * sizeof (float) ) )
+            {
+                test_log( "%s: %zu samples in place, mismatch\n", name, n );
+                abort();
+            }
+        }
+
+    free( dst );
+    free( ref );
+    free( src );
+}
+
+static double time_kernel( const format_kernels_t *k, format_kernel_t convert,
+                           size_t samples, unsigned rounds )
+{
+    uint8_t *src = malloc( samples * 8 );
+    uint8_t *dst = malloc( samples * 8 );
+    assert( src != NULL && dst != NULL );
+
+    fill_samples( src, k->src, samples, rnd_real );
+    convert( dst, src, samples ); /* warm up */
+
+    vlc_tick_t start = vlc_tick_now();
+    for( unsigned i = 0; i < rounds; i++ )
+        convert( dst, src, samples );
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    free( dst );
+    free( src );
+    return secf_from_vlc_tick( elapsed ) * 1e9 / ((double)samples * rounds);
+}
+
+static double time_gain_kernel( const format_gain_kernels_t *k,
+                                format_gain_kernel_t convert,
+                                size_t samples, unsigned rounds )
+{
+    uint8_t *src = malloc( samples * 8 );
+    float *dst = malloc( samples * sizeof (float) );
+    assert( src != NULL && dst != NULL );
+
+    fill_samples( src, k->src, samples, rnd_real );
+    convert( dst, src, samples, .7f ); /* warm up */
+
+    vlc_tick_t start = vlc_tick_now();
+    for( unsigned i = 0; i < rounds; i++ )
+        convert( dst, src, samples, .7f );
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    free( dst );
+    free( src );
+    return secf_from_vlc_tick( elapsed ) * 1e9 / ((double)samples * rounds);
+}
+
+static int bench( size_t samples, unsigned rounds )
+{
+    for( size_t i = 0; i < format_kernels_count; i++ )
+    {
+        const format_kernels_t *k = &format_kernels[i];
+
+        printf( "%4.4s->%4.4s C %6.3f", (const char *)&k->src,
+                (const char *)&k->dst, time_kernel( k, k->c, samples, rounds ) );
+#ifdef FORMAT_SSE2
+        if( vlc_CPU_SSE2() )
+            printf( " SSE2 %6.3f", time_kernel( k, k->sse2, samples, rounds ) );
+#endif
+#ifdef FORMAT_AVX2
+        if( vlc_CPU_AVX2() )
+            printf( " AVX2 %6.3f", time_kernel( k, k->avx2, samples, rounds ) );
+#endif
+#ifdef FORMAT_NEON
+        if( vlc_CPU_ARM_NEON() )
+            printf( " NEON %6.3f", time_kernel( k, k->neon, samples, rounds ) );
+#endif
+        printf( " ns/sample\n" );
+    }
+
+    for( size_t i = 0; i < format_gain_kernels_count; i++ )
+    {
+        const format_gain_kernels_t *k = &format_gain_kernels[i];
+
+        printf( "%4.4s->f32l*g C %6.3f", (const char *)&k->src,
+                time_gain_kernel( k, k->c, samples, rounds ) );
+#ifdef FORMAT_SSE2
+        if( vlc_CPU_SSE2() )
+            printf( " SSE2 %6.3f",
+                    time_gain_kernel( k, k->sse2, samples, rounds ) );
+#endif
+#ifdef FORMAT_AVX2
+        if( vlc_CPU_AVX2() )
+            printf( " AVX2 %6.3f",
+                    time_gain_kernel( k, k->avx2, samples, rounds ) );
+#endif
+#ifdef FORMAT_NEON
+        if( vlc_CPU_ARM_NEON() )
+            printf( " NEON %6.3f",
+                    time_gain_kernel( k, k->neon, samples, rounds ) );
+#endif
+        printf( " ns/sample\n" );
+    }
+    return 0;
+}
+
+int main( int argc, char *argv[] )
+{
+    test_init();
+
+    size_t samples = 4096;
+    unsigned rounds = 10000;
+    if( test_bench_args( argc, argv, &samples, &rounds ) )
+        return bench( samples, rounds );
+
+    for( size_t i = 0; i < format_kernels_count; i++ )
+    {
+        const format_kernels_t *k = &format_kernels[i];
+
+        assert( format_FindKernels( k->src, k->dst ) == k );
+#ifdef FORMAT_SSE2
+        if( vlc_CPU_SSE2() )
+            test_kernel( k, "SSE2", k->sse2 );
+#endif
+#ifdef FORMAT_AVX2
+        if( vlc_CPU_AVX2() )
+            test_kernel( k, "AVX2", k->avx2 );
+#endif
+#ifdef FORMAT_NEON
+        if( vlc_CPU_ARM_NEON() )
+            test_kernel( k, "NEON", k->neon );
+#endif
+    }
+    assert( format_FindKernels( VLC_CODEC_FL32, VLC_CODEC_FL32 ) == NULL );
+
+    for( size_t i = 0; i < format_gain_kernels_count; i++ )
+    {
+        const format_gain_kernels_t *k = &format_gain_kernels[i];
+
+        assert( format_FindGainKernels( k->src ) == k );
+        test_gain_kernel( k, "C", k->c );
+#ifdef FORMAT_SSE2
+        if( vlc_CPU_SSE2() )
+            test_gain_kernel( k, "SSE2", k->sse2 );
+#endif
+#ifdef FORMAT_AVX2
+        if( vlc_CPU_AVX2() )
+            test_gain_kernel( k, "AVX2", k->avx2 );
+#endif
+#ifdef FORMAT_NEON
+        if( vlc_CPU_ARM_NEON() )
+            test_gain_kernel( k, "NEON", k->neon );
+#endif
+    }
+    assert( format_FindGainKernels( VLC_CODEC_FL32 ) == NULL );
+
+    return 0;
+}
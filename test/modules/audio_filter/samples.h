@@ -0,0 +1,62 @@
+/*****************************************************************************
+ * samples.h: random PCM samples for the audio kernel tests
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TEST_AUDIO_SAMPLES_H
+#define VLC_TEST_AUDIO_SAMPLES_H
+
+/**
+ * Fills a buffer with random samples of the given format.
+ *
+ * One integer sample in eight is saturated. The floating point samples are
+ * given by real(), from 32 random bits.
+ */
+static inline void fill_samples( void *buf, vlc_fourcc_t fourcc,
+                                 size_t samples, double (*real)( uint32_t ) )
+{
+    for( size_t i = 0; i < samples; i++ )
+    {
+        const uint32_t v = (test_rand() << 16) | test_rand();
+
+        switch( fourcc )
+        {
+            case VLC_CODEC_U8:
+                ((uint8_t *)buf)[i] = v;
+                break;
+            case VLC_CODEC_S16N:
+                ((int16_t *)buf)[i] = (test_rand() & 7) ? (int16_t)v
+                                    : (v & 1) ? INT16_MAX : INT16_MIN;
+                break;
+            case VLC_CODEC_S32N:
+                ((int32_t *)buf)[i] = (test_rand() & 7) ? (int32_t)v
+                                    : (v & 1) ? INT32_MAX : INT32_MIN;
+                break;
+            case VLC_CODEC_FL32:
+                ((float *)buf)[i] = real( v );
+                break;
+            case VLC_CODEC_FL64:
+                ((double *)buf)[i] = real( v );
+                break;
+            default:
+                vlc_assert_unreachable();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,174 @@
+/*****************************************************************************
+ * volume.c: test and benchmark for the software volume kernels
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Checks the vector volume kernels against the C ones, bit for bit.
+ *
+ * With arguments, times every implementation for every format instead:
+ *
+ *   test_modules_audio_mixer_volume bench [samples [rounds]]
+ */
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+
+#include "../modules/audio_mixer/volume_kernels.c"
+#include "../audio_filter/samples.h"
+
+#define MAX_SAMPLES 1024
+#define GUARD       64 /* bytes checked past the end of the samples */
+
+/* Up to 128, as the S32N products would overflow 64 bits beyond */
+static const float volumes[] = {
+    0.f, 1e-30f, .5f, 1.f, 1.37f, 2.f, 8.f, 100.f, 127.9f, 128.f,
+};
+
+/* Uniform in [-1.25, 1.25) */
+static double real( uint32_t v )
+{
+    return ((float)(int32_t)v) / 2147483648.f * 1.25f;
+}
+
+static block_t *alloc_block( size_t size )
+{
+    block_t *block = block_Alloc( size + GUARD );
+    assert( block != NULL );
+    block->i_buffer = size;
+    return block;
+}
+
+static void test_kernel( const volume_kernels_t *k, const char *name,
+                         volume_kernel_t amplify )
+{
+    const size_t size = aout_BitsPerSample( k->format ) / 8;
+    audio_volume_t vol = { .format = k->format };
+    block_t *ref = alloc_block( MAX_SAMPLES * size );
+    block_t *out = alloc_block( MAX_SAMPLES * size );
+
+    test_log( "checking %4.4s %s\n", (const char *)&k->format, name );
+
+    for( size_t n = 0; n <= MAX_SAMPLES; n += (n < 80) ? 1 : 101 )
+        for( size_t v = 0; v < ARRAY_SIZE(volumes); v++ )
+        {
+            memset( ref->p_buffer, 0xA5, n * size + GUARD );
+            fill_samples( ref->p_buffer, k->format, n, real );
+            memcpy( out->p_buffer, ref->p_buffer, n * size + GUARD );
+            ref->i_buffer = out->i_buffer = n * size;
+
+            k->c( &vol, ref, volumes[v] );
+            amplify( &vol, out, volumes[v] );
+            assert( ref->i_buffer == out->i_buffer );
+            if( memcmp( ref->p_buffer, out->p_buffer, n * size + GUARD ) )
+            {
+                for( size_t i = 0; i < n; i++ )
+                    if( memcmp( &ref->p_buffer[i * size],
+                                &out->p_buffer[i * size], size ) )
+                    {
+                        test_log( "%s: %zu samples, volume %g, "
+                                  "mismatch at %zu\n", name, n,
+                                  (double)volumes[v], i );
+                        break;
+                    }
+                abort();
+            }
+        }
+
+    block_Release( out );
+    block_Release( ref );
+}
+
+static double time_kernel( const volume_kernels_t *k, volume_kernel_t amplify,
+                           size_t samples, unsigned rounds )
+{
+    const size_t size = aout_BitsPerSample( k->format ) / 8;
+    audio_volume_t vol = { .format = k->format };
+    block_t *block = alloc_block( samples * size );
+
+    fill_samples( block->p_buffer, k->format, samples, real );
+    amplify( &vol, block, 1.01f ); /* warm up */
+
+    /* Alternate the volumes so that the samples do not saturate */
+    vlc_tick_t start = vlc_tick_now();
+    for( unsigned i = 0; i < rounds; i++ )
+        amplify( &vol, block, (i & 1) ? 1.01f : .99f );
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    block_Release( block );
+    return secf_from_vlc_tick( elapsed ) * 1e9 / ((double)samples * rounds);
+}
+
+static int bench( size_t samples, unsigned rounds )
+{
+    for( size_t i = 0; i < volume_kernels_count; i++ )
+    {
+        const volume_kernels_t *k = &volume_kernels[i];
+
+        printf( "%4.4s C %6.3f", (const char *)&k->format,
+                time_kernel( k, k->c, samples, rounds ) );
+#ifdef VOLUME_SSE2
+        if( k->sse2 != NULL && vlc_CPU_SSE2() )
+            printf( " SSE2 %6.3f", time_kernel( k, k->sse2, samples, rounds ) );
+#endif
+#ifdef VOLUME_AVX2
+        if( k->avx2 != NULL && vlc_CPU_AVX2() )
+            printf( " AVX2 %6.3f", time_kernel( k, k->avx2, samples, rounds ) );
+#endif
+#ifdef VOLUME_NEON
+        if( k->neon != NULL && vlc_CPU_ARM_NEON() )
+            printf( " NEON %6.3f", time_kernel( k, k->neon, samples, rounds ) );
+#endif
+        printf( " ns/sample\n" );
+    }
+    return 0;
+}
+
+int main( int argc, char *argv[] )
+{
+    test_init();
+
+    size_t samples = 4096;
+    unsigned rounds = 10000;
+    if( test_bench_args( argc, argv, &samples, &rounds ) )
+        return bench( samples, rounds );
+
+    for( size_t i = 0; i < volume_kernels_count; i++ )
+    {
+        const volume_kernels_t *k = &volume_kernels[i];
+
+        assert( volume_FindKernels( k->format ) == k );
+#ifdef VOLUME_SSE2
+        if( k->sse2 != NULL && vlc_CPU_SSE2() )
+            test_kernel( k, "SSE2", k->sse2 );
+#endif
+#ifdef VOLUME_AVX2
+        if( k->avx2 != NULL && vlc_CPU_AVX2() )
+            test_kernel( k, "AVX2", k->avx2 );
+#endif
+#ifdef VOLUME_NEON
+        if( k->neon != NULL && vlc_CPU_ARM_NEON() )
+            test_kernel( k, "NEON", k->neon );
+#endif
+    }
+    assert( volume_FindKernels( VLC_CODEC_S24N ) == NULL );
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+/*****************************************************************************
+ * ts_chunk.c: MPEG TS batched packets reader tests
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_stream.h>
+
+#include "../../../modules/demux/mpeg/ts_chunk.h"
+
+const char vlc_module_name[] = "test_ts_chunk";
+
+#define PACKETS 600
+#define GARBAGE_AT 300
+#define GARBAGE_SIZE 50
+
+#define ASSERT(a) do {\
+    if(!(a)) { \
+        fprintf(stderr, "failed line %d\n", __LINE__); \
+        return 1; } \
+    } while(0)
+
+/* Writes PACKETS numbered packets, with garbage in the middle
+ * and a truncated packet at the end */
+static size_t FillStream( uint8_t *p, unsigned i_size, unsigned i_header )
+{
+    size_t i_total = 0;
+    for( unsigned i=0; i<PACKETS; i++ )
+    {
+        if( i == GARBAGE_AT )
+        {
+            memset( &p[i_total], 0x42, GARBAGE_SIZE );
+            i_total += GARBAGE_SIZE;
+        }
+        memset( &p[i_total], 0xFF, i_size );
+        p[i_total + i_header] = 0x47;
+        SetWBE( &p[i_total + i_header + 1], i );
+        i_total += i_size;
+    }
+    p[i_total] = 0x47;
+    return i_total + i_size / 2;
+}
+
+/* Stream returning short reads, which do not end on packet boundaries */
+static ssize_t ShortRead( stream_t *s, void *p_buf, size_t i_len )
+{
+    return vlc_stream_Read( s->p_sys, p_buf, __MIN(i_len, 1000) );
+}
+
+static int ShortSeek( stream_t *s, uint64_t i_pos )
+{
+    return vlc_stream_Seek( s->p_sys, i_pos );
+}
+
+static void ShortDestroy( stream_t *s )
+{
+    vlc_stream_Delete( s->p_sys );
+}
+
+static stream_t *ShortNew( vlc_object_t *obj, uint8_t *p_data, size_t i_data )
+{
+    stream_t *s = vlc_stream_CommonNew( obj, ShortDestroy );
+    if( s == NULL )
+        return NULL;
+    s->p_sys = vlc_stream_MemoryNew( obj, p_data, i_data, true );
+    if( s->p_sys == NULL )
+    {
+        vlc_object_delete( s );
+        return NULL;
+    }
+    s->pf_read = ShortRead;
+    s->pf_seek = ShortSeek;
+    return s;
+}
+
+static int RunTest( vlc_object_t *obj, unsigned i_size, unsigned i_header,
+                    bool b_short )
+{
+    uint8_t *p_data = malloc( PACKETS * i_size * 2 );
+    ASSERT(p_data);
+    size_t i_data = FillStream( p_data, i_size, i_header );
+
+    stream_t *s = b_short ? ShortNew( obj, p_data, i_data )
+                          : vlc_stream_MemoryNew( obj, p_data, i_data, true );
+    ASSERT(s);
+    ts_chunk_reader_t *r = ts_chunk_reader_New( i_size, i_header, 64 );
+    ASSERT(r);
+
+    block_t *p_kept = NULL;
+    for( unsigned i=0; i<PACKETS; i++ )
+    {
+        block_t *p_pkt = ts_chunk_reader_Read( r, obj, s );
+        ASSERT(p_pkt);
+        ASSERT(p_pkt->i_buffer == i_size - i_header);
+        ASSERT(p_pkt->p_buffer[0] == 0x47);
+        ASSERT(GetWBE(&p_pkt->p_buffer[1]) == i);
+
+        /* Position of next packet */
+        if( i < GARBAGE_AT - 1 )
+            ASSERT(vlc_stream_Tell(s) - ts_chunk_reader_Pending(r) ==
+                   (i + 1) * i_size);
+
+        /* Keep a packet across refills, and a detached copy */
+        if( i == 10 )
+            p_kept = p_pkt;
+        else if( i == 20 )
+        {
+            block_t *p_copy = ts_chunk_Detach( p_pkt );
+            ASSERT(p_copy);
+            ASSERT(GetWBE(&p_copy->p_buffer[1]) == i);
+            block_Release( p_copy );
+        }
+        else
+            block_Release( p_pkt );
+    }
+    /* Truncated packet is never returned */
+    ASSERT(ts_chunk_reader_Read( r, obj, s ) == NULL);
+
+    ASSERT(p_kept);
+    ASSERT(GetWBE(&p_kept->p_buffer[1]) == 10);
+
+    /* Seek back */
+    ts_chunk_reader_Flush( r );
+    ASSERT(vlc_stream_Seek( s, 5 * i_size ) == VLC_SUCCESS);
+    block_t *p_pkt = ts_chunk_reader_Read( r, obj, s );
+    ASSERT(p_pkt);
+    ASSERT(GetWBE(&p_pkt->p_buffer[1]) == 5);
+
+    /* Aligned reads run out of pending bytes between two packets */
+    ts_chunk_reader_SetAligned( r, true );
+    for( unsigned i=6; ts_chunk_reader_Pending( r ) > 0; i++ )
+    {
+        ASSERT(i < 5 + 3 * 64);
+        block_t *p_next = ts_chunk_reader_Read( r, obj, s );
+        ASSERT(p_next);
+        ASSERT(GetWBE(&p_next->p_buffer[1]) == i);
+        block_Release( p_next );
+        if( ts_chunk_reader_Pending( r ) == 0 )
+            ASSERT(vlc_stream_Tell(s) == (i + 1) * i_size);
+    }
+    ts_chunk_reader_SetAligned( r, false );
+
+    ts_chunk_reader_Delete( r );
+    /* Packets outlive the reader */
+    ASSERT(GetWBE(&p_pkt->p_buffer[1]) == 5);
+    block_Release( p_pkt );
+    block_Release( p_kept );
+
+    vlc_stream_Delete( s );
+    free( p_data );
+    return 0;
+}
+
+int main()
+{
+    test_init();
+
+    const char * const argv[] = {
+        "-v",
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+    };
+
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(argv), argv );
+    assert( vlc != NULL );
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    int i_ret = 0;
+    for( unsigned i = 0; i < 2 && !i_ret; i++ )
+    {
+        i_ret = RunTest( obj, 188, 0, i );
+        if( !i_ret )
+            i_ret = RunTest( obj, 192, 4, i );
+        if( !i_ret )
+            i_ret = RunTest( obj, 204, 0, i );
+    }
+
+    libvlc_release( vlc );
+    return i_ret;
+}
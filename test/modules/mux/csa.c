@@ -0,0 +1,389 @@
+/*****************************************************************************
+ * csa.c: test and benchmark for the CSA scrambler
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Checks the scrambling framing, the packet by packet scrambler against
+ * known outputs, and the bitsliced kernels against it, bit for bit, on
+ * random packets of random adaptation field lengths, in batches of every
+ * size around the kernel widths. Scrambled packets are also descrambled back.
+ *
+ * With arguments, times the scrambler and every kernel instead:
+ *
+ *   test_modules_mux_csa bench [packets [rounds]]
+ */
+
+#include "../../libvlc/test.h"
+
+#include <sys/resource.h>
+
+#include <vlc_common.h>
+
+#define TS_NO_CSA_CK_MSG
+#include "../modules/mux/mpeg/csa.c"
+
+const char vlc_module_name[] = "test_csa";
+
+#define TS_PACKET_SIZE 188
+
+typedef struct
+{
+    const char *name;
+    csa_lanes_t pf;
+    unsigned lanes;
+} kernel_t;
+
+static kernel_t kernels[3];
+static size_t kernels_count;
+
+static uint32_t digest( const uint8_t *p, size_t i_size )
+{
+    uint32_t h = 2166136261u; /* FNV-1a */
+
+    while( i_size-- )
+        h = (h ^ *p++) * 16777619u;
+    return h;
+}
+
+static vlc_tick_t cpu_time( void )
+{
+    struct rusage ru;
+    getrusage( RUSAGE_SELF, &ru );
+    return vlc_tick_from_timeval( &ru.ru_utime ) +
+           vlc_tick_from_timeval( &ru.ru_stime );
+}
+
+static void init_kernels( void )
+{
+    kernels[kernels_count++] = (kernel_t){ "C", csa_EncryptLanes_c, 64 };
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE2() )
+        kernels[kernels_count++] =
+            (kernel_t){ "SSE2", csa_EncryptLanes_sse2, 128 };
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        kernels[kernels_count++] =
+            (kernel_t){ "AVX2", csa_EncryptLanes_avx2, 256 };
+#endif
+}
+
+/* csa_EncryptBatch() with the given kernel only, NULL for csa_Encrypt() */
+static void scramble( const kernel_t *k, csa_t *c, uint8_t **pp_pkt,
+                      size_t i_count, int i_pkt_size )
+{
+    uint8_t *ck = c->use_odd ? c->o_ck : c->e_ck;
+    uint8_t *kk = c->use_odd ? c->o_kk : c->e_kk;
+    csa_lane_t lanes[CSA_LANES_MAX];
+    unsigned i_lanes = 0;
+
+    if( k == NULL )
+    {
+        for( size_t i = 0; i < i_count; i++ )
+            csa_Encrypt( c, pp_pkt[i], i_pkt_size );
+        return;
+    }
+
+    for( size_t i = 0; i < i_count; i++ )
+        if( csa_EncryptHeader( c, pp_pkt[i], i_pkt_size, &lanes[i_lanes] )
+         && ++i_lanes == k->lanes )
+        {
+            k->pf( ck, kk, lanes, i_lanes );
+            i_lanes = 0;
+        }
+    if( i_lanes > 0 )
+        k->pf( ck, kk, lanes, i_lanes );
+}
+
+/* Digests of the packets scrambled by the original packet by packet code,
+ * for each key, and each adaptation field length and scrambled size */
+static const char *const vector_keys[] = {
+    "0x0000000000000000", "0xffffffffffffffff",
+    "0x0123456789abcdef", "0x1122334455667788",
+};
+
+static const struct
+{
+    int i_adaptation; /* -1 for none */
+    int i_pkt_size;
+} vector_cases[] = {
+    { -1, 188 }, { 7, 188 }, { 10, 188 }, { 0, 188 },
+    { -1, 100 }, { 176, 188 }, { 172, 188 }, { -1, 12 },
+};
+
+static const uint32_t vector_digests[ARRAY_SIZE(vector_keys)]
+                                   [ARRAY_SIZE(vector_cases)] = {
+    { 0xDD8CA0FB, 0x91A0CF66, 0x93004850, 0x90ECAFBB,
+      0xDF7A0286, 0x4252A647, 0x896468C1, 0x8A15E2FA, },
+    { 0x92BFEFF8, 0x481A853A, 0x7ED0EC2A, 0x2F71FB93,
+      0xC2653DA1, 0xA1A898AE, 0x5672DBCE, 0xF2FCDB2C, },
+    { 0xF06DE140, 0xFD3BC16A, 0x71A62F00, 0xFC779E34,
+      0x4358E230, 0xB2F18461, 0x59CC6453, 0x88B8EBD5, },
+    { 0xFA2C3699, 0x9094C539, 0x9D8A3189, 0xF3217164,
+      0x8D1D8C92, 0xEA413E90, 0xDC11CDFC, 0xEBFE65FA, },
+};
+
+static void test_vectors( const kernel_t *k )
+{
+    csa_t *c = csa_New();
+    assert( c != NULL );
+
+    test_log( "checking %s against the test vectors\n",
+              k != NULL ? k->name : "csa_Encrypt" );
+
+    for( size_t i = 0; i < ARRAY_SIZE(vector_keys); i++ )
+    {
+        /* the odd key, and the next one as the even key */
+        const char *psz_even = vector_keys[(i + 1) % ARRAY_SIZE(vector_keys)];
+        int i_ret = csa_SetCW( NULL, c, (char *)vector_keys[i], true );
+        assert( i_ret == VLC_SUCCESS );
+        i_ret = csa_SetCW( NULL, c, (char *)psz_even, false );
+        assert( i_ret == VLC_SUCCESS );
+        (void) i_ret;
+
+        for( size_t j = 0; j < ARRAY_SIZE(vector_cases); j++ )
+        {
+            uint8_t pkt[TS_PACKET_SIZE];
+            uint8_t *p_pkt = pkt;
+
+            for( int b = 0; b < TS_PACKET_SIZE; b++ )
+                pkt[b] = b * 7 + i * 31 + j;
+            pkt[0] = 0x47;
+            pkt[1] = 0x01;
+            pkt[2] = 0x00;
+            pkt[3] = 0x10 | j;
+            if( vector_cases[j].i_adaptation >= 0 )
+            {
+                pkt[3] |= 0x20;
+                pkt[4] = vector_cases[j].i_adaptation;
+            }
+
+            csa_UseKey( NULL, c, (i + j) & 1 );
+            scramble( k, c, &p_pkt, 1, vector_cases[j].i_pkt_size );
+            if( digest( pkt, sizeof (pkt) ) != vector_digests[i][j] )
+            {
+                test_log( "key %s, case %zu: digest %08"PRIX32" instead of "
+                          "%08"PRIX32"\n", vector_keys[i], j,
+                          digest( pkt, sizeof (pkt) ), vector_digests[i][j] );
+                abort();
+            }
+        }
+    }
+    csa_Delete( c );
+}
+
+static void fill( uint8_t *pkt )
+{
+    for( int i = 0; i < TS_PACKET_SIZE; i++ )
+        pkt[i] = test_rand();
+    pkt[0] = 0x47;
+    pkt[3] &= 0x3f; /* not scrambled */
+    if( pkt[3] & 0x20 )
+        /* mostly short adaptation fields, as PCRs, and some stuffing */
+        pkt[4] = (test_rand() & 3) ? test_rand() % 12 : test_rand() % 184;
+}
+
+static void set_random_keys( csa_t *c )
+{
+    char psz_ck[17];
+
+    for( int i = 0; i < 2; i++ )
+    {
+        snprintf( psz_ck, sizeof (psz_ck), "%04x%04x%04x%04x",
+                  test_rand(), test_rand(), test_rand(), test_rand() );
+        int i_ret = csa_SetCW( NULL, c, psz_ck, i );
+        assert( i_ret == VLC_SUCCESS );
+        (void) i_ret;
+    }
+    csa_UseKey( NULL, c, test_rand() & 1 );
+}
+
+/* Checks what the DVB common scrambling framing fixes, whatever the key: the
+ * header and the adaptation field stay in clear, the scrambling control
+ * tells the key used, and the payload is scrambled, unless it is shorter
+ * than a block: such packets are left in clear */
+static void test_framing( void )
+{
+    static const int adaptations[] = { -1, 0, 7, 175, 176, 183 };
+    csa_t *c = csa_New();
+    assert( c != NULL );
+
+    test_log( "checking the framing\n" );
+    set_random_keys( c );
+
+    for( size_t i = 0; i < ARRAY_SIZE(adaptations); i++ )
+        for( int odd = 0; odd < 2; odd++ )
+        {
+            uint8_t src[TS_PACKET_SIZE], pkt[TS_PACKET_SIZE];
+
+            fill( src );
+            src[3] &= ~0x20;
+            if( adaptations[i] >= 0 )
+            {
+                src[3] |= 0x20;
+                src[4] = adaptations[i];
+            }
+            const int i_hdr = 4 + ((src[3] & 0x20) ? src[4] + 1 : 0);
+            memcpy( pkt, src, sizeof (pkt) );
+
+            csa_UseKey( NULL, c, odd );
+            csa_Encrypt( c, pkt, TS_PACKET_SIZE );
+
+            if( TS_PACKET_SIZE - i_hdr < 8 )
+            {
+                assert( !memcmp( pkt, src, TS_PACKET_SIZE ) );
+                continue;
+            }
+            assert( (pkt[3] & 0xc0) == (odd ? 0xc0 : 0x80) );
+            assert( (pkt[3] & 0x3f) == (src[3] & 0x3f) );
+            assert( !memcmp( pkt, src, 3 ) );
+            assert( !memcmp( &pkt[4], &src[4], i_hdr - 4 ) );
+            assert( memcmp( &pkt[i_hdr], &src[i_hdr],
+                            TS_PACKET_SIZE - i_hdr ) );
+        }
+    csa_Delete( c );
+}
+
+static void test_kernel( const kernel_t *k )
+{
+    static const size_t counts[] = {
+        1, 2, 3, 7, 8, 9, 63, 64, 65, 127, 128, 129, 255, 256, 257, 700,
+    };
+    const size_t i_max = counts[ARRAY_SIZE(counts) - 1];
+    uint8_t *src = malloc( i_max * TS_PACKET_SIZE );
+    uint8_t *ref = malloc( i_max * TS_PACKET_SIZE );
+    uint8_t *dst = malloc( i_max * TS_PACKET_SIZE );
+    uint8_t **pp_ref = malloc( i_max * sizeof (*pp_ref) );
+    uint8_t **pp_dst = malloc( i_max * sizeof (*pp_dst) );
+    csa_t *c = csa_New();
+    assert( src != NULL && ref != NULL && dst != NULL && c != NULL );
+    assert( pp_ref != NULL && pp_dst != NULL );
+
+    test_log( "checking %s\n", k != NULL ? k->name : "csa_EncryptBatch" );
+
+    for( size_t i = 0; i < i_max; i++ )
+    {
+        pp_ref[i] = &ref[i * TS_PACKET_SIZE];
+        pp_dst[i] = &dst[i * TS_PACKET_SIZE];
+    }
+
+    for( size_t n = 0; n < ARRAY_SIZE(counts); n++ )
+        for( unsigned round = 0; round < 4; round++ )
+        {
+            const size_t i_count = counts[n];
+            /* the scrambled size is an option of the muxer */
+            const int i_pkt_size = (round & 1) ? 12 + test_rand() % 177 : 188;
+
+            set_random_keys( c );
+            for( size_t i = 0; i < i_count; i++ )
+                fill( &src[i * TS_PACKET_SIZE] );
+            memcpy( ref, src, i_count * TS_PACKET_SIZE );
+            memcpy( dst, src, i_count * TS_PACKET_SIZE );
+
+            scramble( NULL, c, pp_ref, i_count, i_pkt_size );
+            if( k != NULL )
+                scramble( k, c, pp_dst, i_count, i_pkt_size );
+            else
+                csa_EncryptBatch( c, pp_dst, i_count, i_pkt_size );
+
+            for( size_t i = 0; i < i_count; i++ )
+            {
+                if( memcmp( pp_ref[i], pp_dst[i], TS_PACKET_SIZE ) )
+                {
+                    test_log( "%zu packets of %d bytes, mismatch at %zu\n",
+                              i_count, i_pkt_size, i );
+                    abort();
+                }
+
+                /* and back */
+                csa_Decrypt( c, pp_dst[i], i_pkt_size );
+                assert( !memcmp( pp_dst[i], &src[i * TS_PACKET_SIZE],
+                                 TS_PACKET_SIZE ) );
+            }
+        }
+
+    csa_Delete( c );
+    free( pp_dst );
+    free( pp_ref );
+    free( dst );
+    free( ref );
+    free( src );
+}
+
+static double time_kernel( const kernel_t *k, size_t i_count,
+                           unsigned rounds )
+{
+    uint8_t *buf = malloc( i_count * TS_PACKET_SIZE );
+    uint8_t **pp_pkt = malloc( i_count * sizeof (*pp_pkt) );
+    csa_t *c = csa_New();
+    assert( buf != NULL && pp_pkt != NULL && c != NULL );
+
+    set_random_keys( c );
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        pp_pkt[i] = &buf[i * TS_PACKET_SIZE];
+        fill( pp_pkt[i] );
+    }
+
+    vlc_tick_t i_cpu = cpu_time();
+    for( unsigned i = 0; i < rounds; i++ )
+    {
+        /* scrambling sets the scrambling control, clear it */
+        for( size_t j = 0; j < i_count; j++ )
+            pp_pkt[j][3] &= 0x3f;
+        scramble( k, c, pp_pkt, i_count, TS_PACKET_SIZE );
+    }
+    i_cpu = cpu_time() - i_cpu;
+
+    csa_Delete( c );
+    free( pp_pkt );
+    free( buf );
+    return (double)i_count * rounds / secf_from_vlc_tick( i_cpu );
+}
+
+static int bench( size_t i_count, unsigned rounds )
+{
+    printf( "%zu packets: csa_Encrypt %.0f", i_count,
+            time_kernel( NULL, i_count, rounds ) );
+    for( size_t i = 0; i < kernels_count; i++ )
+        printf( " %s %.0f", kernels[i].name,
+                time_kernel( &kernels[i], i_count, rounds ) );
+    printf( " packets/s\n" );
+    return 0;
+}
+
+int main( int argc, char *argv[] )
+{
+    test_init();
+    init_kernels();
+
+    size_t i_count = 1024;
+    unsigned rounds = 100;
+    if( test_bench_args( argc, argv, &i_count, &rounds ) )
+        return bench( i_count, rounds );
+
+    test_framing();
+    test_vectors( NULL );
+    for( size_t i = 0; i < kernels_count; i++ )
+        test_vectors( &kernels[i] );
+
+    for( size_t i = 0; i < kernels_count; i++ )
+        test_kernel( &kernels[i] );
+    test_kernel( NULL );
+    return 0;
+}
@@ -0,0 +1,281 @@
+/*****************************************************************************
+ * ts.c: TS muxer output test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Muxes a synthetic video and audio program, and checks the output blocks:
+ * whole TS packets, no more per block than fit the MTU, continuity counters,
+ * PAT first in header blocks, PCRs matching the block dates, and scrambled
+ * packets with a CSA key only.
+ *
+ * With arguments, measures the muxing rate instead:
+ *
+ *   test_modules_mux_ts bench [seconds [megabits/s [mux]]]
+ */
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_es.h>
+#include <vlc_sout.h>
+
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#define TS_PACKET_SIZE 188
+#define FPS 25
+
+typedef struct
+{
+    bool b_check;
+    unsigned i_max_packets; /* per block */
+
+    uint64_t i_blocks;
+    uint64_t i_packets;
+    unsigned i_headers;
+    unsigned i_pcrs;
+    unsigned i_scrambled;
+    vlc_tick_t i_last_dts;
+    vlc_tick_t i_length_max;
+    vlc_tick_t i_pcr_offset_min;
+    vlc_tick_t i_pcr_offset_max;
+    int8_t cc[8192];
+} output_t;
+
+static vlc_tick_t cpu_time( void )
+{
+    struct rusage ru;
+    getrusage( RUSAGE_SELF, &ru );
+    return vlc_tick_from_timeval( &ru.ru_utime ) +
+           vlc_tick_from_timeval( &ru.ru_stime );
+}
+
+static void CheckBlock( output_t *out, const block_t *p_block )
+{
+    const unsigned i_packets = p_block->i_buffer / TS_PACKET_SIZE;
+
+    assert( p_block->i_buffer == i_packets * TS_PACKET_SIZE );
+    assert( i_packets > 0 && i_packets <= out->i_max_packets );
+    assert( p_block->i_dts >= out->i_last_dts );
+    out->i_last_dts = p_block->i_dts;
+    if( p_block->i_length > out->i_length_max )
+        out->i_length_max = p_block->i_length;
+
+    if( p_block->i_flags & BLOCK_FLAG_HEADER )
+    {
+        /* the PAT */
+        assert( (p_block->p_buffer[1] & 0x1f) == 0 );
+        assert( p_block->p_buffer[2] == 0 );
+        out->i_headers++;
+    }
+
+    for( unsigned i = 0; i < i_packets; i++ )
+    {
+        const uint8_t *p = &p_block->p_buffer[i * TS_PACKET_SIZE];
+        const unsigned i_pid = ((p[1] & 0x1f) << 8) | p[2];
+
+        assert( p[0] == 0x47 );
+        if( p[3] & 0x10 ) /* payload */
+        {
+            const int i_cc = p[3] & 0x0f;
+
+            assert( out->cc[i_pid] < 0 || ((out->cc[i_pid] + 1) & 0xf) == i_cc );
+            out->cc[i_pid] = i_cc;
+        }
+        if( p[3] & 0x80 )
+            out->i_scrambled++;
+        if( (p[3] & 0x20) && p[4] >= 7 && (p[5] & 0x10) )
+        {
+            /* the PCR is the date of the packet, which lies within the
+             * block, so it stays at the same distance from the block date,
+             * give or take the block length and the 90kHz rounding */
+            const int64_t i_base = ((int64_t)p[6] << 25) | (p[7] << 17) |
+                                   (p[8] << 9) | (p[9] << 1) | (p[10] >> 7);
+            const vlc_tick_t i_offset = p_block->i_dts -
+                                        vlc_tick_from_samples( i_base, 90000 );
+
+            if( out->i_pcrs == 0 || i_offset < out->i_pcr_offset_min )
+                out->i_pcr_offset_min = i_offset;
+            if( out->i_pcrs == 0 || i_offset > out->i_pcr_offset_max )
+                out->i_pcr_offset_max = i_offset;
+            out->i_pcrs++;
+        }
+    }
+}
+
+static ssize_t Write( sout_access_out_t *p_access, block_t *p_block )
+{
+    output_t *out = p_access->p_sys;
+    ssize_t i_size = 0;
+
+    while( p_block != NULL )
+    {
+        block_t *p_next = p_block->p_next;
+
+        if( out->b_check )
+            CheckBlock( out, p_block );
+        out->i_blocks++;
+        out->i_packets += p_block->i_buffer / TS_PACKET_SIZE;
+        i_size += p_block->i_buffer;
+        block_Release( p_block );
+        p_block = p_next;
+    }
+    return i_size;
+}
+
+/* Muxes a program of the given video bit rate, and an audio track */
+static void Mux( vlc_object_t *p_obj, output_t *out, const char *psz_mux,
+                 int64_t i_mtu, unsigned i_seconds, unsigned i_mbps )
+{
+    sout_access_out_t *p_access = vlc_object_create( p_obj, sizeof (*p_access) );
+    assert( p_access != NULL );
+    p_access->pf_write = Write;
+    p_access->p_sys = out;
+
+    if( i_mtu > 0 )
+    {
+        var_Create( p_access, "mtu", VLC_VAR_INTEGER );
+        var_SetInteger( p_access, "mtu", i_mtu );
+    }
+    else
+        i_mtu = var_InheritInteger( p_access, "mtu" );
+    out->i_max_packets = VLC_CLIP( i_mtu / TS_PACKET_SIZE, 1, 7 );
+    memset( out->cc, -1, sizeof (out->cc) );
+
+    sout_mux_t *p_mux = sout_MuxNew( p_access, psz_mux );
+    assert( p_mux != NULL );
+
+    es_format_t fmt;
+    es_format_Init( &fmt, VIDEO_ES, VLC_CODEC_MPGV );
+    fmt.video.i_width = fmt.video.i_visible_width = 1920;
+    fmt.video.i_height = fmt.video.i_visible_height = 1080;
+    sout_input_t *p_video = sout_MuxAddStream( p_mux, &fmt );
+    es_format_Clean( &fmt );
+
+    es_format_Init( &fmt, AUDIO_ES, VLC_CODEC_MPGA );
+    fmt.audio.i_rate = 48000;
+    fmt.audio.i_channels = 2;
+    sout_input_t *p_audio = sout_MuxAddStream( p_mux, &fmt );
+    es_format_Clean( &fmt );
+    assert( p_video != NULL && p_audio != NULL );
+
+    const size_t i_frame = i_mbps * 1000000 / 8 / FPS;
+    const vlc_tick_t i_frame_length = vlc_tick_rate_duration( FPS );
+    const vlc_tick_t i_audio_length = vlc_tick_from_samples( 1152, 48000 );
+    const vlc_tick_t i_start = VLC_TICK_0 + VLC_TICK_FROM_SEC(1);
+    const vlc_tick_t i_end = i_start + VLC_TICK_FROM_SEC(i_seconds);
+    vlc_tick_t i_video_dts = i_start, i_audio_dts = i_start;
+
+    for( unsigned i_picture = 0; i_video_dts < i_end; )
+    {
+        block_t *p_block;
+
+        if( i_audio_dts <= i_video_dts )
+        {
+            p_block = block_Alloc( 1152 );
+            assert( p_block != NULL );
+            memset( p_block->p_buffer, 0x55, p_block->i_buffer );
+            p_block->i_dts = p_block->i_pts = i_audio_dts;
+            p_block->i_length = i_audio_length;
+            i_audio_dts += i_audio_length;
+            sout_MuxSendBuffer( p_mux, p_audio, p_block );
+            continue;
+        }
+
+        p_block = block_Alloc( i_frame );
+        assert( p_block != NULL );
+        memset( p_block->p_buffer, 0xaa, p_block->i_buffer );
+        p_block->i_dts = i_video_dts;
+        p_block->i_pts = i_video_dts + i_frame_length;
+        p_block->i_length = i_frame_length;
+        p_block->i_flags = (i_picture++ % 12) ? BLOCK_FLAG_TYPE_P
+                                              : BLOCK_FLAG_TYPE_I;
+        i_video_dts += i_frame_length;
+        sout_MuxSendBuffer( p_mux, p_video, p_block );
+    }
+
+    sout_MuxDeleteStream( p_mux, p_audio );
+    sout_MuxDeleteStream( p_mux, p_video );
+    sout_MuxDelete( p_mux );
+    vlc_object_delete( p_access );
+}
+
+static void test_output( vlc_object_t *p_obj, const char *psz_mux,
+                         int64_t i_mtu )
+{
+    output_t out = { .b_check = true };
+
+    test_log( "muxing with %s, MTU %"PRId64"\n", psz_mux, i_mtu );
+    Mux( p_obj, &out, psz_mux, i_mtu, 6, 20 );
+
+    assert( out.i_packets > 0 && out.i_pcrs > 0 );
+    /* tables are repeated before each key frame with use-key-frames */
+    assert( (out.i_headers > 0) == (strstr( psz_mux, "key" ) != NULL) );
+    assert( (out.i_scrambled > 0) == (strstr( psz_mux, "csa" ) != NULL) );
+    assert( out.i_pcr_offset_max - out.i_pcr_offset_min
+            <= out.i_length_max + 2 * vlc_tick_from_samples( 1, 90000 ) );
+    test_log( "%"PRIu64" packets in %"PRIu64" blocks, %u PCRs, "
+              "PCR to block date variation %"PRId64" us\n",
+              out.i_packets, out.i_blocks, out.i_pcrs,
+              US_FROM_VLC_TICK( out.i_pcr_offset_max - out.i_pcr_offset_min ) );
+}
+
+static void bench( vlc_object_t *p_obj, const char *psz_mux,
+                   unsigned i_seconds, unsigned i_mbps )
+{
+    output_t out = { .b_check = false };
+
+    vlc_tick_t i_cpu = cpu_time();
+    Mux( p_obj, &out, psz_mux, 0, i_seconds, i_mbps );
+    i_cpu = cpu_time() - i_cpu;
+
+    printf( "%s, %u Mbit/s for %u s: %"PRIu64" packets in %"PRIu64" blocks, "
+            "%"PRId64" ms cpu, %.0f packets/s\n", psz_mux, i_mbps, i_seconds,
+            out.i_packets, out.i_blocks, MS_FROM_VLC_TICK( i_cpu ),
+            out.i_packets / secf_from_vlc_tick( i_cpu ) );
+}
+
+int main( int argc, char *argv[] )
+{
+    test_init();
+
+    const char *args[] = { "--ignore-config", "--quiet" };
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(args), args );
+    assert( vlc != NULL );
+    vlc_object_t *p_obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    if( argc > 1 )
+    {
+        alarm( 0 );
+        bench( p_obj, argc > 4 ? argv[4] : "ts",
+               argc > 2 ? atoi( argv[2] ) : 60,
+               argc > 3 ? atoi( argv[3] ) : 60 );
+    }
+    else
+    {
+        test_output( p_obj, "ts{use-key-frames}", 0 );
+        test_output( p_obj, "ts", 600 );
+        test_output( p_obj, "ts", 100 );
+        test_output( p_obj, "ts{csa-ck=0123456789abcdef}", 0 );
+    }
+
+    libvlc_release( vlc );
+    return 0;
+}
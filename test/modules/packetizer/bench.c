@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * bench.c: packetizer helpers micro benchmark
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Times the startcode and emulation prevention scanners on slice like data:
+ *
+ *   test_modules_packetizer_bench [megabytes] [bytes per NAL]
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../modules/packetizer/startcode_helper.h"
+#include "../modules/packetizer/hxxx_ep3b.h"
+
+#define RUNS 10
+
+static size_t bench_startcode( const uint8_t *p, const uint8_t *end,
+                    const uint8_t *(*pf_find)(const uint8_t *, const uint8_t *) )
+{
+    size_t i_found = 0;
+    for( p = pf_find( p, end ); p; p = pf_find( p + 3, end ) )
+        i_found++;
+    return i_found;
+}
+
+static void run_startcode( const char *psz_name, const uint8_t *p, size_t i_size,
+                    const uint8_t *(*pf_find)(const uint8_t *, const uint8_t *) )
+{
+    size_t i_found = 0;
+    vlc_tick_t start = vlc_tick_now();
+    for( unsigned i = 0; i < RUNS; i++ )
+        i_found = bench_startcode( p, p + i_size, pf_find );
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    printf( "startcode %-8s %8.1f MiB/s (%zu found)\n", psz_name,
+            (double) i_size * RUNS / (1 << 20) / secf_from_vlc_tick( elapsed ),
+            i_found );
+}
+
+static void run_ep3b( const char *psz_name, const uint8_t *p, size_t i_size,
+                      size_t (*pf_scan)(const uint8_t *, const uint8_t *) )
+{
+    size_t i_total = 0;
+    vlc_tick_t start = vlc_tick_now();
+    for( unsigned i = 0; i < RUNS; i++ )
+    {
+        i_total = 0;
+        for( const uint8_t *q = p, *end = p + i_size; q + 1 < end; )
+        {
+            size_t i_skip = pf_scan( q, end );
+            i_total += i_skip;
+            q += i_skip + 1;
+        }
+    }
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    printf( "ep3b scan %-8s %8.1f MiB/s (%zu bytes)\n", psz_name,
+            (double) i_size * RUNS / (1 << 20) / secf_from_vlc_tick( elapsed ),
+            i_total );
+}
+
+int main( int argc, char *argv[] )
+{
+    size_t i_size = ((argc > 1) ? strtoul( argv[1], NULL, 0 ) : 64) << 20;
+    size_t i_nal = (argc > 2) ? strtoul( argv[2], NULL, 0 ) : 4096;
+
+    uint8_t *p_data = malloc( i_size );
+    if( !p_data || i_nal < 4 )
+        return 1;
+
+    /* entropy coded like payload, with zeroes escaped as an encoder does */
+    srand( 0 );
+    unsigned i_zeros = 0;
+    for( size_t i = 0; i < i_size; i++ )
+    {
+        uint8_t v = rand();
+        if( i % i_nal < 3 )
+            v = (i % i_nal == 2);
+        else if( i_zeros >= 2 && v <= 3 )
+            v = 3;
+        i_zeros = v ? 0 : i_zeros + 1;
+        p_data[i] = v;
+    }
+
+    run_startcode( "bits", p_data, i_size, startcode_FindAnnexB_Bits );
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    if( vlc_CPU_SSE2() )
+        run_startcode( "sse2", p_data, i_size, startcode_FindAnnexB_SSE2 );
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        run_startcode( "avx2", p_data, i_size, startcode_FindAnnexB_AVX2 );
+#endif
+#ifdef STARTCODE_NEON
+    if( vlc_CPU_ARM_NEON() )
+        run_startcode( "neon", p_data, i_size, startcode_FindAnnexB_NEON );
+#endif
+
+    run_ep3b( "c", p_data, i_size, hxxx_ep3b_scan_C );
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() )
+        run_ep3b( "avx2", p_data, i_size, hxxx_ep3b_scan_AVX2 );
+#endif
+#ifdef HXXX_EP3B_NEON
+    if( vlc_CPU_ARM_NEON() )
+        run_ep3b( "neon", p_data, i_size, hxxx_ep3b_scan_NEON );
+#endif
+
+    /* whole RBSP size computation, as done by the packetizers */
+    vlc_tick_t start = vlc_tick_now();
+    size_t i_rbsp = hxxx_ep3b_total_size( p_data, p_data + i_size );
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    printf( "ep3b size           %8.1f MiB/s (%zu bytes)\n",
+            (double) i_size / (1 << 20) / secf_from_vlc_tick( elapsed ), i_rbsp );
+
+    free( p_data );
+    return 0;
+}
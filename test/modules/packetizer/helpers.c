@@ -30,6 +30,7 @@
 #include <vlc_block_helper.h>
 
 #include "../modules/packetizer/startcode_helper.h"
+#include "../modules/packetizer/hxxx_ep3b.h"
 
 struct results_s
 {
@@ -90,6 +91,207 @@ static int run_annexb_sets( const uint8_t *p_set, const uint8_t *p_end,
     return 0;
 }
 
+typedef const uint8_t *(*startcode_find_t)(const uint8_t *, const uint8_t *);
+
+static const struct
+{
+    const char *psz_name;
+    startcode_find_t pf_find;
+} startcode_impls[] = {
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    { "sse2", startcode_FindAnnexB_SSE2 },
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    { "avx2", startcode_FindAnnexB_AVX2 },
+#endif
+#ifdef STARTCODE_NEON
+    { "neon", startcode_FindAnnexB_NEON },
+#endif
+    { "dispatch", startcode_FindAnnexB },
+};
+
+static bool startcode_usable( const char *psz_name )
+{
+#if defined(__i386__) || defined(__x86_64__)
+    if( !strcmp( psz_name, "sse2" ) )
+        return vlc_CPU_SSE2();
+    if( !strcmp( psz_name, "avx2" ) )
+        return vlc_CPU_AVX2();
+#endif
+#if defined(__arm__) || defined(__aarch64__)
+    if( !strcmp( psz_name, "neon" ) )
+        return vlc_CPU_ARM_NEON();
+#endif
+    return true;
+}
+
+/* Random data with many zeros and ones, for lots of (almost) startcodes */
+static void fill_random( uint8_t *p, size_t i_size, const uint8_t *p_alphabet,
+                         size_t i_alphabet )
+{
+    for( size_t i = 0; i < i_size; i++ )
+        p[i] = p_alphabet[rand() % i_alphabet];
+}
+
+static int check_random_startcodes( void )
+{
+    static const uint8_t alphabet[] = { 0, 0, 0, 0, 1, 1, 0x42, 0xFF };
+    uint8_t *p_data = malloc( 1024 + 64 );
+    if( !p_data )
+        return 1;
+
+    for( unsigned i_run = 0; i_run < 2000; i_run++ )
+    {
+        size_t i_offset = rand() % 64;
+        size_t i_size = rand() % 1024;
+        const uint8_t *p = &p_data[i_offset];
+        const uint8_t *p_end = p + i_size;
+        fill_random( &p_data[i_offset], i_size, alphabet, ARRAY_SIZE(alphabet) );
+
+        for( size_t i = 0; i < ARRAY_SIZE(startcode_impls); i++ )
+        {
+            if( !startcode_usable( startcode_impls[i].psz_name ) )
+                continue;
+
+            const uint8_t *p_ref = p, *p_test = p;
+            do
+            {
+                p_ref = startcode_FindAnnexB_Bits( p_ref, p_end );
+                p_test = startcode_impls[i].pf_find( p_test, p_end );
+                if( p_ref != p_test )
+                {
+                    printf("%s mismatch at run %u\n",
+                           startcode_impls[i].psz_name, i_run);
+                    free( p_data );
+                    return 1;
+                }
+                if( p_ref )
+                    p_ref = ++p_test;
+            } while( p_ref );
+        }
+    }
+
+    free( p_data );
+    return 0;
+}
+
+/* Original byte by byte emulation prevention removal */
+static uint8_t *ref_ep3b_to_rbsp( uint8_t *p, uint8_t *end, unsigned *pi_prev,
+                                  size_t i_count )
+{
+    for( size_t i=0; i<i_count; i++ )
+    {
+        if( ++p >= end )
+            return p;
+
+        *pi_prev = (*pi_prev << 1) | (!*p);
+
+        if( *p == 0x03 && ( p + 1 ) != end )
+        {
+            if( (*pi_prev & 0x06) == 0x06 )
+            {
+                ++p;
+                *pi_prev = ((*pi_prev >> 1) << 1) | (!*p);
+            }
+        }
+    }
+    return p;
+}
+
+static size_t ref_ep3b_total_size( const uint8_t *p, const uint8_t *p_end )
+{
+    unsigned i_prev = 0;
+    size_t i = 0;
+    while( p < p_end )
+    {
+        uint8_t *n = ref_ep3b_to_rbsp( (uint8_t *)p, (uint8_t *)p_end, &i_prev, 1 );
+        if( n > p )
+            ++i;
+        p = n;
+    }
+    return i;
+}
+
+static int check_ep3b( uint8_t *p, size_t i_size )
+{
+    uint8_t *p_end = p + i_size;
+
+    if( hxxx_ep3b_total_size( p, p_end ) != ref_ep3b_total_size( p, p_end ) )
+    {
+        printf("ep3b size mismatch\n");
+        return 1;
+    }
+
+    size_t i_scan = hxxx_ep3b_scan_C( p, p_end );
+#ifdef HAVE_AVX2_INTRINSICS
+    if( vlc_CPU_AVX2() && hxxx_ep3b_scan_AVX2( p, p_end ) != i_scan )
+    {
+        printf("ep3b avx2 scan mismatch\n");
+        return 1;
+    }
+#endif
+#ifdef HXXX_EP3B_NEON
+    if( vlc_CPU_ARM_NEON() && hxxx_ep3b_scan_NEON( p, p_end ) != i_scan )
+    {
+        printf("ep3b neon scan mismatch\n");
+        return 1;
+    }
+#endif
+    VLC_UNUSED(i_scan);
+
+    /* walk the data by various steps, as the bitstream reader does */
+    static const size_t steps[] = { 1, 2, 5, 31, 32, 33, 100, 1000 };
+    for( size_t i = 0; i < ARRAY_SIZE(steps); i++ )
+    {
+        uint8_t *p_ref = p, *p_test = p;
+        unsigned i_ref = 0, i_test = 0;
+        while( p_ref < p_end )
+        {
+            p_ref = ref_ep3b_to_rbsp( p_ref, p_end, &i_ref, steps[i] );
+            p_test = hxxx_ep3b_to_rbsp( p_test, p_end, &i_test, steps[i] );
+            if( p_ref != p_test || (i_ref & 3) != (i_test & 3) )
+            {
+                printf("ep3b mismatch at %zu by %zu\n", p_ref - p, steps[i]);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int check_random_ep3b( const uint8_t *p_real, size_t i_real )
+{
+    static const uint8_t alphabet[] = { 0, 0, 0, 0, 3, 3, 1, 0x42 };
+    uint8_t *p_data = malloc( 4096 );
+    if( !p_data )
+        return 1;
+
+    for( unsigned i_run = 0; i_run < 2000; i_run++ )
+    {
+        size_t i_size = rand() % 4096;
+        fill_random( p_data, i_size, alphabet, ARRAY_SIZE(alphabet) );
+        /* sparse escapes, as in real bitstreams */
+        if( i_run & 1 )
+            for( size_t i = 0; i < i_size; i++ )
+                if( p_data[i] == 0 && rand() % 16 )
+                    p_data[i] = 0x80;
+        if( check_ep3b( p_data, i_size ) )
+        {
+            free( p_data );
+            return 1;
+        }
+    }
+
+    /* real data */
+    memcpy( p_data, p_real, i_real );
+    int i_ret = 0;
+    for( size_t i = 0; i < i_real && !i_ret; i++ )
+        i_ret = check_ep3b( &p_data[i], i_real - i );
+
+    free( p_data );
+    return i_ret;
+}
+
 int main( void )
 {
     const uint8_t test1_annexbdata[] = { 0, 0, 0, 1, 0x55, 0x55, 0x55, 0x55, 0x55, // 9
@@ -134,5 +336,29 @@ int main( void )
             return i_ret;
     }
 
-    return 0;
+    srand( 42 );
+
+    printf("* Running tests on random sets:\n");
+    i_ret = check_random_startcodes();
+    if( i_ret != 0 )
+        return i_ret;
+
+    /* HEVC VPS, SPS, PPS and slices */
+    static const uint8_t test2_hevcdata[] = {
+        0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x04, 0x08,
+        0x00, 0x00, 0x03, 0x00, 0x9e, 0x08, 0x00, 0x00, 0x03, 0x00, 0x00, 0x1e,
+        0x95, 0x98, 0x09, 0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x04, 0x08,
+        0x00, 0x00, 0x03, 0x00, 0x9e, 0x08, 0x00, 0x00, 0x03, 0x00, 0x00, 0x1e,
+        0x90, 0x11, 0x08, 0xb2, 0xca, 0xcd, 0x57, 0x95, 0xcd, 0x40, 0x80, 0x80,
+        0x01, 0x00, 0x00, 0x03, 0x00, 0x01, 0x00, 0x00, 0x03, 0x00, 0x19, 0x08,
+        0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc1, 0x73, 0x18, 0x31, 0x08, 0x90,
+        0x00, 0x00, 0x01, 0x28, 0x01, 0xaf, 0x19, 0x80, 0xef, 0xef, 0xcb, 0x5f,
+        0xfe, 0x52, 0x0b, 0xfe, 0xbb, 0x6d, 0xfd, 0x0f, 0xf8, 0x00, 0x00, 0x00,
+        0x01, 0x02, 0x01, 0xd0, 0x29, 0x4b, 0xe1, 0x0c, 0x20, 0xa4, 0xfa, 0x44,
+        0x00, 0x00, 0x00, 0x01, 0x02, 0x01, 0xe0, 0x64, 0x9d, 0x78, 0x20, 0xc4,
+        0xbf, 0x20, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0xe0, 0x24, 0xf5, 0x5f,
+    };
+
+    printf("* Running emulation prevention tests:\n");
+    return check_random_ep3b( test2_hevcdata, sizeof(test2_hevcdata) );
 }
@@ -0,0 +1,256 @@
+/*****************************************************************************
+ * duplicate.c: duplicate stream output test
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Duplicates a video track to an asynchronous and a synchronous memory
+ * output. While the asynchronous one is stalled, the synchronous one must
+ * still get every frame, and the asynchronous one must get what its
+ * overflow policy keeps, in order, once it resumes.
+ */
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_es.h>
+#include <vlc_sout.h>
+
+#define FRAMES_MAX 256
+#define GOP 5
+
+typedef struct
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;
+    bool        b_stalled;
+    vlc_tick_t  i_delay;
+    unsigned    i_count;
+    vlc_tick_t  pts[FRAMES_MAX];
+    uint8_t     buffer[64];
+} sink_t;
+
+static void Prerender( void *data, uint8_t **pp_buffer, size_t i_size )
+{
+    sink_t *p_sink = data;
+
+    assert( i_size <= sizeof (p_sink->buffer) );
+    *pp_buffer = p_sink->buffer;
+}
+
+static void Postrender( void *data, uint8_t *p_buffer, int i_width,
+                        int i_height, int i_bpp, size_t i_size,
+                        vlc_tick_t i_pts )
+{
+    sink_t *p_sink = data;
+    VLC_UNUSED(p_buffer); VLC_UNUSED(i_width); VLC_UNUSED(i_height);
+    VLC_UNUSED(i_bpp); VLC_UNUSED(i_size);
+
+    if( p_sink->i_delay > 0 )
+        vlc_tick_sleep( p_sink->i_delay );
+
+    vlc_mutex_lock( &p_sink->lock );
+    assert( p_sink->i_count < FRAMES_MAX );
+    p_sink->pts[p_sink->i_count++] = i_pts;
+    vlc_cond_broadcast( &p_sink->wait );
+    while( p_sink->b_stalled )
+        vlc_cond_wait( &p_sink->wait, &p_sink->lock );
+    vlc_mutex_unlock( &p_sink->lock );
+}
+
+static void SinkInit( sink_t *p_sink )
+{
+    memset( p_sink, 0, sizeof (*p_sink) );
+    vlc_mutex_init( &p_sink->lock );
+    vlc_cond_init( &p_sink->wait );
+}
+
+static void SinkStall( sink_t *p_sink, bool b_stalled )
+{
+    vlc_mutex_lock( &p_sink->lock );
+    p_sink->b_stalled = b_stalled;
+    vlc_cond_broadcast( &p_sink->wait );
+    vlc_mutex_unlock( &p_sink->lock );
+}
+
+static void SinkWait( sink_t *p_sink, unsigned i_count )
+{
+    vlc_mutex_lock( &p_sink->lock );
+    while( p_sink->i_count < i_count )
+        vlc_cond_wait( &p_sink->wait, &p_sink->lock );
+    vlc_mutex_unlock( &p_sink->lock );
+}
+
+static void SinkChain( char *psz, size_t i_size, sink_t *p_sink )
+{
+    snprintf( psz, i_size, "smem{video-prerender-callback=%lld,"
+              "video-postrender-callback=%lld,video-data=%lld}",
+              (long long)(intptr_t)Prerender,
+              (long long)(intptr_t)Postrender,
+              (long long)(intptr_t)p_sink );
+}
+
+static void Send( sout_stream_t *p_stream, void *id, unsigned i_frame )
+{
+    block_t *p_block = block_Alloc( 16 );
+    assert( p_block != NULL );
+    memset( p_block->p_buffer, i_frame, p_block->i_buffer );
+    p_block->i_dts = p_block->i_pts = VLC_TICK_0 + i_frame;
+    p_block->i_flags = (i_frame % GOP) ? BLOCK_FLAG_TYPE_P
+                                       : BLOCK_FLAG_TYPE_I;
+    sout_StreamIdSend( p_stream, id, p_block );
+}
+
+/* Stalls the asynchronous output on the first frame, sends i_stalled more,
+ * resumes it until it has caught up, and sends i_after more. The
+ * asynchronous output must have received the listed frames. */
+static void test_overflow( vlc_object_t *p_obj, const char *psz_options,
+                           unsigned i_stalled, unsigned i_after,
+                           const unsigned *p_expected, unsigned i_expected )
+{
+    sink_t async, sync;
+    char psz_async[256], psz_sync[256], psz_chain[1024];
+    bool b_empty;
+    int i_ret;
+
+    test_log( "duplicate with %s\n", psz_options );
+    SinkInit( &async );
+    SinkInit( &sync );
+    SinkChain( psz_async, sizeof (psz_async), &async );
+    SinkChain( psz_sync, sizeof (psz_sync), &sync );
+    snprintf( psz_chain, sizeof (psz_chain), "duplicate{dst=%s,%s,dst=%s}",
+              psz_async, psz_options, psz_sync );
+
+    sout_instance_t *p_sout = vlc_object_create( p_obj, sizeof (*p_sout) );
+    assert( p_sout != NULL );
+    vlc_mutex_init( &p_sout->lock );
+    sout_stream_t *p_stream = sout_StreamChainNew( p_sout, psz_chain,
+                                                   NULL, NULL );
+    assert( p_stream != NULL );
+
+    es_format_t fmt;
+    es_format_Init( &fmt, VIDEO_ES, VLC_CODEC_MPGV );
+    fmt.video.i_width = fmt.video.i_visible_width = 320;
+    fmt.video.i_height = fmt.video.i_visible_height = 240;
+    void *id = sout_StreamIdAdd( p_stream, &fmt );
+    es_format_Clean( &fmt );
+    assert( id != NULL );
+
+    SinkStall( &async, true );
+    Send( p_stream, id, 0 );
+    SinkWait( &async, 1 );
+
+    /* the stalled output holds neither the input nor the other output */
+    for( unsigned i = 1; i <= i_stalled; i++ )
+        Send( p_stream, id, i );
+    assert( sync.i_count == i_stalled + 1 );
+    i_ret = sout_StreamControl( p_stream, SOUT_STREAM_EMPTY, &b_empty );
+    assert( i_ret == VLC_SUCCESS && !b_empty );
+
+    SinkStall( &async, false );
+    SinkWait( &async, i_expected - i_after );
+    for( unsigned i = 1; i <= i_after; i++ )
+        Send( p_stream, id, i_stalled + i );
+
+    /* queued frames are delivered before the track is deleted */
+    sout_StreamIdDel( p_stream, id );
+    i_ret = sout_StreamControl( p_stream, SOUT_STREAM_EMPTY, &b_empty );
+    assert( i_ret == VLC_SUCCESS && b_empty );
+
+    assert( sync.i_count == i_stalled + i_after + 1 );
+    for( unsigned i = 0; i < sync.i_count; i++ )
+        assert( sync.pts[i] == VLC_TICK_0 + i );
+    assert( async.i_count == i_expected );
+    for( unsigned i = 0; i < i_expected; i++ )
+        assert( async.pts[i] == VLC_TICK_0 + p_expected[i] );
+
+    sout_StreamChainDelete( p_stream, NULL );
+    vlc_object_delete( p_sout );
+}
+
+/* A slow asynchronous output with a short queue blocks the input, but loses
+ * nothing */
+static void test_block( vlc_object_t *p_obj )
+{
+    sink_t async;
+    char psz_async[256], psz_chain[512];
+
+    test_log( "duplicate to a slow output\n" );
+    SinkInit( &async );
+    async.i_delay = VLC_TICK_FROM_MS(1);
+    SinkChain( psz_async, sizeof (psz_async), &async );
+    snprintf( psz_chain, sizeof (psz_chain),
+              "duplicate{dst=%s,async=2,overflow=block}", psz_async );
+
+    sout_instance_t *p_sout = vlc_object_create( p_obj, sizeof (*p_sout) );
+    assert( p_sout != NULL );
+    vlc_mutex_init( &p_sout->lock );
+    sout_stream_t *p_stream = sout_StreamChainNew( p_sout, psz_chain,
+                                                   NULL, NULL );
+    assert( p_stream != NULL );
+
+    es_format_t fmt;
+    es_format_Init( &fmt, VIDEO_ES, VLC_CODEC_MPGV );
+    void *id = sout_StreamIdAdd( p_stream, &fmt );
+    es_format_Clean( &fmt );
+    assert( id != NULL );
+
+    for( unsigned i = 0; i < 100; i++ )
+        Send( p_stream, id, i );
+    sout_StreamIdDel( p_stream, id );
+
+    assert( async.i_count == 100 );
+    for( unsigned i = 0; i < async.i_count; i++ )
+        assert( async.pts[i] == VLC_TICK_0 + i );
+
+    sout_StreamChainDelete( p_stream, NULL );
+    vlc_object_delete( p_sout );
+}
+
+int main( void )
+{
+    test_init();
+
+    const char *args[] = { "--ignore-config", "--quiet" };
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(args), args );
+    assert( vlc != NULL );
+    vlc_object_t *p_obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    /* the queue is deep enough */
+    static const unsigned all[] = {
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+    };
+    test_overflow( p_obj, "async", 9, 2, all, ARRAY_SIZE(all) );
+
+    /* the last 4 frames are kept */
+    static const unsigned oldest[] = { 0, 6, 7, 8, 9, 10, 11 };
+    test_overflow( p_obj, "async=4,overflow=drop-oldest", 9, 2,
+                   oldest, ARRAY_SIZE(oldest) );
+
+    /* frame 4 makes room for key frame 5, and the frames after it wait for
+     * the next key frame */
+    static const unsigned non_key[] = { 0, 1, 2, 3, 5, 10, 11 };
+    test_overflow( p_obj, "async=4,overflow=drop-non-key", 9, 2,
+                   non_key, ARRAY_SIZE(non_key) );
+
+    test_block( p_obj );
+
+    libvlc_release( vlc );
+    return 0;
+}
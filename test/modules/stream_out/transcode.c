@@ -0,0 +1,248 @@
+/*****************************************************************************
+ * transcode.c: transcode stream output renditions test
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Transcodes a raw video track to renditions with their own encoder
+ * settings, and checks that each is output as its own ES, with every picture,
+ * in order, and that the end of sequence goes through all of them. With x264,
+ * also checks that the key frames of all renditions are at the same pictures.
+ */
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_es.h>
+#include <vlc_sout.h>
+
+#define WIDTH 320
+#define HEIGHT 240
+#define FRAMES 40
+#define RENDITIONS 3
+#define GOP 10
+
+typedef struct
+{
+    int        i_es_id;
+    unsigned   i_width;
+    unsigned   i_height;
+    unsigned   i_count;
+    size_t     i_bytes;
+    unsigned   i_eos;
+    unsigned   i_keys;
+    unsigned   i_unaligned_keys;
+    vlc_tick_t i_last_dts;
+} track_t;
+
+typedef struct
+{
+    unsigned i_tracks;
+    track_t  tracks[RENDITIONS + 1];
+} sink_t;
+
+static void *SinkAdd( sout_stream_t *p_stream, const es_format_t *p_fmt )
+{
+    sink_t *p_sink = p_stream->p_sys;
+
+    assert( p_fmt->i_cat == VIDEO_ES );
+    assert( p_sink->i_tracks < ARRAY_SIZE(p_sink->tracks) );
+    for( unsigned i = 0; i < p_sink->i_tracks; i++ )
+        assert( p_sink->tracks[i].i_es_id != p_fmt->i_id );
+
+    track_t *p_track = &p_sink->tracks[p_sink->i_tracks++];
+    p_track->i_es_id = p_fmt->i_id;
+    p_track->i_width = p_fmt->video.i_visible_width;
+    p_track->i_height = p_fmt->video.i_visible_height;
+    p_track->i_last_dts = VLC_TICK_INVALID;
+    return p_track;
+}
+
+static void SinkDel( sout_stream_t *p_stream, void *id )
+{
+    VLC_UNUSED(p_stream); VLC_UNUSED(id);
+}
+
+static int SinkSend( sout_stream_t *p_stream, void *id, block_t *p_chain )
+{
+    track_t *p_track = id;
+    VLC_UNUSED(p_stream);
+
+    for( block_t *p_block = p_chain; p_block; p_block = p_block->p_next )
+    {
+        assert( p_track->i_last_dts == VLC_TICK_INVALID ||
+                p_block->i_dts > p_track->i_last_dts );
+        p_track->i_last_dts = p_block->i_dts;
+        p_track->i_count++;
+        p_track->i_bytes += p_block->i_buffer;
+        if( p_block->i_flags & BLOCK_FLAG_END_OF_SEQUENCE )
+            p_track->i_eos++;
+        if( p_block->i_flags & BLOCK_FLAG_TYPE_I )
+        {
+            vlc_tick_t i_frame = ( p_block->i_pts - VLC_TICK_0 ) /
+                                 vlc_tick_rate_duration( 25 );
+            p_track->i_keys++;
+            if( i_frame % GOP )
+                p_track->i_unaligned_keys++;
+        }
+    }
+    block_ChainRelease( p_chain );
+    return VLC_SUCCESS;
+}
+
+static void Send( sout_stream_t *p_stream, void *id, unsigned i_frame,
+                  bool b_eos )
+{
+    block_t *p_block = block_Alloc( WIDTH * HEIGHT * 3 / 2 );
+    assert( p_block != NULL );
+    for( size_t i = 0; i < p_block->i_buffer; i++ )
+        p_block->p_buffer[i] = i_frame + i * i / WIDTH;
+    p_block->i_dts = p_block->i_pts = VLC_TICK_0 +
+                                      i_frame * vlc_tick_rate_duration( 25 );
+    p_block->i_length = vlc_tick_rate_duration( 25 );
+    if( b_eos )
+        p_block->i_flags |= BLOCK_FLAG_END_OF_SEQUENCE;
+    sout_StreamIdSend( p_stream, id, p_block );
+}
+
+/* Sends the pictures through the chain, or returns false if the encoders are
+ * not available */
+static bool Run( vlc_object_t *p_obj, const char *psz_chain, sink_t *p_sink_sys )
+{
+    sout_instance_t *p_sout = vlc_object_create( p_obj, sizeof (*p_sout) );
+    assert( p_sout != NULL );
+    vlc_mutex_init( &p_sout->lock );
+
+    sout_stream_t *p_sink = vlc_object_create( p_sout, sizeof (*p_sink) );
+    assert( p_sink != NULL );
+    p_sink->p_sout = p_sout;
+    p_sink->pf_add = SinkAdd;
+    p_sink->pf_del = SinkDel;
+    p_sink->pf_send = SinkSend;
+    p_sink->p_sys = p_sink_sys;
+
+    sout_stream_t *p_last;
+    sout_stream_t *p_stream = sout_StreamChainNew( p_sout, psz_chain, p_sink,
+                                                   &p_last );
+    if( p_stream == NULL )
+    {
+        vlc_object_delete( p_sink );
+        vlc_object_delete( p_sout );
+        return false;
+    }
+
+    es_format_t fmt;
+    es_format_Init( &fmt, VIDEO_ES, VLC_CODEC_J420 );
+    fmt.i_id = 3;
+    fmt.video.i_chroma = VLC_CODEC_J420;
+    fmt.video.i_width = fmt.video.i_visible_width = WIDTH;
+    fmt.video.i_height = fmt.video.i_visible_height = HEIGHT;
+    fmt.video.i_sar_num = fmt.video.i_sar_den = 1;
+    fmt.video.i_frame_rate = 25;
+    fmt.video.i_frame_rate_base = 1;
+    void *id = sout_StreamIdAdd( p_stream, &fmt );
+    es_format_Clean( &fmt );
+    if( id != NULL )
+    {
+        for( unsigned i = 0; i < FRAMES; i++ )
+            Send( p_stream, id, i, i == FRAMES / 2 - 1 );
+        sout_StreamIdDel( p_stream, id );
+    }
+
+    sout_StreamChainDelete( p_stream, p_last );
+    vlc_object_delete( p_sink );
+    vlc_object_delete( p_sout );
+    return id != NULL;
+}
+
+static const track_t *GetTrack( const sink_t *p_sink, int i_es_id )
+{
+    for( unsigned i = 0; i < p_sink->i_tracks; i++ )
+        if( p_sink->tracks[i].i_es_id == i_es_id )
+            return &p_sink->tracks[i];
+    assert( !"missing rendition" );
+    return NULL;
+}
+
+int main( void )
+{
+    test_init();
+
+    const char *args[] = { "--ignore-config", "--quiet" };
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(args), args );
+    assert( vlc != NULL );
+    vlc_object_t *p_obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    sink_t sink = { .i_tracks = 0 };
+    if( !Run( p_obj, "transcode{vcodec=jpeg,gop=10,deinterlace,rendition{},"
+                     "rendition{venc=jpeg{quality=50},id=7},"
+                     "rendition{venc=jpeg{quality=5},id=8}}", &sink ) )
+    {
+        test_log( "no raw video decoder or JPEG encoder, skipping\n" );
+        libvlc_release( vlc );
+        return 77;
+    }
+
+    /* the rendition without id replaces the input ES, and the lower the
+     * quality, the smaller the output */
+    static const int expected[RENDITIONS] = { 3, 7, 8 };
+    size_t i_bytes = SIZE_MAX;
+
+    assert( sink.i_tracks == RENDITIONS );
+    for( unsigned i = 0; i < RENDITIONS; i++ )
+    {
+        const track_t *p_track = GetTrack( &sink, expected[i] );
+        test_log( "rendition %d: %ux%u, %u pictures, %zu bytes\n",
+                  p_track->i_es_id, p_track->i_width, p_track->i_height,
+                  p_track->i_count, p_track->i_bytes );
+        assert( p_track->i_width == WIDTH && p_track->i_height == HEIGHT );
+        assert( p_track->i_count == FRAMES );
+        assert( p_track->i_eos == 1 );
+        assert( p_track->i_bytes < i_bytes );
+        i_bytes = p_track->i_bytes;
+    }
+
+    /* only one rendition can go without id */
+    sink.i_tracks = 0;
+    assert( !Run( p_obj, "transcode{vcodec=jpeg,rendition{},rendition{}}",
+                  &sink ) );
+    assert( sink.i_tracks == 0 );
+
+    /* with x264, the key frames of every rendition are at the same pictures */
+    sink = (sink_t) { .i_tracks = 0 };
+    if( Run( p_obj, "transcode{vcodec=h264,venc=x264{preset=ultrafast},gop=10,"
+                    "rendition{vb=200},rendition{vb=800,id=7}}", &sink ) )
+    {
+        assert( sink.i_tracks == 2 );
+        for( unsigned i = 0; i < sink.i_tracks; i++ )
+        {
+            const track_t *p_track = &sink.tracks[i];
+            test_log( "x264 rendition %d: %u pictures, %u key frames\n",
+                      p_track->i_es_id, p_track->i_count, p_track->i_keys );
+            assert( p_track->i_count == FRAMES );
+            assert( p_track->i_keys >= FRAMES / GOP );
+            assert( p_track->i_unaligned_keys == 0 );
+        }
+    }
+    else
+        test_log( "no x264 encoder, skipping the key frame alignment\n" );
+
+    libvlc_release( vlc );
+    return 0;
+}
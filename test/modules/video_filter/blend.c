@@ -0,0 +1,267 @@
+/*****************************************************************************
+ * blend.c: test for the blend filter
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_picture.h>
+
+#include "../modules/video_filter/filter_picture.h"
+
+/* Checks the blending of the most common chromas, which have vector code,
+ * against a per-pixel reference written after the generic code */
+
+static void fill_picture( picture_t *pic, bool alpha )
+{
+    for( int i = 0; i < pic->i_planes; i++ )
+    {
+        plane_t *p = &pic->p[i];
+
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+            {
+                unsigned v = test_rand() & 0xFF;
+                /* plenty of fully transparent and opaque pixels */
+                if( alpha && (v & 3) == 0 )
+                    v = (v & 4) ? 255 : 0;
+                p->p_pixels[y * p->i_pitch + x] = v;
+            }
+    }
+
+    if( pic->format.i_chroma == VLC_CODEC_I420_10L )
+        for( int i = 0; i < pic->i_planes; i++ )
+        {
+            plane_t *p = &pic->p[i];
+            for( int y = 0; y < p->i_lines; y++ )
+            {
+                uint16_t *line = (uint16_t *)&p->p_pixels[y * p->i_pitch];
+                for( int x = 0; x < p->i_pitch / 2; x++ )
+                    line[x] &= 0x3FF;
+            }
+        }
+}
+
+static unsigned div255( unsigned v )
+{
+    return ((v >> 8) + v + 1) >> 8;
+}
+
+static void merge8( uint8_t *dst, unsigned src, unsigned a )
+{
+    *dst = div255( (255 - a) * *dst + src * a );
+}
+
+static void merge16( uint8_t *dst, unsigned src, unsigned a )
+{
+    uint16_t *p = (uint16_t *)dst;
+    *p = div255( (255 - a) * *p + src * a );
+}
+
+static void reference( picture_t *dst, const picture_t *src,
+                       unsigned x0, unsigned y0, unsigned width,
+                       unsigned height, int alpha )
+{
+    const vlc_fourcc_t chroma = dst->format.i_chroma;
+    const bool rgba = src->format.i_chroma == VLC_CODEC_RGBA;
+
+    for( unsigned y = 0; y < height; y++ )
+        for( unsigned x = 0; x < width; x++ )
+        {
+            unsigned px[4];
+
+            if( rgba )
+                for( int i = 0; i < 4; i++ )
+                    px[i] = src->p[0].p_pixels[y * src->p[0].i_pitch + 4 * x + i];
+            else
+                for( int i = 0; i < 4; i++ )
+                    px[i] = src->p[i].p_pixels[y * src->p[i].i_pitch + x];
+
+            unsigned a = div255( alpha * px[3] );
+            if( a == 0 )
+                continue;
+
+            const unsigned dx = x0 + x, dy = y0 + y;
+            const bool full = (dx % 2) == 0 && (dy % 2) == 0;
+
+            if( chroma == VLC_CODEC_RGB32 )
+            {
+                int r, g, b;
+                if( !rgba )
+                {
+                    yuv_to_rgb( &r, &g, &b, px[0], px[1], px[2] );
+                    px[0] = r; px[1] = g; px[2] = b;
+                }
+                int ret = GetPackedRgbIndexes( &dst->format, &r, &g, &b );
+                assert( ret == VLC_SUCCESS );
+                uint8_t *p = &dst->p[0].p_pixels[dy * dst->p[0].i_pitch + 4 * dx];
+                merge8( &p[r], px[0], a );
+                merge8( &p[g], px[1], a );
+                merge8( &p[b], px[2], a );
+                continue;
+            }
+
+            if( rgba )
+            {
+                uint8_t yuv[3];
+                rgb_to_yuv( &yuv[0], &yuv[1], &yuv[2], px[0], px[1], px[2] );
+                for( int i = 0; i < 3; i++ )
+                    px[i] = yuv[i];
+            }
+
+            if( chroma == VLC_CODEC_I420_10L )
+            {
+                for( int i = 0; i < 3; i++ )
+                    px[i] = px[i] * 1023 / 255;
+                merge16( &dst->p[0].p_pixels[dy * dst->p[0].i_pitch + 2 * dx],
+                         px[0], a );
+                if( full )
+                    for( int i = 1; i < 3; i++ )
+                        merge16( &dst->p[i].p_pixels[dy / 2 * dst->p[i].i_pitch
+                                                     + dx / 2 * 2], px[i], a );
+                continue;
+            }
+
+            merge8( &dst->p[0].p_pixels[dy * dst->p[0].i_pitch + dx], px[0], a );
+            if( !full )
+                continue;
+            if( chroma == VLC_CODEC_NV12 || chroma == VLC_CODEC_NV21 )
+            {
+                const bool swap = chroma == VLC_CODEC_NV21;
+                uint8_t *p = &dst->p[1].p_pixels[dy / 2 * dst->p[1].i_pitch + dx];
+                merge8( &p[swap], px[1], a );
+                merge8( &p[!swap], px[2], a );
+            }
+            else
+            {
+                const bool swap = chroma == VLC_CODEC_YV12;
+                merge8( &dst->p[swap ? 2 : 1].p_pixels[dy / 2 *
+                          dst->p[swap ? 2 : 1].i_pitch + dx / 2], px[1], a );
+                merge8( &dst->p[swap ? 1 : 2].p_pixels[dy / 2 *
+                          dst->p[swap ? 1 : 2].i_pitch + dx / 2], px[2], a );
+            }
+        }
+}
+
+static void compare( const picture_t *a, const picture_t *b )
+{
+    for( int i = 0; i < a->i_planes; i++ )
+        for( int y = 0; y < a->p[i].i_visible_lines; y++ )
+            assert( !memcmp( &a->p[i].p_pixels[y * a->p[i].i_pitch],
+                             &b->p[i].p_pixels[y * b->p[i].i_pitch],
+                             a->p[i].i_visible_pitch ) );
+}
+
+static void test( vlc_object_t *obj, vlc_fourcc_t dst_chroma,
+                  uint32_t rmask, uint32_t gmask, uint32_t bmask,
+                  vlc_fourcc_t src_chroma )
+{
+    static const unsigned sizes[][4] = {
+        /* width, height, x, y */
+        {   1,   1,  0,  0 },
+        {   7,   3,  1,  1 },
+        {  33,  17,  3,  2 },
+        {  65,  31,  2,  5 },
+        { 127,  40, 11,  0 },
+        { 200,  60, 56, 99 },
+    };
+    video_format_t dst_fmt, src_fmt;
+
+    video_format_Init( &dst_fmt, dst_chroma );
+    video_format_Setup( &dst_fmt, dst_chroma, 256, 160, 256, 160, 1, 1 );
+    dst_fmt.i_rmask = rmask;
+    dst_fmt.i_gmask = gmask;
+    dst_fmt.i_bmask = bmask;
+    video_format_FixRgb( &dst_fmt );
+
+    for( size_t i = 0; i < ARRAY_SIZE(sizes); i++ )
+    {
+        const unsigned *s = sizes[i];
+
+        video_format_Init( &src_fmt, src_chroma );
+        video_format_Setup( &src_fmt, src_chroma, s[0], s[1], s[0], s[1],
+                            1, 1 );
+
+        filter_t *filter = vlc_object_create( obj, sizeof(*filter) );
+        assert( filter != NULL );
+        es_format_Init( &filter->fmt_in, VIDEO_ES, src_chroma );
+        es_format_Init( &filter->fmt_out, VIDEO_ES, dst_chroma );
+        filter->fmt_in.video = src_fmt;
+        filter->fmt_out.video = dst_fmt;
+        filter->p_module = module_need( filter, "video blending", NULL, false );
+        assert( filter->p_module != NULL );
+
+        picture_t *src = picture_NewFromFormat( &src_fmt );
+        picture_t *dst = picture_NewFromFormat( &dst_fmt );
+        picture_t *ref = picture_NewFromFormat( &dst_fmt );
+        assert( src != NULL && dst != NULL && ref != NULL );
+
+        for( int alpha = 255; alpha > 0; alpha -= 90 )
+        {
+            fill_picture( src, true );
+            fill_picture( dst, false );
+            picture_CopyPixels( ref, dst );
+
+            filter->pf_video_blend( filter, dst, src, s[2], s[3], alpha );
+            reference( ref, src, s[2], s[3], s[0], s[1], alpha );
+            compare( dst, ref );
+        }
+
+        picture_Release( ref );
+        picture_Release( dst );
+        picture_Release( src );
+        module_unneed( filter, filter->p_module );
+        vlc_object_delete( filter );
+    }
+}
+
+int main( void )
+{
+    static const vlc_fourcc_t dsts[] = {
+        VLC_CODEC_I420, VLC_CODEC_YV12, VLC_CODEC_NV12, VLC_CODEC_NV21,
+        VLC_CODEC_I420_10L, VLC_CODEC_RGB32,
+    };
+    static const vlc_fourcc_t srcs[] = { VLC_CODEC_YUVA, VLC_CODEC_RGBA };
+    const char *argv[] = {
+        "-v",
+        "--ignore-config",
+        "--no-media-library",
+    };
+
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(argv), argv );
+    assert( vlc != NULL );
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    for( size_t i = 0; i < ARRAY_SIZE(dsts); i++ )
+        for( size_t j = 0; j < ARRAY_SIZE(srcs); j++ )
+            test( obj, dsts[i], 0, 0, 0, srcs[j] );
+
+    /* another byte order */
+    for( size_t j = 0; j < ARRAY_SIZE(srcs); j++ )
+        test( obj, VLC_CODEC_RGB32, 0x0000ff00, 0x00ff0000, 0xff000000,
+              srcs[j] );
+
+    libvlc_release( vlc );
+    return 0;
+}
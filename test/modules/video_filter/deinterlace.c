@@ -0,0 +1,342 @@
+/*****************************************************************************
+ * deinterlace.c: test and benchmark for the deinterlace filter
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Checks the vector Yadif line filters against the C ones, and the output of
+ * yadif and yadif2x against known checksums.
+ *
+ * With arguments, times every mode instead:
+ *
+ *   test_modules_video_filter_deinterlace bench [pictures [width height]]
+ */
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include "../modules/video_filter/deinterlace/yadif_simd.c"
+
+/*****************************************************************************
+ * Line filters
+ *****************************************************************************/
+#if defined(YADIF_SSE4_1) || defined(YADIF_AVX2)
+#define MAX_WIDTH 200
+#define MARGIN    8 /* samples read before and after the line */
+
+static void fill_lines( uint8_t *buf, size_t size, unsigned sz,
+                        unsigned bits )
+{
+    const unsigned max = (1u << bits) - 1;
+
+    for( size_t i = 0; i < size / sz; i++ )
+    {
+        unsigned v = test_rand() & max;
+        /* extreme values, to check for overflows */
+        if( (test_rand() & 7) == 0 )
+            v = (test_rand() & 1) ? max : 0;
+        if( sz == 1 )
+            buf[i] = v;
+        else
+            ((uint16_t *)buf)[i] = v;
+    }
+}
+
+static void test_line( const char *name, yadif_line_t filter, unsigned sz,
+                       unsigned bits )
+{
+    /* 5 lines per picture, the filtered line being the middle one */
+    const int pitch = (MAX_WIDTH + 2 * MARGIN) * sz;
+    uint8_t *buf[3], dst[2][(MAX_WIDTH + MARGIN) * 2];
+    yadif_line_t ref = sz == 1 ? yadif_filter_line_c
+                               : yadif_filter_line_c_16bit;
+
+    for( int i = 0; i < 3; i++ )
+    {
+        buf[i] = malloc( 5 * pitch );
+        assert( buf[i] != NULL );
+    }
+
+    for( int w = 1; w <= MAX_WIDTH; w += (w < 40) ? 1 : 17 )
+        for( int mode = 0; mode <= 2; mode += 2 )
+            for( int parity = 0; parity <= 1; parity++ )
+                for( int edge = 0; edge < 3; edge++ )
+                {
+                    /* references are mirrored at the edges of the picture */
+                    const int prefs = edge == 2 ? -pitch : pitch;
+                    const int mrefs = edge == 1 ? pitch : -pitch;
+                    uint8_t *line[3];
+
+                    for( int i = 0; i < 3; i++ )
+                    {
+                        fill_lines( buf[i], 5 * pitch, sz, bits );
+                        line[i] = buf[i] + 2 * pitch + MARGIN * sz;
+                    }
+                    /* nothing may be written past the end of the line */
+                    memset( dst, 0xA5, sizeof(dst) );
+
+                    ref( dst[0], line[0], line[1], line[2], w, prefs, mrefs,
+                         parity, mode );
+                    filter( dst[1], line[0], line[1], line[2], w, prefs,
+                            mrefs, parity, mode );
+
+                    if( memcmp( dst[0], dst[1], sizeof(dst[0]) ) )
+                    {
+                        test_log( "%s: %u-bit width %d mode %d parity %d"
+                                  " edge %d mismatch\n", name, bits, w, mode,
+                                  parity, edge );
+                        abort();
+                    }
+                }
+
+    for( int i = 0; i < 3; i++ )
+        free( buf[i] );
+}
+
+static void test_lines( const char *name, yadif_line_t line8,
+                        yadif_line_t line16 )
+{
+    test_log( "checking %s line filters\n", name );
+    test_line( name, line8, 1, 8 );
+    for( unsigned bits = 9; bits <= 12; bits++ )
+        test_line( name, line16, 2, bits );
+}
+#endif
+
+/*****************************************************************************
+ * Whole pictures
+ *****************************************************************************/
+/* A bar moving 4 samples per field, over noise, and a flat padding, so that
+ * the pictures do not depend on the pitch */
+static void fill_picture( picture_t *pic, unsigned index, unsigned bits )
+{
+    const unsigned shift = bits - 8;
+
+    for( int i = 0; i < pic->i_planes; i++ )
+    {
+        const plane_t *p = &pic->p[i];
+        const int width = p->i_visible_pitch / p->i_pixel_pitch;
+
+        for( int y = 0; y < p->i_lines; y++ )
+        {
+            uint8_t *line = &p->p_pixels[y * p->i_pitch];
+            const int pos = (index * 2 + (y & 1)) * 4 % width;
+
+            for( int x = 0; x < p->i_pitch / p->i_pixel_pitch; x++ )
+            {
+                unsigned v = (x >= pos && x < pos + width / 8) ? 200 : 60;
+                if( x < width )
+                    v = ((v + (test_rand() & 31)) << shift)
+                      | (test_rand() & ((1 << shift) - 1));
+                else
+                    v <<= shift;
+                if( p->i_pixel_pitch == 1 )
+                    line[x] = v;
+                else
+                    ((uint16_t *)line)[x] = v;
+            }
+        }
+    }
+}
+
+/* FNV-1a over the visible samples */
+static uint32_t checksum( uint32_t hash, const picture_t *pic )
+{
+    for( int i = 0; i < pic->i_planes; i++ )
+    {
+        const plane_t *p = &pic->p[i];
+
+        for( int y = 0; y < p->i_visible_lines; y++ )
+        {
+            const uint8_t *line = &p->p_pixels[y * p->i_pitch];
+
+            for( int x = 0; x < p->i_visible_pitch / p->i_pixel_pitch; x++ )
+            {
+                unsigned v = p->i_pixel_pitch == 1 ? line[x]
+                                                   : ((const uint16_t *)line)[x];
+                hash = (hash ^ v) * 16777619;
+            }
+        }
+    }
+    return hash;
+}
+
+/* Feeds pictures through the deinterlace filter, and returns the checksum of
+ * the output, from the third input picture on */
+static uint32_t run( vlc_object_t *obj, const char *mode, vlc_fourcc_t chroma,
+                     unsigned width, unsigned height, unsigned count,
+                     vlc_tick_t *elapsed )
+{
+    const vlc_chroma_description_t *desc =
+        vlc_fourcc_GetChromaDescription( chroma );
+    char filter[64];
+    uint32_t hash = 2166136261;
+    unsigned outputs = 0;
+
+    /* discard, mean and phosphor change the output format */
+    filter_chain_t *chain = filter_chain_NewVideo( obj, true, NULL );
+    assert( chain != NULL );
+
+    es_format_t fmt;
+    es_format_Init( &fmt, VIDEO_ES, chroma );
+    video_format_Setup( &fmt.video, chroma, width, height, width, height,
+                        1, 1 );
+    fmt.video.i_frame_rate = 25;
+    fmt.video.i_frame_rate_base = 1;
+    filter_chain_Reset( chain, &fmt, NULL, &fmt );
+    snprintf( filter, sizeof(filter), "deinterlace{mode=%s}", mode );
+    assert( filter_chain_AppendFromString( chain, filter ) == 1 );
+
+    /* the inputs are generated up front, not to be timed */
+    picture_t *in[count];
+    test_srand( 1 );
+    for( unsigned i = 0; i < count; i++ )
+    {
+        in[i] = picture_NewFromFormat( &fmt.video );
+        assert( in[i] != NULL );
+        fill_picture( in[i], i, desc->pixel_bits );
+        in[i]->date = VLC_TICK_0 + i * VLC_TICK_FROM_MS(40);
+        in[i]->b_progressive = false;
+        in[i]->b_top_field_first = true;
+        in[i]->i_nb_fields = 2;
+    }
+
+    vlc_tick_t start = vlc_tick_now();
+    for( unsigned i = 0; i < count; i++ )
+    {
+        picture_t *out = filter_chain_VideoFilter( chain, in[i] );
+        while( out != NULL )
+        {
+            if( i >= 2 )
+                hash = checksum( hash, out );
+            outputs++;
+            picture_Release( out );
+            out = filter_chain_VideoFilter( chain, NULL );
+        }
+    }
+    *elapsed = vlc_tick_now() - start;
+    assert( outputs > 0 );
+
+    filter_chain_Delete( chain );
+    es_format_Clean( &fmt );
+    return hash;
+}
+
+static int bench( vlc_object_t *obj, unsigned count, unsigned width,
+                  unsigned height )
+{
+    static const struct
+    {
+        const char *name;
+        bool high_bit_depth;
+    } modes[] = {
+        { "discard", true }, { "bob", true }, { "linear", true },
+        { "mean", true }, { "blend", true }, { "yadif", true },
+        { "yadif2x", true }, { "x", false }, { "phosphor", false },
+        { "ivtc", false },
+    };
+    static const vlc_fourcc_t chromas[] = {
+        VLC_CODEC_I420, VLC_CODEC_I420_10L,
+    };
+
+    for( size_t i = 0; i < ARRAY_SIZE(chromas); i++ )
+        for( size_t j = 0; j < ARRAY_SIZE(modes); j++ )
+        {
+            vlc_tick_t elapsed;
+
+            /* the other modes fall back to blend */
+            if( chromas[i] != VLC_CODEC_I420 && !modes[j].high_bit_depth )
+                continue;
+
+            run( obj, modes[j].name, chromas[i], width, height, count,
+                 &elapsed );
+            printf( "%4.4s %-8s %8.2f ms/picture\n",
+                    (const char *)&chromas[i], modes[j].name,
+                    secf_from_vlc_tick( elapsed ) * 1000 / count );
+        }
+    return 0;
+}
+
+int main( int argc, char *argv[] )
+{
+    const char *vlc_argv[] = {
+        "-v",
+        "--ignore-config",
+        "--no-media-library",
+    };
+
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(vlc_argv), vlc_argv );
+    assert( vlc != NULL );
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    size_t count = 50;
+    if( test_bench_args( argc, argv, &count, NULL ) )
+    {
+        unsigned width = argc > 4 ? strtoul( argv[3], NULL, 0 ) : 1920;
+        unsigned height = argc > 4 ? strtoul( argv[4], NULL, 0 ) : 1080;
+
+        int ret = bench( obj, count < 3 ? 3 : count, width, height );
+        libvlc_release( vlc );
+        return ret;
+    }
+
+    test_srand( 1 );
+#ifdef YADIF_SSE4_1
+    if( vlc_CPU_SSE4_1() )
+        test_lines( "SSE4.1", yadif_filter_line_sse4_1,
+                    yadif_filter_line_sse4_1_16bit );
+#endif
+#ifdef YADIF_AVX2
+    if( vlc_CPU_AVX2() )
+        test_lines( "AVX2", yadif_filter_line_avx2,
+                    yadif_filter_line_avx2_16bit );
+#endif
+
+    /* Outputs of the C code, which all the line filters must give */
+    static const struct
+    {
+        const char *mode;
+        vlc_fourcc_t chroma;
+        uint32_t hash;
+    } golden[] = {
+        { "yadif",   VLC_CODEC_I420,     0xd771d3b8 },
+        { "yadif2x", VLC_CODEC_I420,     0x4a8c9419 },
+        { "yadif",   VLC_CODEC_I420_10L, 0x15cd3c5c },
+        { "yadif2x", VLC_CODEC_I420_10L, 0x49d9a97b },
+        { "yadif",   VLC_CODEC_I420_12L, 0x0a0108fa },
+    };
+
+    for( size_t i = 0; i < ARRAY_SIZE(golden); i++ )
+    {
+        vlc_tick_t elapsed;
+        uint32_t hash = run( obj, golden[i].mode, golden[i].chroma,
+                             720, 576, 6, &elapsed );
+
+        test_log( "%s %4.4s: %08"PRIx32"\n", golden[i].mode,
+                  (const char *)&golden[i].chroma, hash );
+        assert( hash == golden[i].hash );
+    }
+
+    libvlc_release( vlc );
+    return 0;
+}
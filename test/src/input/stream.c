@@ -33,7 +33,8 @@
 #include <unistd.h>
 
 #ifndef TEST_NET
-#define RAND_FILE_SIZE (1024 * 1024)
+/* spans several memory mapping windows, and ends in the middle of a page */
+#define RAND_FILE_SIZE (9 * 1024 * 1024 + 1234)
 #else
 #define HTTP_URL "http://streams.videolan.org/streams/ogm/MJPEG.ogm"
 #define HTTP_MD5 "4eaf9e8837759b670694398a33f02bc0"
@@ -182,7 +183,7 @@ stream_close( struct reader *p_reader )
 }
 
 static struct reader *
-stream_open( const char *psz_url )
+stream_open( const char *psz_url, const char *psz_input )
 {
     libvlc_instance_t *p_vlc;
     struct reader *p_reader;
@@ -194,12 +195,20 @@ stream_open( const char *psz_url )
         "--no-media-library",
         "--vout=dummy",
         "--aout=dummy",
+        NULL, /* last: --file-mmap or --file-uring */
     };
+    char psz_option[16];
 
     p_reader = calloc( 1, sizeof(struct reader) );
     assert( p_reader );
 
-    p_vlc = libvlc_new( ARRAY_SIZE(argv), argv );
+    if( psz_input != NULL )
+    {
+        snprintf( psz_option, sizeof(psz_option), "--file-%s", psz_input );
+        argv[ARRAY_SIZE(argv) - 1] = psz_option;
+    }
+
+    p_vlc = libvlc_new( ARRAY_SIZE(argv) - (psz_input == NULL), argv );
     assert( p_vlc != NULL );
 
     p_reader->u.s = vlc_stream_NewURL( p_vlc->p_libvlc_int, psz_url );
@@ -216,7 +225,7 @@ stream_open( const char *psz_url )
     p_reader->pf_tell = stream_tell;
     p_reader->pf_seek = stream_seek;
     p_reader->p_data = p_vlc;
-    p_reader->psz_name = "stream";
+    p_reader->psz_name = psz_input != NULL ? psz_input : "stream";
     return p_reader;
 }
 
@@ -365,7 +374,7 @@ fill_rand( int i_fd, size_t i_size )
 int
 main( void )
 {
-    struct reader *pp_readers[3];
+    struct reader *pp_readers[4];
 
     test_init();
 
@@ -377,15 +386,22 @@ main( void )
     test_log( "Generating random file...\n" );
     i_tmp_fd = vlc_mkstemp( psz_tmp_path );
     fill_rand( i_tmp_fd, RAND_FILE_SIZE );
-    test_log( "Testing random file with libc, and stream...\n" );
+    test_log( "Testing random file with libc, stream, mmap and uring streams...\n" );
     assert( i_tmp_fd != -1 );
     assert( asprintf( &psz_url, "file://%s", psz_tmp_path ) != -1 );
 
+    unsigned i_readers = 2;
     assert( ( pp_readers[0] = libc_open( psz_tmp_path ) ) );
-    assert( ( pp_readers[1] = stream_open( psz_url ) ) );
+    assert( ( pp_readers[1] = stream_open( psz_url, NULL ) ) );
+#ifndef _WIN32
+    assert( ( pp_readers[i_readers++] = stream_open( psz_url, "mmap" ) ) );
+#endif
+#ifdef HAVE_LINUX_IO_URING_H
+    assert( ( pp_readers[i_readers++] = stream_open( psz_url, "uring" ) ) );
+#endif
 
-    test( pp_readers, 2, NULL );
-    for( unsigned int i = 0; i < 2; ++i )
+    test( pp_readers, i_readers, NULL );
+    for( unsigned int i = 0; i < i_readers; ++i )
         pp_readers[i]->pf_close( pp_readers[i] );
     free( psz_url );
 
@@ -394,7 +410,7 @@ main( void )
 
     test_log( "Testing http url with stream...\n" );
     alarm( 0 );
-    if( !( pp_readers[0] = stream_open( HTTP_URL ) ) )
+    if( !( pp_readers[0] = stream_open( HTTP_URL, NULL ) ) )
     {
         test_log( "WARNING: can't test http url" );
         return 0;
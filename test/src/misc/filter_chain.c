@@ -0,0 +1,178 @@
+/*****************************************************************************
+ * filter_chain.c: test for video filters processed in slices
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+/* Odd band sizes, to check the slice boundaries */
+#define WIDTH    642
+#define HEIGHT   362
+#define PICTURES 4
+
+/* gaussianblur reads a bit past the visible pixels, so it comes first, where
+ * the padding is initialized */
+static const char filters[] =
+    "gaussianblur{sigma=1}:"
+    "adjust{contrast=1.3,hue=30,saturation=1.7,gamma=1.2}:"
+    "sharpen{sigma=0.8}:hqdn3d:gradfun";
+
+static void fill_picture( picture_t *pic, unsigned index )
+{
+    uint32_t seed = 0x12345678 + index;
+
+    for( int i = 0; i < pic->i_planes; i++ )
+    {
+        const plane_t *p = &pic->p[i];
+
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+            {
+                /* gradients, for the debanding, plus some noise */
+                seed = seed * 1103515245 + 12345;
+                p->p_pixels[y * p->i_pitch + x] =
+                    (x + y + index * 8) / 4 + ((seed >> 16) & 15);
+            }
+    }
+}
+
+static void filter( vlc_object_t *obj, picture_t **out )
+{
+    filter_chain_t *chain = filter_chain_NewVideo( obj, false, NULL );
+    assert( chain != NULL );
+
+    es_format_t fmt;
+    es_format_Init( &fmt, VIDEO_ES, VLC_CODEC_I420 );
+    video_format_Setup( &fmt.video, VLC_CODEC_I420, WIDTH, HEIGHT,
+                        WIDTH, HEIGHT, 1, 1 );
+    filter_chain_Reset( chain, &fmt, NULL, &fmt );
+    assert( filter_chain_AppendFromString( chain, filters ) == 5 );
+
+    for( unsigned i = 0; i < PICTURES; i++ )
+    {
+        picture_t *pic = picture_NewFromFormat( &fmt.video );
+        assert( pic != NULL );
+        fill_picture( pic, i );
+        pic->date = VLC_TICK_0 + i;
+
+        out[i] = filter_chain_VideoFilter( chain, pic );
+        assert( out[i] != NULL );
+        assert( out[i]->date == VLC_TICK_0 + i );
+    }
+
+    filter_chain_Delete( chain );
+    es_format_Clean( &fmt );
+}
+
+struct concurrent
+{
+    vlc_object_t *obj;
+    picture_t *out[PICTURES];
+};
+
+static void *filter_thread( void *data )
+{
+    struct concurrent *c = data;
+
+    filter( c->obj, c->out );
+    return NULL;
+}
+
+/* Runs the chain, or as many chains as out pictures arrays at once, sharing
+ * the slice threads */
+static void run( const char *threads, picture_t **out, unsigned chains )
+{
+    const char *argv[] = {
+        "-v",
+        "--ignore-config",
+        "--no-media-library",
+        threads,
+    };
+
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(argv), argv );
+    assert( vlc != NULL );
+
+    vlc_tick_t start = vlc_tick_now();
+    struct concurrent c[chains];
+    vlc_thread_t th[chains];
+
+    for( unsigned i = 0; i < chains; i++ )
+    {
+        c[i].obj = VLC_OBJECT(vlc->p_libvlc_int);
+        int ret = vlc_clone( &th[i], filter_thread, &c[i],
+                             VLC_THREAD_PRIORITY_LOW );
+        assert( ret == 0 );
+    }
+    for( unsigned i = 0; i < chains; i++ )
+    {
+        vlc_join( th[i], NULL );
+        memcpy( &out[i * PICTURES], c[i].out, sizeof (c[i].out) );
+    }
+    test_log( "%s, %u chain(s): %"PRId64" ms\n", threads, chains,
+              MS_FROM_VLC_TICK(vlc_tick_now() - start) );
+
+    libvlc_release( vlc );
+}
+
+static void compare( picture_t *a, picture_t *b )
+{
+    assert( a->i_planes == b->i_planes );
+    for( int i = 0; i < a->i_planes; i++ )
+    {
+        const plane_t *pa = &a->p[i], *pb = &b->p[i];
+
+        assert( pa->i_visible_lines == pb->i_visible_lines );
+        for( int y = 0; y < pa->i_visible_lines; y++ )
+            assert( !memcmp( &pa->p_pixels[y * pa->i_pitch],
+                             &pb->p_pixels[y * pb->i_pitch],
+                             pa->i_visible_pitch ) );
+    }
+}
+
+int main( void )
+{
+    picture_t *ref[PICTURES], *sliced[2 * PICTURES];
+
+    test_init();
+
+    /* Slices must not change the output of the filters, including when
+     * several chains share the threads */
+    run( "--video-filter-threads=1", ref, 1 );
+    run( "--video-filter-threads=4", sliced, 1 );
+    for( unsigned i = 0; i < PICTURES; i++ )
+    {
+        compare( ref[i], sliced[i] );
+        picture_Release( sliced[i] );
+    }
+
+    run( "--video-filter-threads=4", sliced, 2 );
+    for( unsigned i = 0; i < PICTURES; i++ )
+    {
+        compare( ref[i], sliced[i] );
+        compare( ref[i], sliced[PICTURES + i] );
+        picture_Release( ref[i] );
+        picture_Release( sliced[i] );
+        picture_Release( sliced[PICTURES + i] );
+    }
+    return 0;
+}
@@ -0,0 +1,265 @@
+/*****************************************************************************
+ * httpd.c: HTTP server test
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Drives local clients against a loopback HTTP stream, and checks that they
+ * all receive the stream data, for various numbers of server threads.
+ *
+ * Without arguments, a few clients read a short stream. With arguments, this
+ * is a load run reporting the aggregate throughput:
+ *
+ *   test_src_network_httpd [clients] [kbytes per client]
+ */
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_block.h>
+#include <vlc_httpd.h>
+#include <vlc_network.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+const char vlc_module_name[] = "test_httpd";
+
+#define BLOCK_SIZE  (7 * 188 * 10)
+
+struct bench
+{
+    vlc_object_t   *obj;
+    unsigned        port;
+    size_t          target;
+
+    atomic_uint     done;
+    atomic_uint     failed;
+
+    /* clients reading data */
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait;
+    unsigned        progress;
+};
+
+struct client
+{
+    struct bench   *bench;
+    vlc_thread_t    thread;
+};
+
+static void Progress(struct bench *b)
+{
+    vlc_mutex_lock(&b->lock);
+    b->progress++;
+    vlc_cond_signal(&b->wait);
+    vlc_mutex_unlock(&b->lock);
+}
+
+static void *ClientThread(void *data)
+{
+    struct client *cl = data;
+    struct bench *b = cl->bench;
+    static const char req[] = "GET /stream HTTP/1.0\r\n\r\n";
+    char line[16];
+    bool ok = false;
+
+    int fd = net_ConnectTCP(b->obj, "127.0.0.1", b->port);
+    if (fd == -1)
+        goto end;
+
+    if (net_Write(b->obj, fd, req, strlen(req)) != (ssize_t)strlen(req))
+        goto end_fd;
+
+    /* status line, then skip the headers */
+    if (net_Read(b->obj, fd, line, 12) != 12
+     || strncmp(line, "HTTP/1.0 200", 12))
+        goto end_fd;
+
+    uint32_t last = 0;
+    for (;;) {
+        char c;
+        if (net_Read(b->obj, fd, &c, 1) != 1)
+            goto end_fd;
+        last = (last << 8) | (uint8_t)c;
+        if (last == 0x0d0a0d0a)
+            break;
+    }
+    Progress(b);
+
+    uint8_t *buf = malloc(65536);
+    if (buf == NULL)
+        goto end_fd;
+
+    /* clients start, and skip data, on block boundaries */
+    size_t total = 0;
+    while (total < b->target) {
+        size_t len = __MIN(b->target - total, 65536);
+        ssize_t val = net_Read(b->obj, fd, buf, len);
+        if (val <= 0)
+            break;
+        for (ssize_t i = 0; i < val; i++)
+            if (buf[i] != (uint8_t)((total + i) % BLOCK_SIZE))
+                goto end_buf;
+        total += val;
+        Progress(b);
+    }
+    ok = total == b->target;
+end_buf:
+    free(buf);
+
+end_fd:
+    net_Close(fd);
+end:
+    if (!ok)
+        atomic_fetch_add(&b->failed, 1);
+    atomic_fetch_add(&b->done, 1);
+    Progress(b);
+    return NULL;
+}
+
+/* Finds a free port, letting the system choose from the ephemeral ones */
+static unsigned GetFreePort(vlc_object_t *obj)
+{
+    char addr[NI_MAXNUMERICHOST];
+    int port;
+
+    int *fds = net_ListenTCP(obj, "127.0.0.1", 0);
+    if (fds == NULL)
+        return 0;
+    if (net_GetSockAddress(fds[0], addr, &port))
+        port = 0;
+    net_ListenClose(fds);
+    return port;
+}
+
+static int RunBench(vlc_object_t *obj, unsigned clients, size_t target,
+                    unsigned threads)
+{
+    struct bench b = { .obj = obj, .target = target };
+    httpd_host_t *host = NULL;
+
+    atomic_init(&b.done, 0);
+    atomic_init(&b.failed, 0);
+    vlc_mutex_init(&b.lock);
+    vlc_cond_init(&b.wait);
+
+    var_SetInteger(obj, "http-threads", threads);
+    /* another process may take the port in between, try a few */
+    for (unsigned i = 0; i < 10 && host == NULL; i++) {
+        b.port = GetFreePort(obj);
+        if (b.port == 0)
+            break;
+        var_SetInteger(obj, "http-port", b.port);
+        host = vlc_http_HostNew(obj);
+    }
+    if (host == NULL) {
+        fprintf(stderr, "cannot create HTTP host\n");
+        return 77;
+    }
+
+    httpd_stream_t *stream = httpd_StreamNew(host, "/stream",
+                                             "application/octet-stream",
+                                             NULL, NULL);
+    assert(stream != NULL);
+
+    block_t *block = block_Alloc(BLOCK_SIZE);
+    assert(block != NULL);
+    for (size_t i = 0; i < BLOCK_SIZE; i++)
+        block->p_buffer[i] = i;
+
+    struct client *cls = malloc(clients * sizeof (*cls));
+    assert(cls != NULL);
+
+    vlc_tick_t start = vlc_tick_now();
+
+    for (unsigned i = 0; i < clients; i++) {
+        cls[i].bench = &b;
+        if (vlc_clone(&cls[i].thread, ClientThread, &cls[i],
+                      VLC_THREAD_PRIORITY_LOW))
+            abort();
+    }
+
+    /* feed the stream until every client is served, each time clients
+     * connect or read, so as not to go too far ahead of the ones reading */
+    unsigned progress = 0;
+
+    vlc_mutex_lock(&b.lock);
+    while (atomic_load(&b.done) < clients) {
+        vlc_mutex_unlock(&b.lock);
+        for (unsigned i = 0; i < 128; i++)
+            httpd_StreamSend(stream, block);
+        vlc_mutex_lock(&b.lock);
+
+        while (b.progress == progress)
+            vlc_cond_wait(&b.wait, &b.lock);
+        progress = b.progress;
+    }
+    vlc_mutex_unlock(&b.lock);
+
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    for (unsigned i = 0; i < clients; i++)
+        vlc_join(cls[i].thread, NULL);
+    free(cls);
+
+    unsigned failed = atomic_load(&b.failed);
+    printf("%3u clients, %2u thread(s): %8.1f MiB/s in %4"PRId64" ms"
+           " (%u failed)\n", clients, threads,
+           (double)clients * target / (1 << 20) / secf_from_vlc_tick(elapsed),
+           MS_FROM_VLC_TICK(elapsed), failed);
+
+    block_Release(block);
+    httpd_StreamDelete(stream);
+    httpd_HostDelete(host);
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    bool load = argc > 1;
+    unsigned clients = load ? strtoul(argv[1], NULL, 0) : 4;
+    size_t target = ((argc > 2) ? strtoul(argv[2], NULL, 0)
+                                : load ? 1024 : 64) * 1024;
+
+    test_init();
+
+    const char * const args[] = {
+        "-v",
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        "--http-host=127.0.0.1",
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    var_Create(obj, "http-port", VLC_VAR_INTEGER);
+    var_Create(obj, "http-threads", VLC_VAR_INTEGER);
+
+    int ret = 0;
+    static const unsigned threads[] = { 1, 2, 4 };
+    size_t runs = load ? ARRAY_SIZE(threads) : 2;
+    for (size_t i = 0; i < runs && ret == 0; i++)
+        ret = RunBench(obj, clients, target, threads[i]);
+
+    libvlc_release(vlc);
+    return ret;
+}
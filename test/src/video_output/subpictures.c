@@ -0,0 +1,230 @@
+/*****************************************************************************
+ * subpictures.c: subpicture unit rendering test
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Renders the same subpictures several times, and checks that the rendered
+ * text and the converted regions are reused only while they do not change,
+ * with the hit and miss counts of both caches. No scaler is needed: the
+ * text is rendered at the video size, and the paletted regions are only
+ * converted to RGBA.
+ */
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_spu.h>
+#include <vlc_subpicture.h>
+#include <vlc_text_style.h>
+
+#define WIDTH  640
+#define HEIGHT 480
+
+struct cache_stats
+{
+    unsigned long long hits, misses;
+};
+
+struct stats
+{
+    struct cache_stats region, text;
+};
+
+/* Gets the hit and miss counts logged when the spu is destroyed */
+static void Log( void *data, int level, const libvlc_log_t *ctx,
+                 const char *fmt, va_list ap )
+{
+    struct stats *stats = data;
+    char name[16];
+    struct cache_stats cache;
+    char *msg;
+
+    (void) level; (void) ctx;
+    if( vasprintf( &msg, fmt, ap ) == -1 )
+        return;
+    if( sscanf( msg, "%15s cache: %llu hit(s), %llu miss(es)", name,
+                &cache.hits, &cache.misses ) == 3 )
+    {
+        if( !strcmp( name, "region" ) )
+            stats->region = cache;
+        else if( !strcmp( name, "text" ) )
+            stats->text = cache;
+    }
+    free( msg );
+}
+
+static subpicture_region_t *NewText( const char *text )
+{
+    video_format_t fmt;
+    video_format_Init( &fmt, VLC_CODEC_TEXT );
+    subpicture_region_t *region = subpicture_region_New( &fmt );
+    assert( region != NULL );
+    region->p_text = text_segment_New( text );
+    assert( region->p_text != NULL );
+    return region;
+}
+
+/* A paletted region, in a transparent color and the given opaque one */
+static subpicture_region_t *NewPaletted( uint8_t luma )
+{
+    video_palette_t palette = {
+        .i_entries = 2,
+        .palette = { { 0, 128, 128, 0 }, { luma, 128, 128, 255 } },
+    };
+    video_format_t fmt;
+    video_format_Init( &fmt, VLC_CODEC_YUVP );
+    fmt.i_width = fmt.i_visible_width = 64;
+    fmt.i_height = fmt.i_visible_height = 32;
+    fmt.i_sar_num = fmt.i_sar_den = 1;
+    fmt.p_palette = &palette;
+
+    subpicture_region_t *region = subpicture_region_New( &fmt );
+    assert( region != NULL );
+    const plane_t *p = &region->p_picture->p[0];
+    for( int y = 0; y < p->i_lines; y++ )
+        for( int x = 0; x < p->i_pitch; x++ )
+            p->p_pixels[y * p->i_pitch + x] = (x / 8 + y / 8) & 1;
+    return region;
+}
+
+/* Renders a subpicture with the region, and returns its picture */
+static picture_t *Render( spu_t *spu, size_t channel,
+                          subpicture_region_t *region )
+{
+    static const vlc_fourcc_t chromas[] = { VLC_CODEC_RGBA, 0 };
+    const vlc_tick_t now = vlc_tick_now();
+
+    subpicture_t *subpic = subpicture_New( NULL );
+    assert( subpic != NULL );
+    subpic->i_channel = channel;
+    subpic->i_start = now;
+    subpic->i_stop = now + VLC_TICK_FROM_SEC(10);
+    subpic->i_original_picture_width = WIDTH;
+    subpic->i_original_picture_height = HEIGHT;
+    subpic->p_region = region;
+    spu_ClearChannel( spu, channel );
+    spu_PutSubpicture( spu, subpic );
+
+    video_format_t fmt;
+    video_format_Setup( &fmt, VLC_CODEC_RGBA, WIDTH, HEIGHT, WIDTH, HEIGHT,
+                        1, 1 );
+    subpicture_t *out = spu_Render( spu, chromas, &fmt, &fmt, now, now,
+                                    false, false );
+    if( out == NULL || out->p_region == NULL )
+    {
+        if( out != NULL )
+            subpicture_Delete( out );
+        return NULL;
+    }
+
+    picture_t *pic = picture_Hold( out->p_region->p_picture );
+    subpicture_Delete( out );
+    return pic;
+}
+
+static void TestRegions( spu_t *spu, size_t channel )
+{
+    picture_t *first = Render( spu, channel, NewPaletted( 235 ) );
+    assert( first != NULL );
+    assert( first->format.i_chroma == VLC_CODEC_RGBA );
+
+    /* the same region again is not converted again */
+    picture_t *pic = Render( spu, channel, NewPaletted( 235 ) );
+    assert( pic == first );
+    picture_Release( pic );
+
+    /* another palette */
+    pic = Render( spu, channel, NewPaletted( 16 ) );
+    assert( pic != NULL && pic != first );
+    picture_Release( pic );
+
+    /* the first conversion is still there */
+    pic = Render( spu, channel, NewPaletted( 235 ) );
+    assert( pic == first );
+    picture_Release( pic );
+
+    picture_Release( first );
+}
+
+static bool TestText( vlc_object_t *obj, spu_t *spu, size_t channel )
+{
+    picture_t *first = Render( spu, channel, NewText( "Hello" ) );
+    if( first == NULL )
+        return false;
+
+    /* the same text again is not rendered again */
+    picture_t *pic = Render( spu, channel, NewText( "Hello" ) );
+    assert( pic == first );
+    picture_Release( pic );
+
+    /* other text */
+    pic = Render( spu, channel, NewText( "World" ) );
+    assert( pic != NULL && pic != first );
+    picture_Release( pic );
+
+    /* the same text at another scale */
+    var_Create( obj, "sub-text-scale", VLC_VAR_INTEGER );
+    var_SetInteger( obj, "sub-text-scale", 200 );
+    pic = Render( spu, channel, NewText( "Hello" ) );
+    assert( pic != NULL && pic != first );
+    assert( pic->format.i_visible_width > first->format.i_visible_width );
+    picture_Release( pic );
+
+    picture_Release( first );
+    return true;
+}
+
+int main( void )
+{
+    test_init();
+
+    const char *args[] = { "--ignore-config", "--no-media-library", "-v" };
+    libvlc_instance_t *vlc = libvlc_new( ARRAY_SIZE(args), args );
+    assert( vlc != NULL );
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    struct stats stats = { { 0, 0 }, { 0, 0 } };
+    libvlc_log_set( vlc, Log, &stats );
+
+    spu_t *spu = spu_Create( obj, NULL );
+    if( spu == NULL )
+    {
+        test_log( "no paletted subpicture converter, skipping\n" );
+        libvlc_log_unset( vlc );
+        libvlc_release( vlc );
+        return 77;
+    }
+    ssize_t channel = spu_RegisterChannel( spu );
+    assert( channel >= 0 );
+
+    TestRegions( spu, channel );
+    bool text = TestText( obj, spu, channel );
+    if( !text )
+        test_log( "no text renderer, skipping the text\n" );
+
+    spu_Destroy( spu );
+    libvlc_log_unset( vlc );
+
+    assert( stats.region.hits == 2 && stats.region.misses == 2 );
+    if( text )
+        assert( stats.text.hits == 1 && stats.text.misses == 3 );
+
+    libvlc_release( vlc );
+    return 0;
+}